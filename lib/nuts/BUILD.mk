@@ -14,6 +14,6 @@
 NBUILD =		../../../nbuild
 
 GNU_LIB =		libnuts.a
-GNU_LIB_SRCS =	debug.c debug.cpp pic.c strmem.c list.c win.c
+GNU_LIB_SRCS =	bits.c debug.c debug.cpp dlog.c nqi.c pic.c picbatch.c picseq.c picstream.c strmem.c list.c metric.c queue.c symtab.c trace.c win.c
 
 
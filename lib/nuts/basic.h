@@ -84,6 +84,14 @@
 #define EXTERN_C_END
 #endif
 
+#ifndef THREAD_LOCAL
+#if defined UNIX_GNU || defined ANDROID
+#define THREAD_LOCAL	__thread
+#else
+#define THREAD_LOCAL
+#endif
+#endif
+
 #endif
 
 /*****************************************************************************
@@ -0,0 +1,230 @@
+/* -*- tab-width: 8 -*- */
+/** 
+ *  benchmark: append, iterate and remove by handle with tLnkList (NEW()),
+ *  tLnkList with a tNodePool and tChkList, 10^3..10^7 elements. prints ns
+ *  per element. every measurement runs in a child process, so the heap
+ *  state left by one container does not affect the next
+ *
+ *	bench_list [max_n]
+ *
+ *  \file      bench_list.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"nuts/list.h"
+#include	"nuts/debug.h"
+#include	"nuts/timer.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<unistd.h>
+#include	<sys/wait.h>
+
+
+/*****************************************************************************
+ *  local types
+ ****************************************************************************/
+
+/* same payload as the rectangles in win.c */
+typedef struct {
+  tNode			Node;
+  int			X,Y,Dx,Dy;
+  int			Col;
+} tRect;
+
+typedef struct {
+  int			X,Y,Dx,Dy;
+  int			Col;
+} tElem;
+
+typedef struct {
+  double		Add,Iter,Remove;	/* ns per element */
+} tResult;
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static volatile long	lSink;
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  random permutation of the handles
+ */
+static void Shuffle(void **pp, int N)
+{
+  int		i,j;
+  void		*t;
+
+  for(i=N-1;i>0;i--){
+    j=rand()%(i+1);
+    t=pp[i]; pp[i]=pp[j]; pp[j]=t;
+  }
+}
+
+
+/****************************************************************************/
+/*  number of iteration passes, so every size touches about 10^7 elements
+ */
+static int Passes(int N)
+{
+  return MAX(1,10000000/N);
+}
+
+
+/****************************************************************************/
+/*  tLnkList, nodes from NEW() or from a pool
+ */
+static tResult BenchLnk(int N, bool Pool, void **ppH)
+{
+  tLnkList	l;
+  tNodePool	np;
+  tRect		*pr;
+  tTimer	t;
+  tResult	r;
+  long		s=0;
+  int		i,k,passes=Passes(N);
+
+  if(Pool){
+    NodePool_Init(&np,sizeof(tRect));
+    LnkList_InitPool(&l,&np);
+  }
+  else
+    LnkList_Init(&l);
+
+  startTimer(&t);
+  for(i=0;i<N;i++){
+    pr=Pool?LnkList_NewNode(&l):NEW(tRect);
+    LnkList_Add(&l,pr);
+    pr->X=i;
+    ppH[i]=pr;
+  }
+  r.Add=stopTimer(&t)*1e6/N;
+
+  startTimer(&t);
+  for(k=0;k<passes;k++)
+    LNKLIST_FOR(l,pr)
+      s+=pr->X;
+  r.Iter=stopTimer(&t)*1e6/N/passes;
+  lSink=s;
+
+  Shuffle(ppH,N);
+  startTimer(&t);
+  for(i=0;i<N;i++){
+    LnkList_Remove(&l,ppH[i]);
+    if(Pool)
+      NodePool_Put(&np,ppH[i]);
+    else
+      free(ppH[i]);
+  }
+  r.Remove=stopTimer(&t)*1e6/N;
+  MUST_Eq(l.Len,0);
+
+  if(Pool)
+    NodePool_Free(&np);
+
+  return r;
+}
+
+
+/****************************************************************************/
+/*  tChkList
+ */
+static tResult BenchChk(int N, void **ppH)
+{
+  tChkList	l;
+  tElem		*pe;
+  tTimer	t;
+  tResult	r;
+  long		s=0;
+  int		i,k,passes=Passes(N);
+
+  ChkList_Init(&l,sizeof(tElem));
+
+  startTimer(&t);
+  for(i=0;i<N;i++){
+    pe=ChkList_Add(&l);
+    pe->X=i;
+    ppH[i]=pe;
+  }
+  r.Add=stopTimer(&t)*1e6/N;
+
+  startTimer(&t);
+  for(k=0;k<passes;k++)
+    CHKLIST_FOR(l,pe)
+      s+=pe->X;
+  r.Iter=stopTimer(&t)*1e6/N/passes;
+  lSink=s;
+
+  Shuffle(ppH,N);
+  startTimer(&t);
+  for(i=0;i<N;i++)
+    ChkList_Remove(&l,ppH[i]);
+  r.Remove=stopTimer(&t)*1e6/N;
+  MUST_Eq(l.Len,0);
+
+  ChkList_Free(&l);
+
+  return r;
+}
+
+
+/****************************************************************************/
+/*  run one benchmark in a child process
+ *
+ *  \param  Kind 0: tLnkList, 1: tLnkList with pool, 2: tChkList
+ */
+static tResult Run(int Kind, int N)
+{
+  tResult	r;
+  void		**ph;
+  int		fd[2];
+
+  MUST(pipe(fd)==0);
+  if(fork()==0){
+    ph=malloc(N*sizeof(*ph));  MUST(ph);
+    srand(N);
+    r=Kind==2?BenchChk(N,ph):BenchLnk(N,Kind==1,ph);
+    if(write(fd[1],&r,sizeof(r))!=sizeof(r))
+      _exit(1);
+    _exit(0);
+  }
+  close(fd[1]);
+  if(read(fd[0],&r,sizeof(r))!=sizeof(r))
+    ERROR("benchmark failed");
+  close(fd[0]);
+  wait(NULL);
+
+  return r;
+}
+
+
+/*****************************************************************************
+ *  main
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  int		n,max=argc>1?atoi(argv[1]):10000000;
+  tResult	a,b,c;
+
+  printf("%9s | %-23s | %-23s | %-23s\n","",
+	 "append ns/elem","iterate ns/elem","remove ns/elem");
+  printf("%9s | %7s %7s %7s | %7s %7s %7s | %7s %7s %7s\n","n",
+	 "lnk","pool","chk","lnk","pool","chk","lnk","pool","chk");
+  for(n=1000;n<=max;n*=10){
+    a=Run(0,n);
+    b=Run(1,n);
+    c=Run(2,n);
+    printf("%9d | %7.2f %7.2f %7.2f | %7.2f %7.2f %7.2f | %7.2f %7.2f %7.2f\n",
+	   n,a.Add,b.Add,c.Add,a.Iter,b.Iter,c.Iter,a.Remove,b.Remove,c.Remove);
+  }
+
+  return 0;
+}
@@ -0,0 +1,487 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  benchmark: throughput of the pic.c kernels (copy, convert, shift, SAD,
+ *  pad, draw) for image sizes from QVGA to 8K and 3 memory layouts:
+ *
+ *	packed	stride = width, lines start 64 byte aligned
+ *	pad	stride rounded up to 64 bytes plus one cache line
+ *	odd	stride = width + 1 pel, first pel 1 pel off the alignment
+ *
+ *  every kernel runs repeatedly for at least -t ms, the fastest run counts.
+ *  GB/s counts the bytes read and written by the kernel, for the nqi coder
+ *  the bytes of the uncompressed pels.
+ *
+ *	bench_pic [-csv|-json] [-k kernel] [-s size] [-l layout] [-t ms]
+ *
+ *  -k selects kernels by substring (e.g. "-k Pic16_"), -s and -l by name
+ *  (e.g. "-s 4K"). all of them can be repeated.
+ *
+ *  \file      bench_pic.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"nuts/debug.h"
+#include	"nuts/pic.h"
+#include	"nuts/nqi.h"
+#include	"nuts/timer.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define PADM		16		/* margin around each pic, in pels */
+#define MAXSEL		16
+
+
+/*****************************************************************************
+ *  local types
+ ****************************************************************************/
+
+/* a kernel wrapper, returns the number of pels it processed */
+typedef long (*tRun)(tPic *pD, tPic *pA, tPic *pB);
+
+typedef struct {
+  const char		*Name;
+  int			DBpp;		/* bytes per pel of pD */
+  int			ABpp,BBpp;	/* of pA and pB, 0: not used */
+  int			Bytes;		/* read+written per pel */
+  tRun			Run;
+} tKernel;
+
+typedef struct {
+  const char		*Name;
+  int			Dx,Dy;
+} tSize;
+
+typedef enum { OUT_TEXT, OUT_CSV, OUT_JSON } tOut;
+
+typedef struct {
+  u8			*pMem;
+  tPic			Pic;
+} tBuf;
+
+
+/*****************************************************************************
+ *  local functions: kernel wrappers
+ ****************************************************************************/
+
+#define PELS(p)		((long)(p)->Dx*(p)->Dy)
+
+/* dst from src */
+#define CONV(f)	static long R_##f(tPic *pD, tPic *pA, tPic *pB)		\
+  { (void)pB; f(pD,pA); return PELS(pD); }
+/* dst from src with a shift */
+#define CONVSH(f,sh) static long R_##f(tPic *pD, tPic *pA, tPic *pB)	\
+  { (void)pB; f(pD,pA,sh); return PELS(pD); }
+/* in place with an argument */
+#define SELF(f,...) static long R_##f(tPic *pD, tPic *pA, tPic *pB)	\
+  { (void)pA; (void)pB; f(pD,##__VA_ARGS__); return PELS(pD); }
+/* dst from 2 sources */
+#define SAD(f)	static long R_##f(tPic *pD, tPic *pA, tPic *pB)		\
+  { f(pD,pA,pB,4); return PELS(pD); }
+
+CONV(Pic8_Copy)
+SELF(Pic8_Set,0x55)
+SELF(Pic8_Clear)
+SELF(Pic8_ShiftLeft,1)
+SELF(Pic8_Pad,PADM)
+CONVSH(Pic8_CopyU16Shr,4)
+SAD(Pic8_Sad8)
+SAD(Pic8_Sad16)
+SAD(Pic8_Sad32)
+
+CONV(Pic16_Copy)
+SELF(Pic16_Set,0x1234)
+SELF(Pic16_ShiftLeft,1)
+CONVSH(Pic16_CopyU32Shr,8)
+CONV(Pic16_Pack4444)
+CONV(Pic16_Pack565_XRGB)
+CONV(Pic16_Pack565_RGBX)
+CONV(Pic16_BGRfromU8)
+
+CONV(Pic24_Copy)
+CONV(Pic24_RGBfromRGBX)
+CONV(Pic24_BGRfromRGBX)
+
+CONV(Pic32_Copy)
+SELF(Pic32_Set,0x12345678)
+SELF(Pic32_GenAlpha,1,2,3)
+CONVSH(Pic32_CopyU16Shl,8)
+CONV(Pic32_UnPack565)
+CONV(Pic32_RGBXfromU8)
+CONV(Pic32_RGBXfromRGB)
+CONV(Pic32_RGBXfromBGR)
+CONV(Pic32_XBGRfromU8)
+
+static long R_Pic_HorFlip(tPic *pD, tPic *pA, tPic *pB)
+{
+  (void)pA; (void)pB;
+  Pic_HorFlip(pD);
+  return PELS(pD);
+}
+
+/* the draw functions write a few pels per call, so call them on a grid */
+static long R_Pic16_DrawRect(tPic *pD, tPic *pA, tPic *pB)
+{
+  int		x,y;
+  long		n=0;
+
+  (void)pA; (void)pB;
+  for(y=1;y<pD->Dy-1;y+=4)
+    for(x=1;x<pD->Dx-1;x+=4,n+=8)
+      Pic16_DrawRect(pD,x,y,0xffff);
+  return n;
+}
+
+static long R_Pic32_DrawRect(tPic *pD, tPic *pA, tPic *pB)
+{
+  int		x,y;
+  long		n=0;
+
+  (void)pA; (void)pB;
+  for(y=1;y<pD->Dy-1;y+=4)
+    for(x=1;x<pD->Dx-1;x+=4,n+=8)
+      Pic32_DrawRect(pD,x,y,0xffffff);
+  return n;
+}
+
+static long R_Pic16_DrawCross(tPic *pD, tPic *pA, tPic *pB)
+{
+  int		x,y;
+  long		n=0;
+
+  (void)pA; (void)pB;
+  for(y=2;y<pD->Dy-2;y+=6)
+    for(x=2;x<pD->Dx-2;x+=6,n+=9)
+      Pic16_DrawCross(pD,x,y,0xffff);
+  return n;
+}
+
+/* a fan of lines from the top left corner to the right and bottom edges */
+static long R_Pic16_DrawLine(tPic *pD, tPic *pA, tPic *pB)
+{
+  int		i;
+  long		n=0;
+
+  (void)pA; (void)pB;
+  for(i=0;i<64;i++){
+    Pic16_DrawLine(pD,0,0,pD->Dx-1,(pD->Dy-1)*i/63,0xffff);
+    Pic16_DrawLine(pD,0,0,(pD->Dx-1)*i/63,pD->Dy-1,0xffff);
+    n+=MAX(pD->Dx,pD->Dy)*2;
+  }
+  return n;
+}
+
+static long R_Pic32_DrawLine(tPic *pD, tPic *pA, tPic *pB)
+{
+  int		i;
+  long		n=0;
+
+  (void)pA; (void)pB;
+  for(i=0;i<64;i++){
+    Pic32_DrawLine(pD,0,0,pD->Dx-1,(pD->Dy-1)*i/63,0xffffff);
+    Pic32_DrawLine(pD,0,0,(pD->Dx-1)*i/63,pD->Dy-1,0xffffff);
+    n+=MAX(pD->Dx,pD->Dy)*2;
+  }
+  return n;
+}
+
+
+/* the nqi line coder: encode pA, or decode it into pD. a decode encodes
+   first if pA is not the last one encoded, the fastest run does not count
+   that. the noise of Alloc() is the worst case of the coder */
+static u8		*lNqi;
+static int		*lNqiLen;
+static const u8		*lNqiSrc;
+
+static long Nqi(tPic *pD, tPic *pA, int Bpp, bool Dec)
+{
+  tNqi		q;
+  int		y,b;
+
+  Nqi_Init(&q,pD->Dx,Bpp);
+  b=Nqi_Bound(&q);
+  if(!Dec || lNqiSrc!=pA->Pel){
+    free(lNqi);
+    free(lNqiLen);
+    lNqi=malloc((size_t)b*pA->Dy);
+    lNqiLen=malloc(sizeof(int)*pA->Dy);
+    for(y=0;y<pA->Dy;y++)
+      lNqiLen[y]=Nqi_EncodeRow(&q,lNqi+(size_t)b*y,pA->Pel+(long)y*pA->S,
+			       y?pA->Pel+(long)(y-1)*pA->S:NULL);
+    lNqiSrc=pA->Pel;
+  }
+  if(Dec)
+    for(y=0;y<pD->Dy;y++)
+      if(Nqi_DecodeRow(&q,pD->Pel+(long)y*pD->S,
+		       y?pD->Pel+(long)(y-1)*pD->S:NULL,lNqi+(size_t)b*y,
+		       lNqiLen[y])<0)
+	ERROR("nqi decode failed");
+  Nqi_Free(&q);
+  return PELS(pD);
+}
+
+static long R_Nqi8_Encode(tPic *pD, tPic *pA, tPic *pB)
+{ (void)pB; return Nqi(pD,pA,1,FALSE); }
+static long R_Nqi8_Decode(tPic *pD, tPic *pA, tPic *pB)
+{ (void)pB; return Nqi(pD,pA,1,TRUE); }
+static long R_Nqi16_Encode(tPic *pD, tPic *pA, tPic *pB)
+{ (void)pB; return Nqi(pD,pA,2,FALSE); }
+static long R_Nqi16_Decode(tPic *pD, tPic *pA, tPic *pB)
+{ (void)pB; return Nqi(pD,pA,2,TRUE); }
+static long R_Nqi32_Encode(tPic *pD, tPic *pA, tPic *pB)
+{ (void)pB; return Nqi(pD,pA,4,FALSE); }
+static long R_Nqi32_Decode(tPic *pD, tPic *pA, tPic *pB)
+{ (void)pB; return Nqi(pD,pA,4,TRUE); }
+
+/* YUV to RGB: pA is the Y plane and holds U and V side by side in its
+   upper half, that is 1.5 source bytes per pel */
+static long Yuv(tPic *pD, tPic *pA, int Fmt)
+{
+  tYuv		s;
+  int		cx=(pA->Dx+1)/2,cy=(pA->Dy+1)/2;
+
+  s.Dx=pA->Dx;  s.Dy=pA->Dy;
+  s.C[0]=*pA;
+  Pic_Create(&s.C[1],pA->S,cx,cy,pA->Pel);
+  Pic_Create(&s.C[2],pA->S,cx,cy,pA->Pel+pA->Dx/2);
+  if(Fmt==0)
+    Pic32_BGRXfromYuv(pD,&s,PIC_BT709);
+  else
+    Pic16_RGB565fromYuv(pD,&s,PIC_BT709);
+  return PELS(pD);
+}
+
+static long R_Pic32_BGRXfromYuv(tPic *pD, tPic *pA, tPic *pB)
+{ (void)pB; return Yuv(pD,pA,0); }
+static long R_Pic16_RGB565fromYuv(tPic *pD, tPic *pA, tPic *pB)
+{ (void)pB; return Yuv(pD,pA,1); }
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+#define K(f,d,a,b,n)	{ #f, d,a,b, n, R_##f }
+
+static const tKernel	lKernel[]={
+  K(Pic8_Copy,		1,1,0,2),
+  K(Pic8_Set,		1,0,0,1),
+  K(Pic8_Clear,		1,0,0,1),
+  K(Pic8_ShiftLeft,	1,0,0,2),
+  K(Pic8_Pad,		1,0,0,1),
+  K(Pic8_CopyU16Shr,	1,2,0,3),
+  K(Pic8_Sad8,		1,1,1,3),
+  K(Pic8_Sad16,		1,2,2,5),
+  K(Pic8_Sad32,		1,4,4,9),
+  K(Pic16_Copy,		2,2,0,4),
+  K(Pic16_Set,		2,0,0,2),
+  K(Pic16_ShiftLeft,	2,0,0,4),
+  K(Pic16_CopyU32Shr,	2,4,0,6),
+  K(Pic16_Pack4444,	2,4,0,6),
+  K(Pic16_Pack565_XRGB,	2,4,0,6),
+  K(Pic16_Pack565_RGBX,	2,4,0,6),
+  K(Pic16_BGRfromU8,	2,1,0,3),
+  K(Pic16_RGB565fromYuv,2,1,0,4),
+  K(Pic16_DrawRect,	2,0,0,2),
+  K(Pic16_DrawCross,	2,0,0,2),
+  K(Pic16_DrawLine,	2,0,0,2),
+  K(Pic24_Copy,		3,3,0,6),
+  K(Pic24_RGBfromRGBX,	3,4,0,7),
+  K(Pic24_BGRfromRGBX,	3,4,0,7),
+  K(Pic32_Copy,		4,4,0,8),
+  K(Pic32_Set,		4,0,0,4),
+  K(Pic32_GenAlpha,	4,0,0,5),
+  K(Pic32_CopyU16Shl,	4,2,0,6),
+  K(Pic32_UnPack565,	4,2,0,6),
+  K(Pic32_RGBXfromU8,	4,1,0,5),
+  K(Pic32_RGBXfromRGB,	4,3,0,7),
+  K(Pic32_RGBXfromBGR,	4,3,0,7),
+  K(Pic32_XBGRfromU8,	4,1,0,5),
+  K(Pic32_BGRXfromYuv,	4,1,0,6),
+  K(Pic32_DrawRect,	4,0,0,4),
+  K(Pic32_DrawLine,	4,0,0,4),
+  K(Pic_HorFlip,	4,0,0,8),
+  K(Nqi8_Encode,	1,1,0,1),
+  K(Nqi8_Decode,	1,1,0,1),
+  K(Nqi16_Encode,	2,2,0,2),
+  K(Nqi16_Decode,	2,2,0,2),
+  K(Nqi32_Encode,	4,4,0,4),
+  K(Nqi32_Decode,	4,4,0,4),
+};
+
+static const tSize	lSize[]={
+  {"QVGA",  320, 240},
+  {"VGA",   640, 480},
+  {"HD",   1280, 720},
+  {"FHD",  1920,1080},
+  {"4K",   3840,2160},
+  {"8K",   7680,4320},
+};
+
+static const char	*lLayout[]={"packed","pad","odd"};
+
+static tOut		lOut=OUT_TEXT;
+static int		lFirst=TRUE;
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  allocate a pic with Bpp bytes per pel in one of the layouts, with PADM
+ *  pels of margin on all sides for Pic8_Pad(), filled with noise
+ */
+static void Alloc(tBuf *pb, int Dx, int Dy, int Bpp, int Layout)
+{
+  int		s,off;
+  size_t	n,i;
+  u32		r=12345;
+
+  s=Dx*Bpp;
+  off=0;
+  if(Layout==1)
+    s=(s+63)/64*64+64;
+  else if(Layout==2){
+    s+=Bpp;
+    off=Bpp;
+  }
+
+  n=(size_t)s*(Dy+2*PADM)+2*PADM*Bpp+128;
+  if(posix_memalign((void**)&pb->pMem,64,n))
+    ERROR("out of memory");
+  for(i=0;i<n/4;i++){
+    r=r*1664525+1013904223;
+    ((u32*)pb->pMem)[i]=r;
+  }
+  Pic_Create(&pb->Pic,s,Dx,Dy,pb->pMem+(size_t)PADM*s+PADM*Bpp+64+off);
+}
+
+
+/****************************************************************************/
+/*  is Name (or contains it, if Sub) one of the selections, or is there none
+ */
+static bool Selected(const char *Name, const char **ppSel, int N, bool Sub)
+{
+  int		i;
+
+  for(i=0;i<N;i++)
+    if(Sub?strstr(Name,ppSel[i])!=NULL:strcmp(Name,ppSel[i])==0)
+      return TRUE;
+
+  return N==0;
+}
+
+
+static void Print(const tKernel *pk, const tSize *ps, int Layout, int S,
+		  double Ms, long Pels)
+{
+  double	mpix=Pels/Ms/1000.0,gbs=(double)Pels*pk->Bytes/Ms/1e6;
+
+  switch(lOut){
+  case OUT_TEXT:
+    if(lFirst)
+      printf("%-20s %-5s %-6s %6s %9s %9s %8s\n",
+	     "kernel","size","layout","stride","ms","Mpix/s","GB/s");
+    printf("%-20s %-5s %-6s %6d %9.3f %9.1f %8.2f\n",
+	   pk->Name,ps->Name,lLayout[Layout],S,Ms,mpix,gbs);
+    break;
+  case OUT_CSV:
+    if(lFirst)
+      printf("kernel,size,dx,dy,layout,stride,ms,mpix_s,gb_s\n");
+    printf("%s,%s,%d,%d,%s,%d,%.4f,%.2f,%.3f\n",pk->Name,ps->Name,
+	   ps->Dx,ps->Dy,lLayout[Layout],S,Ms,mpix,gbs);
+    break;
+  case OUT_JSON:
+    printf("%s\n  {\"kernel\":\"%s\",\"size\":\"%s\",\"dx\":%d,\"dy\":%d,"
+	   "\"layout\":\"%s\",\"stride\":%d,\"ms\":%.4f,\"mpix_s\":%.2f,"
+	   "\"gb_s\":%.3f}",lFirst?"[":",",pk->Name,ps->Name,ps->Dx,ps->Dy,
+	   lLayout[Layout],S,Ms,mpix,gbs);
+    break;
+  }
+  lFirst=FALSE;
+  fflush(stdout);
+}
+
+
+/****************************************************************************/
+/*  run one kernel for one size and layout, report the fastest run
+ */
+static void Bench(const tKernel *pk, const tSize *ps, int Layout, double MinMs)
+{
+  tBuf		d,a,b;
+  tTimer	t;
+  double	ms,best=1e30,total=0;
+  long		pels=0;
+  int		n;
+
+  Alloc(&d,ps->Dx,ps->Dy,pk->DBpp,Layout);
+  if(pk->ABpp) Alloc(&a,ps->Dx,ps->Dy,pk->ABpp,Layout);
+  if(pk->BBpp) Alloc(&b,ps->Dx,ps->Dy,pk->BBpp,Layout);
+
+  for(n=0;n<3 || total<MinMs;n++){
+    startTimer(&t);
+    pels=pk->Run(&d.Pic,pk->ABpp?&a.Pic:NULL,pk->BBpp?&b.Pic:NULL);
+    ms=stopTimer(&t);
+    best=MIN(best,ms);
+    total+=ms;
+  }
+  Print(pk,ps,Layout,d.Pic.S,best,pels);
+
+  free(d.pMem);
+  if(pk->ABpp) free(a.pMem);
+  if(pk->BBpp) free(b.pMem);
+}
+
+
+/*****************************************************************************
+ *  main
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  const char	*kSel[MAXSEL],*sSel[MAXSEL],*lSel[MAXSEL];
+  int		nk=0,ns=0,nl=0,i,j,l;
+  double	minMs=50;
+
+  for(i=1;i<argc;i++){
+    if(strcmp(argv[i],"-csv")==0)
+      lOut=OUT_CSV;
+    else if(strcmp(argv[i],"-json")==0)
+      lOut=OUT_JSON;
+    else if(i+1<argc && strcmp(argv[i],"-k")==0 && nk<MAXSEL)
+      kSel[nk++]=argv[++i];
+    else if(i+1<argc && strcmp(argv[i],"-s")==0 && ns<MAXSEL)
+      sSel[ns++]=argv[++i];
+    else if(i+1<argc && strcmp(argv[i],"-l")==0 && nl<MAXSEL)
+      lSel[nl++]=argv[++i];
+    else if(i+1<argc && strcmp(argv[i],"-t")==0)
+      minMs=atof(argv[++i]);
+    else
+      ERROR("usage: %s [-csv|-json] [-k kernel] [-s size] [-l layout] "
+	    "[-t ms]",argv[0]);
+  }
+
+  for(i=0;i<(int)LEN(lKernel);i++){
+    if(!Selected(lKernel[i].Name,kSel,nk,TRUE))
+      continue;
+    for(j=0;j<(int)LEN(lSize);j++){
+      if(!Selected(lSize[j].Name,sSel,ns,FALSE))
+	continue;
+      for(l=0;l<(int)LEN(lLayout);l++)
+	if(Selected(lLayout[l],lSel,nl,FALSE))
+	  Bench(&lKernel[i],&lSize[j],l,minMs);
+    }
+  }
+  if(lOut==OUT_JSON)
+    printf(lFirst?"[]\n":"\n]\n");
+
+  return 0;
+}
@@ -0,0 +1,263 @@
+/* -*- tab-width: 8 -*- */
+/** 
+ *  benchmark: throughput of tSpsc and tMpsc with 1..8 producers and round
+ *  trip latency, against a queue with a mutex and condition variables
+ *
+ *	bench_queue [items]
+ *
+ *  \file      bench_queue.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"nuts/queue.h"
+#include	"nuts/debug.h"
+#include	"nuts/timer.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<pthread.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define CAP		1024		/* queue capacity */
+#define MAXPROD		8
+#define ROUNDS		100000		/* latency round trips */
+
+
+/*****************************************************************************
+ *  local types
+ ****************************************************************************/
+
+/* the hand rolled queue this is compared to */
+typedef struct {
+  pthread_mutex_t	Mutex;
+  pthread_cond_t	NotEmpty;
+  pthread_cond_t	NotFull;
+  void			*Buf[CAP];
+  int			Head,N;
+} tLockQ;
+
+typedef enum { Q_SPSC, Q_MPSC, Q_LOCK } tKind;
+
+typedef struct {
+  tKind			Kind;
+  tSpsc			Spsc[2];
+  tMpsc			Mpsc[2];
+  tLockQ		Lock[2];
+  long			N;		/* items per producer */
+} tBench;
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+static void LockQ_Init(tLockQ *q)
+{
+  pthread_mutex_init(&q->Mutex,NULL);
+  pthread_cond_init(&q->NotEmpty,NULL);
+  pthread_cond_init(&q->NotFull,NULL);
+  q->Head=q->N=0;
+}
+
+static void LockQ_Push(tLockQ *q, void *p)
+{
+  pthread_mutex_lock(&q->Mutex);
+  while(q->N==CAP)
+    pthread_cond_wait(&q->NotFull,&q->Mutex);
+  q->Buf[(q->Head+q->N++)%CAP]=p;
+  pthread_cond_signal(&q->NotEmpty);
+  pthread_mutex_unlock(&q->Mutex);
+}
+
+static void *LockQ_Pop(tLockQ *q)
+{
+  void		*p;
+
+  pthread_mutex_lock(&q->Mutex);
+  while(!q->N)
+    pthread_cond_wait(&q->NotEmpty,&q->Mutex);
+  p=q->Buf[q->Head];
+  q->Head=(q->Head+1)%CAP;
+  q->N--;
+  pthread_cond_broadcast(&q->NotFull);
+  pthread_mutex_unlock(&q->Mutex);
+
+  return p;
+}
+
+
+/****************************************************************************/
+/*  blocking push/pop on queue i of a bench
+ */
+static void Push(tBench *pb, int i, void *p)
+{
+  switch(pb->Kind){
+  case Q_SPSC: Spsc_PushWait(&pb->Spsc[i],p,-1); break;
+  case Q_MPSC: Mpsc_PushWait(&pb->Mpsc[i],p,-1); break;
+  case Q_LOCK: LockQ_Push(&pb->Lock[i],p);	 break;
+  }
+}
+
+static void *Pop(tBench *pb, int i)
+{
+  switch(pb->Kind){
+  case Q_SPSC: return Spsc_PopWait(&pb->Spsc[i],-1);
+  case Q_MPSC: return Mpsc_PopWait(&pb->Mpsc[i],-1);
+  default:     return LockQ_Pop(&pb->Lock[i]);
+  }
+}
+
+
+/****************************************************************************/
+/*  producer of the throughput test
+ */
+static void *Producer(void *p)
+{
+  tBench	*pb=p;
+  long		i;
+
+  for(i=1;i<=pb->N;i++)
+    Push(pb,0,(void*)i);
+
+  return NULL;
+}
+
+
+/****************************************************************************/
+/*  echo thread of the latency test
+ */
+static void *Echo(void *p)
+{
+  tBench	*pb=p;
+  int		i;
+
+  for(i=0;i<ROUNDS;i++)
+    Push(pb,1,Pop(pb,0));
+
+  return NULL;
+}
+
+
+static void Init(tBench *pb, tKind Kind)
+{
+  int		i;
+
+  pb->Kind=Kind;
+  for(i=0;i<2;i++){
+    Spsc_Init(&pb->Spsc[i],CAP);
+    Mpsc_Init(&pb->Mpsc[i],CAP);
+    LockQ_Init(&pb->Lock[i]);
+  }
+}
+
+static void Exit(tBench *pb)
+{
+  int		i;
+
+  for(i=0;i<2;i++){
+    Spsc_Free(&pb->Spsc[i]);
+    Mpsc_Free(&pb->Mpsc[i]);
+  }
+}
+
+
+/****************************************************************************/
+/*  million items per second with NProd producers
+ */
+static double Throughput(tKind Kind, int NProd, long Items)
+{
+  tBench	*pb=calloc(1,sizeof(tBench));
+  pthread_t	th[MAXPROD];
+  tTimer	t;
+  long		i,n=Items/NProd,sum=0;
+  double	ms;
+
+  Init(pb,Kind);
+  pb->N=n;
+
+  startTimer(&t);
+  for(i=0;i<NProd;i++)
+    pthread_create(&th[i],NULL,Producer,pb);
+  for(i=0;i<n*NProd;i++)
+    sum+=(long)Pop(pb,0);
+  for(i=0;i<NProd;i++)
+    pthread_join(th[i],NULL);
+  ms=stopTimer(&t);
+  MUST_Eq(sum,NProd*n*(n+1)/2);
+
+  Exit(pb);
+  free(pb);
+
+  return n*NProd/ms/1000.0;
+}
+
+
+static int CmpU64(const void *a, const void *b)
+{
+  return *(const u64*)a<*(const u64*)b?-1:*(const u64*)a>*(const u64*)b;
+}
+
+
+/****************************************************************************/
+/*  round trip latency median and 99% in ns
+ */
+static void Latency(tKind Kind, u64 *pMed, u64 *pP99)
+{
+  tBench	*pb=calloc(1,sizeof(tBench));
+  u64		*lat=malloc(ROUNDS*sizeof(u64)),t0;
+  pthread_t	th;
+  int		i;
+
+  Init(pb,Kind);
+  pthread_create(&th,NULL,Echo,pb);
+  for(i=0;i<ROUNDS;i++){
+    t0=timerNs();
+    Push(pb,0,(void*)1);
+    Pop(pb,1);
+    lat[i]=timerNs()-t0;
+  }
+  pthread_join(th,NULL);
+
+  qsort(lat,ROUNDS,sizeof(u64),CmpU64);
+  *pMed=lat[ROUNDS/2];
+  *pP99=lat[ROUNDS*99/100];
+
+  Exit(pb);
+  free(pb);
+  free(lat);
+}
+
+
+/*****************************************************************************
+ *  main
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  long		items=argc>1?atol(argv[1]):4000000;
+  u64		med,p99;
+  int		n;
+
+  printf("throughput, million items/s (%ld items, capacity %d)\n",items,CAP);
+  printf("%-10s %10s %10s\n","producers","lock free","mutex");
+  printf("%-10s %10.2f %10.2f\n","1 (spsc)",
+	 Throughput(Q_SPSC,1,items),Throughput(Q_LOCK,1,items));
+  for(n=1;n<=MAXPROD;n*=2)
+    printf("%-10d %10.2f %10.2f\n",n,
+	   Throughput(Q_MPSC,n,items),Throughput(Q_LOCK,n,items));
+
+  printf("\nround trip latency, ns (median / 99%%)\n");
+  Latency(Q_SPSC,&med,&p99);
+  printf("%-10s %10llu %10llu\n","spsc",med,p99);
+  Latency(Q_MPSC,&med,&p99);
+  printf("%-10s %10llu %10llu\n","mpsc",med,p99);
+  Latency(Q_LOCK,&med,&p99);
+  printf("%-10s %10llu %10llu\n","mutex",med,p99);
+
+  return 0;
+}
@@ -0,0 +1,565 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  bulk byte swapping, 3<->4 byte pel conversion and (de)interleaving of
+ *  YUV chroma, see bits.h. on x86
+ *  the arrays are processed 16 bytes at a time with pshufb if the cpu has
+ *  SSSE3 (checked at runtime). swaps fall back to SSE2 shifts and
+ *  shuffles, the tails and other cpus use scalar code.
+ *
+ *  \file      bits.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"bits.h"
+#include	"debug.h"
+#include	<string.h>
+#if defined __x86_64__ || (defined __i386__ && defined __SSE2__)
+#define SIMD_X86
+#include	<emmintrin.h>
+#include	<tmmintrin.h>
+#endif
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+#ifdef SIMD_X86
+
+#define SSSE3		__attribute__((target("ssse3")))
+
+/****************************************************************************/
+/*  swap N elements of size 1<<Log2 with pshufb, returns the number done
+ */
+static SSSE3 int SwapSsse3(u8 *pDst, const u8 *pSrc, int N, int Log2)
+{
+  static const u8	lShuf[3][16]={
+    {1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14},
+    {3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12},
+    {7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8}};
+  __m128i	shuf=_mm_loadu_si128((const __m128i*)lShuf[Log2-1]),a,b;
+  int		i,n=(N<<Log2)&~31;
+
+  for(i=0;i<n;i+=32){
+    a=_mm_loadu_si128((const __m128i*)(pSrc+i));
+    b=_mm_loadu_si128((const __m128i*)(pSrc+i+16));
+    _mm_storeu_si128((__m128i*)(pDst+i),_mm_shuffle_epi8(a,shuf));
+    _mm_storeu_si128((__m128i*)(pDst+i+16),_mm_shuffle_epi8(b,shuf));
+  }
+
+  return n>>Log2;
+}
+
+
+/****************************************************************************/
+/*  the same with SSE2: swap the bytes of each word, then the words
+ */
+static int SwapSse2(u8 *pDst, const u8 *pSrc, int N, int Log2)
+{
+  __m128i	a;
+  int		i,n=(N<<Log2)&~15;
+
+  for(i=0;i<n;i+=16){
+    a=_mm_loadu_si128((const __m128i*)(pSrc+i));
+    a=_mm_or_si128(_mm_slli_epi16(a,8),_mm_srli_epi16(a,8));
+    if(Log2>=2){
+      a=_mm_shufflelo_epi16(a,_MM_SHUFFLE(2,3,0,1));
+      a=_mm_shufflehi_epi16(a,_MM_SHUFFLE(2,3,0,1));
+    }
+    if(Log2==3)
+      a=_mm_shuffle_epi32(a,_MM_SHUFFLE(2,3,0,1));
+    _mm_storeu_si128((__m128i*)(pDst+i),a);
+  }
+
+  return n>>Log2;
+}
+
+
+
+/****************************************************************************/
+/*  4 byte pels to 3 bytes with pshufb, 4 pels per step. stores 16 bytes,
+ *  so it stops while there is room for that. returns the number done
+ */
+static SSSE3 int Pack4to3Ssse3(u8 *pDst, const u8 *pSrc, int N,
+			       const u8 *pOrd)
+{
+  u8		m[16];
+  __m128i	shuf;
+  int		i,k;
+
+  for(i=0;i<4;i++){
+    for(k=0;k<3;k++)
+      m[3*i+k]=4*i+pOrd[k];
+    m[12+i]=0x80;
+  }
+  shuf=_mm_loadu_si128((const __m128i*)m);
+
+  for(i=0;i+6<=N;i+=4)
+    _mm_storeu_si128((__m128i*)(pDst+3*i),
+		     _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)
+						      (pSrc+4*i)),shuf));
+  return i;
+}
+
+
+/****************************************************************************/
+/*  3 byte pels to 4 bytes with pshufb, 4 pels per step. loads 16 bytes,
+ *  so it stops while there are that many. returns the number done
+ */
+static SSSE3 int Expand3to4Ssse3(u8 *pDst, const u8 *pSrc, int N,
+				 const u8 *pOrd)
+{
+  u8		m[16];
+  __m128i	shuf;
+  int		i,k;
+
+  for(i=0;i<4;i++)
+    for(k=0;k<4;k++)
+      m[4*i+k]=pOrd[k]>2?0x80:3*i+pOrd[k];
+  shuf=_mm_loadu_si128((const __m128i*)m);
+
+  for(i=0;i+6<=N;i+=4)
+    _mm_storeu_si128((__m128i*)(pDst+4*i),
+		     _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)
+						      (pSrc+3*i)),shuf));
+  return i;
+}
+
+
+
+/****************************************************************************/
+/*  big endian words to native and shift left, SSE2, 8 pels per step
+ */
+static int Be16ShlSse2(u16 *pDst, const u8 *pSrc, int N, int Shift)
+{
+  __m128i	a,sh=_mm_cvtsi32_si128(Shift);
+  int		i;
+
+  for(i=0;i+8<=N;i+=8){
+    a=_mm_loadu_si128((const __m128i*)(pSrc+2*i));
+    a=_mm_or_si128(_mm_slli_epi16(a,8),_mm_srli_epi16(a,8));
+    _mm_storeu_si128((__m128i*)(pDst+i),_mm_sll_epi16(a,sh));
+  }
+  return i;
+}
+
+
+/****************************************************************************/
+/*  bytes to words and shift left, SSE2, 16 pels per step
+ */
+static int U8to16ShlSse2(u16 *pDst, const u8 *pSrc, int N, int Shift)
+{
+  __m128i	a,z=_mm_setzero_si128(),sh=_mm_cvtsi32_si128(Shift);
+  int		i;
+
+  for(i=0;i+16<=N;i+=16){
+    a=_mm_loadu_si128((const __m128i*)(pSrc+i));
+    _mm_storeu_si128((__m128i*)(pDst+i),
+		     _mm_sll_epi16(_mm_unpacklo_epi8(a,z),sh));
+    _mm_storeu_si128((__m128i*)(pDst+i+8),
+		     _mm_sll_epi16(_mm_unpackhi_epi8(a,z),sh));
+  }
+  return i;
+}
+
+
+
+/****************************************************************************/
+/*  Bits_Interleave2(), SSE2, 16 pairs per step
+ */
+static int Interleave2Sse2(u8 *pDst, const u8 *pA, const u8 *pB, int N)
+{
+  __m128i	a,b;
+  int		i;
+
+  for(i=0;i+16<=N;i+=16){
+    a=_mm_loadu_si128((const __m128i*)(pA+i));
+    b=_mm_loadu_si128((const __m128i*)(pB+i));
+    _mm_storeu_si128((__m128i*)(pDst+2*i),_mm_unpacklo_epi8(a,b));
+    _mm_storeu_si128((__m128i*)(pDst+2*i+16),_mm_unpackhi_epi8(a,b));
+  }
+  return i;
+}
+
+
+/****************************************************************************/
+/*  split 32 bytes into the even (*pA) and odd (*pB) ones
+ */
+static inline void Split(__m128i *pA, __m128i *pB, __m128i s0, __m128i s1)
+{
+  __m128i	m=_mm_set1_epi16(0xff);
+
+  *pA=_mm_packus_epi16(_mm_and_si128(s0,m),_mm_and_si128(s1,m));
+  *pB=_mm_packus_epi16(_mm_srli_epi16(s0,8),_mm_srli_epi16(s1,8));
+}
+
+
+/****************************************************************************/
+/*  Bits_Deinterleave2(), SSE2, 16 pairs per step
+ */
+static int Deinterleave2Sse2(u8 *pA, u8 *pB, const u8 *pSrc, int N)
+{
+  __m128i	a,b;
+  int		i;
+
+  for(i=0;i+16<=N;i+=16){
+    Split(&a,&b,_mm_loadu_si128((const __m128i*)(pSrc+2*i)),
+	  _mm_loadu_si128((const __m128i*)(pSrc+2*i+16)));
+    _mm_storeu_si128((__m128i*)(pA+i),a);
+    _mm_storeu_si128((__m128i*)(pB+i),b);
+  }
+  return i;
+}
+
+
+/****************************************************************************/
+/*  Bits_PackYuyv(), SSE2, 16 pel pairs (64 bytes) per step
+ */
+static int PackYuyvSse2(u8 *pDst, const u8 *pY, const u8 *pU, const u8 *pV,
+			int N, bool Uyvy)
+{
+  __m128i	y0,y1,c0,c1,u,v;
+  int		i;
+
+#define ST(o,v)	_mm_storeu_si128((__m128i*)(pDst+4*i+(o)),v)
+  for(i=0;i+16<=N;i+=16){
+    y0=_mm_loadu_si128((const __m128i*)(pY+2*i));
+    y1=_mm_loadu_si128((const __m128i*)(pY+2*i+16));
+    u=_mm_loadu_si128((const __m128i*)(pU+i));
+    v=_mm_loadu_si128((const __m128i*)(pV+i));
+    c0=_mm_unpacklo_epi8(u,v);
+    c1=_mm_unpackhi_epi8(u,v);
+    if(Uyvy){
+      ST(0,_mm_unpacklo_epi8(c0,y0));
+      ST(16,_mm_unpackhi_epi8(c0,y0));
+      ST(32,_mm_unpacklo_epi8(c1,y1));
+      ST(48,_mm_unpackhi_epi8(c1,y1));
+    }
+    else{
+      ST(0,_mm_unpacklo_epi8(y0,c0));
+      ST(16,_mm_unpackhi_epi8(y0,c0));
+      ST(32,_mm_unpacklo_epi8(y1,c1));
+      ST(48,_mm_unpackhi_epi8(y1,c1));
+    }
+  }
+#undef ST
+  return i;
+}
+
+
+/****************************************************************************/
+/*  Bits_UnpackYuyv(), SSE2, 16 pel pairs per step
+ */
+static int UnpackYuyvSse2(u8 *pY, u8 *pU, u8 *pV, const u8 *pSrc, int N,
+			  bool Uyvy)
+{
+  __m128i	s[4],y0,y1,c0,c1,u,v;
+  int		i,k;
+
+  for(i=0;i+16<=N;i+=16){
+    for(k=0;k<4;k++)
+      s[k]=_mm_loadu_si128((const __m128i*)(pSrc+4*i+16*k));
+    if(Uyvy){
+      Split(&c0,&y0,s[0],s[1]);
+      Split(&c1,&y1,s[2],s[3]);
+    }
+    else{
+      Split(&y0,&c0,s[0],s[1]);
+      Split(&y1,&c1,s[2],s[3]);
+    }
+    Split(&u,&v,c0,c1);
+    _mm_storeu_si128((__m128i*)(pY+2*i),y0);
+    _mm_storeu_si128((__m128i*)(pY+2*i+16),y1);
+    _mm_storeu_si128((__m128i*)(pU+i),u);
+    _mm_storeu_si128((__m128i*)(pV+i),v);
+  }
+  return i;
+}
+
+#endif /* SIMD_X86 */
+
+
+/****************************************************************************/
+/*  vector part of all swaps, returns the number of elements done
+ */
+static int SwapSimd(void *pDst, const void *pSrc, int N, int Log2)
+{
+  ;   MUST(N>=0);
+#ifdef SIMD_X86
+  if(__builtin_cpu_supports("ssse3"))
+    return SwapSsse3(pDst,pSrc,N,Log2);
+  return SwapSse2(pDst,pSrc,N,Log2);
+#else
+  (void)pDst; (void)pSrc; (void)N; (void)Log2;
+  return 0;
+#endif
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/** swap the bytes of an array of 16 bit values, e.g. big endian file data
+ *  to native. pDst==pSrc is fine, other overlaps are not. any alignment
+ *
+ *  \param  pDst destination
+ *  \param  pSrc source
+ *  \param  N    number of values
+ */
+void Bits_Swap16(void *pDst, const void *pSrc, int N)
+{
+  u8		*pd=pDst;
+  const u8	*ps=pSrc;
+  u16		v;
+  int		i;
+
+  for(i=SwapSimd(pDst,pSrc,N,1);i<N;i++){
+    memcpy(&v,ps+2*i,2);
+    v=__builtin_bswap16(v);
+    memcpy(pd+2*i,&v,2);
+  }
+}
+
+
+/****************************************************************************/
+/** as Bits_Swap16() for 32 bit values
+ *
+ *  \param  pDst destination
+ *  \param  pSrc source
+ *  \param  N    number of values
+ */
+void Bits_Swap32(void *pDst, const void *pSrc, int N)
+{
+  u8		*pd=pDst;
+  const u8	*ps=pSrc;
+  u32		v;
+  int		i;
+
+  for(i=SwapSimd(pDst,pSrc,N,2);i<N;i++){
+    memcpy(&v,ps+4*i,4);
+    v=__builtin_bswap32(v);
+    memcpy(pd+4*i,&v,4);
+  }
+}
+
+
+/****************************************************************************/
+/** as Bits_Swap16() for 64 bit values
+ *
+ *  \param  pDst destination
+ *  \param  pSrc source
+ *  \param  N    number of values
+ */
+void Bits_Swap64(void *pDst, const void *pSrc, int N)
+{
+  u8		*pd=pDst;
+  const u8	*ps=pSrc;
+  u64		v;
+  int		i;
+
+  for(i=SwapSimd(pDst,pSrc,N,3);i<N;i++){
+    memcpy(&v,ps+8*i,8);
+    v=__builtin_bswap64(v);
+    memcpy(pd+8*i,&v,8);
+  }
+}
+
+
+/****************************************************************************/
+/** pack pels of 4 bytes to 3 bytes, e.g. XRGB in memory to a ppm line
+ *
+ *	u8 xrgb[3]={1,2,3};
+ *	Bits_Pack4to3(line,pp,dx,xrgb);
+ *
+ *  \param  pDst  destination, 3*N bytes
+ *  \param  pSrc  source, 4*N bytes
+ *  \param  N     number of pels
+ *  \param  pOrd  for each of the 3 destination bytes the source byte 0..3
+ */
+void Bits_Pack4to3(void *pDst, const void *pSrc, int N, const u8 *pOrd)
+{
+  u8		*pd=pDst;
+  const u8	*ps=pSrc;
+  int		i=0;
+
+#ifdef SIMD_X86
+  if(__builtin_cpu_supports("ssse3"))
+    i=Pack4to3Ssse3(pd,ps,N,pOrd);
+#endif
+  for(;i<N;i++){
+    pd[3*i+0]=ps[4*i+pOrd[0]];
+    pd[3*i+1]=ps[4*i+pOrd[1]];
+    pd[3*i+2]=ps[4*i+pOrd[2]];
+  }
+}
+
+
+/****************************************************************************/
+/** expand pels of 3 bytes to 4 bytes, e.g. a ppm line to XRGB in memory
+ *
+ *  \param  pDst  destination, 4*N bytes
+ *  \param  pSrc  source, 3*N bytes
+ *  \param  N     number of pels
+ *  \param  pOrd  for each of the 4 destination bytes the source byte 0..2,
+ *                or 0xff for a 0
+ */
+void Bits_Expand3to4(void *pDst, const void *pSrc, int N, const u8 *pOrd)
+{
+  u8		*pd=pDst;
+  const u8	*ps=pSrc;
+  int		i=0,k;
+
+#ifdef SIMD_X86
+  if(__builtin_cpu_supports("ssse3"))
+    i=Expand3to4Ssse3(pd,ps,N,pOrd);
+#endif
+  for(;i<N;i++)
+    for(k=0;k<4;k++)
+      pd[4*i+k]=pOrd[k]>2?0:ps[3*i+pOrd[k]];
+}
+
+
+/****************************************************************************/
+/** convert big endian 16 bit values (e.g. pgm data) to native and shift
+ *  them left. pDst==pSrc is fine
+ *
+ *  \param  pDst  destination, N u16
+ *  \param  pSrc  source, 2*N bytes
+ *  \param  N     number of values
+ *  \param  Shift left shift, bits above 16 are lost
+ */
+void Bits_Be16Shl(u16 *pDst, const void *pSrc, int N, int Shift)
+{
+  const u8	*ps=pSrc;
+  int		i=0;
+
+#ifdef SIMD_X86
+  i=Be16ShlSse2(pDst,ps,N,Shift);
+#endif
+  for(;i<N;i++)
+    pDst[i]=(ps[2*i]<<8|ps[2*i+1])<<Shift;
+}
+
+
+/****************************************************************************/
+/** widen bytes to 16 bit values and shift them left
+ *
+ *  \param  pDst  destination, N u16
+ *  \param  pSrc  source, N bytes, must not overlap pDst
+ *  \param  N     number of values
+ *  \param  Shift left shift, bits above 16 are lost
+ */
+void Bits_U8to16Shl(u16 *pDst, const u8 *pSrc, int N, int Shift)
+{
+  int		i=0;
+
+#ifdef SIMD_X86
+  i=U8to16ShlSse2(pDst,pSrc,N,Shift);
+#endif
+  for(;i<N;i++)
+    pDst[i]=pSrc[i]<<Shift;
+}
+
+
+/****************************************************************************/
+/** interleave two byte arrays, e.g. the U and V planes of I420 to the
+ *  chroma of NV12 (or V and U to NV21)
+ *
+ *  \param  pDst destination, 2*N bytes
+ *  \param  pA   source of the even bytes, N bytes
+ *  \param  pB   source of the odd bytes
+ *  \param  N    number of pairs
+ */
+void Bits_Interleave2(u8 *pDst, const u8 *pA, const u8 *pB, int N)
+{
+  int		i=0;
+
+#ifdef SIMD_X86
+  i=Interleave2Sse2(pDst,pA,pB,N);
+#endif
+  for(;i<N;i++){
+    pDst[2*i]=pA[i];
+    pDst[2*i+1]=pB[i];
+  }
+}
+
+
+/****************************************************************************/
+/** split a byte array into its even and odd bytes, e.g. NV12 chroma to
+ *  the U and V planes of I420
+ *
+ *  \param  pA   destination of the even bytes, N bytes
+ *  \param  pB   destination of the odd bytes
+ *  \param  pSrc source, 2*N bytes
+ *  \param  N    number of pairs
+ */
+void Bits_Deinterleave2(u8 *pA, u8 *pB, const u8 *pSrc, int N)
+{
+  int		i=0;
+
+#ifdef SIMD_X86
+  i=Deinterleave2Sse2(pA,pB,pSrc,N);
+#endif
+  for(;i<N;i++){
+    pA[i]=pSrc[2*i];
+    pB[i]=pSrc[2*i+1];
+  }
+}
+
+
+/****************************************************************************/
+/** pack a line of pel pairs as YUYV (Y0 U Y1 V) or UYVY (U Y0 V Y1)
+ *
+ *  \param  pDst destination, 4*N bytes
+ *  \param  pY   2*N luma samples
+ *  \param  pU   N chroma samples
+ *  \param  pV   N chroma samples
+ *  \param  N    number of pel pairs
+ *  \param  Uyvy UYVY, else YUYV
+ */
+void Bits_PackYuyv(u8 *pDst, const u8 *pY, const u8 *pU, const u8 *pV, int N,
+		   bool Uyvy)
+{
+  int		i=0,y=Uyvy?1:0,c=Uyvy?0:1;
+
+#ifdef SIMD_X86
+  i=PackYuyvSse2(pDst,pY,pU,pV,N,Uyvy);
+#endif
+  for(;i<N;i++){
+    pDst[4*i+y]=pY[2*i];
+    pDst[4*i+c]=pU[i];
+    pDst[4*i+y+2]=pY[2*i+1];
+    pDst[4*i+c+2]=pV[i];
+  }
+}
+
+
+/****************************************************************************/
+/** split a line of YUYV or UYVY pel pairs into planes
+ *
+ *  \param  pY   2*N luma samples
+ *  \param  pU   N chroma samples
+ *  \param  pV   N chroma samples
+ *  \param  pSrc source, 4*N bytes
+ *  \param  N    number of pel pairs
+ *  \param  Uyvy UYVY, else YUYV
+ */
+void Bits_UnpackYuyv(u8 *pY, u8 *pU, u8 *pV, const u8 *pSrc, int N,
+		     bool Uyvy)
+{
+  int		i=0,y=Uyvy?1:0,c=Uyvy?0:1;
+
+#ifdef SIMD_X86
+  i=UnpackYuyvSse2(pY,pU,pV,pSrc,N,Uyvy);
+#endif
+  for(;i<N;i++){
+    pY[2*i]=pSrc[4*i+y];
+    pU[i]=pSrc[4*i+c];
+    pY[2*i+1]=pSrc[4*i+y+2];
+    pV[i]=pSrc[4*i+c+2];
+  }
+}
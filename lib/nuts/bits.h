@@ -11,6 +11,11 @@
 #ifndef BITS_H
 #define BITS_H
 
+#include	"basic.h"
+#if defined __BMI2__ && (defined __x86_64__ || defined __i386__)
+#include	<immintrin.h>
+#endif
+
 /*****************************************************************************
  *  macros
  ****************************************************************************/
@@ -63,6 +68,161 @@
 #define SBITS(v,m,l)	SGNEXT(BITS(v,m,l),(m)-(l)+1)
 
 
+/*****************************************************************************
+ *  inline variants of the above
+ *
+ *  the field is cut out with a pair of shifts: left to drop the bits above
+ *  the msb, right (arithmetic for the signed variants) to drop the bits
+ *  below the lsb. no branches and no shifts by the full width, valid for
+ *  0<=l<=m<=31 (63). with constant m,l the compiler folds everything into
+ *  one or two instructions, same as the macros. unlike SETBITS the inserted
+ *  value is masked to the field width.
+ *
+ *  the upper case wrappers refuse constant fields out of range at compile
+ *  time (gcc, clang).
+ ****************************************************************************/
+
+#if defined __cplusplus && __cplusplus>=201103L
+#define BITS_CONSTEXPR	constexpr
+#else
+#define BITS_CONSTEXPR
+#endif
+
+/** return the bitfield m..l of v */
+static inline BITS_CONSTEXPR u32 bitsU32(u32 v, int m, int l)
+{
+  return v<<(31-m)>>(31-m+l);
+}
+
+/** return the bitfield m..l of v, sign extended */
+static inline BITS_CONSTEXPR s32 bitsS32(u32 v, int m, int l)
+{
+  return (s32)(v<<(31-m))>>(31-m+l);
+}
+
+/** return i with the bitfield m..l replaced by the lower bits of v */
+static inline BITS_CONSTEXPR u32 bitsSet32(u32 i, int m, int l, u32 v)
+{
+  return (i&~(~0u>>(31-m+l)<<l)) | (v<<(31-m+l)>>(31-m));
+}
+
+/** sign extend the lowest w (1..32) bits of v */
+static inline BITS_CONSTEXPR s32 sgnExt32(u32 v, int w)
+{
+  return (s32)(v<<(32-w))>>(32-w);
+}
+
+/** as bitsU32 for 64 bits */
+static inline BITS_CONSTEXPR u64 bitsU64(u64 v, int m, int l)
+{
+  return v<<(63-m)>>(63-m+l);
+}
+
+/** as bitsS32 for 64 bits */
+static inline BITS_CONSTEXPR s64 bitsS64(u64 v, int m, int l)
+{
+  return (s64)(v<<(63-m))>>(63-m+l);
+}
+
+/** as bitsSet32 for 64 bits */
+static inline BITS_CONSTEXPR u64 bitsSet64(u64 i, int m, int l, u64 v)
+{
+  return (i&~(~0ull>>(63-m+l)<<l)) | (v<<(63-m+l)>>(63-m));
+}
+
+/** as sgnExt32 for 64 bits, w 1..64 */
+static inline BITS_CONSTEXPR s64 sgnExt64(u64 v, int w)
+{
+  return (s64)(v<<(64-w))>>(64-w);
+}
+
+
+/** gather the bits of v selected by mask into the low bits (pext)
+ */
+static inline u32 bitsPext32(u32 v, u32 mask)
+{
+#if defined __BMI2__ && (defined __x86_64__ || defined __i386__)
+  return _pext_u32(v,mask);
+#else
+  u32		r=0,b;
+
+  for(b=1;mask;mask&=mask-1,b<<=1)
+    if(v&mask&-mask)
+      r|=b;
+  return r;
+#endif
+}
+
+/** scatter the low bits of v to the bits selected by mask (pdep)
+ */
+static inline u32 bitsPdep32(u32 v, u32 mask)
+{
+#if defined __BMI2__ && (defined __x86_64__ || defined __i386__)
+  return _pdep_u32(v,mask);
+#else
+  u32		r=0,b;
+
+  for(b=1;mask;mask&=mask-1,b<<=1)
+    if(v&b)
+      r|=mask&-mask;
+  return r;
+#endif
+}
+
+/** as bitsPext32 for 64 bits */
+static inline u64 bitsPext64(u64 v, u64 mask)
+{
+#if defined __BMI2__ && defined __x86_64__
+  return _pext_u64(v,mask);
+#else
+  u64		r=0,b;
+
+  for(b=1;mask;mask&=mask-1,b<<=1)
+    if(v&mask&-mask)
+      r|=b;
+  return r;
+#endif
+}
+
+/** as bitsPdep32 for 64 bits */
+static inline u64 bitsPdep64(u64 v, u64 mask)
+{
+#if defined __BMI2__ && defined __x86_64__
+  return _pdep_u64(v,mask);
+#else
+  u64		r=0,b;
+
+  for(b=1;mask;mask&=mask-1,b<<=1)
+    if(v&b)
+      r|=mask&-mask;
+  return r;
+#endif
+}
+
+
+#if defined __GNUC__
+extern void bitsBadField(void) __attribute__((error("bitfield out of range")));
+/* evaluates to 0, an error if m,l are constants and not a field of n bits */
+#define BITS_CHK(m,l,n)	((__builtin_constant_p(m) && __builtin_constant_p(l) \
+			  && ((l)<0 || (m)<(l) || (m)>=(n))) ? bitsBadField() : (void)0)
+#else
+#define BITS_CHK(m,l,n)	((void)0)
+#endif
+
+/** checked bitsU32() */
+#define UBITS32(v,m,l)	(BITS_CHK(m,l,32),bitsU32(v,m,l))
+/** checked bitsS32() */
+#define SBITS32(v,m,l)	(BITS_CHK(m,l,32),bitsS32(v,m,l))
+/** checked bitsSet32(), returns the new value */
+#define SETBITS32(i,m,l,v) (BITS_CHK(m,l,32),bitsSet32(i,m,l,v))
+/** checked bitsU64() */
+#define UBITS64(v,m,l)	(BITS_CHK(m,l,64),bitsU64(v,m,l))
+/** checked bitsS64() */
+#define SBITS64(v,m,l)	(BITS_CHK(m,l,64),bitsS64(v,m,l))
+/** checked bitsSet64(), returns the new value */
+#define SETBITS64(i,m,l,v) (BITS_CHK(m,l,64),bitsSet64(i,m,l,v))
+
+
 /* the following macros assume a little endian core at the moment. TODO: add
  * a variant for big endian cores
  */
@@ -147,4 +307,27 @@
 
 #endif /* not NUTS_BIG_ENDIAN */
 
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+EXTERN_C_BEGIN
+
+void  Bits_Swap16(void *pDst, const void *pSrc, int N);
+void  Bits_Swap32(void *pDst, const void *pSrc, int N);
+void  Bits_Swap64(void *pDst, const void *pSrc, int N);
+void  Bits_Pack4to3(void *pDst, const void *pSrc, int N, const u8 *pOrd);
+void  Bits_Expand3to4(void *pDst, const void *pSrc, int N, const u8 *pOrd);
+void  Bits_Be16Shl(u16 *pDst, const void *pSrc, int N, int Shift);
+void  Bits_U8to16Shl(u16 *pDst, const u8 *pSrc, int N, int Shift);
+void  Bits_Interleave2(u8 *pDst, const u8 *pA, const u8 *pB, int N);
+void  Bits_Deinterleave2(u8 *pA, u8 *pB, const u8 *pSrc, int N);
+void  Bits_PackYuyv(u8 *pDst, const u8 *pY, const u8 *pU, const u8 *pV,
+		    int N, bool Uyvy);
+void  Bits_UnpackYuyv(u8 *pY, u8 *pU, u8 *pV, const u8 *pSrc, int N,
+		      bool Uyvy);
+
+EXTERN_C_END
+
 #endif /* BITS_H */
@@ -17,11 +17,17 @@
 
 #include		"debug.h"
 #include		"strmem.h"
+#ifndef LINUX_KERNEL
+#include		"timer.h"
+#endif
 
 #ifdef LINUX_GNU
 #include		<execinfo.h>
-#include		<sys/stat.h>
+#include		"symtab.h"
+#endif
+#ifdef UNIX_GNU
 #include		<signal.h>
+#include		<unistd.h>
 #endif
 
 #ifdef ANDROID
@@ -40,6 +46,16 @@
 #endif
 
 
+/*****************************************************************************
+ *  global variables
+ ****************************************************************************/
+
+#ifndef LINUX_KERNEL
+tTimer			g_TLstamp;	/* reference of TSLOG */
+bool			g_TLinit=FALSE;
+#endif
+
+
 /*****************************************************************************
  *  local variables
  ****************************************************************************/
@@ -60,31 +76,40 @@ static void (*lMustExit)(void)=NULL;
  ****************************************************************************/
 
 /****************************************************************************/
-/*  our signal handler
+/*  our signal handler. only uses async signal safe calls, prints a stack
+ *  trace to stderr and raises the signal again with the default action
  */
 #ifdef UNIX_GNU
 static void SigHandler(int nSig)
 {
-  const char *s=StrGen("signal %d received",nSig);
+  const char	*s="\n*** signal received\n";
 
   void db_stop(void);
 
   db_stop();
-	
+
   switch(nSig)
   {
   case SIGSEGV:
-	  s="segmentation fault";
+	  s="\n*** segmentation fault\n";
 	  break;
   case SIGBUS:
-	  s="bus error";
+	  s="\n*** bus error\n";
 	  break;
   case SIGABRT:
-	  s="abort";
+	  s="\n*** abort\n";
 	  break;
   }
-	
-  ERROR("%s",s);
+  if(write(STDERR_FILENO,s,strlen(s))>0){
+#ifdef LINUX_GNU
+    s="stacktrace:\n";
+    if(write(STDERR_FILENO,s,strlen(s))>0)
+      Sym_PrintTrace(STDERR_FILENO,1);	/* hide ourselves */
+#endif
+  }
+
+  signal(nSig,SIG_DFL);
+  raise(nSig);
 }
 #endif
 
@@ -163,71 +188,22 @@ static void PrintStackTrace(int start, int end, bool func)
 #endif
 #ifdef LINUX_GNU
 	void		*bta[128];
-	int			btl,i;
-	char		**bts,*s;
-	char		exe[256];
-	char		progname[256];
-	const char	*pathes[]={"","/usr/local/bin/"};
-	struct stat	sbuf;
-
-	start+=2;  /* remove ourselves */
-	btl=backtrace(bta,LEN(bta));
+	int		btl;
+	tSymInfo	si;
 
-	size_t		off=nuts_GetTextStart();
+	start+=1;  /* remove ourselves */
+	btl=backtrace(bta,LEN(bta));
+	Sym_Init();
+	nuts_flush();
 
 	if(btl>2)
 	{
-		bts=backtrace_symbols(bta,btl);
-		if( (s=strchr(bts[0],'(')) )
-		{
-			strncpy(exe,bts[0],s-bts[0]);
-			exe[s-bts[0]]=0;
-			for(i=0;i<LEN(pathes);i++)
-			{
-				strcpy(progname,pathes[i]);
-				strcat(progname,exe);					DLOG("progname %s",progname);
-				if(stat(progname,&sbuf)==0)
-					break;
-			}
-			if(i<LEN(pathes))
-			{
-				if(func)
-				{
-					nuts_printf("function: "); nuts_flush();
-					system(mustSG("addr2line -f -s -e %s %p | head -1 | c++filt",progname,(size_t)bta[2]-off));
-				}
-				nuts_printf("stacktrace:\n"); nuts_flush();
-				for(i=start;i<btl-end;i++)
-				{
-					int add=(size_t)bta[i]-off;			DLOG("bta[i]=%zx, add=%x",bta[i],add);
-					system(mustSG("addr2line -f -s -e %s %p | awk '{if($0!~\":\") f=$0; "
-								  "else { gsub(\" .discri.*)\",\"\",$0); printf($0\": \"); "
-								  "system(\"c++filt \"f\" | tr -d \\\\\\\\n\"); "
-								  "printf(\"() @ 0x%x\\n\");}}'",progname,
-								  add-2,add));
-				}
-			}
-			else
-			{
-				nuts_printf("sorry, no stracktrace. cannot find executable '%s'\n",exe); nuts_flush();
-			}
-		}
-		else
-		{
-			nuts_printf("sorry, no stracktrace. cannot guess executable name\n"); nuts_flush();
-		}
-	}
-#if 0
-	char              **bts;
-	if(btl>0)
-	{
-		if(bts)
-		{
-			for(i=start;i<btl-end;i++)
-				nuts_printf("%s\n",bts[i]);
-		}
+		if(func && Sym_Lookup((u8*)bta[2]-1,&si) && si.Func)
+			nuts_printf("function: %s\n",si.Func);
+		nuts_printf("stacktrace:\n"); nuts_flush();
+		if(btl-end>start)
+			Sym_PrintFrames(STDOUT_FILENO,bta+start,btl-end-start);
 	}
-#endif
 #else
 	(void)start; (void)end; (void)func;
 #endif
@@ -391,16 +367,16 @@ void mustNoRet(void)
 
 
 /****************************************************************************/
-/*  private StrGen to avoid strange messages
+/*  private StrGen to avoid strange messages, one buffer per thread. longer
+ *  messages are truncated
  */
 const char * mustSG(const char *fmt, ...)
 {
   va_list       v_args;
-  static char   buffer[1024];
+  static THREAD_LOCAL char buffer[1024];
 
   va_start(v_args, fmt);
-  vsprintf( buffer,     fmt, v_args);
-  MUST(strlen(buffer)<sizeof(buffer));
+  vsnprintf(buffer, sizeof(buffer), fmt, v_args);
   va_end(v_args);
 
   return buffer;
@@ -412,7 +388,7 @@ const char * mustSG(const char *fmt, ...)
  */
 void stackTrace(void)
 {
-  PrintStackTrace(0,2,FALSE);
+  PrintStackTrace(1,2,FALSE);
 }
 
 
@@ -456,15 +432,36 @@ int HexDump(const void *pBase, int Offset, int Size)
 
 
 /****************************************************************************/
-/** install a private segmentation fault handler
+/** install a private segmentation fault handler. it runs on an alternate
+ *  stack (stack overflows) and prints a stack trace with the symbol tables
+ *  that are loaded here
  */
 void debugCatchSignals(void)
 {
-//	(void)SigHandler;
 #ifdef UNIX_GNU
-	signal(SIGSEGV, SigHandler);
-	signal(SIGBUS , SigHandler);
-	signal(SIGABRT, SigHandler);
+	static bool		sInit=FALSE;
+	struct sigaction	sa;
+	stack_t			ss;
+
+	if(!sInit)
+	{
+		ss.ss_sp=malloc(64*1024);  MUST(ss.ss_sp);
+		ss.ss_size=64*1024;
+		ss.ss_flags=0;
+		sigaltstack(&ss,NULL);
+		sInit=TRUE;
+	}
+#ifdef LINUX_GNU
+	Sym_Init();
+#endif
+
+	memset(&sa,0,sizeof(sa));
+	sa.sa_handler=SigHandler;
+	sa.sa_flags=SA_ONSTACK;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGSEGV,&sa,NULL);
+	sigaction(SIGBUS ,&sa,NULL);
+	sigaction(SIGABRT,&sa,NULL);
 #endif
 }
 
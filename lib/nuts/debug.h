@@ -21,12 +21,66 @@
 #define DLOGCOND	1
 #endif
 
+/** levels for the runtime filter of the DLOG macros
+ */
+enum {
+  DLOG_OFF=0,
+  DLOG_ERR,
+  DLOG_WARN,
+  DLOG_INFO,
+  DLOG_DEBUG,
+  DLOG_TRACE
+};
+
+/** default level of the DLOGs of a source file, can be defined before
+ *  including debug.h
+ */
+#ifndef DLOGLEVEL
+#define DLOGLEVEL	DLOG_DEBUG
+#endif
+
+/** tag of the DLOGs of a source file (a string), can be defined before
+ *  including debug.h
+ */
+#ifndef DLOGTAGNAME
+#define DLOGTAGNAME	NULL
+#endif
+
 #define DLNUM2STR_(exp)	#exp
 #define DLNUM2STR(exp)	DLNUM2STR_(exp)
 #define DLNUM2SYM_(p,x)	p##x
 #define DLNUM2SYM(p,x)	DLNUM2SYM_(p,x)
 #define DLOGTAG		__FILE__ ":" DLNUM2STR(__LINE__) ": "
 
+/** max number of arguments of a DLOG in binary mode (DLOGBIN)
+ */
+#define DLOGBIN_MAXARGS	8
+
+/** static descriptor of a DLOG call site, only used with DLOGBIN. the format
+ *  is analyzed once on the first call, afterwards a call only stores the
+ *  site pointer, a timestamp and the raw arguments
+ */
+typedef struct {
+  const char	*Fmt;		/**< format string, including DLOGTAG */
+  int		Id;		/**< running number, 0 until first call */
+  int		NArgs;		/**< number of arguments */
+  u8		Type[DLOGBIN_MAXARGS];	/**< argument classes */
+  int		Lit;		/**< leading chars of Fmt that are plain text */
+} tDLogSite;
+
+/** static filter state of a DLOG call site. On is 1 until the site is
+ *  resolved against the runtime filter on its first call and afterwards
+ *  caches the result, so a disabled DLOG costs one predictable branch
+ */
+typedef struct sDLogFilt {
+  struct sDLogFilt *pNext;	/**< list of all resolved sites */
+  const char	*File;		/**< source file */
+  const char	*Tag;		/**< tag or NULL */
+  int		Level;		/**< level of the DLOG */
+  int		On;		/**< cached filter result */
+  int		Known;		/**< site has been resolved */
+} tDLogFilt;
+
 EXTERN_C_BEGIN
 
 void MUST_SetHandler(void *pMustFmt, void *pMustExit);
@@ -37,6 +91,16 @@ int mustImpl(const char *file, int line, const char *msg);
 int nuts_printf(const char *format, ...);
 void nuts_flush(void);
 
+void nuts_dlogbin(tDLogSite *pSite, ...);
+void DLogBin_Flush(void);
+void DLogBin_FlushAll(void);
+bool DLogBin_Dump(const char *Name);
+bool DLogBin_Decode(const char *Name);
+
+int  nuts_dlogon(tDLogFilt *pFilt);
+void DLog_SetFilter(const char *Spec);
+void DLog_SetLevel(const char *Pattern, int Level);
+
 EXTERN_C_END
 
 /*****************************************************************************
@@ -227,60 +291,107 @@ EXTERN_C_END
 //#define DLOGCR
 //#endif
 
+/** check the runtime filter (see dlog.c) for a DLOG with tag t and level l
+ */
+#ifdef UNIX_GNU
+#define DLOGON(t,l)	({ static tDLogFilt dlf_={NULL,__FILE__,(t),(l),1,0}; \
+			__builtin_expect(dlf_.On,0) && nuts_dlogon(&dlf_); })
+#else
+#define DLOGON(t,l)	1
+#endif
+
+#define DLOGIF		(DLOGCOND && DLOGON(DLOGTAGNAME,DLOGLEVEL))
+
+#ifdef DLOGBIN
+
+/* binary mode: only the call site, a timestamp and the raw arguments are
+ * recorded in a per thread buffer. formatting is done when the buffer is
+ * flushed or offline with DLogBin_Decode(), see dlog.c. the format must be
+ * a string literal, %s arguments are copied (truncated to 255 chars)
+ */
+#define DLOGBIN_(fmt,...) do{ static tDLogSite dls_={DLOGTAG fmt,0,0,{0},0}; \
+			nuts_dlogbin(&dls_, ##__VA_ARGS__); }while(0)
+
+/* the expression text is part of the static format, it may contain % */
+#define DLOGBINX_(exp,fmt,arg) do{ static tDLogSite dls_={DLOGTAG #exp fmt, \
+			0,0,{0},sizeof(DLOGTAG #exp)-1}; \
+			nuts_dlogbin(&dls_,arg); }while(0)
+
+#define DLOGd(exp)    do{if(DLOGIF) DLOGBINX_(exp,"=%d",(int)(exp)); }while(0)
+#define DLOGx(exp)    do{if(DLOGIF) DLOGBINX_(exp,"=0x%x",(int)(exp)); }while(0)
+#define DLOG64d(exp)  do{if(DLOGIF) DLOGBINX_(exp,"=0x%lld",(s64)(exp)); }while(0)
+#define DLOG64x(exp)  do{if(DLOGIF) DLOGBINX_(exp,"=0x%llx",(u64)(exp)); }while(0)
+#define DLOGp(exp)    do{if(DLOGIF) DLOGBINX_(exp,"=0x%p",(void*)(exp)); }while(0)
+#define DLOGf(exp)    do{if(DLOGIF) DLOGBINX_(exp,"=%f",(double)(exp)); }while(0)
+#define DLOG(...)     do{if(DLOGIF) DLOGBIN_(__VA_ARGS__); }while(0)
+#define DLOGTL(t,l,...) do{if(DLOGCOND && DLOGON(t,l)) DLOGBIN_(__VA_ARGS__); }while(0)
+
+#else /* ! DLOGBIN */
 
 /** log an expression, format string is generated internally
  */
-#define DLOGd(exp)    do{if(DLOGCOND){nuts_printf(DLOGTAG"%s=%d",#exp,(int)(exp)); \
+#define DLOGd(exp)    do{if(DLOGIF){nuts_printf(DLOGTAG"%s=%d",#exp,(int)(exp)); \
 			DLOGCR; }}while(0)
 
 /** log an expression in hex, format string is generated internally
  */
-#define DLOGx(exp)   do{if(DLOGCOND){nuts_printf(DLOGTAG"%s=0x%x",#exp,(int)(exp));\
+#define DLOGx(exp)   do{if(DLOGIF){nuts_printf(DLOGTAG"%s=0x%x",#exp,(int)(exp));\
 			DLOGCR; }}while(0)
 
 /** log an expression in hex, format string is generated internally
  */
-#define DLOG64d(exp)   do{if(DLOGCOND){nuts_printf(DLOGTAG"%s=0x%lld",#exp,(s64)(exp));\
+#define DLOG64d(exp)   do{if(DLOGIF){nuts_printf(DLOGTAG"%s=0x%lld",#exp,(s64)(exp));\
 	                  DLOGCR; }}while(0)
 
 /** log an expression in hex, format string is generated internally
  */
-#define DLOG64x(exp)   do{if(DLOGCOND){nuts_printf(DLOGTAG"%s=0x%llx",#exp,(u64)(exp));\
+#define DLOG64x(exp)   do{if(DLOGIF){nuts_printf(DLOGTAG"%s=0x%llx",#exp,(u64)(exp));\
 	                  DLOGCR; }}while(0)
 
 /** log a pointer, format string is generated internally
  */
-#define DLOGp(exp)   do{if(DLOGCOND){nuts_printf(DLOGTAG"%s=0x%p",#exp,(exp));\
+#define DLOGp(exp)   do{if(DLOGIF){nuts_printf(DLOGTAG"%s=0x%p",#exp,(exp));\
 			DLOGCR; }}while(0)
 
 /** log an expression in float, format string is generated internally
  */
-#define DLOGf(exp)   do{if(DLOGCOND){nuts_printf(DLOGTAG"%s=%f",#exp,(double)(exp));\
+#define DLOGf(exp)   do{if(DLOGIF){nuts_printf(DLOGTAG"%s=%f",#exp,(double)(exp));\
 	                DLOGCR; }}while(0)
 
+/** log with format, like printf
+ */
+#define DLOG(...)   do{if(DLOGIF){nuts_printf(DLOGTAG __VA_ARGS__); DLOGCR; }}	\
+			while(0)
+
+/** log with format and explicit tag and level, see DLog_SetFilter()
+ */
+#define DLOGTL(t,l,...)	do{if(DLOGCOND && DLOGON(t,l)){			\
+			nuts_printf(DLOGTAG __VA_ARGS__); DLOGCR; }}while(0)
+
+#endif /* DLOGBIN */
+
+/** log with format and explicit level, see DLog_SetFilter()
+ */
+#define DLOGL(l,...)	DLOGTL(DLOGTAGNAME,l,__VA_ARGS__)
+
 /** log an expression that is a c++ class, i.e. has a print method
  */
-#define DLOGc(exp)   do{if(DLOGCOND){nuts_printf(DLOGTAG"%s=",#exp); (exp).print(stdout); \
+#define DLOGc(exp)   do{if(DLOGIF){nuts_printf(DLOGTAG"%s=",#exp); (exp).print(stdout); \
 			DLOGCR; }}while(0)
 
 /** log an expression that is a struct and has a print method
  */
-#define DLOGs(str,exp) do{if(DLOGCOND){nuts_printf(DLOGTAG"%s=",#exp); str##_print(&(exp)); \
+#define DLOGs(str,exp) do{if(DLOGIF){nuts_printf(DLOGTAG"%s=",#exp); str##_print(&(exp)); \
 			DLOGCR; }}while(0)
 
-/** log with format, like printf
- */
-#define DLOG(...)   do{if(DLOGCOND){nuts_printf(DLOGTAG __VA_ARGS__); DLOGCR; }}	\
-			while(0)
-
 /** log a stack trace
  */
-#define DSTACK  do{if(DLOGCOND){nuts_printf(DLOGTAG"stack trace\n"); stackTrace(); }}while(0)
+#define DSTACK  do{if(DLOGIF){nuts_printf(DLOGTAG"stack trace\n"); stackTrace(); }}while(0)
 
 /** dump the memory according to expression, format string etc is generated
   * internally
   */
-#define DDUMP(exp)   ({if(DLOGCOND){nuts_printf(DLOGTAG"dump of: %s =\n",#exp);\
+#define DDUMP(exp)   ({if(DLOGIF){nuts_printf(DLOGTAG"dump of: %s =\n",#exp);\
 	debugDump(&(exp),0,sizeof(exp)); nuts_flush(); }})
 
 /** dump extended (rectangular memory area with stride).
@@ -289,21 +400,23 @@ EXTERN_C_END
  *  \param dx	width
  *  \param dy	height
  */
-#define DDUMPX(mem,st,dx,dy) ({if(DLOGCOND){nuts_printf(DLOGTAG"dump of: %s/%d (%d,%d) =\n",#mem,st,dx,dy); \
+#define DDUMPX(mem,st,dx,dy) ({if(DLOGIF){nuts_printf(DLOGTAG"dump of: %s/%d (%d,%d) =\n",#mem,st,dx,dy); \
 		        debugDump(mem,st,dx,dy); nuts_flush(); }})
 
-#define DDUMP32X(mem,st,dx,dy) ({if(DLOGCOND){nuts_printf(DLOGTAG"dump of: %s/%d (%d,%d) =\n",#mem,st,dx,dy); \
+#define DDUMP32X(mem,st,dx,dy) ({if(DLOGIF){nuts_printf(DLOGTAG"dump of: %s/%d (%d,%d) =\n",#mem,st,dx,dy); \
 		debugDump32(mem,st,dx,dy); nuts_flush(); }})
 
 /** C++ version of DLOG to utilize overloaded << operators of fancy classes
  */
-#define DOUT(exp)    do{if(DLOGCOND){nuts_printf(DLOGTAG"%s=\n",#exp); std::cout<<exp; DLOGCR; }}while(0)
+#define DOUT(exp)    do{if(DLOGIF){nuts_printf(DLOGTAG"%s=\n",#exp); std::cout<<exp; DLOGCR; }}while(0)
 
 #else // META
 
 #include	<meta/tblog.h>
 
 #define DLOG			TBLOG
+#define DLOGL(l,...)		TBLOG(__VA_ARGS__)
+#define DLOGTL(t,l,...)		TBLOG(__VA_ARGS__)
 #define DLOGd			TBLOGd
 #define DLOGx			TBLOGx
 #define DLOGp			TBLOGx
@@ -322,6 +435,8 @@ EXTERN_C_END
 #define DLOGc(exp)
 #define DLOGs(str,exp)
 #define DLOG(...)
+#define DLOGL(l,...)
+#define DLOGTL(t,l,...)
 #define DSTACK
 #define DDUMP(exp)
 #define DDUMPX(mem,st,dx,dy)
@@ -335,7 +450,7 @@ EXTERN_C_END
 #endif
 
 /*****************************************************************************
- *  very simple timing instrumentation
+ *  very simple timing instrumentation (see trace.h for nested scopes)
  ****************************************************************************/
 
 #if defined TLOGGING
@@ -349,11 +464,11 @@ extern bool	g_TLinit;
 #define TLSTART	startTimer(&TLtimer);
 
 #define TLOG(text) do{ double d=stopTimer(&TLtimer); \
-	nuts_printf(DLOGTAG"TLOG(%s): %.1f ms\n",(text),d); nuts_flush(); }while(0)
+	nuts_printf(DLOGTAG"TLOG(%s): %.3f ms\n",(text),d); nuts_flush(); }while(0)
 								    
 
 #define TSLOG(text) do{ double d; if(!g_TLinit) { startTimer(&g_TLstamp); g_TLinit=TRUE; } \
-    d=stopTimer(&g_TLstamp); nuts_printf(DLOGTAG"TIMESTAMP(%s): %d ms\n",d); \
+    d=stopTimer(&g_TLstamp); nuts_printf(DLOGTAG"TIMESTAMP(%s): %.3f ms\n",(text),d); \
     nuts_flush(); }while(0)
 
 #else
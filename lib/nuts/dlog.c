@@ -0,0 +1,841 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  runtime support for the DLOG macros
+ *
+ *  runtime filter: every DLOG has a level (DLOGLEVEL or DLOGL()) and an
+ *  optional tag (DLOGTAGNAME or DLOGTL()). the filter is a comma separated
+ *  list of rules "pattern=level", the last matching rule wins. pattern is a
+ *  shell pattern for the source file ("pic.c", "*win*") or "#" and a pattern
+ *  for the tag ("#io"), level is a number or one of off, err, warn, info,
+ *  debug, trace. default is "*=trace", i.e. everything on. the filter is
+ *  read from the environment variable NUTS_DLOG or set with DLog_SetFilter(),
+ *  e.g. NUTS_DLOG="*=off,pic.c=debug,#io=info".
+ *
+ *  binary logging mode (switch DLOGBIN together with DLOGGING): a DLOG only
+ *  records the address of its static call site descriptor, a timestamp and
+ *  the raw arguments in a per thread buffer. the formatting happens when the
+ *  buffer is flushed (full, thread exit, program exit or DLogBin_Flush()).
+ *  with the environment variable NUTS_DLOGBIN=<file> the buffers are not
+ *  formatted at all but streamed to <file> in binary form, which can be
+ *  printed later with DLogBin_Decode().
+ *
+ *  \file      dlog.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+//#define DLOGGING
+#include	"debug.h"
+#include	"list.h"
+
+#ifdef UNIX_GNU
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<stdarg.h>
+#include	<stddef.h>
+#include	<stdint.h>
+#include	<string.h>
+#include	<time.h>
+#include	<pthread.h>
+#include	<unistd.h>
+#include	<fnmatch.h>
+#include	<sys/syscall.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define RECS		2048		/* records per thread buffer */
+#define STRBUF		(32*1024)	/* bytes for copied %s per thread */
+#define MAXSTR		255		/* max length of a copied %s */
+#define MAXSITES	(1<<20)		/* site ids DLogBin_Decode() accepts */
+#define DUMPMAGIC	0x424c444e	/* "NDLB" */
+#define MAXRULES	64		/* rules of the runtime filter */
+
+/* argument classes in tDLogSite.Type
+ */
+enum {
+  ARG_NONE=0,
+  ARG_INT,
+  ARG_LONG,
+  ARG_LLONG,
+  ARG_SIZE,
+  ARG_INTMAX,
+  ARG_PTRDIFF,
+  ARG_DOUBLE,
+  ARG_PTR,
+  ARG_STR
+};
+
+
+/*****************************************************************************
+ *  local types
+ ****************************************************************************/
+
+typedef struct {
+  const tDLogSite	*pSite;
+  u64			Ts;
+  u64			Arg[DLOGBIN_MAXARGS];	/* %s: offset in tBuf.Str */
+} tRec;
+
+typedef struct {
+  tNode			Node;
+  int			Tid;
+  int			N;		/* used records */
+  int			NStr;		/* used bytes in Str */
+  tRec			Rec[RECS];
+  char			Str[STRBUF];
+} tBuf;
+
+typedef struct {
+  FILE			*File;
+  u8			*pKnown;	/* sites already written, by Id */
+  int			NKnown;
+} tDump;
+
+typedef struct {
+  char			*Pat;		/* file pattern or "#" tag pattern */
+  int			Level;
+} tRule;
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static pthread_mutex_t	lMutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t	lDumpMutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t	lKey;
+static tLnkList		lBufs;
+static bool		lInit=FALSE;
+static int		lNextId=0;
+static tDump		lStream;	/* NUTS_DLOGBIN */
+static __thread tBuf	*lpBuf=NULL;
+
+static pthread_mutex_t	lFiltMutex=PTHREAD_MUTEX_INITIALIZER;
+static bool		lFiltInit=FALSE;
+static tRule		lRules[MAXRULES];
+static int		lNRules=0;
+static tDLogFilt	*lpSites=NULL;	/* all resolved sites */
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  monotonic time in ns
+ */
+static u64 Now(void)
+{
+  struct timespec	ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+
+/****************************************************************************/
+/*  analyze a format string
+ *
+ *  \param  pFmt  the format
+ *  \param  pType gets the argument classes
+ *  \return number of arguments
+ */
+static int ParseFmt(const char *pFmt, u8 *pType)
+{
+  const char	*p=pFmt;
+  int		n=0,t;
+
+  while(*p){
+    if(*p++!='%')
+      continue;
+    if(*p=='%'){
+      p++;
+      continue;
+    }
+    p+=strspn(p,"-+ #0'");
+    MUST_MSG(*p!='*',"DLOGBIN: '*' not supported in \"%s\"",pFmt);
+    p+=strspn(p,"0123456789.");
+
+    t=ARG_INT;
+    switch(*p){
+    case 'h': while(*p=='h') p++;		break;
+    case 'l': p++; t=ARG_LONG;
+	      if(*p=='l'){ p++; t=ARG_LLONG; }	break;
+    case 'z': p++; t=ARG_SIZE;			break;
+    case 'j': p++; t=ARG_INTMAX;		break;
+    case 't': p++; t=ARG_PTRDIFF;		break;
+    }
+
+    switch(*p){
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+      break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+      t=ARG_DOUBLE;
+      break;
+    case 'p':
+      t=ARG_PTR;
+      break;
+    case 's':
+      t=ARG_STR;
+      break;
+    default:
+      MUST_MSG(0,"DLOGBIN: unsupported conversion in \"%s\"",pFmt);
+      return n;
+    }
+    p++;
+
+    MUST_MSG(n<DLOGBIN_MAXARGS,"DLOGBIN: too many arguments in \"%s\"",pFmt);
+    if(n<DLOGBIN_MAXARGS)
+      pType[n++]=t;
+  }
+
+  return n;
+}
+
+
+/****************************************************************************/
+/*  format a record
+ *
+ *  \param  pOut  output buffer
+ *  \param  Size  its size
+ *  \param  pFmt  the format
+ *  \param  pType argument classes
+ *  \param  pArg  arguments, %s already converted to pointers
+ */
+static void FormatRec(char *pOut, int Size, const char *pFmt, const u8 *pType,
+		      const u64 *pArg)
+{
+  const char	*p=pFmt,*s;
+  char		spec[32];
+  int		n=0,i=0,l,r;
+  double	d;
+
+  while(*p && n<Size-1){
+    if(*p!='%'){
+      pOut[n++]=*p++;
+      continue;
+    }
+    if(p[1]=='%'){
+      pOut[n++]='%';
+      p+=2;
+      continue;
+    }
+
+    s=p++;
+    p+=strspn(p,"-+ #0'0123456789.hlzjt");
+    if(*p) p++;
+    l=MIN(p-s,(int)sizeof(spec)-1);
+    memcpy(spec,s,l);
+    spec[l]=0;
+
+    r=0;
+    switch(i<DLOGBIN_MAXARGS?pType[i]:ARG_NONE){
+    case ARG_INT:	r=snprintf(pOut+n,Size-n,spec,(int)pArg[i]);		break;
+    case ARG_LONG:	r=snprintf(pOut+n,Size-n,spec,(long)pArg[i]);		break;
+    case ARG_LLONG:	r=snprintf(pOut+n,Size-n,spec,(long long)pArg[i]);	break;
+    case ARG_SIZE:	r=snprintf(pOut+n,Size-n,spec,(size_t)pArg[i]);		break;
+    case ARG_INTMAX:	r=snprintf(pOut+n,Size-n,spec,(intmax_t)pArg[i]);	break;
+    case ARG_PTRDIFF:	r=snprintf(pOut+n,Size-n,spec,(ptrdiff_t)pArg[i]);	break;
+    case ARG_DOUBLE:	memcpy(&d,&pArg[i],sizeof(d));
+			r=snprintf(pOut+n,Size-n,spec,d);			break;
+    case ARG_PTR:	r=snprintf(pOut+n,Size-n,spec,(void*)(size_t)pArg[i]);	break;
+    case ARG_STR:	r=snprintf(pOut+n,Size-n,spec,(const char*)(size_t)pArg[i]); break;
+    }
+    i++;
+    n=MIN(n+MAX(r,0),Size-1);
+  }
+  pOut[n]=0;
+}
+
+
+/****************************************************************************/
+/*  print one record
+ */
+static void PrintRec(const char *pFmt, const u8 *pType, const u64 *pArg,
+		     int Tid, u64 Ts)
+{
+  char		buf[1024];
+
+  FormatRec(buf,sizeof(buf),pFmt,pType,pArg);
+  nuts_printf("%s [%d @%llu.%09llu]\n",buf,Tid,Ts/1000000000ULL,
+	      Ts%1000000000ULL);
+}
+
+
+/****************************************************************************/
+/*  write the records of a buffer to a dump file
+ */
+static void DumpRecs(tDump *pDump, const tBuf *pb)
+{
+  const tRec		*pr;
+  const tDLogSite	*ps;
+  int			i,a,n;
+  u8			c;
+  u16			l;
+  u32			w;
+
+  for(i=0;i<pb->N;i++){
+    pr=&pb->Rec[i];
+    ps=pr->pSite;
+
+    if(ps->Id>=pDump->NKnown){
+      n=2*(ps->Id+1);
+      pDump->pKnown=realloc(pDump->pKnown,n);  MUST(pDump->pKnown);
+      memset(pDump->pKnown+pDump->NKnown,0,n-pDump->NKnown);
+      pDump->NKnown=n;
+    }
+    if(!pDump->pKnown[ps->Id]){
+      c='S';			fwrite(&c,1,1,pDump->File);
+      w=ps->Id;			fwrite(&w,4,1,pDump->File);
+      l=strlen(ps->Fmt);	fwrite(&l,2,1,pDump->File);
+      fwrite(ps->Fmt,l,1,pDump->File);
+      pDump->pKnown[ps->Id]=TRUE;
+    }
+
+    c='R';			fwrite(&c,1,1,pDump->File);
+    w=ps->Id;			fwrite(&w,4,1,pDump->File);
+    w=pb->Tid;			fwrite(&w,4,1,pDump->File);
+    fwrite(&pr->Ts,8,1,pDump->File);
+    for(a=0;a<ps->NArgs;a++){
+      if(ps->Type[a]==ARG_STR){
+	l=strlen(pb->Str+pr->Arg[a]);
+	fwrite(&l,2,1,pDump->File);
+	fwrite(pb->Str+pr->Arg[a],l,1,pDump->File);
+      }
+      else
+	fwrite(&pr->Arg[a],8,1,pDump->File);
+    }
+  }
+}
+
+
+/****************************************************************************/
+/*  empty a buffer: format the records or stream them to the dump file
+ */
+static void Drain(tBuf *pb)
+{
+  const tRec	*pr;
+  u64		arg[DLOGBIN_MAXARGS];
+  int		i,a;
+
+  if(lStream.File){
+    pthread_mutex_lock(&lDumpMutex);
+    DumpRecs(&lStream,pb);
+    pthread_mutex_unlock(&lDumpMutex);
+  }
+  else{
+    for(i=0;i<pb->N;i++){
+      pr=&pb->Rec[i];
+      for(a=0;a<pr->pSite->NArgs;a++)
+	arg[a]=pr->pSite->Type[a]==ARG_STR?(u64)(size_t)(pb->Str+pr->Arg[a]):
+	  pr->Arg[a];
+      PrintRec(pr->pSite->Fmt,pr->pSite->Type,arg,pb->Tid,pr->Ts);
+    }
+    nuts_flush();
+  }
+
+  pb->N=0;
+  pb->NStr=0;
+}
+
+
+/****************************************************************************/
+/*  thread exit: flush and release the buffer of the thread. a DLOG in a
+ *  later TSD destructor of the thread creates a new one, which is released
+ *  in the next destructor round
+ */
+static void ThreadExit(void *p)
+{
+  tBuf		*pb=p;
+
+  Drain(pb);
+
+  pthread_mutex_lock(&lMutex);
+  LnkList_Remove(&lBufs,pb);
+  pthread_mutex_unlock(&lMutex);
+
+  lpBuf=NULL;
+  free(pb);
+}
+
+
+/****************************************************************************/
+/*  program exit
+ */
+static void AtExit(void)
+{
+  DLogBin_FlushAll();
+
+  if(lStream.File){
+    fclose(lStream.File);
+    lStream.File=NULL;
+  }
+}
+
+
+/****************************************************************************/
+/*  one time initialization, called with lMutex locked
+ */
+static void Init(void)
+{
+  const char	*s;
+  u32		w=DUMPMAGIC;
+
+  LnkList_Init(&lBufs);
+  pthread_key_create(&lKey,ThreadExit);
+
+  if((s=getenv("NUTS_DLOGBIN")) && *s){
+    if(!(lStream.File=fopen(s,"w"))) ERROR("cannot create: %s",s);
+    fwrite(&w,4,1,lStream.File);
+  }
+
+  atexit(AtExit);
+  lInit=TRUE;
+}
+
+
+/****************************************************************************/
+/*  create the buffer of the current thread
+ */
+static tBuf * NewBuf(void)
+{
+  tBuf		*pb;
+
+  pb=malloc(sizeof(tBuf));  MUST(pb);
+  pb->Tid=syscall(SYS_gettid);
+  pb->N=0;
+  pb->NStr=0;
+
+  pthread_mutex_lock(&lMutex);
+  if(!lInit)
+    Init();
+  LnkList_Add(&lBufs,pb);
+  pthread_mutex_unlock(&lMutex);
+
+  pthread_setspecific(lKey,pb);
+
+  return lpBuf=pb;
+}
+
+
+/****************************************************************************/
+/*  first call of a site: analyze the format and assign an id
+ */
+static void InitSite(tDLogSite *pSite)
+{
+  const char	*s;
+  char		*f;
+  int		i,n=0;
+
+  pthread_mutex_lock(&lMutex);
+  if(!pSite->Id){
+    /* a % in the plain text of a DLOGd expression, make it %% */
+    for(s=pSite->Fmt,i=0;i<pSite->Lit;i++)
+      n+=s[i]=='%';
+    if(n){
+      f=malloc(strlen(s)+n+1);  MUST(f);
+      for(i=0,n=0;s[i];i++){
+	f[n++]=s[i];
+	if(s[i]=='%' && i<pSite->Lit)
+	  f[n++]='%';
+      }
+      f[n]=0;
+      pSite->Fmt=f;
+    }
+    pSite->NArgs=ParseFmt(pSite->Fmt,pSite->Type);
+    __atomic_store_n(&pSite->Id,++lNextId,__ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&lMutex);
+}
+
+
+/****************************************************************************/
+/*  copy a string argument into the buffer
+ *
+ *  \return offset in pb->Str
+ */
+static u64 CopyStr(tBuf *pb, const char *s)
+{
+  int		l,o=pb->NStr;
+
+  if(!s) s="(null)";
+  l=strnlen(s,MAXSTR);
+  memcpy(pb->Str+o,s,l);
+  pb->Str[o+l]=0;
+  pb->NStr+=l+1;
+
+  return o;
+}
+
+
+/****************************************************************************/
+/*  parse a level of a filter rule
+ */
+static int ParseLevel(const char *s)
+{
+  static const char	*names[]={"off","err","warn","info","debug","trace"};
+  int			i;
+
+  for(i=0;i<LEN(names);i++)
+    if(!strcmp(s,names[i]))
+      return i;
+  if(*s<'0' || *s>'9')
+    WARN("DLOG filter: unknown level '%s'",s);
+
+  return atoi(s);
+}
+
+
+/****************************************************************************/
+/*  append the rules of a filter specification, called with lFiltMutex locked
+ */
+static void AddRules(const char *Spec)
+{
+  char		*buf,*tok,*save,*lvl;
+
+  buf=strdup(Spec);  MUST(buf);
+
+  for(tok=strtok_r(buf,", ",&save);tok;tok=strtok_r(NULL,", ",&save)){
+    if(lNRules==MAXRULES){
+      WARN("DLOG filter: more than %d rules",MAXRULES);
+      break;
+    }
+    if((lvl=strchr(tok,'=')))
+      *lvl++=0;
+    lRules[lNRules].Pat=strdup(tok);  MUST(lRules[lNRules].Pat);
+    lRules[lNRules].Level=lvl?ParseLevel(lvl):DLOG_TRACE;
+    lNRules++;
+  }
+
+  free(buf);
+}
+
+
+/****************************************************************************/
+/*  evaluate the filter for a site
+ *
+ *  \return TRUE if the site is enabled
+ */
+static int Resolve(const tDLogFilt *pFilt)
+{
+  const char	*base;
+  const tRule	*pr;
+  int		i,lvl=DLOG_TRACE;
+
+  base=strrchr(pFilt->File,'/');
+  base=base?base+1:pFilt->File;
+
+  for(i=0;i<lNRules;i++){
+    pr=&lRules[i];
+    if(pr->Pat[0]=='#'){
+      if(pFilt->Tag && !fnmatch(pr->Pat+1,pFilt->Tag,0))
+	lvl=pr->Level;
+    }
+    else if(!fnmatch(pr->Pat,pFilt->File,0) || !fnmatch(pr->Pat,base,0))
+      lvl=pr->Level;
+  }
+
+  return pFilt->Level<=lvl;
+}
+
+
+/****************************************************************************/
+/*  read the initial filter, called with lFiltMutex locked
+ */
+static void FiltInit(void)
+{
+  const char	*s;
+
+  if((s=getenv("NUTS_DLOG")))
+    AddRules(s);
+  lFiltInit=TRUE;
+}
+
+
+/****************************************************************************/
+/*  update the cached state of all resolved sites, called with lFiltMutex
+ *  locked
+ */
+static void Reresolve(void)
+{
+  tDLogFilt	*p;
+
+  for(p=lpSites;p;p=p->pNext)
+    p->On=Resolve(p);
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/** resolve the runtime filter for a DLOG call site. used internally by the
+ *  DLOG macros, which call it on every DLOG while the site is enabled. the
+ *  first call evaluates the filter and registers the site, later ones
+ *  return the cached state, which DLog_SetFilter() updates
+ *
+ *  \param  pFilt the static filter state of the call site
+ *  \return TRUE if the DLOG is enabled
+ */
+int nuts_dlogon(tDLogFilt *pFilt)
+{
+  if(!__atomic_load_n(&pFilt->Known,__ATOMIC_ACQUIRE)){
+    pthread_mutex_lock(&lFiltMutex);
+    if(!lFiltInit)
+      FiltInit();
+    if(!pFilt->Known){
+      pFilt->On=Resolve(pFilt);
+      pFilt->pNext=lpSites;
+      lpSites=pFilt;
+      __atomic_store_n(&pFilt->Known,1,__ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&lFiltMutex);
+  }
+
+  return pFilt->On;
+}
+
+
+/****************************************************************************/
+/** replace the runtime filter of the DLOG macros (including the one from
+ *  NUTS_DLOG)
+ *
+ *  \param  Spec rules "pattern=level,..." as described above
+ */
+void DLog_SetFilter(const char *Spec)
+{
+  int		i;
+
+  pthread_mutex_lock(&lFiltMutex);
+  for(i=0;i<lNRules;i++)
+    free(lRules[i].Pat);
+  lNRules=0;
+  lFiltInit=TRUE;
+  if(Spec)
+    AddRules(Spec);
+  Reresolve();
+  pthread_mutex_unlock(&lFiltMutex);
+}
+
+
+/****************************************************************************/
+/** append a rule to the runtime filter of the DLOG macros
+ *
+ *  \param  Pattern file pattern or "#" and a tag pattern
+ *  \param  Level   max level of the DLOGs that match Pattern
+ */
+void DLog_SetLevel(const char *Pattern, int Level)
+{
+  pthread_mutex_lock(&lFiltMutex);
+  if(!lFiltInit)
+    FiltInit();
+  if(lNRules<MAXRULES){
+    lRules[lNRules].Pat=strdup(Pattern);  MUST(lRules[lNRules].Pat);
+    lRules[lNRules].Level=Level;
+    lNRules++;
+  }
+  else
+    WARN("DLOG filter: more than %d rules",MAXRULES);
+  Reresolve();
+  pthread_mutex_unlock(&lFiltMutex);
+}
+
+
+/****************************************************************************/
+/** record a DLOG in binary mode. used internally by the DLOG macros
+ *
+ *  \param  pSite the static descriptor of the call site
+ *  \param  ...   the arguments as for the format of the site
+ */
+void nuts_dlogbin(tDLogSite *pSite, ...)
+{
+  tBuf		*pb=lpBuf;
+  tRec		*pr;
+  va_list	args;
+  int		i;
+  double	d;
+
+  if(!__atomic_load_n(&pSite->Id,__ATOMIC_ACQUIRE))
+    InitSite(pSite);
+  if(!pb)
+    pb=NewBuf();
+  if(pb->N==RECS || pb->NStr>STRBUF-(MAXSTR+1)*DLOGBIN_MAXARGS)
+    Drain(pb);
+
+  pr=&pb->Rec[pb->N++];
+  pr->pSite=pSite;
+  pr->Ts=Now();
+
+  va_start(args,pSite);
+  for(i=0;i<pSite->NArgs;i++){
+    switch(pSite->Type[i]){
+    case ARG_INT:	pr->Arg[i]=va_arg(args,int);			break;
+    case ARG_LONG:	pr->Arg[i]=va_arg(args,long);			break;
+    case ARG_LLONG:	pr->Arg[i]=va_arg(args,long long);		break;
+    case ARG_SIZE:	pr->Arg[i]=va_arg(args,size_t);			break;
+    case ARG_INTMAX:	pr->Arg[i]=va_arg(args,intmax_t);		break;
+    case ARG_PTRDIFF:	pr->Arg[i]=va_arg(args,ptrdiff_t);		break;
+    case ARG_DOUBLE:	d=va_arg(args,double);
+			memcpy(&pr->Arg[i],&d,sizeof(d));		break;
+    case ARG_PTR:	pr->Arg[i]=(size_t)va_arg(args,void*);		break;
+    case ARG_STR:	pr->Arg[i]=CopyStr(pb,va_arg(args,const char*));	break;
+    }
+  }
+  va_end(args);
+}
+
+
+/****************************************************************************/
+/** flush the binary log buffer of the calling thread
+ */
+void DLogBin_Flush(void)
+{
+  if(lpBuf)
+    Drain(lpBuf);
+}
+
+
+/****************************************************************************/
+/** flush the binary log buffers of all threads. the other threads must not
+ *  log at the same time (e.g. use it at the end of the program)
+ */
+void DLogBin_FlushAll(void)
+{
+  tBuf		*pb;
+
+  if(!lInit)
+    return;
+
+  pthread_mutex_lock(&lMutex);
+  LNKLIST_FOR(lBufs,pb)
+    Drain(pb);
+  pthread_mutex_unlock(&lMutex);
+
+  if(lStream.File)
+    fflush(lStream.File);
+}
+
+
+/****************************************************************************/
+/** write the binary log buffers of all threads to a file and empty them.
+ *  the other threads must not log at the same time
+ *
+ *  \param  Name filename
+ *  \return TRUE on success
+ */
+bool DLogBin_Dump(const char *Name)
+{
+  tDump		dump={NULL,NULL,0};
+  tBuf		*pb;
+  u32		w=DUMPMAGIC;
+
+  if(!(dump.File=fopen(Name,"w")))
+    return FALSE;
+  fwrite(&w,4,1,dump.File);
+
+  if(lInit){
+    pthread_mutex_lock(&lMutex);
+    LNKLIST_FOR(lBufs,pb){
+      DumpRecs(&dump,pb);
+      pb->N=0;
+      pb->NStr=0;
+    }
+    pthread_mutex_unlock(&lMutex);
+  }
+
+  free(dump.pKnown);
+
+  return fclose(dump.File)==0;
+}
+
+
+/****************************************************************************/
+/** print a file written by DLogBin_Dump() or with NUTS_DLOGBIN
+ *
+ *  \param  Name filename
+ *  \return TRUE on success
+ */
+bool DLogBin_Decode(const char *Name)
+{
+  FILE		*file;
+  struct {
+    char	*pFmt;
+    int		NArgs;
+    u8		Type[DLOGBIN_MAXARGS];
+  }		*pSites=NULL;
+  int		nsites=0,a,o;
+  u64		arg[DLOGBIN_MAXARGS],ts;
+  char		str[DLOGBIN_MAXARGS*(MAXSTR+1)];
+  u32		w,id,tid;
+  u16		l;
+  u8		c;
+  bool		ok=TRUE;
+
+  if(!(file=fopen(Name,"r")))
+    return FALSE;
+
+  if(fread(&w,4,1,file)!=1 || w!=DUMPMAGIC)
+    ERROR("%s is no DLOGBIN dump",Name);
+
+  while(ok && fread(&c,1,1,file)==1){
+    if(fread(&id,4,1,file)!=1)
+      break;
+    if(id>=MAXSITES)
+      ERROR("%s: corrupt DLOGBIN dump, site %u",Name,id);
+    if((int)id>=nsites){
+      pSites=realloc(pSites,(id+1)*sizeof(*pSites));  MUST(pSites);
+      memset(pSites+nsites,0,(id+1-nsites)*sizeof(*pSites));
+      nsites=id+1;
+    }
+
+    switch(c){
+    case 'S':
+      if(!(ok=fread(&l,2,1,file)==1))
+	break;
+      free(pSites[id].pFmt);
+      pSites[id].pFmt=calloc(l+1,1);  MUST(pSites[id].pFmt);
+      ok=ok && fread(pSites[id].pFmt,1,l,file)==l;
+      pSites[id].NArgs=ParseFmt(pSites[id].pFmt,pSites[id].Type);
+      break;
+
+    case 'R':
+      if(!pSites[id].pFmt)
+	ERROR("%s: record for unknown site %u",Name,id);
+      ok=fread(&tid,4,1,file)==1 && fread(&ts,8,1,file)==1;
+      for(a=o=0;ok && a<pSites[id].NArgs;a++){
+	if(pSites[id].Type[a]==ARG_STR){
+	  ok=fread(&l,2,1,file)==1 && l<=MAXSTR && fread(str+o,1,l,file)==l;
+	  if(!ok)
+	    break;
+	  str[o+l]=0;
+	  arg[a]=(size_t)(str+o);
+	  o+=l+1;
+	}
+	else
+	  ok=fread(&arg[a],8,1,file)==1;
+      }
+      if(ok)
+	PrintRec(pSites[id].pFmt,pSites[id].Type,arg,tid,ts);
+      break;
+
+    default:
+      ERROR("%s: corrupt DLOGBIN dump",Name);
+    }
+  }
+  nuts_flush();
+
+  for(o=0;o<nsites;o++)
+    free(pSites[o].pFmt);
+  free(pSites);
+  fclose(file);
+
+  return ok;
+}
+
+#endif /* UNIX_GNU */
@@ -10,17 +10,25 @@
 
 #include	"list.h"
 #include	"debug.h"
+#include	<string.h>
+#include	<stdlib.h>
 
 /*****************************************************************************
- *  exported functions
+ *  local defines
+ ****************************************************************************/
+
+#define SLABBYTES	(64*1024)	/* target size of a slab */
+#define CHKBYTES	(16*1024)	/* max size of a ChkList block */
+
+
+/*****************************************************************************
+ *  local functions
  ****************************************************************************/
 
 /****************************************************************************/
-/** initialize a linked list
- *
- *  \param pList pointer to the list
+/*  make a list empty without touching the nodes
  */
-void LnkList_Init(tLnkList *pList)
+static void Empty(tLnkList *pList)
 {
   pList->Head.pSucc=&pList->Tail;
   pList->Head.pPred=NULL;
@@ -30,6 +38,37 @@ void LnkList_Init(tLnkList *pList)
 }
 
 
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/** initialize a linked list
+ *
+ *  \param pList pointer to the list
+ */
+void LnkList_Init(tLnkList *pList)
+{
+  Empty(pList);
+  pList->pPool=NULL;
+}
+
+
+/****************************************************************************/
+/** initialize a linked list whose nodes come from a pool. several lists can
+ *  share a pool
+ *
+ *  \param pList pointer to the list
+ *  \param pPool the pool, nodes are allocated with LnkList_NewNode()
+ */
+void LnkList_InitPool(tLnkList *pList, tNodePool *pPool)
+{
+  Empty(pList);
+  pList->pPool=pPool;
+  pPool->Lists++;
+}
+
+
 /****************************************************************************/
 /** add a new node at the end of a linked list
  *
@@ -81,7 +120,22 @@ void * LnkList_Remove(tLnkList *pList, void *pNode)
 #ifdef UNIX_GNU
 
 /****************************************************************************/
-/** free all nodes of a list
+/** allocate a cleared node from the pool of a list (the node is not added)
+ *
+ *  \param pList pointer to the list, initialized with LnkList_InitPool()
+ *  \return the node
+ */
+void * LnkList_NewNode(tLnkList *pList)
+{
+  ;   MUST_MSG(pList->pPool,"list without pool");
+
+  return NodePool_Alloc(pList->pPool);
+}
+
+
+/****************************************************************************/
+/** free all nodes of a list. if the list is the only one bound to its pool
+ *  this just resets the pool
  *
  *  \param pList pointer to the list
  */
@@ -92,13 +146,20 @@ void LnkList_Free(tLnkList *pList)
   MUST_MSG(pList->Head.pSucc && pList->Tail.pPred &&
 	   !pList->Head.pPred && !pList->Tail.pSucc,"list not initialized");
 
-  for(pr=pList->Head.pSucc;pr->pSucc;){
-    ps=pr->pSucc;
-    free(pr);
-    pr=ps;
+  if(pList->pPool && pList->pPool->Lists==1)
+    NodePool_Reset(pList->pPool);
+  else{
+    for(pr=pList->Head.pSucc;pr->pSucc;){
+      ps=pr->pSucc;
+      if(pList->pPool)
+	NodePool_Put(pList->pPool,pr);
+      else
+	free(pr);
+      pr=ps;
+    }
   }
 
-  LnkList_Init(pList);
+  Empty(pList);
 }
 
 
@@ -122,7 +183,10 @@ void LnkList_FreeNodes(tLnkList *pList, void *pNode, int N)
 
   for(;N;pc=pp,N--){
     pp=pc->pPred; MUST(pc);
-    free(pc);
+    if(pList->pPool)
+      NodePool_Put(pList->pPool,pc);
+    else
+      free(pc);
     pList->Len--;
   }
 
@@ -130,4 +194,217 @@ void LnkList_FreeNodes(tLnkList *pList, void *pNode, int N)
   ps->pPred=pp;
 }
 
+
+/****************************************************************************/
+/** initialize a node pool
+ *
+ *  \param pPool    the pool
+ *  \param NodeSize size of the nodes, e.g. sizeof(tMyNode)
+ */
+void NodePool_Init(tNodePool *pPool, int NodeSize)
+{
+  ;   MUST_Ge(NodeSize,(int)sizeof(tNode));
+
+  memset(pPool,0,sizeof(*pPool));
+  pPool->NodeSize=(NodeSize+sizeof(long long)-1)&~(sizeof(long long)-1);
+}
+
+
+/****************************************************************************/
+/** allocate a cleared node
+ *
+ *  \param pPool the pool
+ *  \return the node
+ */
+void * NodePool_Alloc(tNodePool *pPool)
+{
+  tSlab		*ps;
+  void		*p;
+  int		n;
+
+  if((p=pPool->pFree))
+    pPool->pFree=*(void**)p;
+  else{
+    ps=pPool->pCur;
+    if(!ps || pPool->Pos==ps->N){
+      /* next slab, keep the ones from before a reset */
+      if(ps && ps->pNext)
+	ps=ps->pNext;
+      else if(!ps && pPool->pFirst)
+	ps=pPool->pFirst;
+      else{
+	n=MAX(1,SLABBYTES/pPool->NodeSize);	/* a big node gets its own */
+	ps=malloc(sizeof(tSlab)+(long)n*pPool->NodeSize);  MUST(ps);
+	ps->pNext=NULL;
+	ps->N=n;
+	if(pPool->pCur)
+	  pPool->pCur->pNext=ps;
+	else
+	  pPool->pFirst=ps;
+      }
+      pPool->pCur=ps;
+      pPool->Pos=0;
+    }
+    p=(char*)ps->Dat+pPool->Pos*pPool->NodeSize;
+    pPool->Pos++;
+  }
+
+  memset(p,0,pPool->NodeSize);
+
+  return p;
+}
+
+
+/****************************************************************************/
+/** return a node to its pool
+ *
+ *  \param pPool the pool
+ *  \param pNode the node
+ */
+void NodePool_Put(tNodePool *pPool, void *pNode)
+{
+  *(void**)pNode=pPool->pFree;
+  pPool->pFree=pNode;
+}
+
+
+/****************************************************************************/
+/** release all nodes of a pool at once, the memory is kept
+ *
+ *  \param pPool the pool
+ */
+void NodePool_Reset(tNodePool *pPool)
+{
+  pPool->pCur=NULL;
+  pPool->Pos=0;
+  pPool->pFree=NULL;
+}
+
+
+/****************************************************************************/
+/** free the memory of a pool
+ *
+ *  \param pPool the pool
+ */
+void NodePool_Free(tNodePool *pPool)
+{
+  tSlab		*ps,*pn;
+
+  for(ps=pPool->pFirst;ps;ps=pn){
+    pn=ps->pNext;
+    free(ps);
+  }
+  pPool->pFirst=pPool->pCur=NULL;
+  pPool->Pos=0;
+  pPool->pFree=NULL;
+}
+
+
+/****************************************************************************/
+/** initialize a chunked list
+ *
+ *  \param pList    the list
+ *  \param ElemSize size of the elements
+ */
+void ChkList_Init(tChkList *pList, int ElemSize)
+{
+  int		per;
+
+  ;   MUST_Gt(ElemSize,0);  MUST_Le(ElemSize,CHKBYTES-(int)sizeof(tChkBlk));
+
+  memset(pList,0,sizeof(*pList));
+  pList->ElemSize=ElemSize;
+
+  per=MIN(64,(CHKBYTES-(int)sizeof(tChkBlk))/ElemSize);
+  for(pList->BlkSize=64;pList->BlkSize<(int)sizeof(tChkBlk)+per*ElemSize;)
+    pList->BlkSize*=2;
+  pList->PerBlk=MIN(64,(pList->BlkSize-(int)sizeof(tChkBlk))/ElemSize);
+}
+
+
+/****************************************************************************/
+/** append a cleared element to a chunked list
+ *
+ *  \param pList the list
+ *  \return the element, valid until it is removed
+ */
+void * ChkList_Add(tChkList *pList)
+{
+  tChkBlk	*pb=pList->pLast;
+  void		*p;
+
+  if(!pb || pb->Top==pList->PerBlk){
+    if(posix_memalign((void**)&pb,pList->BlkSize,pList->BlkSize))
+      ERROR("out of memory");
+    pb->pNext=NULL;
+    pb->pPrev=pList->pLast;
+    pb->Used=0;
+    pb->Top=0;
+    if(pList->pLast)
+      pList->pLast->pNext=pb;
+    else
+      pList->pFirst=pb;
+    pList->pLast=pb;
+  }
+
+  p=(char*)pb->Dat+pb->Top*pList->ElemSize;
+  memset(p,0,pList->ElemSize);
+  pb->Used|=1ull<<pb->Top;
+  pb->Top++;
+  pList->Len++;
+
+  return p;
+}
+
+
+/****************************************************************************/
+/** remove an element from a chunked list
+ *
+ *  \param pList the list
+ *  \param pElem the element as returned by ChkList_Add()
+ */
+void ChkList_Remove(tChkList *pList, void *pElem)
+{
+  tChkBlk	*pb;
+  int		i;
+
+  pb=(tChkBlk*)((size_t)pElem&~(size_t)(pList->BlkSize-1));
+  i=((char*)pElem-(char*)pb->Dat)/pList->ElemSize;
+  MUST_MSG(pb->Used&(1ull<<i),"element not in list");
+
+  pb->Used&=~(1ull<<i);
+  pList->Len--;
+
+  /* free empty blocks, except a last one that is still filled up */
+  if(!pb->Used && (pb!=pList->pLast || pb->Top==pList->PerBlk)){
+    if(pb->pPrev)
+      pb->pPrev->pNext=pb->pNext;
+    else
+      pList->pFirst=pb->pNext;
+    if(pb->pNext)
+      pb->pNext->pPrev=pb->pPrev;
+    else
+      pList->pLast=pb->pPrev;
+    free(pb);
+  }
+}
+
+
+/****************************************************************************/
+/** free all elements of a chunked list
+ *
+ *  \param pList the list
+ */
+void ChkList_Free(tChkList *pList)
+{
+  tChkBlk	*pb,*pn;
+
+  for(pb=pList->pFirst;pb;pb=pn){
+    pn=pb->pNext;
+    free(pb);
+  }
+  pList->pFirst=pList->pLast=NULL;
+  pList->Len=0;
+}
+
 #endif
@@ -39,6 +39,15 @@
  */
 #define LNKLIST_LAST(l)		((l).Tail.pPred)
 
+/** iterate a pointer through the elements of a chunked list in insertion
+ *  order. elements must not be removed while iterating
+ *  \param l the list
+ *  \param p pointer of suitable type
+ */
+#define CHKLIST_FOR(l,p)	for(tChkIt chk_it_=ChkList_Begin(&(l));\
+				    ((p)=ChkIt_Get(&chk_it_));\
+				    chk_it_.Bits&=chk_it_.Bits-1)
+
 #ifdef UNIX_GNU
 
 #include	<malloc.h>
@@ -59,13 +68,99 @@ typedef struct sNode {
 } tNode;
 
 
+typedef struct sSlab {
+  struct sSlab	*pNext;
+  int		N;		/* nodes in Dat */
+  long long	Dat[];		/* aligned for any node */
+} tSlab;
+
+
+/** slab allocator for list nodes of one size. freeing a single node puts it
+ *  on a free list, resetting the pool releases all nodes in O(1) and keeps
+ *  the slabs for reuse
+ */
+typedef struct {
+  int		NodeSize;
+  int		Lists;		/* lists bound to the pool */
+  tSlab		*pFirst;
+  tSlab		*pCur;		/* slab for the next new node */
+  int		Pos;		/* next unused node in pCur */
+  void		*pFree;		/* freed nodes */
+} tNodePool;
+
+
 typedef struct {
   tNode		Head;
   tNode		Tail;
   int		Len;
+  tNodePool	*pPool;		/* NULL: nodes from NEW() */
 } tLnkList;
 
 
+/** a block of a chunked list, aligned to its size (a power of 2), so the
+ *  block of an element is found by masking its address
+ */
+typedef struct sChkBlk {
+  struct sChkBlk *pNext;
+  struct sChkBlk *pPrev;
+  u64		Used;		/* bitmap of the used slots */
+  int		Top;		/* slots >= Top have never been used */
+  long long	Dat[] __attribute__((aligned(64)));
+} tChkBlk;
+
+
+/** chunked (unrolled) list of fixed size elements. up to 64 elements share
+ *  a cache line aligned block, iteration follows a bitmap per block instead
+ *  of a pointer per element. elements never move, so their address is a
+ *  stable handle for ChkList_Remove(). new elements are appended, holes
+ *  left by removals are not reused, empty blocks are freed
+ */
+typedef struct {
+  tChkBlk	*pFirst;
+  tChkBlk	*pLast;
+  int		Len;
+  int		ElemSize;
+  int		PerBlk;		/* elements per block */
+  int		BlkSize;	/* bytes per block */
+} tChkList;
+
+
+/** iterator of CHKLIST_FOR
+ */
+typedef struct {
+  tChkBlk	*pBlk;
+  u64		Bits;		/* slots left in pBlk */
+  int		ElemSize;
+} tChkIt;
+
+
+/*****************************************************************************
+ *  inline functions
+ ****************************************************************************/
+
+static inline tChkIt ChkList_Begin(const tChkList *pList)
+{
+  tChkIt	it;
+
+  it.pBlk=pList->pFirst;
+  it.Bits=it.pBlk?it.pBlk->Used:0;
+  it.ElemSize=pList->ElemSize;
+
+  return it;
+}
+
+static inline void *ChkIt_Get(tChkIt *pIt)
+{
+  while(!pIt->Bits){
+    if(!pIt->pBlk || !(pIt->pBlk=pIt->pBlk->pNext))
+      return NULL;
+    pIt->Bits=pIt->pBlk->Used;
+  }
+
+  return (char*)pIt->pBlk->Dat+__builtin_ctzll(pIt->Bits)*pIt->ElemSize;
+}
+
+
 /*****************************************************************************
  *  exported functions
  ****************************************************************************/
@@ -75,6 +170,19 @@ void* LnkList_Add(tLnkList *pList, void *pNode);
 void* LnkList_Remove(tLnkList *pList, void *pNode);
 void  LnkList_Free(tLnkList *pList);
 void  LnkList_FreeNodes(tLnkList *pList, void *pNode, int N);
+void  LnkList_InitPool(tLnkList *pList, tNodePool *pPool);
+void* LnkList_NewNode(tLnkList *pList);
+
+void  NodePool_Init(tNodePool *pPool, int NodeSize);
+void* NodePool_Alloc(tNodePool *pPool);
+void  NodePool_Put(tNodePool *pPool, void *pNode);
+void  NodePool_Reset(tNodePool *pPool);
+void  NodePool_Free(tNodePool *pPool);
+
+void  ChkList_Init(tChkList *pList, int ElemSize);
+void* ChkList_Add(tChkList *pList);
+void  ChkList_Remove(tChkList *pList, void *pElem);
+void  ChkList_Free(tChkList *pList);
 
 
 #endif /* LIST_H */
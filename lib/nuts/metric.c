@@ -0,0 +1,341 @@
+/* -*- tab-width: 8 -*- */
+/** 
+ *  light weight metrics, see metric.h. the shards of a metric are only
+ *  summed up when a snapshot is taken, so the values of a snapshot taken
+ *  while other threads are recording are not exactly consistent.
+ *
+ *  \file      metric.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"metric.h"
+#include	"debug.h"
+
+#ifdef UNIX_GNU
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<pthread.h>
+#include	<unistd.h>
+
+
+/*****************************************************************************
+ *  global variables
+ ****************************************************************************/
+
+int			g_MetricsOn=0;
+__thread int		g_MetricShard=0;	/* shard+1, 0 unassigned */
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static pthread_mutex_t	lMutex=PTHREAD_MUTEX_INITIALIZER;
+static tMetric		*lpMetrics=NULL;	/* all registered metrics */
+static int		lNMetrics=0;
+static int		lNextShard=0;
+static const char	*lAutoName=NULL;	/* NUTS_METRICS */
+
+static pthread_t	lThread;		/* Metric_Periodic() */
+static bool		lRunning=FALSE;
+static pthread_mutex_t	lPerMutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	lPerCond=PTHREAD_COND_INITIALIZER;
+static int		lPerMs;
+static tMetricFn	*lPerFn;
+static void		*lPerUser;
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  take a snapshot into a malloced array
+ *
+ *  \param  pN returns the number of metrics
+ */
+static tMetricVal *Snapshot(int *pN)
+{
+  tMetricVal	*pv=NULL;
+  int		n;
+
+  do{
+    n=Metric_Snapshot(NULL,0);
+    free(pv);
+    pv=malloc((n+1)*sizeof(*pv));  MUST(pv);
+  }while((*pN=Metric_Snapshot(pv,n+1))>n+1);
+
+  return pv;
+}
+
+
+/****************************************************************************/
+/*  print the table of all metrics
+ */
+static void Print(FILE *f, const tMetricVal *pv, int n)
+{
+  int		i;
+
+  fprintf(f,"%-32s %12s %12s %10s %10s %10s\n",
+	  "metric","count","total ms","avg us","p50 us","p99 us");
+  for(i=0;i<n;i++,pv++){
+    if(!pv->Count)
+      continue;
+    if(pv->Timed)
+      fprintf(f,"%-32s %12llu %12.3f %10.3f %10.3f %10.3f\n",
+	      pv->Name,pv->Count,pv->Sum/1e6,pv->Sum/1e3/pv->Count,
+	      Metric_Quantile(pv,0.5)/1e3,Metric_Quantile(pv,0.99)/1e3);
+    else
+      fprintf(f,"%-32s %12llu\n",pv->Name,pv->Count);
+  }
+}
+
+
+/****************************************************************************/
+/*  print the metrics at exit (NUTS_METRICS)
+ */
+static void AtExit(void)
+{
+  Metric_Periodic(0,NULL,NULL);
+  Metric_Save(lAutoName);
+}
+
+
+/****************************************************************************/
+/*  check NUTS_METRICS at startup
+ */
+static void __attribute__((constructor)) Init(void)
+{
+  if((lAutoName=getenv("NUTS_METRICS")) && *lAutoName){
+    atexit(AtExit);
+    Metric_Enable(TRUE);
+  }
+}
+
+
+/****************************************************************************/
+/*  thread of Metric_Periodic()
+ */
+static void *Periodic(void *pUndef)
+{
+  struct timespec	ts;
+  tMetricVal		*pv;
+  int			n;
+
+  pthread_mutex_lock(&lPerMutex);
+  clock_gettime(CLOCK_REALTIME,&ts);
+  while(lRunning){
+    ts.tv_sec+=lPerMs/1000;
+    ts.tv_nsec+=(lPerMs%1000)*1000000;
+    if(ts.tv_nsec>=1000000000){
+      ts.tv_sec++;
+      ts.tv_nsec-=1000000000;
+    }
+    if(pthread_cond_timedwait(&lPerCond,&lPerMutex,&ts)==0)
+      continue;
+    pv=Snapshot(&n);
+    lPerFn(pv,n,lPerUser);
+    free(pv);
+  }
+  pthread_mutex_unlock(&lPerMutex);
+
+  return pUndef;
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/** register a metric on its first use. used internally by the METRIC
+ *  macros
+ *
+ *  \param  pThat the metric
+ */
+void nuts_metricreg(tMetric *pThat)
+{
+  pthread_mutex_lock(&lMutex);
+  if(!pThat->Known){
+    pThat->pNext=lpMetrics;
+    lpMetrics=pThat;
+    lNMetrics++;
+    __atomic_store_n(&pThat->Known,1,__ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&lMutex);
+}
+
+
+/****************************************************************************/
+/** assign a shard to the calling thread. used internally by the METRIC
+ *  macros
+ *
+ *  \return shard+1
+ */
+int nuts_metricshard(void)
+{
+  return g_MetricShard=__atomic_fetch_add(&lNextShard,1,__ATOMIC_RELAXED)%
+    METRIC_SHARDS+1;
+}
+
+
+/****************************************************************************/
+/** enable/disable recording of all metrics
+ *
+ *  \param  On
+ */
+void Metric_Enable(bool On)
+{
+  __atomic_store_n(&g_MetricsOn,On,__ATOMIC_RELEASE);
+}
+
+
+/****************************************************************************/
+/** sum up the shards of all metrics that have been used so far
+ *
+ *  \param  pVal array for the values, may be NULL
+ *  \param  N    size of pVal
+ *  \return number of metrics, only the first N are written to pVal
+ */
+int Metric_Snapshot(tMetricVal *pVal, int N)
+{
+  tMetric	*pm;
+  tMetricShard	*ps;
+  int		i,s,b,n;
+
+  pthread_mutex_lock(&lMutex);
+  n=lNMetrics;
+  for(pm=lpMetrics,i=0;pm && i<N;pm=pm->pNext,i++){
+    memset(&pVal[i],0,sizeof(pVal[i]));
+    pVal[i].Name=pm->Name;
+    pVal[i].Timed=pm->Timed;
+    for(s=0;s<METRIC_SHARDS;s++){
+      ps=&pm->Shard[s];
+      pVal[i].Count+=__atomic_load_n(&ps->Count,__ATOMIC_RELAXED);
+      pVal[i].Sum+=__atomic_load_n(&ps->Sum,__ATOMIC_RELAXED);
+      for(b=0;b<METRIC_BUCKETS;b++)
+	pVal[i].Hist[b]+=__atomic_load_n(&ps->Hist[b],__ATOMIC_RELAXED);
+    }
+  }
+  pthread_mutex_unlock(&lMutex);
+
+  return n;
+}
+
+
+/****************************************************************************/
+/** clear all metrics
+ */
+void Metric_Reset(void)
+{
+  tMetric	*pm;
+  tMetricShard	*ps;
+  int		s,b;
+
+  pthread_mutex_lock(&lMutex);
+  for(pm=lpMetrics;pm;pm=pm->pNext){
+    for(s=0;s<METRIC_SHARDS;s++){
+      ps=&pm->Shard[s];
+      __atomic_store_n(&ps->Count,0,__ATOMIC_RELAXED);
+      __atomic_store_n(&ps->Sum,0,__ATOMIC_RELAXED);
+      for(b=0;b<METRIC_BUCKETS;b++)
+	__atomic_store_n(&ps->Hist[b],0,__ATOMIC_RELAXED);
+    }
+  }
+  pthread_mutex_unlock(&lMutex);
+}
+
+
+/****************************************************************************/
+/** estimate a quantile of a timed metric from its histogram
+ *
+ *  \param  pVal the metric
+ *  \param  Q    quantile in [0,1]
+ *  \return upper bound of the histogram bucket in ns
+ */
+u64 Metric_Quantile(const tMetricVal *pVal, double Q)
+{
+  u64		n=0,total=0;
+  int		b;
+
+  for(b=0;b<METRIC_BUCKETS;b++)
+    total+=pVal->Hist[b];
+  for(b=0;b<METRIC_BUCKETS;b++){
+    n+=pVal->Hist[b];
+    if(n && n>=Q*total)
+      break;
+  }
+
+  return b<METRIC_BUCKETS-1?(2ull<<b)-1:~0ull;
+}
+
+
+/****************************************************************************/
+/** print a table of all metrics
+ *
+ *  \param  Name file name, "-" for stdout
+ *  \return TRUE if successful
+ */
+bool Metric_Save(const char *Name)
+{
+  FILE		*f;
+  tMetricVal	*pv;
+  int		n;
+
+  if(strcmp(Name,"-")==0)
+    f=stdout;
+  else if(!(f=fopen(Name,"w"))){
+    WARN("can't open %s",Name);
+    return FALSE;
+  }
+
+  pv=Snapshot(&n);
+  Print(f,pv,n);
+  free(pv);
+
+  if(f==stdout)
+    fflush(f);
+  else if(fclose(f)){
+    WARN("can't write %s",Name);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** call a function with a snapshot of all metrics periodically from a
+ *  background thread
+ *
+ *  \param  Ms    period, 0 stops the thread
+ *  \param  Fn    the callback
+ *  \param  pUser passed to Fn
+ */
+void Metric_Periodic(int Ms, tMetricFn *Fn, void *pUser)
+{
+  if(lRunning){
+    pthread_mutex_lock(&lPerMutex);
+    lRunning=FALSE;
+    pthread_cond_signal(&lPerCond);
+    pthread_mutex_unlock(&lPerMutex);
+    pthread_join(lThread,NULL);
+  }
+
+  if(Ms<=0)
+    return;
+
+  ;   MUST(Fn);
+  lPerMs=Ms;
+  lPerFn=Fn;
+  lPerUser=pUser;
+  lRunning=TRUE;
+  if(pthread_create(&lThread,NULL,Periodic,NULL))
+    ERROR("can't create thread");
+}
+
+#endif /* UNIX_GNU */
@@ -0,0 +1,185 @@
+/* -*- tab-width: 8 -*- */
+/** 
+ *  light weight metrics: event counters and latency histograms with per
+ *  thread sharded relaxed atomics. every METRIC_* call site owns a static
+ *  tMetric, which registers itself on the first use. recording is enabled
+ *  with Metric_Enable() or the environment variable NUTS_METRICS=<file>
+ *  ("-" for stdout), which also prints the table at program exit. while
+ *  disabled a call site costs one predictable branch, NO_METRICS compiles
+ *  the macros out.
+ *
+ *	void Foo(void)
+ *	{
+ *	  METRIC_FUNC;
+ *	  ...
+ *	  if(miss)
+ *	    METRIC_COUNT("Foo miss");
+ *	}
+ *
+ *  \file      metric.h
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#ifndef METRIC_H
+#define METRIC_H
+
+#include	"basic.h"
+
+#ifdef UNIX_GNU
+#include	"timer.h"
+#endif
+
+
+/*****************************************************************************
+ *  defines
+ ****************************************************************************/
+
+#define METRIC_SHARDS	8		/**< power of 2 */
+#define METRIC_BUCKETS	32		/**< log2 ns buckets, the last one
+					     collects everything >= 2 s */
+
+
+/*****************************************************************************
+ *  types
+ ****************************************************************************/
+
+/** the counters of one shard, a cache line of its own
+ */
+typedef struct {
+  u64		Count;
+  u64		Sum;			/**< ns */
+  u64		Hist[METRIC_BUCKETS];	/**< bucket b counts [2^b,2^(b+1)) ns */
+} __attribute__((aligned(64))) tMetricShard;
+
+/** static state of a metric call site
+ */
+typedef struct sMetric {
+  const char	*Name;
+  int		Timed;		/**< histogram (METRIC_SCOPE) or counter */
+  int		Known;		/**< registered */
+  struct sMetric *pNext;
+  tMetricShard	Shard[METRIC_SHARDS];
+} tMetric;
+
+/** state of an open METRIC_SCOPE
+ */
+typedef struct {
+  tMetric	*p;
+  u64		T0;		/**< start time, 0 if disabled */
+} tMetricScope;
+
+/** a metric summed over all shards, see Metric_Snapshot()
+ */
+typedef struct {
+  const char	*Name;
+  int		Timed;
+  u64		Count;
+  u64		Sum;
+  u64		Hist[METRIC_BUCKETS];
+} tMetricVal;
+
+/** callback of Metric_Periodic()
+ */
+typedef void tMetricFn(const tMetricVal *pVal, int N, void *pUser);
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+EXTERN_C_BEGIN
+
+extern int		g_MetricsOn;
+#ifdef UNIX_GNU
+extern __thread int	g_MetricShard;
+#endif
+
+void nuts_metricreg(tMetric *pThat);
+int  nuts_metricshard(void);
+
+void Metric_Enable(bool On);
+int  Metric_Snapshot(tMetricVal *pVal, int N);
+void Metric_Reset(void);
+u64  Metric_Quantile(const tMetricVal *pVal, double Q);
+bool Metric_Save(const char *Name);
+void Metric_Periodic(int Ms, tMetricFn *Fn, void *pUser);
+
+EXTERN_C_END
+
+
+/*****************************************************************************
+ *  recording
+ ****************************************************************************/
+
+#if defined UNIX_GNU && !defined NO_METRICS
+
+#define METRIC_SYM_(p,x) p##x
+#define METRIC_SYM(p,x)	METRIC_SYM_(p,x)
+
+/** add to a metric, used internally by the METRIC macros
+ */
+static inline void nuts_metricadd(tMetric *pThat, u64 N, u64 Ns)
+{
+  tMetricShard	*ps;
+  int		s=g_MetricShard;
+
+  if(__builtin_expect(!pThat->Known,0))
+    nuts_metricreg(pThat);
+  if(__builtin_expect(!s,0))
+    s=nuts_metricshard();
+
+  ps=&pThat->Shard[(s-1)&(METRIC_SHARDS-1)];
+  __atomic_fetch_add(&ps->Count,N,__ATOMIC_RELAXED);
+  if(pThat->Timed){
+    __atomic_fetch_add(&ps->Sum,Ns,__ATOMIC_RELAXED);
+    __atomic_fetch_add(&ps->Hist[Ns?MIN(63-__builtin_clzll(Ns),
+					METRIC_BUCKETS-1):0],
+		       1,__ATOMIC_RELAXED);
+  }
+}
+
+/** cleanup handler of METRIC_SCOPE
+ */
+static inline void nuts_metricscope(tMetricScope *p)
+{
+  if(__builtin_expect(p->T0!=0,0))
+    nuts_metricadd(p->p,1,timerNs()-p->T0);
+}
+
+/** count and time the rest of the enclosing block
+ *  \param name static string
+ */
+#define METRIC_SCOPE(name) \
+	static tMetric METRIC_SYM(mtr_,__LINE__)={.Name=(name),.Timed=1}; \
+	tMetricScope METRIC_SYM(mts_,__LINE__) \
+	__attribute__((cleanup(nuts_metricscope)))= \
+	{ &METRIC_SYM(mtr_,__LINE__), \
+	  __builtin_expect(g_MetricsOn,0)?timerNs():0 }
+
+/** count and time the rest of the enclosing function
+ */
+#define METRIC_FUNC	METRIC_SCOPE(__func__)
+
+/** add n to a counter
+ *  \param name static string
+ */
+#define METRIC_ADD(name,n) do{ static tMetric mtr_={.Name=(name),.Timed=0}; \
+	if(__builtin_expect(g_MetricsOn,0)) nuts_metricadd(&mtr_,(n),0); \
+	}while(0)
+
+/** increment a counter
+ */
+#define METRIC_COUNT(name)	METRIC_ADD(name,1)
+
+#else
+
+#define METRIC_SCOPE(name)
+#define METRIC_FUNC
+#define METRIC_ADD(name,n)
+#define METRIC_COUNT(name)
+
+#endif
+
+#endif /* METRIC_H */
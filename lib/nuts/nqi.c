@@ -0,0 +1,775 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  nqi line coder, see nqi.h. the residuals of a whole line are computed
+ *  first (no dependencies, SSE2 does 8 at once), then written block by
+ *  block as bit planes: with SSE2 a plane of 32 residuals is two
+ *  movemasks. decoding has to run along the line, since each pel is
+ *  predicted from the one decoded before.
+ *
+ *  \file      nqi.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"nqi.h"
+#include	"debug.h"
+#include	<stdlib.h>
+#include	<string.h>
+#if defined __x86_64__ || (defined __i386__ && defined __SSE2__)
+#define SIMD_X86
+#include	<emmintrin.h>
+#endif
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define BLK		32		/* samples per block */
+
+#define PUT32(p,v)	((p)[0]=(v),(p)[1]=(v)>>8,(p)[2]=(v)>>16,(p)[3]=(v)>>24)
+#define GET32(p)	((u32)(p)[0]|(u32)(p)[1]<<8|(u32)(p)[2]<<16|\
+			 (u32)(p)[3]<<24)
+
+/* bits of a byte to the lsbs of the bytes of a u64 */
+#define SPREAD(x)	((((x)&0x7f)*0x0002040810204081ull&0x0101010101010101ull)|\
+			 (u64)((x)>>7)<<56)
+
+/* median of LOCO-I: left a, up b, up left c. same as a+b-c clipped to the
+   range of a and b */
+#define MED(a,b,c)	MIN(MAX((a)+(b)-(c),MIN(a,b)),MAX(a,b))
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  zigzag code a residual of 8 or 16 bit
+ */
+static inline u8 Zig8(int d)
+{
+  s8		s=d;
+
+  return (u8)((u8)s<<1)^(u8)(s>>7);
+}
+
+static inline u16 Zig16(int d)
+{
+  s16		s=d;
+
+  return (u16)((u16)s<<1)^(u16)(s>>15);
+}
+
+static inline int UnZig(u32 z)
+{
+  return (int)(z>>1)^-(int)(z&1);
+}
+
+
+#ifdef SIMD_X86
+/****************************************************************************/
+/*  median predictor on 8 samples of 16 bit. Bias is 0x8000 for unsigned 16
+ *  bit samples, so the signed compares work, 0 for 8bit ones
+ */
+static inline __m128i Med(__m128i a, __m128i b, __m128i c, __m128i Bias)
+{
+  __m128i	ab=_mm_xor_si128(a,Bias),bb=_mm_xor_si128(b,Bias);
+  __m128i	cb=_mm_xor_si128(c,Bias),mx,mn,t,m;
+
+  mx=_mm_max_epi16(ab,bb);
+  mn=_mm_min_epi16(ab,bb);
+  t=_mm_sub_epi16(_mm_add_epi16(a,b),c);
+
+  /* c<=mn: mx, c>=mx: mn, else a+b-c */
+  m=_mm_cmpgt_epi16(cb,mn);
+  t=_mm_or_si128(_mm_and_si128(m,t),_mm_andnot_si128(m,_mm_xor_si128(mx,Bias)));
+  m=_mm_cmpgt_epi16(mx,cb);
+  return _mm_or_si128(_mm_and_si128(m,t),_mm_andnot_si128(m,_mm_xor_si128(mn,Bias)));
+}
+
+
+/****************************************************************************/
+/*  zigzag of 8 residuals of 16 bit
+ */
+static inline __m128i Zig(__m128i d)
+{
+  return _mm_xor_si128(_mm_slli_epi16(d,1),_mm_srai_epi16(d,15));
+}
+
+
+/****************************************************************************/
+/*  Resid8() from sample i on, returns the number done
+ */
+static int Resid8Sse2(u8 *pZ, const u8 *p, const u8 *pUp, int N, int C, int i)
+{
+  __m128i	zero=_mm_setzero_si128(),x[2],a[2],b[2],c[2],z[2];
+  int		h;
+
+  /* 16 samples, as two halfs of 8 in 16bit lanes */
+#define LD8(v,q)	(v[0]=_mm_loadu_si128((const __m128i*)(q)),\
+			 v[1]=_mm_unpackhi_epi8(v[0],zero),\
+			 v[0]=_mm_unpacklo_epi8(v[0],zero))
+  for(;i+16<=N;i+=16){
+    LD8(x,p+i);
+    LD8(a,p+i-C);
+    if(pUp){
+      LD8(b,pUp+i);
+      LD8(c,pUp+i-C);
+    }
+    for(h=0;h<2;h++){
+      if(pUp)
+	a[h]=Med(a[h],b[h],c[h],zero);
+      /* sign extend the low byte of the difference */
+      z[h]=_mm_sub_epi16(x[h],a[h]);
+      z[h]=Zig(_mm_srai_epi16(_mm_slli_epi16(z[h],8),8));
+    }
+    _mm_storeu_si128((__m128i*)(pZ+i),_mm_packus_epi16(z[0],z[1]));
+  }
+#undef LD8
+  return i;
+}
+
+
+/****************************************************************************/
+/*  Resid16() from sample 1 on, returns the number done
+ */
+static int Resid16Sse2(u16 *pZ, const u16 *p, const u16 *pUp, int N)
+{
+  __m128i	bias=_mm_set1_epi16(-0x8000),x,a,b,c;
+  int		i;
+
+#define LD16(q)	_mm_loadu_si128((const __m128i*)(q))
+  for(i=1;i+8<=N;i+=8){
+    x=LD16(p+i);
+    a=LD16(p+i-1);
+    if(pUp){
+      b=LD16(pUp+i);
+      c=LD16(pUp+i-1);
+      a=Med(a,b,c,bias);
+    }
+    _mm_storeu_si128((__m128i*)(pZ+i),Zig(_mm_sub_epi16(x,a)));
+  }
+#undef LD16
+  return i;
+}
+#endif /* SIMD_X86 */
+
+
+/****************************************************************************/
+/*  residuals of a line of 8bit samples, C channels
+ */
+static void Resid8(u8 *pZ, const u8 *p, const u8 *pUp, int N, int C)
+{
+  int		i,a,b,c;
+
+  for(i=0;i<C && i<N;i++)
+    pZ[i]=Zig8(p[i]-(pUp?pUp[i]:0));
+#ifdef SIMD_X86
+  i=Resid8Sse2(pZ,p,pUp,N,C,i);
+#endif
+  if(!pUp)
+    for(;i<N;i++)
+      pZ[i]=Zig8(p[i]-p[i-C]);
+  else
+    for(;i<N;i++){
+      a=p[i-C]; b=pUp[i]; c=pUp[i-C];
+      pZ[i]=Zig8(p[i]-MED(a,b,c));
+    }
+}
+
+
+/****************************************************************************/
+/*  residuals of a line of 16bit samples
+ */
+static void Resid16(u16 *pZ, const u16 *p, const u16 *pUp, int N)
+{
+  int		i=1,a,b,c;
+
+  if(N<1)
+    return;
+  pZ[0]=Zig16(p[0]-(pUp?pUp[0]:0));
+#ifdef SIMD_X86
+  i=Resid16Sse2(pZ,p,pUp,N);
+#endif
+  if(!pUp)
+    for(;i<N;i++)
+      pZ[i]=Zig16(p[i]-p[i-1]);
+  else
+    for(;i<N;i++){
+      a=p[i-1]; b=pUp[i]; c=pUp[i-1];
+      pZ[i]=Zig16(p[i]-MED(a,b,c));
+    }
+}
+
+
+/****************************************************************************/
+/*  zigzag coded differences of N samples to the previous frame, Bpp 2 for
+ *  16bit samples, else 8 bit
+ */
+static void Delta(u8 *pZ, const u8 *p, const u8 *pPrev, int N, int Bpp)
+{
+  int		i=0;
+
+  if(Bpp==2){
+    u16		*pz=(u16*)pZ;
+    const u16	*p16=(const u16*)p,*pp16=(const u16*)pPrev;
+
+#ifdef SIMD_X86
+    for(;i+8<=N;i+=8)
+      _mm_storeu_si128((__m128i*)(pz+i),Zig(_mm_sub_epi16(
+	_mm_loadu_si128((const __m128i*)(p16+i)),
+	_mm_loadu_si128((const __m128i*)(pp16+i)))));
+#endif
+    for(;i<N;i++)
+      pz[i]=Zig16(p16[i]-pp16[i]);
+  }
+  else{
+#ifdef SIMD_X86
+    __m128i	zero=_mm_setzero_si128(),d;
+
+    for(;i+16<=N;i+=16){
+      d=_mm_sub_epi8(_mm_loadu_si128((const __m128i*)(p+i)),
+		     _mm_loadu_si128((const __m128i*)(pPrev+i)));
+      _mm_storeu_si128((__m128i*)(pZ+i),
+		       _mm_xor_si128(_mm_add_epi8(d,d),_mm_cmpgt_epi8(zero,d)));
+    }
+#endif
+    for(;i<N;i++)
+      pZ[i]=Zig8(p[i]-pPrev[i]);
+  }
+}
+
+
+/****************************************************************************/
+/*  write a block of BLK residuals of 8 bit: the width B of the largest one
+ *  and the B lower bit planes, one 32bit word per plane
+ *
+ *  \return bytes written
+ */
+static int Pack8(u8 *pd, const u8 *pz)
+{
+  int		i,k,b;
+  u32		m,o;
+
+#ifdef SIMD_X86
+  __m128i	v0,v1,t,sh;
+
+  v0=_mm_loadu_si128((const __m128i*)pz);
+  v1=_mm_loadu_si128((const __m128i*)(pz+16));
+  t=_mm_or_si128(v0,v1);
+  t=_mm_or_si128(t,_mm_srli_si128(t,8));
+  t=_mm_or_si128(t,_mm_srli_si128(t,4));
+  t=_mm_or_si128(t,_mm_srli_si128(t,2));
+  t=_mm_or_si128(t,_mm_srli_si128(t,1));
+  o=_mm_cvtsi128_si32(t)&0xff;
+  b=o?32-__builtin_clz(o):0;
+
+  for(k=0;k<b;k++){
+    /* bit k of each byte to its msb */
+    sh=_mm_cvtsi32_si128(7-k);
+    m=(u32)_mm_movemask_epi8(_mm_sll_epi16(v0,sh))|
+      (u32)_mm_movemask_epi8(_mm_sll_epi16(v1,sh))<<16;
+    PUT32(pd+1+4*k,m);
+  }
+#else
+  for(o=0,i=0;i<BLK;i++)
+    o|=pz[i];
+  b=o?32-__builtin_clz(o):0;
+  for(k=0;k<b;k++){
+    for(m=0,i=0;i<BLK;i++)
+      m|=(u32)(pz[i]>>k&1)<<i;
+    PUT32(pd+1+4*k,m);
+  }
+#endif
+  *pd=b;
+  (void)i;
+
+  return 1+4*b;
+}
+
+
+/****************************************************************************/
+/*  as Pack8() for residuals of 16 bit
+ */
+static int Pack16(u8 *pd, const u16 *pz)
+{
+  int		i,k=0,b;
+  u32		m,o;
+
+#ifdef SIMD_X86
+  __m128i	ff=_mm_set1_epi16(0xff),v[4],l0,l1,sh;
+
+  for(i=0;i<4;i++)
+    v[i]=_mm_loadu_si128((const __m128i*)(pz+8*i));
+  l0=_mm_or_si128(_mm_or_si128(v[0],v[1]),_mm_or_si128(v[2],v[3]));
+  l0=_mm_or_si128(l0,_mm_srli_si128(l0,8));
+  l0=_mm_or_si128(l0,_mm_srli_si128(l0,4));
+  l0=_mm_or_si128(l0,_mm_srli_si128(l0,2));
+  o=_mm_cvtsi128_si32(l0)&0xffff;
+  b=o?32-__builtin_clz(o):0;
+
+  /* low bytes first, then the high bytes */
+  l0=_mm_packus_epi16(_mm_and_si128(v[0],ff),_mm_and_si128(v[1],ff));
+  l1=_mm_packus_epi16(_mm_and_si128(v[2],ff),_mm_and_si128(v[3],ff));
+  for(;k<b;k++){
+    if(k==8){
+      l0=_mm_packus_epi16(_mm_srli_epi16(v[0],8),_mm_srli_epi16(v[1],8));
+      l1=_mm_packus_epi16(_mm_srli_epi16(v[2],8),_mm_srli_epi16(v[3],8));
+    }
+    sh=_mm_cvtsi32_si128(7-(k&7));
+    m=(u32)_mm_movemask_epi8(_mm_sll_epi16(l0,sh))|
+      (u32)_mm_movemask_epi8(_mm_sll_epi16(l1,sh))<<16;
+    PUT32(pd+1+4*k,m);
+  }
+#else
+  for(o=0,i=0;i<BLK;i++)
+    o|=pz[i];
+  b=o?32-__builtin_clz(o):0;
+  for(;k<b;k++){
+    for(m=0,i=0;i<BLK;i++)
+      m|=(u32)(pz[i]>>k&1)<<i;
+    PUT32(pd+1+4*k,m);
+  }
+#endif
+  *pd=b;
+
+  return 1+4*b;
+}
+
+
+/****************************************************************************/
+/*  read the B bit planes of a block of BLK residuals, planes 0..7 as BLK
+ *  bytes to pLo, planes 8..15 to pHi (NULL for 8 bit residuals). with SSE2
+ *  a plane is spread over 32 bytes by unpacking and a compare, else
+ *  SPREAD() does 8 samples at once
+ */
+static void Unpack(u8 *pLo, u8 *pHi, const u8 *ps, int B)
+{
+  int		i,k;
+
+#ifdef SIMD_X86
+  const __m128i	sel=_mm_set1_epi64x(0x8040201008040201ll);
+  __m128i	acc[4],v,w,m;
+
+  for(i=0;i<4;i++)
+    acc[i]=_mm_setzero_si128();
+  for(k=0;k<B;k++,ps+=4){
+    /* bytes 0..3 of the plane 8 times each, then the bit of each lane */
+    v=_mm_cvtsi32_si128(GET32(ps));
+    v=_mm_unpacklo_epi8(v,v);
+    v=_mm_unpacklo_epi16(v,v);
+    w=_mm_unpackhi_epi32(v,v);
+    v=_mm_unpacklo_epi32(v,v);
+    m=_mm_set1_epi8(1<<(k&7));
+    v=_mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(v,sel),sel),m);
+    w=_mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(w,sel),sel),m);
+    i=k>>3<<1;
+    acc[i]=_mm_or_si128(acc[i],v);
+    acc[i+1]=_mm_or_si128(acc[i+1],w);
+  }
+  _mm_storeu_si128((__m128i*)pLo,acc[0]);
+  _mm_storeu_si128((__m128i*)(pLo+16),acc[1]);
+  if(pHi){
+    _mm_storeu_si128((__m128i*)pHi,acc[2]);
+    _mm_storeu_si128((__m128i*)(pHi+16),acc[3]);
+  }
+#else
+  u64		lo[4]={0,0,0,0},hi[4]={0,0,0,0},*pa;
+  u32		m;
+
+  for(k=0;k<B;k++,ps+=4){
+    m=GET32(ps);
+    pa=k<8?lo:hi;
+    for(i=0;i<4;i++)
+      pa[i]|=SPREAD(m>>8*i&0xff)<<(k&7);
+  }
+  for(i=0;i<BLK;i++){
+    pLo[i]=lo[i/8]>>8*(i%8);
+    if(pHi)
+      pHi[i]=hi[i/8]>>8*(i%8);
+  }
+#endif
+}
+
+
+/****************************************************************************/
+/*  undo the prediction of a line of N samples of C interleaved channels.
+ *  the left and upper left neighbours stay in registers, so the chain
+ *  from one sample to the next is just the median and an add. meant to be
+ *  inlined with a constant C
+ */
+static inline __attribute__((always_inline))
+void Recon8(u8 *p, const u8 *pu, const u8 *pz, int N, const int C)
+{
+  int		a[4],c[4],b,i,k;
+
+  for(k=0;k<C;k++){
+    c[k]=pu?pu[k]:0;
+    a[k]=p[k]=c[k]+UnZig(pz[k]);
+  }
+  if(!pu)
+    for(i=C;i<N;i+=C)
+      for(k=0;k<C;k++)
+	a[k]=p[i+k]=a[k]+UnZig(pz[i+k]);
+  else
+    for(i=C;i<N;i+=C)
+      for(k=0;k<C;k++){
+	b=pu[i+k];
+	a[k]=p[i+k]=MED(a[k],b,c[k])+UnZig(pz[i+k]);
+	c[k]=b;
+      }
+}
+
+
+#ifdef SIMD_X86
+/****************************************************************************/
+/*  Recon8() for 4 channels, a pel at a time in 16bit lanes
+ */
+static void Recon8x4(u8 *p, const u8 *pu, const u8 *pz, int N)
+{
+  __m128i	zero=_mm_setzero_si128(),ff=_mm_set1_epi16(0xff);
+  __m128i	a,b,c,z,d;
+  int		i;
+
+#define LD4(q)	_mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const u32*)(q)),zero)
+  c=zero;
+  a=zero;
+  for(i=0;i<N;i+=4){
+    z=LD4(pz+i);
+    d=_mm_xor_si128(_mm_srli_epi16(z,1),
+		    _mm_sub_epi16(zero,_mm_and_si128(z,_mm_set1_epi16(1))));
+    b=pu?LD4(pu+i):zero;
+    a=_mm_and_si128(_mm_add_epi16(i?Med(a,b,c,zero):b,d),ff);
+    *(u32*)(p+i)=_mm_cvtsi128_si32(_mm_packus_epi16(a,a));
+    c=b;
+  }
+#undef LD4
+}
+#endif
+
+
+/****************************************************************************/
+/*  as Recon8() for one channel of 16 bit
+ */
+static void Recon16(u16 *p, const u16 *pu, const u16 *pz, int N)
+{
+  int		a,c,b,i;
+
+  c=pu?pu[0]:0;
+  a=p[0]=c+UnZig(pz[0]);
+  if(!pu)
+    for(i=1;i<N;i++)
+      a=p[i]=a+UnZig(pz[i]);
+  else
+    for(i=1;i<N;i++){
+      b=pu[i];
+      a=p[i]=MED(a,b,c)+UnZig(pz[i]);
+      c=b;
+    }
+}
+
+
+/****************************************************************************/
+/*  p=pPrev+residual for the N zigzag coded residuals of Delta()
+ */
+static void UnDelta(u8 *p, const u8 *pPrev, const u8 *pZ, int N, int Bpp)
+{
+  int		i=0;
+
+  if(Bpp==2){
+    u16		*p16=(u16*)p;
+    const u16	*pz=(const u16*)pZ,*pp16=(const u16*)pPrev;
+
+#ifdef SIMD_X86
+    __m128i	zero=_mm_setzero_si128(),one=_mm_set1_epi16(1),z;
+
+    for(;i+8<=N;i+=8){
+      z=_mm_loadu_si128((const __m128i*)(pz+i));
+      z=_mm_xor_si128(_mm_srli_epi16(z,1),
+		      _mm_sub_epi16(zero,_mm_and_si128(z,one)));
+      _mm_storeu_si128((__m128i*)(p16+i),_mm_add_epi16(z,
+	_mm_loadu_si128((const __m128i*)(pp16+i))));
+    }
+#endif
+    for(;i<N;i++)
+      p16[i]=pp16[i]+UnZig(pz[i]);
+  }
+  else{
+#ifdef SIMD_X86
+    __m128i	zero=_mm_setzero_si128(),one=_mm_set1_epi8(1);
+    __m128i	m7f=_mm_set1_epi8(0x7f),z;
+
+    for(;i+16<=N;i+=16){
+      z=_mm_loadu_si128((const __m128i*)(pZ+i));
+      z=_mm_xor_si128(_mm_and_si128(_mm_srli_epi16(z,1),m7f),
+		      _mm_sub_epi8(zero,_mm_and_si128(z,one)));
+      _mm_storeu_si128((__m128i*)(p+i),_mm_add_epi8(z,
+	_mm_loadu_si128((const __m128i*)(pPrev+i))));
+    }
+#endif
+    for(;i<N;i++)
+      p[i]=pPrev[i]+UnZig(pZ[i]);
+  }
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/** initialize a line coder
+ *
+ *  \param  pThat the coder
+ *  \param  Dx    pels per line
+ *  \param  Bpp   bytes per pel: 1, 2 (one 16bit sample), 3 or 4 (channels
+ *		  of 8 bit)
+ */
+void Nqi_Init(tNqi *pThat, int Dx, int Bpp)
+{
+  ;   MUST_In(Bpp,1,4);  MUST(Dx>0);
+
+  pThat->Dx=Dx;
+  pThat->Bpp=Bpp;
+  pThat->N=Bpp==2?Dx:Dx*Bpp;
+  pThat->pZ=calloc(PAD(pThat->N,BLK),sizeof(u16));  MUST(pThat->pZ);
+}
+
+
+/****************************************************************************/
+/** free a line coder
+ *
+ *  \param  pThat the coder
+ */
+void Nqi_Free(tNqi *pThat)
+{
+  free(pThat->pZ);
+  pThat->pZ=NULL;
+}
+
+
+/****************************************************************************/
+/** max bytes of a coded line
+ *
+ *  \param  pThat the coder
+ *  \return the size
+ */
+int Nqi_Bound(const tNqi *pThat)
+{
+  return PAD(pThat->N,BLK)/BLK*(1+4*(pThat->Bpp==2?16:8));
+}
+
+
+/****************************************************************************/
+/** code a line
+ *
+ *  \param  pThat the coder
+ *  \param  pDst  Nqi_Bound() bytes
+ *  \param  pRow  the pels
+ *  \param  pUp   the line above, NULL for the first line
+ *  \return bytes in pDst
+ */
+int Nqi_EncodeRow(tNqi *pThat, u8 *pDst, const void *pRow, const void *pUp)
+{
+  u8		*pd=pDst;
+  int		k,n=pThat->N;
+
+  /* the tail of the last block is coded as 0 */
+  if(pThat->Bpp==2){
+    u16		*pz=(u16*)pThat->pZ;
+
+    Resid16(pz,pRow,pUp,n);
+    memset(pz+n,0,(PAD(n,BLK)-n)*sizeof(u16));
+    for(k=0;k<n;k+=BLK)
+      pd+=Pack16(pd,pz+k);
+  }
+  else{
+    u8		*pz=pThat->pZ;
+
+    Resid8(pz,pRow,pUp,n,pThat->Bpp);
+    memset(pz+n,0,PAD(n,BLK)-n);
+    for(k=0;k<n;k+=BLK)
+      pd+=Pack8(pd,pz+k);
+  }
+
+  return pd-pDst;
+}
+
+
+/****************************************************************************/
+/** decode a line
+ *
+ *  \param  pThat the coder
+ *  \param  pRow  the pels
+ *  \param  pUp   the line above, NULL for the first line
+ *  \param  pSrc  the coded line
+ *  \param  N     bytes in pSrc
+ *  \return bytes used from pSrc, -1 if it is not a valid line
+ */
+int Nqi_DecodeRow(tNqi *pThat, void *pRow, const void *pUp, const u8 *pSrc,
+		  int N)
+{
+  const u8	*ps=pSrc,*pe=pSrc+N;
+  u8		lo[BLK],hi[BLK];
+  int		i,k,b,n=pThat->N,c=pThat->Bpp;
+
+  /* residuals */
+  for(k=0;k<n;k+=BLK){
+    if(ps>=pe || (b=*ps++)>(c==2?16:8) || ps+4*b>pe)
+      return -1;
+    if(c==2){
+      Unpack(lo,hi,ps,b);
+      for(i=0;i<BLK;i++)
+	((u16*)pThat->pZ)[k+i]=lo[i]|hi[i]<<8;
+    }
+    else
+      Unpack(pThat->pZ+k,NULL,ps,b);
+    ps+=4*b;
+  }
+
+  /* pels */
+  if(c==2)
+    Recon16(pRow,pUp,(u16*)pThat->pZ,n);
+  else if(c==1)
+    Recon8(pRow,pUp,pThat->pZ,n,1);
+  else if(c==3)
+    Recon8(pRow,pUp,pThat->pZ,n,3);
+  else
+#ifdef SIMD_X86
+    Recon8x4(pRow,pUp,pThat->pZ,n);
+#else
+    Recon8(pRow,pUp,pThat->pZ,n,4);
+#endif
+
+  return ps-pSrc;
+}
+
+
+/****************************************************************************/
+/** code a line as difference to the same line of the previous frame. the
+ *  blocks are the same as for Nqi_EncodeRow(), but a run of up to 128
+ *  blocks without change is a single byte 0x80+n-1, so a line that did not
+ *  change costs a few bytes
+ *
+ *  \param  pThat the coder
+ *  \param  pDst  Nqi_Bound() bytes
+ *  \param  pRow  the pels
+ *  \param  pPrev the line in the previous frame
+ *  \return bytes in pDst
+ */
+int Nqi_EncodeDelta(tNqi *pThat, u8 *pDst, const void *pRow, const void *pPrev)
+{
+  u8		*pd=pDst,*pr=NULL;
+  int		k,l,n=pThat->N,c=pThat->Bpp;
+
+  Delta(pThat->pZ,pRow,pPrev,n,c);
+  memset(pThat->pZ+n*(c==2?2:1),0,(PAD(n,BLK)-n)*(c==2?2:1));
+  for(k=0;k<n;k+=BLK){
+    l=c==2?Pack16(pd,(u16*)pThat->pZ+k):Pack8(pd,pThat->pZ+k);
+    if(l>1){
+      pd+=l;
+      pr=NULL;
+    }
+    else if(pr && *pr<0xff)
+      (*pr)++;
+    else{
+      pr=pd;
+      *pd++=0x80;
+    }
+  }
+
+  return pd-pDst;
+}
+
+
+/****************************************************************************/
+/** decode a line of Nqi_EncodeDelta()
+ *
+ *  \param  pThat the coder
+ *  \param  pRow  the pels
+ *  \param  pPrev the line in the previous frame
+ *  \param  pSrc  the coded line
+ *  \param  N     bytes in pSrc
+ *  \return bytes used from pSrc, -1 if it is not a valid line
+ */
+int Nqi_DecodeDelta(tNqi *pThat, void *pRow, const void *pPrev,
+		    const u8 *pSrc, int N)
+{
+  const u8	*ps=pSrc,*pe=pSrc+N;
+  u8		lo[BLK],hi[BLK];
+  int		i,k,b,n=pThat->N,c=pThat->Bpp,z=c==2?2:1;
+
+  for(k=0;k<n;k+=BLK){
+    if(ps>=pe)
+      return -1;
+    b=*ps++;
+    if(b>=0x80){
+      b-=0x7f;
+      if(k+b*BLK>PAD(n,BLK))
+	return -1;
+      memset(pThat->pZ+k*z,0,b*BLK*z);
+      k+=(b-1)*BLK;
+      continue;
+    }
+    if(b>(c==2?16:8) || ps+4*b>pe)
+      return -1;
+    if(c==2){
+      Unpack(lo,hi,ps,b);
+      for(i=0;i<BLK;i++)
+	((u16*)pThat->pZ)[k+i]=lo[i]|hi[i]<<8;
+    }
+    else
+      Unpack(pThat->pZ+k,NULL,ps,b);
+    ps+=4*b;
+  }
+  UnDelta(pRow,pPrev,pThat->pZ,n,c);
+
+  return ps-pSrc;
+}
+
+
+/****************************************************************************/
+/** write the header of a nqi file
+ *
+ *  \param  pDst  NQI_HEAD bytes
+ *  \param  Type  PIC_G8, PIC_G16 or PIC_XRGB
+ *  \param  Bpp   bytes per pel
+ *  \param  Dx,Dy size
+ */
+void Nqi_PutHead(u8 *pDst, int Type, int Bpp, int Dx, int Dy)
+{
+  memcpy(pDst,"NQI1",4);
+  pDst[4]=Type;
+  pDst[5]=Bpp;
+  pDst[6]=pDst[7]=0;
+  PUT32(pDst+8,(u32)Dx);
+  PUT32(pDst+12,(u32)Dy);
+}
+
+
+/****************************************************************************/
+/** read the header of a nqi file
+ *
+ *  \param  pSrc  NQI_HEAD bytes
+ *  \param  pType PIC_G8, PIC_G16 or PIC_XRGB
+ *  \param  pBpp  bytes per pel
+ *  \param  pDx   width
+ *  \param  pDy   height
+ *  \return FALSE if it is not a nqi header
+ */
+bool Nqi_GetHead(const u8 *pSrc, int *pType, int *pBpp, int *pDx, int *pDy)
+{
+  u32		dx=GET32(pSrc+8),dy=GET32(pSrc+12);
+
+  if(memcmp(pSrc,"NQI1",4)!=0 || pSrc[5]<1 || pSrc[5]>4 ||
+     dx<1 || dx>1<<16 || dy<1 || dy>1<<16)
+    return FALSE;
+  *pType=pSrc[4];
+  *pBpp=pSrc[5];
+  *pDx=dx;
+  *pDy=dy;
+
+  return TRUE;
+}
@@ -0,0 +1,72 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  nqi, a fast lossless codec for the lines of 8, 16 and 32bit pics (the
+ *  latter as 4 channels of 8 bit). each sample is predicted from its left,
+ *  upper and upper left neighbour of the same channel (the median predictor
+ *  of LOCO-I), the residuals are zigzag coded and stored in blocks of 32
+ *  as a width byte and that many bit planes of 32 bit. no tables, no
+ *  entropy coder, so it codes at memory speed and still halves typical
+ *  camera frames.
+ *
+ *  Nqi_EncodeDelta() codes a line against the same line of the previous
+ *  frame instead, for sequences, see picseq.h.
+ *
+ *  a file is NQI_HEAD bytes of header and then for each line a 32bit
+ *  little endian byte count and the coded line, see Pic8_SaveNqi() etc.
+ *
+ *  \file      nqi.h
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#ifndef NQI_H
+#define NQI_H
+
+#include	"basic.h"
+
+
+/*****************************************************************************
+ *  defines
+ ****************************************************************************/
+
+#define NQI_HEAD	16	/**< bytes of the file header */
+
+
+/*****************************************************************************
+ *  types
+ ****************************************************************************/
+
+/** state of a coder for lines of one size
+ */
+typedef struct {
+  int		Dx;		/**< pels per line */
+  int		Bpp;		/**< bytes per pel, 1..4 */
+  int		N;		/**< samples per line */
+  u8		*pZ;		/**< residuals of a line, u16 for Bpp 2 */
+} tNqi;
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+EXTERN_C_BEGIN
+
+void Nqi_Init(tNqi *pThat, int Dx, int Bpp);
+void Nqi_Free(tNqi *pThat);
+int  Nqi_Bound(const tNqi *pThat);
+int  Nqi_EncodeRow(tNqi *pThat, u8 *pDst, const void *pRow, const void *pUp);
+int  Nqi_DecodeRow(tNqi *pThat, void *pRow, const void *pUp, const u8 *pSrc,
+		   int N);
+int  Nqi_EncodeDelta(tNqi *pThat, u8 *pDst, const void *pRow,
+		     const void *pPrev);
+int  Nqi_DecodeDelta(tNqi *pThat, void *pRow, const void *pPrev,
+		     const u8 *pSrc, int N);
+
+void Nqi_PutHead(u8 *pDst, int Type, int Bpp, int Dx, int Dy);
+bool Nqi_GetHead(const u8 *pSrc, int *pType, int *pBpp, int *pDx, int *pDy);
+
+EXTERN_C_END
+
+#endif /* NQI_H */
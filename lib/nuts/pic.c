@@ -17,6 +17,11 @@
 #include		<stdio.h>
 #include		<string.h>
 #include		<malloc.h>
+#ifdef UNIX_GNU
+#include		<unistd.h>
+#include		<fcntl.h>
+#include		<pthread.h>
+#endif
 #elif defined		LINUX_KERNEL
 #include		<linux/module.h>
 #include		<linux/kernel.h>
@@ -32,12 +37,22 @@
 #define fclose(a)	(MUST_MSG(0,"don't have this in kernel"))
 #define fprintf(...)	(MUST_MSG(0,"don't have this in kernel"))
 #define fscanf(...)	(MUST_MSG(0,"don't have this in kernel"))
+#define ungetc(a,b)	(MUST_MSG(0,"don't have this in kernel"))
+#define ftell(a)	(MUST_MSG(0,"don't have this in kernel"))
 #define FILE		void
 #endif
 
 #include		"debug.h"
 #include		"pic.h"
 #include		"bits.h"
+#include		"trace.h"
+#include		"metric.h"
+#include		"nqi.h"
+#if (defined __x86_64__ || (defined __i386__ && defined __SSE2__)) \
+    && !defined LINUX_KERNEL
+#define SIMD_X86
+#include		<emmintrin.h>
+#endif
 
 
 /*****************************************************************************
@@ -51,6 +66,19 @@
 #define CEW32(a,v)	(*((u32*)(a))=(v))
 #define CEW16(a,v)	(*((u16*)(a))=(v))
 
+#ifdef UNIX_GNU
+#define GETC(f)		getc_unlocked(f)
+#else
+#define GETC(f)		fgetc(f)
+#endif
+
+#define ROI_PAR_MIN	(1<<20)	/* bytes of a roi worth parallel reads */
+#define ROI_THREADS	16
+
+#define YUV_RGBX	0	/* pel formats of YuvRow() */
+#define YUV_BGRX	1
+#define YUV_565		2
+
 
 /*****************************************************************************
  *  local macros: kernel dummies
@@ -67,12 +95,545 @@
 #define fclose(a)	MUST_MSG(0,"don't have this in kernel")
 #define fprintf(...)	MUST_MSG(0,"don't have this in kernel")
 #define fscanf(...)	MUST_MSG(0,"don't have this in kernel")
+#define ungetc(a,b)	MUST_MSG(0,"don't have this in kernel")
+#define ftell(a)	MUST_MSG(0,"don't have this in kernel")
 #define FILE		void
 #define stdin		NULL
 #define EOF		0
 #endif
 
 
+/*****************************************************************************
+ *  local types
+ ****************************************************************************/
+
+#ifdef UNIX_GNU
+/* rows of a raw file to pread, see ReadRows() */
+typedef struct {
+    int		Fd;
+    off_t	Off;		/* file position of the first row */
+    long	FileS;		/* file bytes per line */
+    int		Dx,N;		/* pels per row, rows */
+    u8		*pDst;		/* first destination row */
+    int		S;
+    int		FBpp,Bpp,Shift;
+    bool	Native;		/* see ConvRow() */
+    const char	*Name;
+} tRows;
+#endif
+
+/* YUV to RGB in fixed point, see YuvRow(). Y in Q6 is (Y*Ky>>8)+Yofs, the
+   rounding included, the chroma terms are pairs of Q13 coefficients */
+typedef struct {
+    s16		Ky,Yofs;
+    s16		R[2],G[2],B[2];
+} tYuvK;
+
+
+/*****************************************************************************
+ *  global variables
+ ****************************************************************************/
+
+bool		g_Pic16Native=FALSE;
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+/* by Mode of Pic32_RGBXfromYuv(), the chroma pairs are (U,V) */
+static const tYuvK	lYuvK[4]={
+    {19077,-1160,{0,13075},{-3209,-6660},{16525,0}},	/* BT.601 */
+    {19077,-1160,{0,14686},{-1747,-4366},{17305,0}},	/* BT.709 */
+    {16384,   32,{0,11485},{-2819,-5850},{14516,0}},	/* full range */
+    {16384,   32,{0,12901},{-1535,-3835},{15201,0}},
+};
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  write the pels of a 32bit pic as raw ppm data, line by line through a
+ *  staging buffer. pOrd are the 3 bytes of a pel to write
+ */
+static void WritePpm(const tPic *pThat, FILE *file, const u8 *pOrd)
+{
+    u8    *pp,*pl;
+    int   y;
+
+    pl=calloc(pThat->Dx,3);  MUST(pl);
+    pp=pThat->Pel;
+    for(y=0;y<pThat->Dy;y++){
+	Bits_Pack4to3(pl,pp,pThat->Dx,pOrd);
+	if(fwrite(pl,pThat->Dx*3,1,file)!=1) ERROR("cannot write");
+	pp+=pThat->S;
+    }
+    free(pl);
+}
+
+
+/****************************************************************************/
+/*  read raw ppm data into a 32bit pic, line by line through a staging
+ *  buffer. pOrd says where the 3 bytes go, see Bits_Expand3to4()
+ */
+static void ReadPpm(tPic *pThat, FILE *file, const char *Name, const u8 *pOrd)
+{
+    u8    *pp,*pl;
+    int   y;
+
+    pl=calloc(pThat->Dx,3);  MUST(pl);
+    pp=pThat->Pel;
+    for(y=0;y<pThat->Dy;y++){
+	if(fread(pl,pThat->Dx*3,1,file)!=1)
+	    ERROR("read error in %s line %d",Name,y);
+	Bits_Expand3to4(pp,pl,pThat->Dx,pOrd);
+	pp+=pThat->S;
+    }
+    free(pl);
+}
+
+
+/****************************************************************************/
+/*  read the next number of an ascii pnm file (P2/P3), skipping white space
+ *  and comments. replaces a fscanf() per pel
+ */
+static bool ReadNum(FILE *file, u32 *pV)
+{
+    int   c;
+    u32   v;
+
+    for(;;){
+	c=GETC(file);
+	if(c=='#')
+	    while(c!='\n' && c!=EOF)
+		c=GETC(file);
+	else if(c!=' ' && c!='\n' && c!='\t' && c!='\r')
+	    break;
+    }
+    if(c<'0' || c>'9')
+	return FALSE;
+
+    for(v=0;c>='0' && c<='9';c=GETC(file))
+	v=v*10+c-'0';
+    if(c=='#')
+	ungetc(c,file);
+    *pV=v;
+
+    return TRUE;
+}
+
+
+/****************************************************************************/
+/*  parse a pnm header up to the first pel, see Pic_Open()
+ *
+ *  \return NULL or what is wrong
+ */
+static const char *ParseHeader(tPicFile *pThat, FILE *file)
+{
+    int   c,bpp,ndx,ndy;
+    u32   dx,dy;
+    u8    head[NQI_HEAD];
+
+    pThat->Native=g_Pic16Native;
+    c=GETC(file);
+    if(c=='N'){
+	head[0]=c;
+	if(fread(head+1,NQI_HEAD-1,1,file)!=1 ||
+	   !Nqi_GetHead(head,&pThat->Type,&bpp,&ndx,&ndy))
+	    return "nqi header not found";
+	if(!(pThat->Type==PIC_G8 && bpp==1) &&
+	   !(pThat->Type==PIC_G16 && bpp==2) &&
+	   !(pThat->Type==PIC_XRGB && bpp==4))
+	    return "unsupported nqi type";
+	pThat->Dx=ndx;
+	pThat->Dy=ndy;
+	pThat->MaxVal=bpp==2?0xffff:0xff;
+	pThat->Nqi=TRUE;
+	pThat->Offset=ftell(file);
+	return NULL;
+    }
+    if(c!='P')
+	return "pnm header not found";
+    c=GETC(file);
+    if(c!='2' && c!='3' && c!='5' && c!='6')
+	return "pnm header (P2/P3/P5/P6) not found";
+
+    if(!ReadNum(file,&dx) || !ReadNum(file,&dy) ||
+       !ReadNum(file,&pThat->MaxVal))
+	return "cannot read size";
+    if(dx<1 || dx>1<<16 || dy<1 || dy>1<<16)
+	return "implausible size";
+
+    pThat->Dx=dx;
+    pThat->Dy=dy;
+    pThat->Raw=c=='5' || c=='6';
+    if(c=='3' || c=='6'){
+	if(pThat->MaxVal>0xff)
+	    return "unsupported range";
+	pThat->Type=PIC_XRGB;
+    }
+    else if(pThat->MaxVal<=0xff)
+	pThat->Type=PIC_G8;
+    else if(pThat->MaxVal<=0xffff)
+	pThat->Type=PIC_G16;
+    else
+	pThat->Type=PIC_G32;
+    pThat->Offset=ftell(file);
+
+    return NULL;
+}
+
+
+/****************************************************************************/
+/*  bytes per pel in a raw file of a tPicFile. checks that Bpp, the bytes
+ *  per pel in memory, is a supported conversion, 0 is set to the natural one
+ */
+static int FileBpp(const tPicFile *pThat, int *pBpp)
+{
+    int   fbpp;
+
+    fbpp=pThat->Type==PIC_G8?1:pThat->Type==PIC_G16?2:pThat->Type==PIC_XRGB?3:4;
+    if(pThat->Nqi && fbpp==3)
+	fbpp=4;
+    if(!*pBpp)
+	*pBpp=fbpp==3?4:fbpp;
+    if(!(*pBpp==fbpp || (fbpp==1 && *pBpp==2) || (fbpp==3 && *pBpp==4)))
+	ERROR("cannot read %s into %d byte pels",pThat->Name,*pBpp);
+
+    return fbpp;
+}
+
+
+/****************************************************************************/
+/*  allocate a pic, or check that the buffer of a given one is large enough
+ *  and set its size. no MUST_PLAUS, the files can be huge
+ */
+static void NeedPic(tPic *pPic, int dx, int dy, int Bpp)
+{
+    if(!pPic->Pel){
+	pPic->S=PAD(dx*Bpp,sizeof(int));
+	pPic->Pel=calloc((long)pPic->S*dy,1);  MUST(pPic->Pel);
+	pPic->Dx=dx;
+	pPic->Dy=dy;
+    }
+    else{
+	MUST_Ge(pPic->S,dx*Bpp);
+	MUST_Ge(pPic->Dy,dy);
+	pPic->Dx=dx;
+	pPic->Dy=dy;
+    }
+}
+
+
+/****************************************************************************/
+/*  convert a row of raw pnm data with FBpp bytes per pel to Bpp bytes per
+ *  pel in memory, see Pic_ReadInto(). in place if the sizes are equal.
+ *  Native: 16 bit pels are not big endian, see tPicFile
+ */
+static void ConvRow(u8 *pDst, const u8 *pSrc, int dx, int FBpp, int Bpp,
+		    int Shift, bool Native)
+{
+    static const u8	ord[4]={0xff,0,1,2};
+    int			x;
+
+    if(FBpp==3)
+	Bits_Expand3to4(pDst,pSrc,dx,ord);
+    else if(FBpp==1 && Bpp==2)
+	Bits_U8to16Shl((u16*)pDst,pSrc,dx,Shift);
+    else if(Bpp==2){
+	if(!Native)
+	    Bits_Be16Shl((u16*)pDst,pSrc,dx,Shift);
+	else if(Shift)
+	    for(x=0;x<dx;x++)
+		CEW16(pDst+2*x,CERU16(pSrc+2*x)<<Shift);
+    }
+}
+
+
+/****************************************************************************/
+/*  decode the lines of a nqi file into Bpp byte pels, see Pic_ReadInto().
+ *  straight into the pic if nothing has to be converted, else via two
+ *  staging lines (the predictor needs the line above)
+ */
+static void ReadNqi(tPicFile *pThat, tPic *pPic, int FBpp, int Bpp, int Shift)
+{
+    FILE		*file=pThat->pFile;
+    const char		*name=pThat->Name;
+    tNqi		q;
+    u8			*pp=pPic->Pel,*pc,*pl[2]={NULL,NULL},*pr,*pu=NULL;
+    u8			len[4];
+    int			x,y,max,dx=pThat->Dx;
+    u32			n;
+    bool		direct=FBpp==Bpp && !Shift;
+
+    Nqi_Init(&q,dx,FBpp);
+    max=Nqi_Bound(&q);
+    pc=malloc(max);  MUST(pc);
+    if(!direct){
+	pl[0]=calloc(dx,FBpp);  MUST(pl[0]);
+	pl[1]=calloc(dx,FBpp);  MUST(pl[1]);
+    }
+
+    for(y=0;y<pThat->Dy;y++){
+	pr=direct?pp:pl[y&1];
+	if(fread(len,4,1,file)!=1 ||
+	   (n=len[0]|len[1]<<8|len[2]<<16|(u32)len[3]<<24)>(u32)max ||
+	   fread(pc,n,1,file)!=1)
+	    ERROR("read error in %s line %d",name,y);
+	if(Nqi_DecodeRow(&q,pr,pu,pc,n)!=(int)n)
+	    ERROR("corrupt line %d in %s",y,name);
+	if(FBpp==1 && Bpp==2)
+	    Bits_U8to16Shl((u16*)pp,pr,dx,Shift);
+	else if(!direct)
+	    for(x=0;x<dx;x++)
+		((u16*)pp)[x]=((u16*)pr)[x]<<Shift;
+	pu=pr;
+	pp+=pPic->S;
+    }
+
+    free(pl[0]);
+    free(pl[1]);
+    free(pc);
+    Nqi_Free(&q);
+}
+
+
+/****************************************************************************/
+/*  save a pic with Bpp byte pels as nqi file
+ */
+static bool SaveNqi(const tPic *pThat, const char *Name, int Type, int Bpp)
+{
+    FILE		*file;
+    tNqi		q;
+    u8			*pp=pThat->Pel,*pc;
+    int			y,n;
+
+    if(!(file=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
+
+    Nqi_Init(&q,pThat->Dx,Bpp);
+    pc=malloc(4+Nqi_Bound(&q));  MUST(pc);
+    Nqi_PutHead(pc,Type,Bpp,pThat->Dx,pThat->Dy);
+    if(fwrite(pc,NQI_HEAD,1,file)!=1) ERROR("writing: %s",Name);
+
+    for(y=0;y<pThat->Dy;y++){
+	n=Nqi_EncodeRow(&q,pc+4,pp,y?pp-pThat->S:NULL);
+	pc[0]=n; pc[1]=n>>8; pc[2]=n>>16; pc[3]=n>>24;
+	if(fwrite(pc,4+n,1,file)!=1) ERROR("writing: %s",Name);
+	pp+=pThat->S;
+    }
+
+    fclose(file);
+    free(pc);
+    Nqi_Free(&q);
+
+    return TRUE;
+}
+
+/****************************************************************************/
+/*  read Dy lines of Len bytes into a plane, in one piece if it has no
+ *  padding
+ */
+static bool ReadPlane(FILE *file, u8 *pPel, int Len, int Dy, int S)
+{
+    int			y;
+
+    if(S==Len)
+	return Dy==0 || fread(pPel,(size_t)Len*Dy,1,file)==1;
+    for(y=0;y<Dy;y++)
+	if(fread(pPel+(long)y*S,Len,1,file)!=1)
+	    return FALSE;
+    return TRUE;
+}
+
+#ifdef SIMD_X86
+/****************************************************************************/
+/*  one color of 16 pels: the Y terms yl,yh plus the chroma term of the
+ *  pairs in cl,ch (each for 2 pels), Q6 to u8 with saturation
+ */
+static inline __m128i YuvChan(__m128i yl, __m128i yh, __m128i cl, __m128i ch,
+			      __m128i k)
+{
+    __m128i	t;
+
+    t=_mm_packs_epi32(_mm_srai_epi32(_mm_madd_epi16(cl,k),7),
+		      _mm_srai_epi32(_mm_madd_epi16(ch,k),7));
+    return _mm_packus_epi16(
+	_mm_srai_epi16(_mm_adds_epi16(yl,_mm_unpacklo_epi16(t,t)),6),
+	_mm_srai_epi16(_mm_adds_epi16(yh,_mm_unpackhi_epi16(t,t)),6));
+}
+
+/* RGB565 of 8 pels from the low or high halves of r,g,b */
+#define PACK565(un,r,g,b)						\
+    _mm_or_si128(_mm_or_si128(						\
+	_mm_slli_epi16(_mm_and_si128(un(r,z),_mm_set1_epi16(0xf8)),8),	\
+	_mm_slli_epi16(_mm_and_si128(un(g,z),_mm_set1_epi16(0xfc)),3)),	\
+	_mm_srli_epi16(un(b,z),3))
+#endif
+
+/****************************************************************************/
+/*  convert a line of N pels from Y and chroma pairs of 2 pels each to
+ *  RGBX, BGRX (X=255) or RGB565. the pair is pC0[i*Step],pC1[i*Step], with
+ *  Step 1 for planes, else 2 and pC1=pC0+1. pK is in the order of the pair.
+ *  SSE2 does 16 pels a time, with the same integer math as the tail
+ */
+static void YuvRow(u8 *pDst, const u8 *pY, const u8 *pC0, const u8 *pC1,
+		   int Step, int N, const tYuvK *pK, int Fmt)
+{
+    int		x=0,l,c0,c1,r,g,b;
+#ifdef SIMD_X86
+    const __m128i	z=_mm_setzero_si128(),ff=_mm_set1_epi8(-1);
+    const __m128i	k128=_mm_set1_epi16(128),ky=_mm_set1_epi16(pK->Ky);
+    const __m128i	yofs=_mm_set1_epi16(pK->Yofs);
+    const __m128i	kr=_mm_set1_epi32((u16)pK->R[0]|(u32)(u16)pK->R[1]<<16);
+    const __m128i	kg=_mm_set1_epi32((u16)pK->G[0]|(u32)(u16)pK->G[1]<<16);
+    const __m128i	kb=_mm_set1_epi32((u16)pK->B[0]|(u32)(u16)pK->B[1]<<16);
+    __m128i	v,yl,yh,cl,ch,vr,vg,vb,lo,hi,xl,xh;
+    __m128i	*pd;
+
+    for(;x+16<=N;x+=16){
+	v=_mm_loadu_si128((const __m128i*)(pY+x));
+	yl=_mm_add_epi16(_mm_mulhi_epu16(_mm_unpacklo_epi8(z,v),ky),yofs);
+	yh=_mm_add_epi16(_mm_mulhi_epu16(_mm_unpackhi_epi8(z,v),ky),yofs);
+	if(Step==1)
+	    v=_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(pC0+x/2)),
+				_mm_loadl_epi64((const __m128i*)(pC1+x/2)));
+	else
+	    v=_mm_loadu_si128((const __m128i*)(pC0+x));
+	cl=_mm_sub_epi16(_mm_unpacklo_epi8(v,z),k128);
+	ch=_mm_sub_epi16(_mm_unpackhi_epi8(v,z),k128);
+	vr=YuvChan(yl,yh,cl,ch,kr);
+	vg=YuvChan(yl,yh,cl,ch,kg);
+	vb=YuvChan(yl,yh,cl,ch,kb);
+
+	if(Fmt==YUV_565){
+	    pd=(__m128i*)(pDst+2*x);
+	    _mm_storeu_si128(pd+0,PACK565(_mm_unpacklo_epi8,vr,vg,vb));
+	    _mm_storeu_si128(pd+1,PACK565(_mm_unpackhi_epi8,vr,vg,vb));
+	}
+	else{
+	    if(Fmt==YUV_BGRX){
+		v=vr; vr=vb; vb=v;
+	    }
+	    lo=_mm_unpacklo_epi8(vr,vg);  hi=_mm_unpackhi_epi8(vr,vg);
+	    xl=_mm_unpacklo_epi8(vb,ff);  xh=_mm_unpackhi_epi8(vb,ff);
+	    pd=(__m128i*)(pDst+4*x);
+	    _mm_storeu_si128(pd+0,_mm_unpacklo_epi16(lo,xl));
+	    _mm_storeu_si128(pd+1,_mm_unpackhi_epi16(lo,xl));
+	    _mm_storeu_si128(pd+2,_mm_unpacklo_epi16(hi,xh));
+	    _mm_storeu_si128(pd+3,_mm_unpackhi_epi16(hi,xh));
+	}
+    }
+#endif
+
+    for(;x<N;x++){
+	c0=pC0[x/2*Step]-128;
+	c1=pC1[x/2*Step]-128;
+	l=(pY[x]*pK->Ky>>8)+pK->Yofs;
+	r=CLIP((l+((c0*pK->R[0]+c1*pK->R[1])>>7))>>6,0,255);
+	g=CLIP((l+((c0*pK->G[0]+c1*pK->G[1])>>7))>>6,0,255);
+	b=CLIP((l+((c0*pK->B[0]+c1*pK->B[1])>>7))>>6,0,255);
+	switch(Fmt){
+	case YUV_RGBX:
+	    CEW32(pDst+4*x,r|g<<8|b<<16|0xffu<<24);  break;
+	case YUV_BGRX:
+	    CEW32(pDst+4*x,b|g<<8|r<<16|0xffu<<24);  break;
+	default:
+	    CEW16(pDst+2*x,(r>>3)<<11|(g>>2)<<5|b>>3);
+	}
+    }
+}
+
+
+/****************************************************************************/
+/*  convert Y with chroma pairs for 2 pels (see YuvRow()) to the pels of
+ *  pThat, as far as both reach. 4:2:0 chroma is used for two lines each.
+ *  Vu: the pairs are (V,U)
+ */
+static void YuvToRgb(tPic *pThat, const tPic *pY, const tPic *pC0,
+		     const tPic *pC1, int Step, int Mode, bool Vu, int Fmt)
+{
+    tYuvK	k=lYuvK[Mode&(PIC_BT709|PIC_FULL)];
+    int		y,c,dx,dy;
+    s16		t;
+    TRACE_FUNC;
+    METRIC_FUNC;
+
+    dx=MIN(pThat->Dx,pY->Dx);  dy=MIN(pThat->Dy,pY->Dy);
+    MUST_Ge(pC0->Dx/Step,(dx+1)/2);
+    if(Vu){
+	t=k.R[0]; k.R[0]=k.R[1]; k.R[1]=t;
+	t=k.G[0]; k.G[0]=k.G[1]; k.G[1]=t;
+	t=k.B[0]; k.B[0]=k.B[1]; k.B[1]=t;
+    }
+
+    for(y=0;y<dy;y++){
+	c=(long)y*pC0->Dy/pY->Dy;
+	YuvRow(pThat->Pel+(long)y*pThat->S,pY->Pel+(long)y*pY->S,
+	       pC0->Pel+(long)c*pC0->S,pC1->Pel+(long)c*pC1->S+Step-1,Step,
+	       dx,&k,Fmt);
+    }
+}
+
+#ifdef UNIX_GNU
+/****************************************************************************/
+/*  pread and convert the rows of a tRows, a thread function
+ */
+static void *ReadRows(void *pArg)
+{
+    tRows	*pr=pArg;
+    u8		*pp=pr->pDst,*pl=NULL;
+    ssize_t	len=(ssize_t)pr->Dx*pr->FBpp;
+    int		y;
+
+    if(pr->FBpp!=pr->Bpp){
+	pl=calloc(pr->Dx,pr->FBpp);  MUST(pl);
+    }
+    for(y=0;y<pr->N;y++){
+	if(pread(pr->Fd,pl?pl:pp,len,pr->Off+y*pr->FileS)!=len)
+	    ERROR("read error in %s",pr->Name);
+	ConvRow(pp,pl?pl:pp,pr->Dx,pr->FBpp,pr->Bpp,pr->Shift,pr->Native);
+	pp+=pr->S;
+    }
+    free(pl);
+
+    return NULL;
+}
+
+
+/****************************************************************************/
+/*  read the rows of a tRows, split into bands for up to Threads threads if
+ *  there is enough to read
+ */
+static void ReadRowsPar(tRows *pRows, int Threads)
+{
+    pthread_t	th[ROI_THREADS];
+    tRows	band[ROI_THREADS];
+    int		i,n,y=0;
+
+    n=MIN(MIN(Threads,ROI_THREADS),pRows->N);
+    if(n<=1 || (long)pRows->Dx*pRows->FBpp*pRows->N<ROI_PAR_MIN){
+	ReadRows(pRows);
+	return;
+    }
+
+    for(i=0;i<n;i++){
+	band[i]=*pRows;
+	band[i].N=pRows->N*(i+1)/n-y;
+	band[i].Off+=y*pRows->FileS;
+	band[i].pDst+=(long)y*pRows->S;
+	y+=band[i].N;
+	if(i>0 && pthread_create(&th[i],NULL,ReadRows,&band[i]))
+	    ERROR("cannot create thread");
+    }
+    ReadRows(&band[0]);
+    for(i=1;i<n;i++)
+	pthread_join(th[i],NULL);
+}
+#endif /* UNIX_GNU */
+
+
 /*****************************************************************************
  *  exported functions
  ****************************************************************************/
@@ -259,146 +820,339 @@ void Yc420_Malloc(tYc *pThat, int dx, int dy)
 
 
 /****************************************************************************/
-/** import a Yc image from a Yuv image
+/** import a Yc image (NV12) from a Yuv image (I420)
  *
  *  \param  pThat
  *  \param  pSrc
  */
 void Yc_Import(tYc *pThat, tYuv *pSrc)
 {
-    u8    *pd,*pu,*pv;
-    int   x,y;
-
-    Pic8_Copy(&pThat->Y,&pSrc->C[0]);
-
-    pd=pThat->C.Pel;
-    pu=pSrc->C[1].Pel;
-    pv=pSrc->C[2].Pel;
-    for(y=0;y<pThat->C.Dy;y++){
-	for(x=0;x<pThat->Dx/2;x++){
-	    pd[2*x]=pu[x];
-	    pd[2*x+1]=pv[x];
-	}
-	pd+=pThat->C.S;
-	pu+=pSrc->C[1].S;
-	pv+=pSrc->C[2].S;
-    }
+    Yc_FromYuv(pThat,pSrc,FALSE);
 }
 
 
 /****************************************************************************/
-/** copy that pic from a source pic
+/** planar to semi-planar: I420 to NV12 or NV21, any width. the chroma
+ *  planes of pSrc must have the lines of pThat->C
  *
- *  \param  pThat the pic
+ *  \param  pThat
+ *  \param  pSrc
+ *  \param  Vu    V first (NV21), else U first (NV12)
  */
-void Pic8_Clear(tPic *pThat)
+void Yc_FromYuv(tYc *pThat, const tYuv *pSrc, bool Vu)
 {
-    u8    *pd;
-    int   y;
+    const tPic	*pu=&pSrc->C[Vu?2:1],*pv=&pSrc->C[Vu?1:2];
+    int		y,n=MIN(pu->Dx,pThat->C.Dx/2);
+    TRACE_FUNC;
+    METRIC_FUNC;
 
-    pd=pThat->Pel;
-    for(y=0;y<pThat->Dy;y++){
-	memset(pd,0,pThat->Dx);
-	pd+=pThat->S;
-    }
+    Pic8_Copy(&pThat->Y,(tPic*)&pSrc->C[0]);
+
+    MUST_Ge(pu->Dy,pThat->C.Dy);
+    for(y=0;y<pThat->C.Dy;y++)
+	Bits_Interleave2(pThat->C.Pel+(long)y*pThat->C.S,pu->Pel+(long)y*pu->S,
+			 pv->Pel+(long)y*pv->S,n);
 }
 
 
 /****************************************************************************/
-/** copy that pic from a source pic
+/** semi-planar to planar: NV12 or NV21 to I420, any width
  *
  *  \param  pThat
  *  \param  pSrc
+ *  \param  Vu    pSrc is V first (NV21), else U first (NV12)
  */
-void Pic8_Copy(tPic *pThat, tPic *pSrc)
+void Yuv_FromYc(tYuv *pThat, const tYc *pSrc, bool Vu)
 {
-    u8    *pd,*ps;
-    int   y;
+    tPic	*pu=&pThat->C[Vu?2:1],*pv=&pThat->C[Vu?1:2];
+    int		y,n=MIN(pu->Dx,pSrc->C.Dx/2);
+    TRACE_FUNC;
+    METRIC_FUNC;
 
-    MUST_Ge(pThat->Dx,pSrc->Dx);
-    MUST_Ge(pThat->Dy,pSrc->Dy);
+    Pic8_Copy(&pThat->C[0],(tPic*)&pSrc->Y);
 
-    pd=pThat->Pel;
-    ps=pSrc->Pel;
-    for(y=0;y<pSrc->Dy;y++){
-	memcpy(pd,ps,pSrc->Dx);
-	pd+=pThat->S;
-	ps+=pSrc->S;
-    }
+    MUST_Ge(pu->Dy,pSrc->C.Dy);
+    for(y=0;y<pSrc->C.Dy;y++)
+	Bits_Deinterleave2(pu->Pel+(long)y*pu->S,pv->Pel+(long)y*pv->S,
+			   pSrc->C.Pel+(long)y*pSrc->C.S,n);
 }
 
 
 /****************************************************************************/
-/** copy that pic from a source pic
+/** swap the chroma of a Yc image in place, NV12 <-> NV21
  *
  *  \param  pThat
- *  \param  pSrc
  */
-void Pic16_Copy(tPic *pThat, tPic *pSrc)
+void Yc_SwapUv(tYc *pThat)
 {
-    u8    *pd,*ps;
-    int   y;
-
-    MUST_Ge(pThat->Dx,pSrc->Dx);
-    MUST_Ge(pThat->Dy,pSrc->Dy);
+    int		y;
+    METRIC_FUNC;
 
-    pd=pThat->Pel;
-    ps=pSrc->Pel;
-    for(y=0;y<pSrc->Dy;y++){
-	memcpy(pd,ps,pSrc->Dx*2);
-	pd+=pThat->S;
-	ps+=pSrc->S;
-    }
+    for(y=0;y<pThat->C.Dy;y++)
+	Bits_Swap16(pThat->C.Pel+(long)y*pThat->C.S,
+		    pThat->C.Pel+(long)y*pThat->C.S,pThat->C.Dx/2);
 }
 
 
 /****************************************************************************/
-/** copy that pic from a source pic
+/** pack a Yuv image to YUYV or UYVY in a 16 bit pic. 4:2:0 chroma is used
+ *  for two lines each. with an odd width the last pair repeats the last
+ *  luma sample, so the stride must hold whole pairs
  *
- *  \param  pThat
- *  \param  pSrc
+ *  \param  pThat Dx and Dy as the luma of pSrc
+ *  \param  pSrc  4:2:2 or 4:2:0
+ *  \param  Uyvy  UYVY, else YUYV
  */
-void Pic24_Copy(tPic *pThat, tPic *pSrc)
+void Pic16_YuyvFromYuv(tPic *pThat, const tYuv *pSrc, bool Uyvy)
 {
-    u8    *pd,*ps;
-    int   y;
+    const tPic	*py=&pSrc->C[0],*pu=&pSrc->C[1],*pv=&pSrc->C[2];
+    const u8	*ly,*lu,*lv;
+    u8		*pd;
+    int		y,c,n=py->Dx/2;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
-    MUST_Ge(pThat->Dx,pSrc->Dx);
-    MUST_Ge(pThat->Dy,pSrc->Dy);
+    MUST_Ge(pThat->Dy,py->Dy);
+    MUST_Ge(pThat->S,4*((py->Dx+1)/2));
+    MUST_Ge(pu->Dx,(py->Dx+1)/2);
 
-    pd=pThat->Pel;
-    ps=pSrc->Pel;
-    for(y=0;y<pSrc->Dy;y++){
-	memcpy(pd,ps,pSrc->Dx*3);
-	pd+=pThat->S;
-	ps+=pSrc->S;
+    for(y=0;y<py->Dy;y++){
+	c=(long)y*pu->Dy/py->Dy;
+	pd=pThat->Pel+(long)y*pThat->S;
+	ly=py->Pel+(long)y*py->S;
+	lu=pu->Pel+(long)c*pu->S;
+	lv=pv->Pel+(long)c*pv->S;
+	Bits_PackYuyv(pd,ly,lu,lv,n,Uyvy);
+	if(py->Dx&1){
+	    pd+=4*n;
+	    pd[Uyvy?1:0]=pd[Uyvy?3:2]=ly[2*n];
+	    pd[Uyvy?0:1]=lu[n];
+	    pd[Uyvy?2:3]=lv[n];
+	}
     }
 }
 
+
 /****************************************************************************/
-/** copy that pic from a source pic
+/** unpack YUYV or UYVY from a 16 bit pic into a Yuv image. for 4:2:0
+ *  chroma the even lines are used
  *
- *  \param  pThat
- *  \param  pSrc
+ *  \param  pThat 4:2:2 or 4:2:0
+ *  \param  pSrc  Dx and Dy as the luma of pThat
+ *  \param  Uyvy  UYVY, else YUYV
  */
-void Pic32_Copy(tPic *pThat, tPic *pSrc)
+void Yuv_FromYuyv(tYuv *pThat, const tPic *pSrc, bool Uyvy)
 {
-    u8    *pd,*ps;
-    int   y;
+    tPic	*py=&pThat->C[0],*pu=&pThat->C[1],*pv=&pThat->C[2];
+    const u8	*ps;
+    u8		*ly,*lu,*lv,*pt=NULL;
+    int		y,c,n=py->Dx/2;
+    bool	sub=pu->Dy<py->Dy;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
-    MUST_Ge(pThat->Dx,pSrc->Dx);
-    MUST_Ge(pThat->Dy,pSrc->Dy);
+    MUST_Ge(pSrc->Dy,py->Dy);
+    MUST_Ge(pSrc->S,4*((py->Dx+1)/2));
+    MUST_Ge(pu->Dx,(py->Dx+1)/2);
+    if(sub){
+	pt=malloc(py->Dx+1);  MUST(pt);
+    }
+
+    for(y=0;y<py->Dy;y++){
+	c=(long)y*pu->Dy/py->Dy;
+	ps=pSrc->Pel+(long)y*pSrc->S;
+	ly=py->Pel+(long)y*py->S;
+	lu=pu->Pel+(long)c*pu->S;
+	lv=pv->Pel+(long)c*pv->S;
+	if(sub && (y&1)){
+	    /* luma only, the chroma of this line is dropped */
+	    if(Uyvy)
+		Bits_Deinterleave2(pt,ly,ps,2*n);
+	    else
+		Bits_Deinterleave2(ly,pt,ps,2*n);
+	}
+	else{
+	    Bits_UnpackYuyv(ly,lu,lv,ps,n,Uyvy);
+	    if(py->Dx&1){
+		lu[n]=ps[4*n+(Uyvy?0:1)];
+		lv[n]=ps[4*n+(Uyvy?2:3)];
+	    }
+	}
+	if(py->Dx&1)
+	    ly[2*n]=ps[4*n+(Uyvy?1:0)];
+    }
+    free(pt);
+}
+
+
+/****************************************************************************/
+/** convert a Yuv image (I420, or 4:2:2) to RGBX, as far as both reach. the
+ *  conversion is in fixed point, with SSE2 on x86
+ *
+ *  \param  pThat 32 bit pic
+ *  \param  pSrc
+ *  \param  Mode  PIC_BT601 or PIC_BT709, | PIC_FULL for full range Y,U,V
+ */
+void Pic32_RGBXfromYuv(tPic *pThat, const tYuv *pSrc, int Mode)
+{
+    YuvToRgb(pThat,&pSrc->C[0],&pSrc->C[1],&pSrc->C[2],1,Mode,FALSE,
+	     YUV_RGBX);
+}
+
+
+/****************************************************************************/
+/** convert a Yuv image to BGRX, see Pic32_RGBXfromYuv(). that is the
+ *  memory layout of XRGB words on little endian machines
+ *
+ *  \param  pThat 32 bit pic
+ *  \param  pSrc
+ *  \param  Mode  see Pic32_RGBXfromYuv()
+ */
+void Pic32_BGRXfromYuv(tPic *pThat, const tYuv *pSrc, int Mode)
+{
+    YuvToRgb(pThat,&pSrc->C[0],&pSrc->C[1],&pSrc->C[2],1,Mode,FALSE,
+	     YUV_BGRX);
+}
+
+
+/****************************************************************************/
+/** convert a Yuv image to RGB565 words, see Pic32_RGBXfromYuv()
+ *
+ *  \param  pThat 16 bit pic
+ *  \param  pSrc
+ *  \param  Mode  see Pic32_RGBXfromYuv()
+ */
+void Pic16_RGB565fromYuv(tPic *pThat, const tYuv *pSrc, int Mode)
+{
+    YuvToRgb(pThat,&pSrc->C[0],&pSrc->C[1],&pSrc->C[2],1,Mode,FALSE,
+	     YUV_565);
+}
+
+
+/****************************************************************************/
+/** convert a Yc image (NV12 or NV21) to RGBX, see Pic32_RGBXfromYuv()
+ *
+ *  \param  pThat 32 bit pic
+ *  \param  pSrc
+ *  \param  Mode  see Pic32_RGBXfromYuv()
+ *  \param  Vu    V first (NV21), else U first (NV12)
+ */
+void Pic32_RGBXfromYc(tPic *pThat, const tYc *pSrc, int Mode, bool Vu)
+{
+    YuvToRgb(pThat,&pSrc->Y,&pSrc->C,&pSrc->C,2,Mode,Vu,YUV_RGBX);
+}
+
+
+/****************************************************************************/
+/** convert a Yc image to BGRX, see Pic32_BGRXfromYuv()
+ *
+ *  \param  pThat 32 bit pic
+ *  \param  pSrc
+ *  \param  Mode  see Pic32_RGBXfromYuv()
+ *  \param  Vu    V first (NV21), else U first (NV12)
+ */
+void Pic32_BGRXfromYc(tPic *pThat, const tYc *pSrc, int Mode, bool Vu)
+{
+    YuvToRgb(pThat,&pSrc->Y,&pSrc->C,&pSrc->C,2,Mode,Vu,YUV_BGRX);
+}
+
+
+/****************************************************************************/
+/** convert a Yc image to RGB565 words, see Pic32_RGBXfromYuv()
+ *
+ *  \param  pThat 16 bit pic
+ *  \param  pSrc
+ *  \param  Mode  see Pic32_RGBXfromYuv()
+ *  \param  Vu    V first (NV21), else U first (NV12)
+ */
+void Pic16_RGB565fromYc(tPic *pThat, const tYc *pSrc, int Mode, bool Vu)
+{
+    YuvToRgb(pThat,&pSrc->Y,&pSrc->C,&pSrc->C,2,Mode,Vu,YUV_565);
+}
+
+
+/****************************************************************************/
+/** copy that pic from a source pic
+ *
+ *  \param  pThat the pic
+ */
+void Pic8_Clear(tPic *pThat)
+{
+    u8    *pd;
+    int   y;
+    METRIC_FUNC;
 
     pd=pThat->Pel;
-    ps=pSrc->Pel;
-    for(y=0;y<pSrc->Dy;y++){
-	memcpy(pd,ps,pSrc->Dx*4);
+    for(y=0;y<pThat->Dy;y++){
+	memset(pd,0,pThat->Dx);
 	pd+=pThat->S;
-	ps+=pSrc->S;
     }
 }
 
 
+/****************************************************************************/
+/** copy that pic from a source pic
+ *
+ *  \param  pThat
+ *  \param  pSrc
+ */
+void Pic8_Copy(tPic *pThat, tPic *pSrc)
+{
+#define PEL_BYTES 1
+#define PIC_COPY
+#include "pic_tpl.c"
+#undef PIC_COPY
+#undef PEL_BYTES
+}
+
+
+/****************************************************************************/
+/** copy that pic from a source pic
+ *
+ *  \param  pThat
+ *  \param  pSrc
+ */
+void Pic16_Copy(tPic *pThat, tPic *pSrc)
+{
+#define PEL_BYTES 2
+#define PIC_COPY
+#include "pic_tpl.c"
+#undef PIC_COPY
+#undef PEL_BYTES
+}
+
+
+/****************************************************************************/
+/** copy that pic from a source pic
+ *
+ *  \param  pThat
+ *  \param  pSrc
+ */
+void Pic24_Copy(tPic *pThat, tPic *pSrc)
+{
+#define PEL_BYTES 3
+#define PIC_COPY
+#include "pic_tpl.c"
+#undef PIC_COPY
+#undef PEL_BYTES
+}
+
+/****************************************************************************/
+/** copy that pic from a source pic
+ *
+ *  \param  pThat
+ *  \param  pSrc
+ */
+void Pic32_Copy(tPic *pThat, tPic *pSrc)
+{
+#define PEL_BYTES 4
+#define PIC_COPY
+#include "pic_tpl.c"
+#undef PIC_COPY
+#undef PEL_BYTES
+}
+
+
 /****************************************************************************/
 /** copy that pic from a source pic
  *
@@ -411,6 +1165,7 @@ void Pic16_CopyU32Shr(tPic *pThat, tPic *pSrc, int Shr)
     u8    *pd,*ps;
     int   y,x;
     u32	pel;
+    METRIC_FUNC;
 
     MUST_Ge(pThat->Dx,pSrc->Dx);
     MUST_Ge(pThat->Dy,pSrc->Dy);
@@ -441,6 +1196,7 @@ void Pic8_CopyU16Shr(tPic *pThat, tPic *pSrc, int Shr)
     u8    *pd,*ps;
     int   y,x;
     u32	pel;
+    METRIC_FUNC;
 
     MUST_Ge(pThat->Dx,pSrc->Dx);
     MUST_Ge(pThat->Dy,pSrc->Dy);
@@ -471,6 +1227,7 @@ void Pic32_CopyU16Shl(tPic *pThat, tPic *pSrc, int Shl)
     u8    *pd,*ps;
     int   y,x;
     u32	pel;
+    METRIC_FUNC;
 
     MUST_Ge(pThat->Dx,pSrc->Dx);
     MUST_Ge(pThat->Dy,pSrc->Dy);
@@ -502,6 +1259,7 @@ void Pic_HorFlip(tPic *pPic)
     int len;
     u8 *bot;
     u8 *top;
+    METRIC_FUNC;
 
     MUST(pPic);
 
@@ -528,16 +1286,13 @@ void Pic_HorFlip(tPic *pPic)
  */
 void Pic8_ShiftLeft(tPic *pThat, int Shift)
 {
-    int x,y,v;
-
-    for(y=0;y<pThat->Dy;y++){
-	for(x=0;x<pThat->Dx;x++){
-	    v=*pPEL8(pThat,x,y);
-	    v<<=Shift;
-	    v=CLIP(v,0,MAX_U8);
-	    *pPEL8(pThat,x,y)=v;
-	}
-    }
+#define PEL u8
+#define PEL_MAX MAX_U8
+#define PIC_SHIFTL
+#include "pic_tpl.c"
+#undef PIC_SHIFTL
+#undef PEL_MAX
+#undef PEL
 }
 
 
@@ -549,16 +1304,13 @@ void Pic8_ShiftLeft(tPic *pThat, int Shift)
  */
 void Pic16_ShiftLeft(tPic *pThat, int Shift)
 {
-    int x,y,v;
-
-    for(y=0;y<pThat->Dy;y++){
-	for(x=0;x<pThat->Dx;x++){
-	    v=CERU16(pPEL16(pThat,x,y));
-	    v<<=Shift;
-	    v=CLIP(v,0,MAX_U16);
-	    CEW16(pPEL16(pThat,x,y),v);
-	}
-    }
+#define PEL u16
+#define PEL_MAX MAX_U16
+#define PIC_SHIFTL
+#include "pic_tpl.c"
+#undef PIC_SHIFTL
+#undef PEL_MAX
+#undef PEL
 }
 
 
@@ -572,6 +1324,7 @@ void Pic8_Set(tPic *pThat, int val)
 {
     u8    *pd;
     int   y;
+    METRIC_FUNC;
 
     pd=pThat->Pel;
     for(y=0;y<pThat->Dy;y++){
@@ -589,11 +1342,11 @@ void Pic8_Set(tPic *pThat, int val)
  */
 void Pic16_Set(tPic *pThat, int val)
 {
-    int   x,y;
-
-    for(y=0;y<pThat->Dy;y++)
-	for(x=0;x<pThat->Dx;x++)
-	    CEW16(pPEL16(pThat,x,y),val);
+#define PEL u16
+#define PIC_SET
+#include "pic_tpl.c"
+#undef PIC_SET
+#undef PEL
 }
 
 
@@ -605,11 +1358,11 @@ void Pic16_Set(tPic *pThat, int val)
  */
 void Pic32_Set(tPic *pThat, u32 val)
 {
-    int   x,y;
-
-    for(y=0;y<pThat->Dy;y++)
-	for(x=0;x<pThat->Dx;x++)
-	    CEW32(pPEL32(pThat,x,y),val);
+#define PEL u32
+#define PIC_SET
+#include "pic_tpl.c"
+#undef PIC_SET
+#undef PEL
 }
 
 
@@ -623,6 +1376,7 @@ void Pic16_Pack4444(tPic *pThat, tPic *pSrc)
 {
     u8    *pd,*ps;
     int   y,x;
+    METRIC_FUNC;
 
     MUST_Eq(pThat->Dx,pSrc->Dx);
     MUST_Eq(pThat->Dy,pSrc->Dy);
@@ -654,6 +1408,7 @@ void Pic16_Pack565_XRGB(tPic *pThat, tPic *pSrc)
 {
     u8    *pd,*ps;
     int   y,x,dx,dy,r,g,b;
+    METRIC_FUNC;
 
     dx=MIN(pThat->Dx,pSrc->Dx);  dy=MIN(pThat->Dy,pSrc->Dy);
     pd=pThat->Pel;  ps=pSrc->Pel;
@@ -680,6 +1435,7 @@ void Pic16_Pack565_RGBX(tPic *pThat, tPic *pSrc)
 {
     u8    *pd,*ps;
     int   y,x,dx,dy,r,g,b;
+    METRIC_FUNC;
 
     dx=MIN(pThat->Dx,pSrc->Dx);  dy=MIN(pThat->Dy,pSrc->Dy);
     pd=pThat->Pel;  ps=pSrc->Pel;
@@ -707,6 +1463,7 @@ void Pic32_UnPack565(tPic *pThat, tPic *pSrc)
     u8    *pd,*ps;
     int   y,x,dx,dy,v;
     u32	argb;
+    METRIC_FUNC;
 
     dx=MIN(pThat->Dx,pSrc->Dx);  dy=MIN(pThat->Dy,pSrc->Dy);
     pd=pThat->Pel;  ps=pSrc->Pel;
@@ -716,8 +1473,9 @@ void Pic32_UnPack565(tPic *pThat, tPic *pSrc)
 	    v=CERU16(ps+2*x);
 	    argb=BITS(v,15,11)<<(16+3)|BITS(v,10,5)<<(8+2)|BITS(v,4,0)<<3;
 	    argb|=BITS(v,15,13)<<16|BITS(v,10,9)<<8|BITS(v,4,2);
-	    BEW32(pd+4*x,argb);
+	    CEW32(pd+4*x,argb);
 	}
+	Bits_Swap32(pd,pd,dx);
 	pd+=pThat->S;
 	ps+=pSrc->S;
     }
@@ -734,6 +1492,7 @@ void Pic32_RGBXfromU8(tPic *pThat, tPic *pSrc)
 {
     u8    	*pd,*ps;
     int   	y,x,dx,dy,v;
+    METRIC_FUNC;
 
     dx=MIN(pThat->Dx,pSrc->Dx);  dy=MIN(pThat->Dy,pSrc->Dy);
 
@@ -765,6 +1524,7 @@ void Pic32_RGBXfromRGB(tPic *pThat, tPic *pSrc)
 {
     u8    	*pd,*ps;
     int   	y,x,dx,dy;
+    METRIC_FUNC;
 
     dx=MIN(pThat->Dx,pSrc->Dx);  dy=MIN(pThat->Dy,pSrc->Dy);
 
@@ -795,6 +1555,7 @@ void Pic32_GenAlpha(tPic *pThat, int r, int g, int b)
 {
     u8    *pd;
     int   y,x;
+    METRIC_FUNC;
 
     pd=pThat->Pel;
     for(y=0;y<pThat->Dy;y++){
@@ -816,6 +1577,7 @@ void Pic32_RGBXfromBGR(tPic *pThat, tPic *pSrc)
 {
     u8    	*pd,*ps;
     int   	y,x,dx,dy;
+    METRIC_FUNC;
 
     dx=MIN(pThat->Dx,pSrc->Dx);  dy=MIN(pThat->Dy,pSrc->Dy);
 
@@ -846,6 +1608,7 @@ void Pic24_RGBfromRGBX(tPic *pThat, tPic *pSrc)
 {
     u8    	*pd,*ps;
     int   	y,x,dx,dy;
+    METRIC_FUNC;
 
     dx=MIN(pThat->Dx,pSrc->Dx);  dy=MIN(pThat->Dy,pSrc->Dy);
 
@@ -875,6 +1638,7 @@ void Pic24_BGRfromRGBX(tPic *pThat, tPic *pSrc)
 {
     u8    	*pd,*ps;
     int   	y,x,dx,dy;
+    METRIC_FUNC;
 
     dx=MIN(pThat->Dx,pSrc->Dx);  dy=MIN(pThat->Dy,pSrc->Dy);
 
@@ -904,32 +1668,29 @@ void Pic24_BGRfromRGBX(tPic *pThat, tPic *pSrc)
 bool Yuv_Load(tYuv *pThat, const char *Name)
 {
     FILE  *file;
-    u8    *pp;
-    int   c,y,r;
+    int   c;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(strcmp(Name,"-")==0)
 	file=stdin;
     else file=fopen(Name,"r");     MUST(file);
 
-    for(c=0;c<LEN(pThat->C);c++){
-	pp=pThat->C[c].Pel;
-	for(y=0;y<pThat->C[c].Dy;y++){
-	    r=fread(pp,pThat->C[c].Dx,1,file);
-	    if(r!=1) ERROR("cannot read");
-	    pp+=pThat->C[c].S;
-	}
-    }
+    for(c=0;c<LEN(pThat->C);c++)
+	if(!ReadPlane(file,pThat->C[c].Pel,pThat->C[c].Dx,pThat->C[c].Dy,
+		      pThat->C[c].S))
+	    ERROR("cannot read");
 
-    fclose(file);
+    if(file!=stdin)
+	fclose(file);
 
     return TRUE;
-
 }
 
 
 /****************************************************************************/
 /** load planar YUV 420 file (3 consecutive images) from file to packed image
- *  in memory
+ *  in memory. the planes are read whole, any width
  *
  *  \param  pThat
  *  \param  Name filename
@@ -938,11 +1699,10 @@ bool Yuv_Load(tYuv *pThat, const char *Name)
 bool Yc_Load(tYc *pThat, const char *Name)
 {
     FILE  *file;
-    u8    *pp;
-    int   x,y,r;
-    u8	buff[1024];
-
-    MUST_Le(pThat->Dx/2,(int)sizeof(buff));
+    u8    *pc;
+    int   y,cx=(pThat->Dx+1)/2,cy=(pThat->Dy+1)/2;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(strcmp(Name,"-")==0)
 	file=stdin;
@@ -960,33 +1720,23 @@ bool Yc_Load(tYc *pThat, const char *Name)
 	return FALSE;
     }
 
-    pp=pThat->Y.Pel;
-    for(y=0;y<pThat->Dy;y++){
-	r=fread(pp,pThat->Dx,1,file);
-	if(r!=1) ERROR("cannot read");
-	pp+=pThat->Y.S;
-    }
-
-    pp=pThat->C.Pel;
-    for(y=0;y<pThat->Dy/2;y++){
-	r=fread(buff,pThat->Dx/2,1,file);
-	if(r!=1) ERROR("cannot read");
-	for(x=0;x<pThat->Dx/2;x++)
-	    pp[2*x+0]=buff[x];
-	pp+=pThat->Y.S;
-    }
+    MUST_Ge(pThat->C.S,2*cx);
+    MUST_Ge(pThat->C.Dy,cy);
 
-    pp=pThat->C.Pel;
-    for(y=0;y<pThat->Dy/2;y++){
-	r=fread(buff,pThat->Dx/2,1,file);
-	if(r!=1) ERROR("cannot read");
-	for(x=0;x<pThat->Dx/2;x++)
-	    pp[2*x+1]=buff[x];
-	pp+=pThat->Y.S;
-    }
+    if(!ReadPlane(file,pThat->Y.Pel,pThat->Dx,pThat->Dy,pThat->Y.S))
+	ERROR("cannot read");
 
+    /* U and V in one read, then interleaved line by line */
+    pc=malloc(2L*cx*cy);  MUST(pc);
+    if(fread(pc,2L*cx*cy,1,file)!=1)
+	ERROR("cannot read");
+    for(y=0;y<cy;y++)
+	Bits_Interleave2(pThat->C.Pel+(long)y*pThat->C.S,pc+(long)y*cx,
+			 pc+(long)(cy+y)*cx,cx);
+    free(pc);
 
-    fclose(file);
+    if(file!=stdin)
+	fclose(file);
 
     return TRUE;
 }
@@ -1016,6 +1766,8 @@ void Yc_Free(tYc *pThat)
 int Pic8_Sad32RGB(tPic *pThat, const tPic *pA, const tPic *pB, int factor)
 {
     int               x,y,r,g,b,s,ss;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     MUST(pThat->Dx<=pA->Dx);
     MUST(pThat->Dy<=pA->Dy);
@@ -1051,7 +1803,10 @@ int Pic8_Sad32RGB(tPic *pThat, const tPic *pA, const tPic *pB, int factor)
 int Pic8_Sad32(tPic *pThat, const tPic *pA, const tPic *pB, int factor)
 {
     int		x,y;
+    u32		a,b;
     u64		s,ss;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     MUST_Le(pThat->Dx,pA->Dx);
     MUST_Le(pThat->Dy,pA->Dy);
@@ -1062,7 +1817,9 @@ int Pic8_Sad32(tPic *pThat, const tPic *pA, const tPic *pB, int factor)
 
     for(y=0;y<pThat->Dy;y++){
 	for(x=0;x<pThat->Dx;x++){
-	    s=ABS(((s64)CERU32(pA->Pel+pA->S*y+4*x))-((s64)CERU32(pB->Pel+pB->S*y+4*x)));
+	    a=CERU32(pA->Pel+pA->S*y+4*x);
+	    b=CERU32(pB->Pel+pB->S*y+4*x);
+	    s=a>b?a-b:b-a;	/* not ABS(), that is for int */
 	    pThat->Pel[pThat->S*y+x]=(u8)MIN(255,s*factor);
 	    ss+=s;
 	}
@@ -1084,6 +1841,8 @@ int Pic8_Sad32(tPic *pThat, const tPic *pA, const tPic *pB, int factor)
 int Pic8_Sad8(tPic *pThat, const tPic *pA, const tPic *pB, int factor)
 {
     int               x,y,s,ss;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     MUST_Le(pThat->Dx,pA->Dx);
     MUST_Le(pThat->Dy,pA->Dy);
@@ -1116,6 +1875,8 @@ int Pic8_Sad8(tPic *pThat, const tPic *pA, const tPic *pB, int factor)
 int Pic8_Sad16(tPic *pThat, const tPic *pA, const tPic *pB, int factor)
 {
     int               x,y,s,ss;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     MUST_Le(pThat->Dx,pA->Dx);
     MUST_Le(pThat->Dy,pA->Dy);
@@ -1145,26 +1906,136 @@ int Pic8_Sad16(tPic *pThat, const tPic *pA, const tPic *pB, int factor)
 void Pic8_Pad(tPic *pThat, int pad)
 {
     int		x,y;
+    METRIC_FUNC;
+
+    /* pPEL8 without the range check, the pad area is outside */
+#define PADPEL(p,x,y)	((p)->Pel+(y)*(p)->S+(x))
 
     /* left */
     for(y=0;y<pThat->Dy;y++)
 	for(x=-pad;x<0;x++)
-	    *pPEL8(pThat,x,y)=*pPEL8(pThat,0,y);
+	    *PADPEL(pThat,x,y)=*PADPEL(pThat,0,y);
 
     /* right */
     for(y=0;y<pThat->Dy;y++)
 	for(x=pThat->Dx;x<pThat->Dx+pad;x++)
-	    *pPEL8(pThat,x,y)=*pPEL8(pThat,pThat->Dx-1,y);
+	    *PADPEL(pThat,x,y)=*PADPEL(pThat,pThat->Dx-1,y);
 
     /* top */
     for(x=-pad;x<pThat->Dx+pad;x++)
 	for(y=-pad;y<0;y++)
-	    *pPEL8(pThat,x,y)=*pPEL8(pThat,x,0);
+	    *PADPEL(pThat,x,y)=*PADPEL(pThat,x,0);
 
     /* bottom */
     for(x=-pad;x<pThat->Dx+pad;x++)
 	for(y=pThat->Dy;y<pThat->Dy+pad;y++)
-	    *pPEL8(pThat,x,y)=*pPEL8(pThat,x,pThat->Dy-1);
+	    *PADPEL(pThat,x,y)=*PADPEL(pThat,x,pThat->Dy-1);
+#undef PADPEL
+}
+
+
+/*****************************************************************************
+ *  exported functions: verification
+ *
+ *  helpers to check kernels against a reference or a stored golden hash.
+ *  they only look at the Dx*Bpp bytes of each line, so pics with different
+ *  strides, windows made with Pic_Create() and padded pics compare equal if
+ *  their pels do.
+ ****************************************************************************/
+
+/****************************************************************************/
+/** fill a pic with reproducible noise
+ *
+ *  \param  pThat
+ *  \param  Bpp   bytes per pel
+ *  \param  Seed  same seed, same pels
+ */
+void Pic_Random(tPic *pThat, int Bpp, u32 Seed)
+{
+    u8    *pd;
+    int   x,y;
+    u32   r=Seed*2654435761u+1;
+
+    pd=pThat->Pel;
+    for(y=0;y<pThat->Dy;y++){
+	for(x=0;x<pThat->Dx*Bpp;x++){
+	    r=r*1664525+1013904223;
+	    pd[x]=r>>24;
+	}
+	pd+=pThat->S;
+    }
+}
+
+
+/****************************************************************************/
+/** 64bit hash of the pels and the size of a pic, e.g. to compare the output
+ *  of a kernel with a golden value
+ *
+ *  \param  pThat
+ *  \param  Bpp   bytes per pel
+ *  \return the hash
+ */
+u64 Pic_Hash(const tPic *pThat, int Bpp)
+{
+    const u8  *ps;
+    u64   h,w;
+    int   x,y,n;
+
+    h=((u64)pThat->Dx<<32|(u64)pThat->Dy<<8|Bpp)*0x9e3779b97f4a7c15ull;
+    n=pThat->Dx*Bpp;
+
+    ps=pThat->Pel;
+    for(y=0;y<pThat->Dy;y++){
+	for(x=0;x+8<=n;x+=8){
+	    memcpy(&w,ps+x,8);
+	    h=(h^w)*0xff51afd7ed558ccdull;
+	    h^=h>>32;
+	}
+	for(w=0;x<n;x++)
+	    w=w<<8|ps[x];
+	h=(h^w^(u64)y<<56)*0xc4ceb9fe1a85ec53ull;
+	h^=h>>29;
+	ps+=pThat->S;
+    }
+
+    return h;
+}
+
+
+/****************************************************************************/
+/** compare the pels of 2 pics of the same size
+ *
+ *  \param  pA,pB the pics
+ *  \param  Bpp   bytes per pel
+ *  \param  pX,pY if not NULL: position of the first different pel
+ *  \return number of different pels
+ */
+int Pic_Diff(const tPic *pA, const tPic *pB, int Bpp, int *pX, int *pY)
+{
+    const u8  *pa,*pb;
+    int   x,y,n=0;
+
+    MUST_Eq(pA->Dx,pB->Dx);
+    MUST_Eq(pA->Dy,pB->Dy);
+
+    pa=pA->Pel;
+    pb=pB->Pel;
+    for(y=0;y<pA->Dy;y++){
+	if(memcmp(pa,pb,pA->Dx*Bpp)!=0){
+	    for(x=0;x<pA->Dx;x++){
+		if(memcmp(pa+x*Bpp,pb+x*Bpp,Bpp)!=0){
+		    if(!n++){
+			if(pX) *pX=x;
+			if(pY) *pY=y;
+		    }
+		}
+	    }
+	}
+	pa+=pA->S;
+	pb+=pB->S;
+    }
+
+    return n;
 }
 
 
@@ -1184,6 +2055,8 @@ bool Pic8_Save(const tPic *pThat, const char *Name)
     FILE  *file;
     u8    *pp;
     int   y;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(!(file=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
     fprintf(file,"P5\n# created by nuts\n%d %d\n255\n",pThat->Dx,pThat->Dy);
@@ -1212,6 +2085,8 @@ bool Pic8_SaveA(const tPic *pThat, const char *Name)
     FILE  *file;
     u8    *pp;
     int   y,x;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(!(file=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
     fprintf(file,"P2\n# created by nuts\n%d %d\n255\n",pThat->Dx,pThat->Dy);
@@ -1232,27 +2107,52 @@ bool Pic8_SaveA(const tPic *pThat, const char *Name)
 
 
 /****************************************************************************/
-/** save 16bit grey image as raw pgm
+/** save 16bit grey image as raw pgm. the pixels are written big endian as
+ *  the format wants it, unless g_Pic16Native is set
  *
  *  \param  pThat
  *  \param  Name filename
  *  \return success (always TRUE at the moment)
  */
 bool Pic16_Save(const tPic *pThat, const char *Name)
+{
+    return Pic16_SaveOrder(pThat,Name,g_Pic16Native);
+}
+
+
+/****************************************************************************/
+/** save 16bit grey image as raw pgm, with the byte order of the pixels
+ *  given
+ *
+ *  \param  pThat
+ *  \param  Name   filename
+ *  \param  Native native byte order as older versions, else big endian
+ *  \return success (always TRUE at the moment)
+ */
+bool Pic16_SaveOrder(const tPic *pThat, const char *Name, bool Native)
 {
     FILE  *file;
-    u8    *pp;
+    u8    *pp,*pl=NULL;
     int   y;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(!(file=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
     fprintf(file,"P5\n# created by nuts\n%d %d\n65535\n",pThat->Dx,pThat->Dy);
 
+    if(!Native){
+	pl=calloc(pThat->Dx,2);  MUST(pl);
+    }
+
     pp=pThat->Pel;
     for(y=0;y<pThat->Dy;y++){
-	if(fwrite(pp,pThat->Dx*2,1,file)!=1) ERROR("writing: %s,Name");
+	if(pl)
+	    Bits_Swap16(pl,pp,pThat->Dx);
+	if(fwrite(pl?pl:pp,pThat->Dx*2,1,file)!=1) ERROR("writing: %s",Name);
 	pp+=pThat->S;
     }
 
+    free(pl);
     fclose(file);
 
     return TRUE;
@@ -1271,6 +2171,8 @@ bool Pic32_Save(const tPic *pThat, const char *Name)
     FILE  *file;
     u8    *pp;
     int   y;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(!(file=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
     fprintf(file,"P5\n# created by nuts\n%d %d\n4294967295\n",pThat->Dx,pThat->Dy);
@@ -1300,6 +2202,8 @@ bool Pic16_SaveA(const tPic *pThat, const char *Name)
     FILE  *file;
     u8    *pp;
     int   x,y;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(!(file=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
     fprintf(file,"P2\n# created by nuts\n%d %d\n65535\n",pThat->Dx,pThat->Dy);
@@ -1332,6 +2236,8 @@ bool Pic32_SaveA(const tPic *pThat, const char *Name)
     FILE  *file;
     u8    *pp;
     int   x,y;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(!(file=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
     fprintf(file,"P2\n# created by nuts\n%d %d\n4294967295\n",pThat->Dx,pThat->Dy);
@@ -1360,20 +2266,14 @@ bool Pic32_SaveA(const tPic *pThat, const char *Name)
 bool Pic32_SaveXRGB(const tPic *pThat, const char *Name)
 {
     FILE  *file;
-    u8    *pp;
-    int   x,y,r;
+    const u8 ord[3]={1,2,3};
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(!(file=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
     fprintf(file,"P6\n# created by nuts\n%d %d\n255\n",pThat->Dx,pThat->Dy);
 
-    pp=pThat->Pel;
-    for(y=0;y<pThat->Dy;y++){
-	for(x=0;x<pThat->Dx;x++){
-	    r=fwrite(&pp[4*x+1],3,1,file);
-	    if(r!=1) ERROR("cannot write");
-	}
-	pp+=pThat->S;
-    }
+    WritePpm(pThat,file,ord);
 
     fclose(file);
 
@@ -1390,20 +2290,14 @@ bool Pic32_SaveXRGB(const tPic *pThat, const char *Name)
 bool Pic32_SaveRGBX(const tPic *pThat, const char *Name)
 {
     FILE  *file;
-    u8    *pp;
-    int   x,y,r;
+    const u8 ord[3]={0,1,2};
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(!(file=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
     fprintf(file,"P6\n# created by nuts\n%d %d\n255\n",pThat->Dx,pThat->Dy);
 
-    pp=pThat->Pel;
-    for(y=0;y<pThat->Dy;y++){
-	for(x=0;x<pThat->Dx;x++){
-	    r=fwrite(&pp[4*x],3,1,file);
-	    if(r!=1) ERROR("cannot read");
-	}
-	pp+=pThat->S;
-    }
+    WritePpm(pThat,file,ord);
 
     fclose(file);
 
@@ -1421,23 +2315,14 @@ bool Pic32_SaveRGBX(const tPic *pThat, const char *Name)
 bool Pic32_SaveBGRX(const tPic *pThat, const char *Name)
 {
     FILE  	*file;
-    u8    	*pp;
-    int   	x,y;
-    u32		pel;
+    const u8	ord[3]={2,1,0};
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(!(file=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
     fprintf(file,"P6\n# created by nuts\n%d %d\n255\n",pThat->Dx,pThat->Dy);
 
-    pp=pThat->Pel;
-    for(y=0;y<pThat->Dy;y++){
-	for(x=0;x<pThat->Dx;x++){
-	    pel=((u32*)pp)[x];
-	    fputc(BITS(pel,23,16),file);
-	    fputc(BITS(pel,15, 8),file);
-	    fputc(BITS(pel, 7, 0),file);
-	}
-	pp+=pThat->S;
-    }
+    WritePpm(pThat,file,ord);
 
     fclose(file);
 
@@ -1456,6 +2341,8 @@ bool Pic32_SaveRgbA(const tPic *pThat, const char *Name)
     FILE  *file;
     u8    *pp;
     int   x,y;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(!(file=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
     fprintf(file,"P3\n# created by nuts\n%d %d\n255\n",pThat->Dx,pThat->Dy);
@@ -1474,35 +2361,85 @@ bool Pic32_SaveRgbA(const tPic *pThat, const char *Name)
     return TRUE;
 }
 
+/****************************************************************************/
+/** save 8 bit pels as lossless compressed nqi file, see nqi.h
+ *
+ *  \param  pThat
+ *  \param  Name filename
+ *  \return success (always TRUE at the moment)
+ */
+bool Pic8_SaveNqi(const tPic *pThat, const char *Name)
+{
+    TRACE_FUNC;
+    METRIC_FUNC;
+
+    return SaveNqi(pThat,Name,PIC_G8,1);
+}
 
-/*****************************************************************************
- *  exported functions: load
- ****************************************************************************/
 
 /****************************************************************************/
-/** load 8bit image from pgm file with alignment
+/** save 16 bit pels as lossless compressed nqi file
  *
  *  \param  pThat
  *  \param  Name filename
- *  \param  Aln  alignment (4,8,16,32)
- *  \return TRUE if file exists
+ *  \return success (always TRUE at the moment)
  */
-bool Pic8_LoadAln(tPic *pThat, const char *Name, int Aln)
+bool Pic16_SaveNqi(const tPic *pThat, const char *Name)
 {
-    FILE		*file;
-    u8		*pp;
-    int		x,y,dx,dy,v;
-    bool		raw=TRUE;
-    char		buffer[256];
+    TRACE_FUNC;
+    METRIC_FUNC;
 
-    if(strcmp(Name,"-")==0)
-	file=stdin;
-    else if(!(file=fopen(Name,"r"))){
-	pThat->Dx=0;
-	pThat->Dy=0;
-	pThat->S=0;
-	pThat->Pel=NULL;
-	return FALSE;
+    return SaveNqi(pThat,Name,PIC_G16,2);
+}
+
+
+/****************************************************************************/
+/** save XRGB 32 bit words as lossless compressed nqi file
+ *
+ *  \param  pThat
+ *  \param  Name filename
+ *  \return success (always TRUE at the moment)
+ */
+bool Pic32_SaveNqi(const tPic *pThat, const char *Name)
+{
+    TRACE_FUNC;
+    METRIC_FUNC;
+
+    return SaveNqi(pThat,Name,PIC_XRGB,4);
+}
+
+
+/*****************************************************************************
+ *  exported functions: load
+ ****************************************************************************/
+
+/****************************************************************************/
+/** load 8bit image from pgm file with alignment
+ *
+ *  \param  pThat
+ *  \param  Name filename
+ *  \param  Aln  alignment (4,8,16,32)
+ *  \return TRUE if file exists
+ */
+bool Pic8_LoadAln(tPic *pThat, const char *Name, int Aln)
+{
+    FILE		*file;
+    u8		*pp;
+    int		x,y,dx,dy,v;
+    u32		n;
+    bool		raw=TRUE;
+    char		buffer[256];
+    TRACE_FUNC;
+    METRIC_FUNC;
+
+    if(strcmp(Name,"-")==0)
+	file=stdin;
+    else if(!(file=fopen(Name,"r"))){
+	pThat->Dx=0;
+	pThat->Dy=0;
+	pThat->S=0;
+	pThat->Pel=NULL;
+	return FALSE;
     }
 
     fgets(buffer,sizeof(buffer),file);
@@ -1533,15 +2470,16 @@ bool Pic8_LoadAln(tPic *pThat, const char *Name, int Aln)
     else{
 	for(y=0;y<dy;y++){
 	    for(x=0;x<dx;x++){
-		if(fscanf(file,"%d",&v)!=1)
+		if(!ReadNum(file,&n))
 		    ERROR("read error in %s at (%d,%d)",Name,x,y);
-		pp[x]=v;
+		pp[x]=n;
 	    }
 	    pp+=pThat->S;
 	}
     }
 
-    fclose(file);
+    if(file!=stdin)
+	fclose(file);
 
     return TRUE;
 }
@@ -1561,7 +2499,8 @@ bool Pic8_Load(tPic *pThat, const char *Name)
 
 
 /****************************************************************************/
-/** load 16bit image from pgm file with alignment
+/** load 16bit image from pgm file with alignment. raw data is taken as big
+ *  endian as the format wants it, unless g_Pic16Native is set
  *
  *  \param  pThat
  *  \param  Name filename
@@ -1569,12 +2508,31 @@ bool Pic8_Load(tPic *pThat, const char *Name)
  *  \return TRUE if file exists
  */
 bool Pic16_LoadAln(tPic *pThat, const char *Name, int Aln)
+{
+    return Pic16_LoadOrder(pThat,Name,Aln,g_Pic16Native);
+}
+
+
+/****************************************************************************/
+/** load 16bit image from pgm file with alignment, with the byte order of
+ *  raw data given
+ *
+ *  \param  pThat
+ *  \param  Name   filename
+ *  \param  Aln    alignment (4,8,16,32)
+ *  \param  Native native byte order as older versions, else big endian
+ *  \return TRUE if file exists
+ */
+bool Pic16_LoadOrder(tPic *pThat, const char *Name, int Aln, bool Native)
 {
     FILE		*file;
     u8		*pp;
     int		x,y,dx,dy,v,res;
+    u32		n;
     bool		raw=TRUE;
     char		buffer[256];
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(strcmp(Name,"-")==0)
 	file=stdin;
@@ -1617,21 +2575,24 @@ bool Pic16_LoadAln(tPic *pThat, const char *Name, int Aln)
 	for(y=0;y<pThat->Dy;y++){
 	    if(fread(pp,pThat->Dx*2,1,file)!=1)
 		ERROR("read error in %s line %d",Name,y);
+	    if(!Native)
+		Bits_Swap16(pp,pp,pThat->Dx);
 	    pp+=pThat->S;
 	}
     }
     else{
 	for(y=0;y<dy;y++){
 	    for(x=0;x<dx;x++){
-		if(fscanf(file,"%d",&v)!=1)
+		if(!ReadNum(file,&n))
 		    ERROR("read error in %s at (%d,%d)",Name,x,y);
-		CEW16(pp+2*x,v);
+		CEW16(pp+2*x,n);
 	    }
 	    pp+=pThat->S;
 	}
     }
 
-    fclose(file);
+    if(file!=stdin)
+	fclose(file);
 
     return TRUE;
 }
@@ -1659,16 +2620,21 @@ bool Pic16_Load(tPic *pThat, const char *Name)
  */
 bool Pic16_UniLoad(tPic *pThat, const char *Name)
 {
-    switch(Pic_FileType(Name)){
-    case PIC_G8:	return Pic16_LoadShl(pThat,Name,8);
-    case PIC_G16:	return Pic16_Load(pThat,Name);
-    default:
-	pThat->Dx=0;
-	pThat->Dy=0;
-	pThat->S=0;
-	pThat->Pel=NULL;
-	return FALSE;
+    tPicFile	f;
+
+    pThat->Pel=NULL;
+    if(Pic_Open(&f,Name)){
+	if(f.Type==PIC_G8 || f.Type==PIC_G16){
+	    Pic_ReadInto(&f,pThat,2,f.Type==PIC_G8?8:0);
+	    Pic_Close(&f);
+	    return TRUE;
+	}
+	Pic_Close(&f);
     }
+    pThat->Dx=0;
+    pThat->Dy=0;
+    pThat->S=0;
+    return FALSE;
 }
 
 
@@ -1688,6 +2654,8 @@ bool Pic32_Load(tPic *pThat, const char *Name)
     bool		raw=TRUE;
     char		buffer[256];
     u32		v;
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(strcmp(Name,"-")==0)
 	file=stdin;
@@ -1735,7 +2703,7 @@ bool Pic32_Load(tPic *pThat, const char *Name)
     else{
 	for(y=0;y<dy;y++){
 	    for(x=0;x<dx;x++){
-		if(fscanf(file,"%u",&v)!=1)
+		if(!ReadNum(file,&v))
 		    ERROR("read error in %s at (%d,%d)",Name,x,y);
 		CEW32(pp+4*x,v);
 	    }
@@ -1743,7 +2711,8 @@ bool Pic32_Load(tPic *pThat, const char *Name)
 	}
     }
 
-    fclose(file);
+    if(file!=stdin)
+	fclose(file);
 
     return TRUE;
 }
@@ -1760,10 +2729,13 @@ bool Pic32_Load(tPic *pThat, const char *Name)
 bool Pic16_LoadShl(tPic *pThat, const char *Name, int Shift)
 {
     FILE		*file;
-    u8		*pp;
+    u8		*pp,*pl;
     int		x,y,dx,dy,v;
+    u32		n;
     bool		raw=TRUE,r8=FALSE;
     char		buffer[256];
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(strcmp(Name,"-")==0)
 	file=stdin;
@@ -1790,33 +2762,39 @@ bool Pic16_LoadShl(tPic *pThat, const char *Name, int Shift)
     sscanf(buffer,"%d",&v);
     if(v!=0xffff){
 	if(v!=0xff)
-	    ERROR("%s has wrong range %d",v,Name);
+	    ERROR("%s has wrong range %d",Name,v);
 	r8=TRUE;
     }
 
     pp=pThat->Pel;
 
-    for(y=0;y<dy;y++){
-	for(x=0;x<dx;x++){
-	    if(raw){
-		v=fgetc(file);
-		if(v==EOF)  ERROR("read error in %s at (%d,%d)",Name,x,y);
-		if(!r8){
-		    v<<=8;
-		    v|=fgetc(file);
-		}
-	    }
-	    else{
-		if(fscanf(file,"%d",&v)!=1)
+    /* whole lines, swap/widen and shift in one pass */
+    if(raw){
+	pl=calloc(dx,r8?1:2);  MUST(pl);
+	for(y=0;y<dy;y++){
+	    if(fread(pl,dx*(r8?1:2),1,file)!=1)
+		ERROR("read error in %s line %d",Name,y);
+	    if(r8)
+		Bits_U8to16Shl((u16*)pp,pl,dx,Shift);
+	    else
+		Bits_Be16Shl((u16*)pp,pl,dx,Shift);
+	    pp+=pThat->S;
+	}
+	free(pl);
+    }
+    else{
+	for(y=0;y<dy;y++){
+	    for(x=0;x<dx;x++){
+		if(!ReadNum(file,&n))
 		    ERROR("read error in %s at (%d,%d)",Name,x,y);
+		CEW16(pp+2*x,n<<Shift);
 	    }
-	    v<<=Shift;
-	    CEW16(pp+2*x,v);
+	    pp+=pThat->S;
 	}
-	pp+=pThat->S;
     }
 
-    fclose(file);
+    if(file!=stdin)
+	fclose(file);
 
     return TRUE;
 }
@@ -1833,9 +2811,13 @@ bool Pic32_LoadXRGB(tPic *pThat, const char *Name)
 {
     FILE  *file;
     u8    *pp;
-    int   x,y,dx,dy,a=0,b=0,c=0;
+    int   x,y,dx,dy;
+    u32   a=0,b=0,c=0;
     char  buffer[256];
     bool	raw=TRUE;
+    const u8 ord[4]={0xff,0,1,2};
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(strcmp(Name,"-")==0)
 	file=stdin;
@@ -1859,26 +2841,18 @@ bool Pic32_LoadXRGB(tPic *pThat, const char *Name)
     Pic32_Malloc(pThat,dx,dy);
 
     do fgets(buffer,sizeof(buffer),file); while(buffer[0]=='#');
-    sscanf(buffer,"%d",&c);
+    sscanf(buffer,"%u",&c);
     if(c!=0xff)
-	ERROR("%s has wrong range %d",Name,c);
+	ERROR("%s has wrong range %u",Name,c);
 
     pp=pThat->Pel;
 
-    if(raw){
-	for(y=0;y<pThat->Dy;y++){
-	    for(x=0;x<pThat->Dx;x++){
-		pp[4*x]=0;
-		if(fread(&pp[4*x+1],3,1,file)!=1)
-		    ERROR("read error in %s  at (%d,%d)",Name,x,y);
-	    }
-	    pp+=pThat->S;
-	}
-    }
+    if(raw)
+	ReadPpm(pThat,file,Name,ord);
     else{
 	for(y=0;y<dy;y++){
 	    for(x=0;x<dx;x++){
-		if(fscanf(file,"%d %d %d",&a,&b,&c)!=3)
+		if(!ReadNum(file,&a) || !ReadNum(file,&b) || !ReadNum(file,&c))
 		    ERROR("read error in %s at (%d,%d)",Name,x,y);
 		pp[4*x+0]=0;
 		pp[4*x+1]=a;
@@ -1889,7 +2863,8 @@ bool Pic32_LoadXRGB(tPic *pThat, const char *Name)
 	}
     }
 
-    fclose(file);
+    if(file!=stdin)
+	fclose(file);
 
     return TRUE;
 }
@@ -1906,9 +2881,13 @@ bool Pic32_LoadRGBX(tPic *pThat, const char *Name)
 {
     FILE  *file;
     u8    *pp;
-    int   x,y,dx,dy,a=0,b=0,c=0;
+    int   x,y,dx,dy;
+    u32   a=0,b=0,c=0;
     char  buffer[256];
     bool	raw=TRUE;
+    const u8 ord[4]={0,1,2,0xff};
+    TRACE_FUNC;
+    METRIC_FUNC;
 
     if(strcmp(Name,"-")==0)
 	file=stdin;
@@ -1932,26 +2911,18 @@ bool Pic32_LoadRGBX(tPic *pThat, const char *Name)
     Pic32_Malloc(pThat,dx,dy);
 
     do fgets(buffer,sizeof(buffer),file); while(buffer[0]=='#');
-    sscanf(buffer,"%d",&c);
+    sscanf(buffer,"%u",&c);
     if(c!=0xff)
-	ERROR("%s has wrong range %d",Name,c);
+	ERROR("%s has wrong range %u",Name,c);
 
     pp=pThat->Pel;
 
-    if(raw){
-	for(y=0;y<pThat->Dy;y++){
-	    for(x=0;x<pThat->Dx;x++){
-		pp[4*x+3]=0;
-		if(fread(&pp[4*x],3,1,file)!=1)
-		    ERROR("read error in %s  at (%d,%d)",Name,x,y);
-	    }
-	    pp+=pThat->S;
-	}
-    }
+    if(raw)
+	ReadPpm(pThat,file,Name,ord);
     else{
 	for(y=0;y<dy;y++){
 	    for(x=0;x<dx;x++){
-		if(fscanf(file,"%d %d %d",&a,&b,&c)!=3)
+		if(!ReadNum(file,&a) || !ReadNum(file,&b) || !ReadNum(file,&c))
 		    ERROR("read error in %s at (%d,%d)",Name,x,y);
 		pp[4*x+0]=a;
 		pp[4*x+1]=b;
@@ -1962,61 +2933,536 @@ bool Pic32_LoadRGBX(tPic *pThat, const char *Name)
 	}
     }
 
-    fclose(file);
+    if(file!=stdin)
+	fclose(file);
+
+    return TRUE;
+}
+
+/****************************************************************************/
+/** load 8 bit pels from a nqi or pgm file, the pic is allocated
+ *
+ *  \param  pThat
+ *  \param  Name filename, "-" for stdin
+ *  \return FALSE if the file cannot be opened
+ */
+bool Pic8_LoadNqi(tPic *pThat, const char *Name)
+{
+    tPicFile	f;
+    TRACE_FUNC;
+    METRIC_FUNC;
+
+    memset(pThat,0,sizeof(*pThat));
+    if(!Pic_Open(&f,Name))
+	return FALSE;
+    Pic_ReadInto(&f,pThat,1,0);
+    Pic_Close(&f);
+
+    return TRUE;
+}
+
+
+/****************************************************************************/
+/** load 16 bit pels from a nqi or pgm file, the pic is allocated. 8 bit
+ *  files are widened
+ *
+ *  \param  pThat
+ *  \param  Name filename, "-" for stdin
+ *  \return FALSE if the file cannot be opened
+ */
+bool Pic16_LoadNqi(tPic *pThat, const char *Name)
+{
+    tPicFile	f;
+    TRACE_FUNC;
+    METRIC_FUNC;
+
+    memset(pThat,0,sizeof(*pThat));
+    if(!Pic_Open(&f,Name))
+	return FALSE;
+    Pic_ReadInto(&f,pThat,2,0);
+    Pic_Close(&f);
+
+    return TRUE;
+}
+
+
+/****************************************************************************/
+/** load XRGB 32 bit words from a nqi or ppm file, the pic is allocated
+ *
+ *  \param  pThat
+ *  \param  Name filename, "-" for stdin
+ *  \return FALSE if the file cannot be opened
+ */
+bool Pic32_LoadNqi(tPic *pThat, const char *Name)
+{
+    tPicFile	f;
+    TRACE_FUNC;
+    METRIC_FUNC;
+
+    memset(pThat,0,sizeof(*pThat));
+    if(!Pic_Open(&f,Name))
+	return FALSE;
+    Pic_ReadInto(&f,pThat,4,0);
+    Pic_Close(&f);
 
     return TRUE;
 }
 
 
 /****************************************************************************/
-/** determine the type of picture contained in a file
+/** determine the type of picture contained in a file. never fails, a bad
+ *  header is no type. stdin is not read, so a loader can read it later
  *
  *  \param Name the filename
- *  \return PIC_G[32|16|8] | NIL
+ *  \return PIC_G[32|16|8], PIC_XRGB, or PIC_NONE for no file, no supported
+ *          header or "-"
  */
 int Pic_FileType(const char *Name)
 {
-    FILE		*file;
-    int		dx,dy;
-    u32		v;
-    int		t,res;
-    char		buffer[256];
+    tPicFile	f;
+    FILE	*file;
+    int		t;
+
+    memset(&f,0,sizeof(f));
+    f.Name=Name;
 
-    if(!(file=fopen(Name,"r")))
+    if(strcmp(Name,"-")==0 || !(file=fopen(Name,"r")))
 	return PIC_NONE;
+    t=ParseHeader(&f,file)?PIC_NONE:f.Type;
+    fclose(file);
 
-    fgets(buffer,sizeof(buffer),file);
-    if(strncmp(buffer,"P3",2)==0||strncmp(buffer,"P6",2)==0)
-	t=PIC_XRGB;
+    return t;
+}
+
+
+/*****************************************************************************
+ *  exported functions: open and read
+ ****************************************************************************/
+
+/****************************************************************************/
+/** open a pgm/ppm file and parse its header, the pels are read later with
+ *  Pic_ReadInto(). this is the only place where a file is opened, so batch
+ *  tools can decide on type and size without a second open
+ *
+ *  \param  pThat the parsed header
+ *  \param  Name  filename, "-" for stdin
+ *  \return FALSE if the file does not exist
+ */
+bool Pic_Open(tPicFile *pThat, const char *Name)
+{
+    FILE		*file;
+    const char		*msg;
+
+    memset(pThat,0,sizeof(*pThat));
+    pThat->Name=Name;
+
+    if(strcmp(Name,"-")==0)
+	file=stdin;
+    else if(!(file=fopen(Name,"r")))
+	return FALSE;
+
+    if((msg=ParseHeader(pThat,file)))
+	ERROR("%s in %s",msg,Name);
+    pThat->pFile=file;
+    ;	DLOGd(pThat->Type); DLOGd(pThat->Dx); DLOGd(pThat->Dy);
+
+    return TRUE;
+}
+
+
+/****************************************************************************/
+/** parse a pgm/ppm header from the first bytes of a file, e.g. read by a
+ *  batch loader. the pels start at pThat->Offset, see Pic_ReadRaw()
+ *
+ *  \param  pThat the parsed header, pFile is NULL
+ *  \param  pBuf  start of the file
+ *  \param  N     bytes in pBuf
+ *  \param  Name  filename for messages
+ *  \return FALSE if there is no complete pnm header
+ */
+bool Pic_ParseHeader(tPicFile *pThat, const void *pBuf, int N,
+		     const char *Name)
+{
+#ifdef UNIX_GNU
+    FILE		*file;
+    bool		ok;
+
+    memset(pThat,0,sizeof(*pThat));
+    pThat->Name=Name;
+
+    if(N<=0 || !(file=fmemopen((void*)pBuf,N,"r")))
+	return FALSE;
+    ok=ParseHeader(pThat,file)==NULL;
+    fclose(file);
+
+    return ok;
+#else
+    (void)pThat; (void)pBuf; (void)N; (void)Name;
+    MUST_MSG(0,"don't have this here");
+    return FALSE;
+#endif
+}
+
+
+/****************************************************************************/
+/** convert the raw pels of a file in memory, as Pic_ReadInto()
+ *
+ *  \param  pThat the header from Pic_ParseHeader(), P5/P6
+ *  \param  pPic  destination, allocated if pPic->Pel is NULL
+ *  \param  pPels the pels, Dx*Dy of them in the file format
+ *  \param  Bpp   bytes per pel of pPic, 0 for the natural size of the type
+ *  \param  Shift for 16bit pels
+ */
+void Pic_ReadRaw(tPicFile *pThat, tPic *pPic, const void *pPels, int Bpp,
+		 int Shift)
+{
+    const u8		*ps=pPels;
+    u8			*pp;
+    int			y,fbpp,len;
+    METRIC_FUNC;
+
+    ;	MUST(pThat->Raw);
+
+    fbpp=FileBpp(pThat,&Bpp);
+    NeedPic(pPic,pThat->Dx,pThat->Dy,Bpp);
+    len=pThat->Dx*fbpp;
+
+    pp=pPic->Pel;
+    for(y=0;y<pThat->Dy;y++){
+	if(fbpp==Bpp){
+	    memcpy(pp,ps,len);
+	    ConvRow(pp,pp,pThat->Dx,fbpp,Bpp,Shift,pThat->Native);
+	}
+	else
+	    ConvRow(pp,ps,pThat->Dx,fbpp,Bpp,Shift,pThat->Native);
+	ps+=len;
+	pp+=pPic->S;
+    }
+}
+
+
+/****************************************************************************/
+/** read the pels of an opened file. if pPic->Pel is NULL, the pic is
+ *  allocated, else the caller's buffer is used (e.g. from PicPool_Get()):
+ *  it must be large enough and gets the size of the file, its stride is
+ *  kept. the conversions are the ones of the Load functions:
+ *
+ *	PIC_G8		Bpp 1, or 2 with the values shifted left by Shift
+ *	PIC_G16		Bpp 2, shifted left by Shift, see pThat->Native
+ *	PIC_G32		Bpp 4, native
+ *	PIC_XRGB	Bpp 4, as Pic32_LoadXRGB()
+ *
+ *  \param  pThat the file from Pic_Open()
+ *  \param  pPic  destination
+ *  \param  Bpp   bytes per pel of pPic, 0 for the natural size of the type
+ *  \param  Shift for 16bit pels
+ *  \return TRUE
+ */
+bool Pic_ReadInto(tPicFile *pThat, tPic *pPic, int Bpp, int Shift)
+{
+    FILE		*file=pThat->pFile;
+    const char		*name=pThat->Name;
+    u8			*pp,*pl=NULL;
+    int			x,y,dx=pThat->Dx,dy=pThat->Dy,fbpp;
+    u32			a,b,c;
+    TRACE_FUNC;
+    METRIC_FUNC;
+
+    ;	MUST(file);
+
+    fbpp=FileBpp(pThat,&Bpp);
+    NeedPic(pPic,dx,dy,Bpp);
+
+    pp=pPic->Pel;
+
+    if(pThat->Nqi)
+	ReadNqi(pThat,pPic,fbpp,Bpp,Shift);
+    else if(pThat->Raw){
+	/* whole lines, expand/swap and shift in place or from staging */
+	if(fbpp!=Bpp){
+	    pl=calloc(dx,fbpp);  MUST(pl);
+	}
+	for(y=0;y<dy;y++){
+	    if(fread(pl?pl:pp,dx*fbpp,1,file)!=1)
+		ERROR("read error in %s line %d",name,y);
+	    ConvRow(pp,pl?pl:pp,dx,fbpp,Bpp,Shift,pThat->Native);
+	    pp+=pPic->S;
+	}
+	free(pl);
+    }
+    else if(fbpp==3){
+	for(y=0;y<dy;y++){
+	    for(x=0;x<dx;x++){
+		if(!ReadNum(file,&a) || !ReadNum(file,&b) || !ReadNum(file,&c))
+		    ERROR("read error in %s at (%d,%d)",name,x,y);
+		pp[4*x+0]=0;
+		pp[4*x+1]=a;
+		pp[4*x+2]=b;
+		pp[4*x+3]=c;
+	    }
+	    pp+=pPic->S;
+	}
+    }
     else{
-	if(strncmp(buffer,"P5",2)!=0){
-	    if(strncmp(buffer,"P2",2)!=0)
-		ERROR("pgm header (P2/P5) not found in %s",Name);
+	for(y=0;y<dy;y++){
+	    for(x=0;x<dx;x++){
+		if(!ReadNum(file,&a))
+		    ERROR("read error in %s at (%d,%d)",name,x,y);
+		if(Bpp==1)
+		    pp[x]=a;
+		else if(Bpp==2)
+		    CEW16(pp+2*x,a<<Shift);
+		else
+		    CEW32(pp+4*x,a);
+	    }
+	    pp+=pPic->S;
 	}
-	do fgets(buffer,sizeof(buffer),file); while(buffer[0]=='#');
+    }
+
+    return TRUE;
+}
+
+
+/****************************************************************************/
+/** close a file from Pic_Open()
+ *
+ *  \param  pThat the file
+ */
+void Pic_Close(tPicFile *pThat)
+{
+    if(pThat->pFile && pThat->pFile!=stdin)
+	fclose(pThat->pFile);
+    pThat->pFile=NULL;
+}
+
+/****************************************************************************/
+/** read a rectangle of a raw pgm/ppm file. only the needed part of each
+ *  line is read with pread(), in bands by pThat->Threads threads if the
+ *  rectangle is large. the conversions are the ones of Pic_ReadInto()
+ *
+ *	Pic_Open(&f,"huge.pgm");
+ *	Pic_ReadRoi(&f,&tile,x,y,512,512,0,0);
+ *
+ *  \param  pThat the file from Pic_Open(), P5/P6
+ *  \param  pPic  destination, allocated if pPic->Pel is NULL
+ *  \param  x,y   topleft of the rectangle in the file
+ *  \param  dx,dy size of the rectangle
+ *  \param  Bpp   bytes per pel of pPic, 0 for the natural size of the type
+ *  \param  Shift for 16bit pels
+ *  \return TRUE
+ */
+bool Pic_ReadRoi(tPicFile *pThat, tPic *pPic, int x, int y, int dx, int dy,
+		 int Bpp, int Shift)
+{
+#ifdef UNIX_GNU
+    tRows		r;
+    TRACE_FUNC;
+    METRIC_FUNC;
+
+    ;	MUST(pThat->pFile);
+    if(!pThat->Raw || pThat->Offset<0)
+	ERROR("%s is no seekable raw file",pThat->Name);
+    MUST(x>=0 && y>=0 && dx>0 && dy>0);
+    MUST(x+dx<=pThat->Dx && y+dy<=pThat->Dy);
+
+    r.FBpp=FileBpp(pThat,&Bpp);
+    NeedPic(pPic,dx,dy,Bpp);
 
-	res=sscanf(buffer,"%d %d",&dx,&dy); DLOGd(res);
-	if(!res) ERROR("cannot read size of %s");
-	else if(res==1){
-	    do fgets(buffer,sizeof(buffer),file); while(buffer[0]=='#');
-	    sscanf(buffer,"%d",&dy);
+    r.Fd=fileno((FILE*)pThat->pFile);
+    r.FileS=(long)pThat->Dx*r.FBpp;
+    r.Off=pThat->Offset+y*r.FileS+(long)x*r.FBpp;
+    r.Dx=dx;
+    r.N=dy;
+    r.pDst=pPic->Pel;
+    r.S=pPic->S;
+    r.Bpp=Bpp;
+    r.Shift=Shift;
+    r.Native=pThat->Native;
+    r.Name=pThat->Name;
+    ReadRowsPar(&r,pThat->Threads);
+
+    return TRUE;
+#else
+    (void)pThat; (void)pPic; (void)x; (void)y; (void)dx; (void)dy;
+    (void)Bpp; (void)Shift;
+    MUST_MSG(0,"don't have this here");
+    return FALSE;
+#endif
+}
+
+
+/****************************************************************************/
+/** load a rectangle of a planar YUV 420 file (3 consecutive images). the
+ *  rectangle has the size of the planes of pThat, the chroma planes are
+ *  read at half the position. the file may have any size, the chroma of an
+ *  odd Dx or Dy is rounded up as in Yc_Load(). Yuv420_Malloc() only makes
+ *  even rectangles, for an odd one the caller sets up chroma planes of
+ *  (dx+1)/2 x (dy+1)/2
+ *
+ *  \param  pThat   destination
+ *  \param  Name    filename
+ *  \param  Dx,Dy   size of the images in the file
+ *  \param  x,y     topleft of the rectangle, even
+ *  \param  Threads max threads for the reads of a plane
+ *  \return TRUE if file exists
+ */
+bool Yuv_LoadRoi(tYuv *pThat, const char *Name, int Dx, int Dy, int x, int y,
+		 int Threads)
+{
+#ifdef UNIX_GNU
+    tRows	r;
+    off_t	off=0;
+    int		c,fd,sub;
+    TRACE_FUNC;
+    METRIC_FUNC;
+
+    MUST(x%2==0 && y%2==0);
+    MUST(x>=0 && y>=0 && x+pThat->Dx<=Dx && y+pThat->Dy<=Dy);
+
+    if((fd=open(Name,O_RDONLY))<0)
+	return FALSE;
+
+    for(c=0;c<LEN(pThat->C);c++){
+	sub=c?2:1;
+	r.Fd=fd;
+	r.FileS=(Dx+sub-1)/sub;
+	r.Off=off+(long)y/sub*r.FileS+x/sub;
+	r.Dx=pThat->C[c].Dx;
+	r.N=pThat->C[c].Dy;
+	r.pDst=pThat->C[c].Pel;
+	r.S=pThat->C[c].S;
+	r.FBpp=r.Bpp=1;
+	r.Shift=0;
+	r.Native=FALSE;
+	r.Name=Name;
+	ReadRowsPar(&r,Threads);
+	off+=r.FileS*((Dy+sub-1)/sub);
+    }
+
+    close(fd);
+
+    return TRUE;
+#else
+    (void)pThat; (void)Name; (void)Dx; (void)Dy; (void)x; (void)y;
+    (void)Threads;
+    MUST_MSG(0,"don't have this here");
+    return FALSE;
+#endif
+}
+
+
+
+/****************************************************************************/
+/*  the entry of a buffer in a pool, -1 if it is not there
+ */
+static int PoolFind(const tPicPool *pThat, const u8 *pBuf)
+{
+    int		i;
+
+    for(i=0;i<pThat->N;i++)
+	if(pThat->pBufs[i].pBuf==pBuf)
+	    return i;
+    return -1;
+}
+
+
+/****************************************************************************/
+/** get a pic from a pool of buffers. a free buffer that is large enough is
+ *  reused, else a new one is allocated. the pels are not cleared. the pool
+ *  keeps the allocated size of each buffer, so the pic may be shrunk (e.g.
+ *  by Pic_ReadInto()) before it is put back
+ *
+ *  \param  pThat the pool
+ *  \param  pPic  the pic, with stride PAD(dx*Bpp,sizeof(int))
+ *  \param  dx,dy size
+ *  \param  Bpp   bytes per pel
+ */
+void PicPool_Get(tPicPool *pThat, tPic *pPic, int dx, int dy, int Bpp)
+{
+    tPicPoolBuf	*pb;
+    int		i,best=-1,s=PAD(dx*Bpp,sizeof(int));
+    long	n=(long)s*dy;
+
+    for(i=0;i<pThat->N;i++){
+	pb=&pThat->pBufs[i];
+	if(!pb->Used && pb->Size>=n &&
+	   (best<0 || pb->Size<pThat->pBufs[best].Size))
+	    best=i;
+    }
+
+    if(best<0){
+	pPic->Pel=calloc(n,1);  MUST(pPic->Pel);
+	/* the address of a buffer that was not put back may come again */
+	if((best=PoolFind(pThat,pPic->Pel))<0){
+	    if(pThat->N==pThat->Max){
+		pThat->Max=MAX(2*pThat->Max,PICPOOL_MAX);
+		pThat->pBufs=realloc(pThat->pBufs,
+				     pThat->Max*sizeof(tPicPoolBuf));
+		MUST(pThat->pBufs);
+	    }
+	    best=pThat->N++;
 	}
+	pThat->pBufs[best].pBuf=pPic->Pel;
+	pThat->pBufs[best].Size=n;
+    }
+    pb=&pThat->pBufs[best];
+    pb->Used=TRUE;
+
+    pPic->Pel=pb->pBuf;
+    pPic->Dx=dx;
+    pPic->Dy=dy;
+    pPic->S=s;
+}
 
-	DLOGd(dx); DLOGd(dy);
 
-	do fgets(buffer,sizeof(buffer),file); while(buffer[0]=='#');
-	DLOG("buf %s",buffer);
-	sscanf(buffer,"%u",&v); DLOGx(v);
-	if(v<=0xff)
-	    t=PIC_G8;
-	else if(v<=0xffff)
-	    t=PIC_G16;
-	else
-	    t=PIC_G32;
+/****************************************************************************/
+/** return the buffer of a pic to its pool. the pool keeps PICPOOL_MAX free
+ *  buffers, if there are more it frees the smallest one. a pic of the pool
+ *  may also be freed with Pic_Free() instead
+ *
+ *  \param  pThat the pool
+ *  \param  pPic  the pic from PicPool_Get() of this pool, set to empty
+ */
+void PicPool_Put(tPicPool *pThat, tPic *pPic)
+{
+    int		i,min=-1,nfree=0;
+
+    if(!pPic->Pel)
+	return;
+
+    i=PoolFind(pThat,pPic->Pel);
+    MUST_MSG(i>=0 && pThat->pBufs[i].Used,"PicPool_Put: not from the pool");
+    pThat->pBufs[i].Used=FALSE;
+
+    for(i=0;i<pThat->N;i++)
+	if(!pThat->pBufs[i].Used){
+	    nfree++;
+	    if(min<0 || pThat->pBufs[i].Size<pThat->pBufs[min].Size)
+		min=i;
+	}
+    if(nfree>PICPOOL_MAX){
+	free(pThat->pBufs[min].pBuf);
+	pThat->pBufs[min]=pThat->pBufs[--pThat->N];
     }
-    ;	DLOGd(t);
-    fclose(file);
-    return t;
+    memset(pPic,0,sizeof(*pPic));
+}
+
+
+/****************************************************************************/
+/** free the free buffers of a pool and the pool. buffers that are handed
+ *  out still belong to their pics, free them with Pic_Free()
+ *
+ *  \param  pThat the pool
+ */
+void PicPool_Free(tPicPool *pThat)
+{
+    int		i;
+
+    for(i=0;i<pThat->N;i++)
+	if(!pThat->pBufs[i].Used)
+	    free(pThat->pBufs[i].pBuf);
+    free(pThat->pBufs);
+    memset(pThat,0,sizeof(*pThat));
 }
 
 
@@ -2029,6 +3475,7 @@ void Pic16_BGRfromU8(tPic *pThat, tPic *pSrc)
     u16		*pd;
     u8    	*ps;
     int   	x,y,pel,r,g,b;
+    METRIC_FUNC;
 
     MUST_Ge(pThat->Dx,pSrc->Dx);
     MUST_Ge(pThat->Dy,pSrc->Dy);
@@ -2059,6 +3506,7 @@ void Pic32_XBGRfromU8(tPic *pThat, tPic *pSrc)
     u32		*pd;
     u8    	*ps;
     int   	x,y,pel;
+    METRIC_FUNC;
 
     MUST_Ge(pThat->Dx,pSrc->Dx);
     MUST_Ge(pThat->Dy,pSrc->Dy);
@@ -2144,128 +3592,20 @@ void Pic32_DrawRect(tPic *pThat, int x, int y, int color)
 
 void Pic16_DrawLine(tPic *pThat, int ax, int ay,  int bx, int by, unsigned int color)
 {
-    // Bresenham
-    int width = pThat->Dx;
-    int height = pThat->Dy;
-    //int stride = pThat->S;
-
-    float x, y, initialX, initialY,  pdx, pdy, dx,dy, incx,incy;
-    int xDiscr, yDiscr, n, t;
-
-    if(ax==bx && ay==by)	return;
-
-    dx = (float)(bx - ax);
-    dy = (float)(by - ay);
-
-    incx = (dx >= 0.0) ? 1.0f : -1.0f;
-    incy = (dy >= 0.0) ? 1.0f : -1.0f;
-
-    dx *= incx;
-    dy *= incy;
-
-    if (dx > dy)
-    {
-	pdx = incx;
-	pdy = incy * dy / dx;
-	n = (int)dx;
-    }
-    else
-    {
-	pdx = incx * dx / dy;
-	pdy = incy;
-	n = (int)dy;
-    }
-
-    if (dx > dy)
-    {
-	int discretisedX =  (int)(ax + 0.5);
-	float deltaSubPxX = (float)discretisedX - ax;
-	float deltaSubPxY = deltaSubPxX * incx * incy * dy / dx;
-	initialX = (float)discretisedX;
-	initialY = ay + deltaSubPxY;
-    }
-    else
-    {
-	int discretisedY =  (int)(ay + 0.5);
-	float deltaSubPxY = (float)(discretisedY) - ay;
-	float deltaSubPxX = deltaSubPxY * incy * incx * dx / dy;
-	initialY = (float)discretisedY;
-	initialX = ax + deltaSubPxX;
-    }
-    for (t=0; t <=n; t++)
-    {
-	x = initialX + t * pdx;
-	y = initialY + t * pdy;
-	xDiscr = (int)(x + 0.5);
-	yDiscr = (int)(y + 0.5);
-	if (xDiscr >= 0 && yDiscr >= 0 && xDiscr < width && yDiscr < height)
-	    *(u16*)pPEL16(pThat,xDiscr,yDiscr)=color;
-    }
+#define PEL u16
+#define PIC_DRAWLINE
+#include "pic_tpl.c"
+#undef PIC_DRAWLINE
+#undef PEL
 }
 
 
-/***************************************
- *  todo: solve this with an include kernel
- **************************************/
-
 void Pic32_DrawLine(tPic *pThat, int ax, int ay,  int bx, int by, unsigned int color)
 {
-    // Bresenham
-    int width = pThat->Dx;
-    int height = pThat->Dy;
-    //int stride = pThat->S;
-
-    float x, y, initialX, initialY,  pdx, pdy, dx,dy, incx,incy;
-    int xDiscr, yDiscr, n, t;
-
-    if(ax==bx && ay==by)	return;
-
-    dx = (float)(bx - ax);
-    dy = (float)(by - ay);
-
-    incx = (dx >= 0.0) ? 1.0f : -1.0f;
-    incy = (dy >= 0.0) ? 1.0f : -1.0f;
-
-    dx *= incx;
-    dy *= incy;
-
-    if (dx > dy)
-    {
-	pdx = incx;
-	pdy = incy * dy / dx;
-	n = (int)dx;
-    }
-    else
-    {
-	pdx = incx * dx / dy;
-	pdy = incy;
-	n = (int)dy;
-    }
-
-    if (dx > dy)
-    {
-	int discretisedX = (int)(ax + 0.5);
-	float deltaSubPxX = (float)discretisedX - ax;
-	float deltaSubPxY = deltaSubPxX * incx * incy * dy / dx;
-	initialX = (float)discretisedX;
-	initialY = ay + deltaSubPxY;
-    }
-    else
-    {
-	int discretisedY = (int)(ay + 0.5);
-	float deltaSubPxY = (float)(discretisedY) - ay;
-	float deltaSubPxX = deltaSubPxY * incy * incx * dx / dy;
-	initialY = (float)discretisedY;
-	initialX = ax + deltaSubPxX;
-    }
-    for (t=0; t <=n; t++)
-    {
-	x = initialX + t * pdx;
-	y = initialY + t * pdy;
-	xDiscr = (int)(x + 0.5);
-	yDiscr = (int)(y + 0.5);
-	if (xDiscr >= 0 && yDiscr >= 0 && xDiscr < width && yDiscr < height)
-	    *(u32*)pPEL32(pThat,xDiscr,yDiscr)=color;
-    }
+#define PEL u32
+#define PIC_DRAWLINE
+#include "pic_tpl.c"
+#undef PIC_DRAWLINE
+#undef PEL
 }
 
@@ -65,6 +65,12 @@ enum {
   PIC_YUV420SP
 };
 
+/** Mode of the YUV to RGB conversions, e.g. Pic32_RGBXfromYuv()
+ */
+#define PIC_BT601	0	/**< matrix of SD video */
+#define PIC_BT709	1	/**< matrix of HD video */
+#define PIC_FULL	2	/**< Y,U,V use 0..255, else Y 16..235 */
+
 
 /*****************************************************************************
  *  types
@@ -96,6 +102,52 @@ typedef struct {
   tPic  Y,C;
 } tYc;
 
+/** a pnm file with parsed header, see Pic_Open()
+ */
+typedef struct {
+  void  *pFile;		/**< the FILE, positioned at the first pel */
+  const char *Name;	/**< filename for messages, not copied */
+  int   Type;		/**< PIC_G8, PIC_G16, PIC_G32 or PIC_XRGB */
+  int   Dx,Dy;
+  u32   MaxVal;
+  bool  Raw;		/**< P5/P6, else ascii P2/P3 */
+  bool  Nqi;		/**< compressed, see nqi.h */
+  long  Offset;		/**< file position of the first pel, -1 for pipes */
+  int   Threads;	/**< max threads of Pic_ReadRoi(), 0: no threads */
+  bool  Native;		/**< raw 16 bit pels in native byte order, not big
+			   endian. g_Pic16Native when opened */
+} tPicFile;
+
+#define PICPOOL_MAX	16	/**< free buffers kept by a tPicPool */
+
+/** a pel buffer of a tPicPool
+ */
+typedef struct {
+  u8    *pBuf;
+  long  Size;		/**< allocated bytes */
+  bool  Used;		/**< handed out by PicPool_Get() */
+} tPicPoolBuf;
+
+/** pel buffers for reuse, see PicPool_Get(). all zero is an empty pool
+ */
+typedef struct {
+  tPicPoolBuf *pBufs;	/**< the buffers handed out and the free ones */
+  int   N;		/**< entries in pBufs */
+  int   Max;		/**< allocated entries */
+} tPicPool;
+
+
+/*****************************************************************************
+ *  global variables
+ ****************************************************************************/
+
+/** Pic16_Save() and Pic16_Load() keep raw 16bit pgm data in native byte
+    order instead of the big endian of the format, like older versions did.
+    only the default: it is read once per call, Pic16_SaveOrder(),
+    Pic16_LoadOrder() and tPicFile.Native choose per file
+*/
+extern bool	g_Pic16Native;
+
 
 /*****************************************************************************
  *  exported functions
@@ -155,10 +207,22 @@ void Yc420_Malloc(tYc *pThat, int dx, int dy);
 void Yc_Free(tYc *pThat);
 bool Yc_Load(tYc *pThat, const char *Name);
 void Yc_Import(tYc *pThat, tYuv *pSrc);
+void Yc_FromYuv(tYc *pThat, const tYuv *pSrc, bool Vu);
+void Yuv_FromYc(tYuv *pThat, const tYc *pSrc, bool Vu);
+void Yc_SwapUv(tYc *pThat);
+void Pic16_YuyvFromYuv(tPic *pThat, const tYuv *pSrc, bool Uyvy);
+void Yuv_FromYuyv(tYuv *pThat, const tPic *pSrc, bool Uyvy);
+void Pic32_RGBXfromYuv(tPic *pThat, const tYuv *pSrc, int Mode);
+void Pic32_BGRXfromYuv(tPic *pThat, const tYuv *pSrc, int Mode);
+void Pic16_RGB565fromYuv(tPic *pThat, const tYuv *pSrc, int Mode);
+void Pic32_RGBXfromYc(tPic *pThat, const tYc *pSrc, int Mode, bool Vu);
+void Pic32_BGRXfromYc(tPic *pThat, const tYc *pSrc, int Mode, bool Vu);
+void Pic16_RGB565fromYc(tPic *pThat, const tYc *pSrc, int Mode, bool Vu);
 
 bool Pic8_Save(const tPic *pThat, const char *Name);
 bool Pic8_SaveA(const tPic *pThat, const char *Name);
 bool Pic16_Save(const tPic *pThat, const char *Name);
+bool Pic16_SaveOrder(const tPic *pThat, const char *Name, bool Native);
 bool Pic16_SaveA(const tPic *pThat, const char *Name);
 bool Pic32_Save(const tPic *pThat, const char *Name);
 bool Pic32_SaveA(const tPic *pThat, const char *Name);
@@ -167,23 +231,50 @@ bool Pic32_SaveRGBX(const tPic *pThat, const char *Name);
 bool Pic32_SaveXRGB(const tPic *pThat, const char *Name);
 bool Pic32_SaveBGRX(const tPic *pThat, const char *Name);
 bool Pic32_SaveRgbA(const tPic *pThat, const char *Name);
+bool Pic8_SaveNqi(const tPic *pThat, const char *Name);
+bool Pic16_SaveNqi(const tPic *pThat, const char *Name);
+bool Pic32_SaveNqi(const tPic *pThat, const char *Name);
 
 bool Pic8_Load(tPic *pThat, const char *Name);
 bool Pic8_LoadAln(tPic *pThat, const char *Name, int Aln);
 
 bool Pic16_Load(tPic *pThat, const char *Name);
 bool Pic16_LoadAln(tPic *pThat, const char *Name, int Aln);
+bool Pic16_LoadOrder(tPic *pThat, const char *Name, int Aln, bool Native);
 bool Pic16_LoadShl(tPic *pThat, const char *Name, int Shift);
 bool Pic16_UniLoad(tPic *pThat, const char *Name);
 
 bool Pic32_Load(tPic *pThat, const char *Name);
 bool Pic32_LoadXRGB(tPic *pThat, const char *Name);
 bool Pic32_LoadRGBX(tPic *pThat, const char *Name);
+bool Pic8_LoadNqi(tPic *pThat, const char *Name);
+bool Pic16_LoadNqi(tPic *pThat, const char *Name);
+bool Pic32_LoadNqi(tPic *pThat, const char *Name);
 
 int  Pic_FileType(const char *Name);
 
+bool Pic_Open(tPicFile *pThat, const char *Name);
+bool Pic_ReadInto(tPicFile *pThat, tPic *pPic, int Bpp, int Shift);
+void Pic_Close(tPicFile *pThat);
+bool Pic_ParseHeader(tPicFile *pThat, const void *pBuf, int N,
+		     const char *Name);
+void Pic_ReadRaw(tPicFile *pThat, tPic *pPic, const void *pPels, int Bpp,
+		 int Shift);
+bool Pic_ReadRoi(tPicFile *pThat, tPic *pPic, int x, int y, int dx, int dy,
+		 int Bpp, int Shift);
+bool Yuv_LoadRoi(tYuv *pThat, const char *Name, int Dx, int Dy, int x, int y,
+		 int Threads);
+
+void PicPool_Get(tPicPool *pThat, tPic *pPic, int dx, int dy, int Bpp);
+void PicPool_Put(tPicPool *pThat, tPic *pPic);
+void PicPool_Free(tPicPool *pThat);
+
 void Pic_HorFlip(tPic *pPic);
 
+void Pic_Random(tPic *pThat, int Bpp, u32 Seed);
+u64  Pic_Hash(const tPic *pThat, int Bpp);
+int  Pic_Diff(const tPic *pA, const tPic *pB, int Bpp, int *pX, int *pY);
+
 void Pic16_DrawRect(tPic *pThat, int x, int y, int color);
 void Pic16_DrawLine(tPic *pThat, int ax, int ay,  int bx, int by, unsigned int color);
 void Pic16_DrawCross(tPic *pThat, int x, int y, int color);
@@ -0,0 +1,138 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  templates for pic functions that exist for several pel sizes. included
+ *  as function body with PEL defined to the pel type and one of
+ *
+ *	PIC_SET		set all pels to val
+ *	PIC_SHIFTL	shift all pels left by Shift, clip to PEL_MAX
+ *	PIC_DRAWLINE	line from (ax,ay) to (bx,by) in color
+ *
+ *  or with PEL_BYTES defined to the bytes per pel, for pels without a type
+ *  such as RGB, and
+ *
+ *	PIC_COPY	copy the pels of pSrc to pThat
+ *
+ *  the pels are accessed through a PEL pointer per line, so the compiler
+ *  sees the type and can vectorize the inner loops.
+ *
+ *  \file      pic_tpl.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#ifdef PIC_COPY
+{
+    u8    *pd,*ps;
+    int   y;
+    METRIC_FUNC;
+
+    MUST_Ge(pThat->Dx,pSrc->Dx);
+    MUST_Ge(pThat->Dy,pSrc->Dy);
+
+    pd=pThat->Pel;
+    ps=pSrc->Pel;
+    for(y=0;y<pSrc->Dy;y++){
+	memcpy(pd,ps,(size_t)pSrc->Dx*PEL_BYTES);
+	pd+=pThat->S;
+	ps+=pSrc->S;
+    }
+}
+#endif /* PIC_COPY */
+
+
+#ifdef PIC_SET
+{
+    PEL   *pd;
+    int   x,y;
+    METRIC_FUNC;
+
+    pd=(PEL*)pThat->Pel;
+    for(y=0;y<pThat->Dy;y++){
+	for(x=0;x<pThat->Dx;x++)
+	    pd[x]=val;
+	pd=(PEL*)((u8*)pd+pThat->S);
+    }
+}
+#endif /* PIC_SET */
+
+
+#ifdef PIC_SHIFTL
+{
+    PEL   *pd;
+    int   x,y;
+    u32   v;
+    METRIC_FUNC;
+
+    pd=(PEL*)pThat->Pel;
+    for(y=0;y<pThat->Dy;y++){
+	for(x=0;x<pThat->Dx;x++){
+	    v=(u32)pd[x]<<Shift;
+	    pd[x]=MIN(v,PEL_MAX);
+	}
+	pd=(PEL*)((u8*)pd+pThat->S);
+    }
+}
+#endif /* PIC_SHIFTL */
+
+
+#ifdef PIC_DRAWLINE
+{
+    // Bresenham
+    int width = pThat->Dx;
+    int height = pThat->Dy;
+
+    float x, y, initialX, initialY,  pdx, pdy, dx,dy, incx,incy;
+    int xDiscr, yDiscr, n, t;
+
+    if(ax==bx && ay==by)	return;
+
+    dx = (float)(bx - ax);
+    dy = (float)(by - ay);
+
+    incx = (dx >= 0.0) ? 1.0f : -1.0f;
+    incy = (dy >= 0.0) ? 1.0f : -1.0f;
+
+    dx *= incx;
+    dy *= incy;
+
+    if (dx > dy)
+    {
+	pdx = incx;
+	pdy = incy * dy / dx;
+	n = (int)dx;
+    }
+    else
+    {
+	pdx = incx * dx / dy;
+	pdy = incy;
+	n = (int)dy;
+    }
+
+    if (dx > dy)
+    {
+	int discretisedX =  (int)(ax + 0.5);
+	float deltaSubPxX = (float)discretisedX - ax;
+	float deltaSubPxY = deltaSubPxX * incx * incy * dy / dx;
+	initialX = (float)discretisedX;
+	initialY = ay + deltaSubPxY;
+    }
+    else
+    {
+	int discretisedY =  (int)(ay + 0.5);
+	float deltaSubPxY = (float)(discretisedY) - ay;
+	float deltaSubPxX = deltaSubPxY * incy * incx * dx / dy;
+	initialY = (float)discretisedY;
+	initialX = ax + deltaSubPxX;
+    }
+    for (t=0; t <=n; t++)
+    {
+	x = initialX + t * pdx;
+	y = initialY + t * pdy;
+	xDiscr = (int)(x + 0.5);
+	yDiscr = (int)(y + 0.5);
+	if (xDiscr >= 0 && yDiscr >= 0 && xDiscr < width && yDiscr < height)
+	    ((PEL*)(pThat->Pel+yDiscr*pThat->S))[xDiscr]=color;
+    }
+}
+#endif /* PIC_DRAWLINE */
@@ -0,0 +1,607 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  batch loader for pgm/ppm files, see picbatch.h. each file in flight
+ *  has a slot with a buffer that receives the whole file: a first read of
+ *  BLOCK bytes that holds the header, then one for the rest once the size
+ *  is known. the reads go through an io_uring (raw syscalls, no liburing)
+ *  or, if there is none, to reader threads through a tSpsc per thread and
+ *  come back through a tMpsc. the pels are converted and the callback is
+ *  run in the calling thread only, so the tPicPool needs no lock.
+ *
+ *  files are opened synchronously, ascii files are read with stdio once
+ *  their header is seen.
+ *
+ *  \file      picbatch.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"picbatch.h"
+#include	"queue.h"
+#include	"debug.h"
+
+#ifdef UNIX_GNU
+
+#include	<stdlib.h>
+#include	<stdint.h>
+#include	<string.h>
+#include	<errno.h>
+#include	<unistd.h>
+#include	<fcntl.h>
+#include	<pthread.h>
+#include	<sys/uio.h>
+#ifdef LINUX_GNU
+#include	<sys/mman.h>
+#include	<sys/syscall.h>
+#include	<linux/io_uring.h>
+#endif
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define BLOCK		(64*1024)	/* first read of a file */
+#define DEPTH		64		/* default files in flight */
+#define THREADS		4		/* default reader threads */
+
+
+/*****************************************************************************
+ *  local types
+ ****************************************************************************/
+
+/* a file in flight */
+typedef struct {
+  int		Idx;
+  const char	*Name;
+  int		Fd;
+  u8		*pBuf;
+  long		Cap;		/* size of pBuf */
+  long		Len;		/* bytes read */
+  long		Need;		/* size of the file, 0 before the header */
+  bool		Fail;
+  bool		Busy;		/* in the io_uring */
+  tPicFile	Head;
+  struct iovec	Iov;		/* of the read in flight */
+} tSlot;
+
+/* a reader thread */
+typedef struct {
+  pthread_t	Th;
+  tSpsc		Jobs;
+  tMpsc		*pDone;
+} tReader;
+
+#ifdef LINUX_GNU
+/* the mapped rings of an io_uring */
+typedef struct {
+  int		Fd;
+  u32		*pSqHead,*pSqTail,SqMask,*pSqArray;
+  struct io_uring_sqe *pSqe;
+  u32		*pCqHead,*pCqTail,CqMask;
+  struct io_uring_cqe *pCqe;
+  void		*pSqMap,*pCqMap;
+  size_t	SqLen,CqLen,SqeLen;
+  u32		ToSubmit;
+} tUring;
+#endif
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static char		lQuit;		/* job that ends a reader */
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  bytes per pel of a file in memory
+ */
+static int PelBytes(const tPicFile *pHead, int Bpp)
+{
+  if(Bpp)
+    return Bpp;
+  return pHead->Type==PIC_G8?1:pHead->Type==PIC_G16?2:4;
+}
+
+
+/****************************************************************************/
+/*  prepare a slot for a file
+ *
+ *  \return bytes of the first read
+ */
+static long Start(tSlot *pSlot, int Idx, const char *Name)
+{
+  pSlot->Idx=Idx;
+  pSlot->Name=Name;
+  pSlot->Len=0;
+  pSlot->Need=0;
+  pSlot->Fail=FALSE;
+  memset(&pSlot->Head,0,sizeof(pSlot->Head));
+  pSlot->Head.Name=Name;
+  pSlot->Head.Type=PIC_NONE;
+  if(pSlot->Cap<BLOCK){
+    free(pSlot->pBuf);
+    pSlot->Cap=BLOCK;
+    pSlot->pBuf=malloc(pSlot->Cap);  MUST(pSlot->pBuf);
+  }
+  if((pSlot->Fd=open(Name,O_RDONLY))<0){
+    pSlot->Fail=TRUE;
+    return 0;
+  }
+
+  return BLOCK;
+}
+
+
+/****************************************************************************/
+/*  account a read of Got bytes at pBuf+Len, parse the header as soon as it
+ *  is there and grow the buffer to the file
+ *
+ *  \return bytes of the next read at pBuf+Len, 0 if done (or failed)
+ */
+static long Next(tSlot *pSlot, long Got)
+{
+  tPicFile	*ph=&pSlot->Head;
+  int		fbpp;
+
+  if(Got<0){
+    pSlot->Fail=TRUE;
+    return 0;
+  }
+  pSlot->Len+=Got;
+
+  if(!pSlot->Need){
+    if(!Pic_ParseHeader(ph,pSlot->pBuf,pSlot->Len,pSlot->Name)){
+      if(Got==0 || pSlot->Len>=BLOCK){
+	pSlot->Fail=TRUE;
+	return 0;
+      }
+      return BLOCK-pSlot->Len;
+    }
+    if(!ph->Raw)
+      return 0;
+    fbpp=ph->Type==PIC_G8?1:ph->Type==PIC_G16?2:ph->Type==PIC_XRGB?3:4;
+    pSlot->Need=ph->Offset+(long)ph->Dx*ph->Dy*fbpp;
+    if(pSlot->Cap<pSlot->Need){
+      pSlot->Cap=pSlot->Need;
+      pSlot->pBuf=realloc(pSlot->pBuf,pSlot->Cap);  MUST(pSlot->pBuf);
+    }
+  }
+
+  if(pSlot->Len>=pSlot->Need)
+    return 0;
+  if(Got==0){
+    WARN("%s is truncated",pSlot->Name);
+    pSlot->Fail=TRUE;
+    return 0;
+  }
+
+  return pSlot->Need-pSlot->Len;
+}
+
+
+/****************************************************************************/
+/*  close the file of a slot, convert its pels and run the callback
+ *
+ *  \return TRUE if there was a pic
+ */
+static bool Finish(tPicBatch *pThat, tSlot *pSlot, int Bpp, int Shift,
+		   tPicBatchDone Done, void *pArg)
+{
+  tPicFile	*ph=&pSlot->Head;
+  tPic		pic;
+
+  if(pSlot->Fd>=0)
+    close(pSlot->Fd);
+
+  if(pSlot->Fail){
+    Done(pArg,pSlot->Idx,ph,NULL);
+    return FALSE;
+  }
+
+  if(ph->Raw){
+    PicPool_Get(&pThat->Pool,&pic,ph->Dx,ph->Dy,PelBytes(ph,Bpp));
+    Pic_ReadRaw(ph,&pic,pSlot->pBuf+ph->Offset,Bpp,Shift);
+  }
+  else{
+    if(!Pic_Open(ph,pSlot->Name)){
+      Done(pArg,pSlot->Idx,ph,NULL);
+      return FALSE;
+    }
+    PicPool_Get(&pThat->Pool,&pic,ph->Dx,ph->Dy,PelBytes(ph,Bpp));
+    Pic_ReadInto(ph,&pic,Bpp,Shift);
+    Pic_Close(ph);
+  }
+  Done(pArg,pSlot->Idx,ph,&pic);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/*  read a whole file with pread, in a reader thread
+ */
+static void ReadFile(tSlot *pSlot)
+{
+  long		n=BLOCK,got;
+
+  while(n>0){
+    got=pread(pSlot->Fd,pSlot->pBuf+pSlot->Len,n,pSlot->Len);
+    n=Next(pSlot,got);
+  }
+}
+
+
+/****************************************************************************/
+/*  reader thread: read the files of the slots from Jobs, pass them on
+ */
+static void *Reader(void *pArg)
+{
+  tReader	*pr=pArg;
+  tSlot		*ps;
+
+  while((ps=Spsc_PopWait(&pr->Jobs,-1))!=(void*)&lQuit){
+    if(!ps->Fail)
+      ReadFile(ps);
+    Mpsc_PushWait(pr->pDone,ps,-1);
+  }
+
+  return NULL;
+}
+
+
+/****************************************************************************/
+/*  load the files from First on with reader threads
+ *
+ *  \return number of files that were loaded
+ */
+static int LoadThreads(tPicBatch *pThat, tSlot *pSlot, int NSlot,
+		       const char * const *ppNames, int First, int N, int Bpp,
+		       int Shift, tPicBatchDone Done, void *pArg)
+{
+  tReader	*pr;
+  tMpsc		done;
+  tSlot		*ps;
+  int		i,nt=MAX(pThat->Threads,1),next=First,busy=0,ok=0;
+
+  Mpsc_Init(&done,NSlot);
+  pr=calloc(nt,sizeof(tReader));  MUST(pr);
+  for(i=0;i<nt;i++){
+    Spsc_Init(&pr[i].Jobs,NSlot+1);
+    pr[i].pDone=&done;
+    if(pthread_create(&pr[i].Th,NULL,Reader,&pr[i]))
+      ERROR("cannot create thread");
+  }
+
+  for(i=0;i<NSlot && next<N;i++,next++,busy++){
+    Start(&pSlot[i],next,ppNames[next]);
+    Spsc_PushWait(&pr[next%nt].Jobs,&pSlot[i],-1);
+  }
+  while(busy){
+    ps=Mpsc_PopWait(&done,-1);
+    ok+=Finish(pThat,ps,Bpp,Shift,Done,pArg);
+    busy--;
+    if(next<N){
+      Start(ps,next,ppNames[next]);
+      Spsc_PushWait(&pr[next%nt].Jobs,ps,-1);
+      next++;
+      busy++;
+    }
+  }
+
+  for(i=0;i<nt;i++){
+    Spsc_PushWait(&pr[i].Jobs,&lQuit,-1);
+    pthread_join(pr[i].Th,NULL);
+    Spsc_Free(&pr[i].Jobs);
+  }
+  free(pr);
+  Mpsc_Free(&done);
+
+  return ok;
+}
+
+
+#ifdef LINUX_GNU
+/****************************************************************************/
+/*  set up an io_uring with Entries submission entries
+ *
+ *  \return FALSE if the kernel does not let us have one
+ */
+static bool UringInit(tUring *pThat, int Entries)
+{
+  struct io_uring_params p;
+  u8		*sq,*cq;
+
+  memset(pThat,0,sizeof(*pThat));
+  memset(&p,0,sizeof(p));
+  if((pThat->Fd=syscall(__NR_io_uring_setup,Entries,&p))<0)
+    return FALSE;
+
+  pThat->SqLen=p.sq_off.array+p.sq_entries*sizeof(u32);
+  pThat->CqLen=p.cq_off.cqes+p.cq_entries*sizeof(struct io_uring_cqe);
+  if(p.features&IORING_FEAT_SINGLE_MMAP)
+    pThat->SqLen=pThat->CqLen=MAX(pThat->SqLen,pThat->CqLen);
+  pThat->SqeLen=p.sq_entries*sizeof(struct io_uring_sqe);
+
+  pThat->pSqMap=mmap(NULL,pThat->SqLen,PROT_READ|PROT_WRITE,
+		     MAP_SHARED|MAP_POPULATE,pThat->Fd,IORING_OFF_SQ_RING);
+  if(pThat->pSqMap==MAP_FAILED){
+    close(pThat->Fd);
+    return FALSE;
+  }
+  if(p.features&IORING_FEAT_SINGLE_MMAP)
+    pThat->pCqMap=pThat->pSqMap;
+  else{
+    pThat->pCqMap=mmap(NULL,pThat->CqLen,PROT_READ|PROT_WRITE,
+		       MAP_SHARED|MAP_POPULATE,pThat->Fd,IORING_OFF_CQ_RING);
+    if(pThat->pCqMap==MAP_FAILED){
+      munmap(pThat->pSqMap,pThat->SqLen);
+      close(pThat->Fd);
+      return FALSE;
+    }
+  }
+  pThat->pSqe=mmap(NULL,pThat->SqeLen,PROT_READ|PROT_WRITE,
+		   MAP_SHARED|MAP_POPULATE,pThat->Fd,IORING_OFF_SQES);
+  if(pThat->pSqe==MAP_FAILED){
+    if(pThat->pCqMap!=pThat->pSqMap)
+      munmap(pThat->pCqMap,pThat->CqLen);
+    munmap(pThat->pSqMap,pThat->SqLen);
+    close(pThat->Fd);
+    return FALSE;
+  }
+
+  sq=pThat->pSqMap;
+  pThat->pSqHead=(u32*)(sq+p.sq_off.head);
+  pThat->pSqTail=(u32*)(sq+p.sq_off.tail);
+  pThat->SqMask=*(u32*)(sq+p.sq_off.ring_mask);
+  pThat->pSqArray=(u32*)(sq+p.sq_off.array);
+  cq=pThat->pCqMap;
+  pThat->pCqHead=(u32*)(cq+p.cq_off.head);
+  pThat->pCqTail=(u32*)(cq+p.cq_off.tail);
+  pThat->CqMask=*(u32*)(cq+p.cq_off.ring_mask);
+  pThat->pCqe=(struct io_uring_cqe*)(cq+p.cq_off.cqes);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/*  unmap and close an io_uring
+ */
+static void UringFree(tUring *pThat)
+{
+  munmap(pThat->pSqe,pThat->SqeLen);
+  if(pThat->pCqMap!=pThat->pSqMap)
+    munmap(pThat->pCqMap,pThat->CqLen);
+  munmap(pThat->pSqMap,pThat->SqLen);
+  close(pThat->Fd);
+}
+
+
+/****************************************************************************/
+/*  queue a read of N bytes into the buffer of a slot, at its Len
+ */
+static void UringRead(tUring *pThat, tSlot *pSlot, long N)
+{
+  u32			t=*pThat->pSqTail,i=t&pThat->SqMask;
+  struct io_uring_sqe	*pe=&pThat->pSqe[i];
+
+  pSlot->Iov.iov_base=pSlot->pBuf+pSlot->Len;
+  pSlot->Iov.iov_len=N;
+
+  memset(pe,0,sizeof(*pe));
+  pe->opcode=IORING_OP_READV;
+  pe->fd=pSlot->Fd;
+  pe->addr=(u64)(uintptr_t)&pSlot->Iov;
+  pe->len=1;
+  pe->off=pSlot->Len;
+  pe->user_data=(u64)(uintptr_t)pSlot;
+  pThat->pSqArray[i]=i;
+  __atomic_store_n(pThat->pSqTail,t+1,__ATOMIC_RELEASE);
+  pThat->ToSubmit++;
+}
+
+
+/****************************************************************************/
+/*  submit the queued reads and wait for Wait completions, again if a signal
+ *  comes in between
+ *
+ *  \return FALSE if io_uring_enter failed
+ */
+static bool UringEnter(tUring *pThat, u32 Wait)
+{
+  int			r;
+
+  do
+    r=syscall(__NR_io_uring_enter,pThat->Fd,pThat->ToSubmit,Wait,
+	      Wait?IORING_ENTER_GETEVENTS:0,NULL,0);
+  while(r<0 && (errno==EINTR || errno==EAGAIN));
+  if(r<0)
+    return FALSE;
+  pThat->ToSubmit-=MIN((u32)r,pThat->ToSubmit);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/*  submit the queued reads and wait for a completion
+ *
+ *  \return the slot of the completion, *pRes the result of the read, NULL
+ *	    if io_uring_enter failed
+ */
+static tSlot *UringWait(tUring *pThat, long *pRes)
+{
+  struct io_uring_cqe	*pc;
+  tSlot			*ps;
+  u32			h;
+
+  if(pThat->ToSubmit && !UringEnter(pThat,0))
+    return NULL;
+  for(;;){
+    h=*pThat->pCqHead;
+    if(h!=__atomic_load_n(pThat->pCqTail,__ATOMIC_ACQUIRE))
+      break;
+    if(!UringEnter(pThat,1))
+      return NULL;
+  }
+
+  pc=&pThat->pCqe[h&pThat->CqMask];
+  ps=(tSlot*)(uintptr_t)pc->user_data;
+  *pRes=pc->res;
+  __atomic_store_n(pThat->pCqHead,h+1,__ATOMIC_RELEASE);
+
+  return ps;
+}
+
+
+/****************************************************************************/
+/*  load with an io_uring. if io_uring_enter fails, the files in flight are
+ *  read again with pread and the rest is left to the reader threads
+ *
+ *  \return number of files that were loaded, *pNext the number of files
+ *	    that were taken, 0 if there is no io_uring
+ */
+static int LoadUring(tPicBatch *pThat, tSlot *pSlot, int NSlot,
+		     const char * const *ppNames, int N, int Bpp, int Shift,
+		     tPicBatchDone Done, void *pArg, int *pNext)
+{
+  tUring	u;
+  tSlot		*ps,**ppFree;
+  long		n,res;
+  int		i,nfree=0,next=0,busy=0,ok=0;
+
+  *pNext=0;
+  if(!UringInit(&u,NSlot))
+    return 0;
+
+  ppFree=calloc(NSlot,sizeof(tSlot*));  MUST(ppFree);
+  for(nfree=0;nfree<NSlot;nfree++)
+    ppFree[nfree]=&pSlot[nfree];
+
+  while(next<N || busy){
+    /* fill the free slots, failed opens complete at once */
+    while(nfree && next<N){
+      ps=ppFree[--nfree];
+      if((n=Start(ps,next,ppNames[next]))>0){
+	UringRead(&u,ps,n);
+	ps->Busy=TRUE;
+	busy++;
+      }
+      else{
+	ok+=Finish(pThat,ps,Bpp,Shift,Done,pArg);
+	ppFree[nfree++]=ps;
+      }
+      next++;
+    }
+    if(!busy)
+      continue;
+
+    if(!(ps=UringWait(&u,&res)))
+      break;
+    if((n=Next(ps,res))>0)
+      UringRead(&u,ps,n);
+    else{
+      ok+=Finish(pThat,ps,Bpp,Shift,Done,pArg);
+      ps->Busy=FALSE;
+      ppFree[nfree++]=ps;
+      busy--;
+    }
+  }
+  UringFree(&u);
+
+  if(busy){
+    WARN("io_uring_enter failed, using threads");
+    for(i=0;i<NSlot;i++){
+      ps=&pSlot[i];
+      if(!ps->Busy)
+	continue;
+      /* a read may still land in the old buffer, leave it to the kernel */
+      close(ps->Fd);
+      ps->pBuf=NULL;
+      ps->Cap=0;
+      if(Start(ps,ps->Idx,ps->Name)>0)
+	ReadFile(ps);
+      ok+=Finish(pThat,ps,Bpp,Shift,Done,pArg);
+      ps->Busy=FALSE;
+    }
+  }
+  free(ppFree);
+  *pNext=next;
+
+  return ok;
+}
+#endif /* LINUX_GNU */
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/** initialize a batch loader with the default settings
+ *
+ *  \param  pThat the loader
+ */
+void PicBatch_Init(tPicBatch *pThat)
+{
+  memset(pThat,0,sizeof(*pThat));
+  pThat->Depth=DEPTH;
+  pThat->Threads=THREADS;
+}
+
+
+/****************************************************************************/
+/** load a list of pgm/ppm files. returns after the callback has been run
+ *  for each of them
+ *
+ *  \param  pThat   the loader
+ *  \param  ppNames filenames
+ *  \param  N       number of files
+ *  \param  Bpp     bytes per pel of the pics, 0 for the natural size, see
+ *		    Pic_ReadInto()
+ *  \param  Shift   for 16bit pels
+ *  \param  Done    called with each pic in the calling thread
+ *  \param  pArg    for Done
+ *  \return number of files that were loaded
+ */
+int PicBatch_Load(tPicBatch *pThat, const char * const *ppNames, int N,
+		  int Bpp, int Shift, tPicBatchDone Done, void *pArg)
+{
+  tSlot		*ps;
+  int		i,ns=MIN(MAX(pThat->Depth,1),MAX(N,1)),ok=0,next=0;
+
+  ps=calloc(ns,sizeof(tSlot));  MUST(ps);
+
+#ifdef LINUX_GNU
+  if(!pThat->NoUring)
+    ok=LoadUring(pThat,ps,ns,ppNames,N,Bpp,Shift,Done,pArg,&next);
+#endif
+  if(next<N)
+    ok+=LoadThreads(pThat,ps,ns,ppNames,next,N,Bpp,Shift,Done,pArg);
+
+  for(i=0;i<ns;i++)
+    free(ps[i].pBuf);
+  free(ps);
+
+  return ok;
+}
+
+
+/****************************************************************************/
+/** free the buffers of a batch loader
+ *
+ *  \param  pThat the loader
+ */
+void PicBatch_Free(tPicBatch *pThat)
+{
+  PicPool_Free(&pThat->Pool);
+}
+
+#endif /* UNIX_GNU */
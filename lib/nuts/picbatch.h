@@ -0,0 +1,65 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  load many small pgm/ppm files with many reads in flight: io_uring if
+ *  the kernel has it, else a few threads with pread(). the header of a
+ *  file is parsed from its first block, the pels land in pics from a
+ *  tPicPool and are handed to a callback in the calling thread:
+ *
+ *	static void Done(void *pArg, int Idx, tPicFile *pHead, tPic *pPic)
+ *	{
+ *	  if(pPic){
+ *	    ... use pPic ...
+ *	    PicPool_Put(&((tPicBatch*)pArg)->Pool,pPic);
+ *	  }
+ *	}
+ *
+ *	PicBatch_Init(&b);
+ *	PicBatch_Load(&b,names,n,0,0,Done,&b);
+ *	PicBatch_Free(&b);
+ *
+ *  \file      picbatch.h
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#ifndef PICBATCH_H
+#define PICBATCH_H
+
+#include	"pic.h"
+
+
+/*****************************************************************************
+ *  types
+ ****************************************************************************/
+
+/** called for each file, in the order of completion. pPic is NULL if the
+ *  file could not be read, else it belongs to the callee
+ */
+typedef void (*tPicBatchDone)(void *pArg, int Idx, tPicFile *pHead,
+			      tPic *pPic);
+
+/** settings and buffers of a batch loader
+ */
+typedef struct {
+  int		Depth;		/**< files in flight */
+  int		Threads;	/**< reader threads without io_uring */
+  bool		NoUring;	/**< use the threads even with io_uring */
+  tPicPool	Pool;		/**< buffers of the loaded pics */
+} tPicBatch;
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+EXTERN_C_BEGIN
+
+void PicBatch_Init(tPicBatch *pThat);
+int  PicBatch_Load(tPicBatch *pThat, const char * const *ppNames, int N,
+		   int Bpp, int Shift, tPicBatchDone Done, void *pArg);
+void PicBatch_Free(tPicBatch *pThat);
+
+EXTERN_C_END
+
+#endif /* PICBATCH_H */
@@ -0,0 +1,342 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  pic sequence files, see picseq.h. the layout, all little endian:
+ *
+ *	"NQS1" bpp 0 0 0 dx:32 dy:32		header, 16 bytes
+ *	bytes:32 key:8 0 0 0 lines		each frame
+ *	(offset<<1|key):64 ...			index, one per frame
+ *	index:64 frames:32 "NQSX"		trailer, 16 bytes
+ *
+ *  the lines of a frame are coded back to back, the decoder knows where
+ *  a line ends. a file without trailer (the writer died) is read by
+ *  walking over the frame headers.
+ *
+ *  \file      picseq.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"picseq.h"
+#include	"debug.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define HEAD		16		/* bytes of the file header */
+#define FHEAD		8		/* of a frame header */
+#define TRAIL		16		/* of the trailer */
+
+#define PUT32(p,v)	((p)[0]=(v),(p)[1]=(v)>>8,(p)[2]=(v)>>16,(p)[3]=(v)>>24)
+#define GET32(p)	((u32)(p)[0]|(u32)(p)[1]<<8|(u32)(p)[2]<<16|\
+			 (u32)(p)[3]<<24)
+#define PUT64(p,v)	(PUT32(p,(u32)(v)),PUT32((p)+4,(u32)((v)>>32)))
+#define GET64(p)	((u64)GET32(p)|(u64)GET32((p)+4)<<32)
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  the line coder, the frame buffer and Prev for a size known by now
+ */
+static void Setup(tPicSeq *pThat)
+{
+  Nqi_Init(&pThat->Nqi,pThat->Dx,pThat->Bpp);
+  pThat->pBuf=malloc((size_t)Nqi_Bound(&pThat->Nqi)*pThat->Dy);
+  MUST(pThat->pBuf);
+  pThat->Prev.S=PAD(pThat->Dx*pThat->Bpp,sizeof(int));
+  pThat->Prev.Pel=calloc((size_t)pThat->Prev.S*pThat->Dy,1);
+  MUST(pThat->Prev.Pel);
+  pThat->Prev.Dx=pThat->Dx;
+  pThat->Prev.Dy=pThat->Dy;
+  pThat->Cur=-1;
+}
+
+
+/****************************************************************************/
+/*  append a frame to the index
+ */
+static void AddIdx(tPicSeq *pThat, long Offset, bool Key)
+{
+  if(pThat->N==pThat->Max){
+    pThat->Max=pThat->Max?2*pThat->Max:256;
+    pThat->pIdx=realloc(pThat->pIdx,pThat->Max*sizeof(u64));
+    MUST(pThat->pIdx);
+  }
+  pThat->pIdx[pThat->N++]=(u64)Offset<<1|Key;
+}
+
+
+/****************************************************************************/
+/*  read the index from the trailer, FALSE if there is none
+ */
+static bool ReadIdx(tPicSeq *pThat)
+{
+  FILE		*file=pThat->pFile;
+  u8		t[TRAIL],e[8];
+  long		end,idx;
+  int		i,n;
+
+  if(fseek(file,0,SEEK_END)!=0 || (end=ftell(file))<HEAD+TRAIL ||
+     fseek(file,end-TRAIL,SEEK_SET)!=0 || fread(t,TRAIL,1,file)!=1 ||
+     memcmp(t+12,"NQSX",4)!=0)
+    return FALSE;
+  idx=GET64(t);
+  n=GET32(t+8);
+  if(idx<HEAD || idx+8L*n!=end-TRAIL || fseek(file,idx,SEEK_SET)!=0)
+    return FALSE;
+  for(i=0;i<n;i++){
+    if(fread(e,8,1,file)!=1)
+      return FALSE;
+    AddIdx(pThat,GET64(e)>>1,GET64(e)&1);
+  }
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/*  build the index from the frame headers, for files without trailer
+ */
+static void ScanIdx(tPicSeq *pThat)
+{
+  FILE		*file=pThat->pFile;
+  u8		h[FHEAD];
+  long		off=HEAD;
+
+  pThat->N=0;
+  while(fseek(file,off,SEEK_SET)==0 && fread(h,FHEAD,1,file)==1 &&
+	h[4]<=1 && fseek(file,GET32(h),SEEK_CUR)==0){
+    AddIdx(pThat,off,h[4]);
+    off+=FHEAD+GET32(h);
+  }
+  /* the last frame may be cut off */
+  if(pThat->N && fseek(file,0,SEEK_END)==0 && ftell(file)<off)
+    pThat->N--;
+  WARN("%s has no index, found %d frames",pThat->Name,pThat->N);
+}
+
+
+/****************************************************************************/
+/*  read frame Idx and decode it into Prev, which holds frame Idx-1 unless
+ *  Idx is a key frame
+ */
+static void Decode(tPicSeq *pThat, int Idx)
+{
+  FILE		*file=pThat->pFile;
+  u8		h[FHEAD],*pp=pThat->Prev.Pel,*ps=pThat->pBuf;
+  long		len;
+  int		y,n,s=pThat->Prev.S;
+  bool		key=pThat->pIdx[Idx]&1;
+
+  if(fseek(file,pThat->pIdx[Idx]>>1,SEEK_SET)!=0 ||
+     fread(h,FHEAD,1,file)!=1 ||
+     (len=GET32(h))>(long)Nqi_Bound(&pThat->Nqi)*pThat->Dy ||
+     fread(ps,len,1,file)!=1)
+    ERROR("read error in %s frame %d",pThat->Name,Idx);
+
+  for(y=0;y<pThat->Dy;y++,pp+=s,ps+=n,len-=n){
+    n=key?Nqi_DecodeRow(&pThat->Nqi,pp,y?pp-s:NULL,ps,len):
+      Nqi_DecodeDelta(&pThat->Nqi,pp,pp,ps,len);
+    if(n<0)
+      ERROR("corrupt frame %d in %s",Idx,pThat->Name);
+  }
+  pThat->Cur=Idx;
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/** create a sequence file
+ *
+ *  \param  pThat  the sequence
+ *  \param  Name   filename, not copied
+ *  \param  Dx     width of all frames
+ *  \param  Dy     height
+ *  \param  Bpp    1, 2 or 4 bytes per pel (Pic8, Pic16, Pic32 as XRGB)
+ *  \param  KeyInt a key frame every KeyInt frames, 1 for key frames only
+ *  \return success (always TRUE at the moment)
+ */
+bool PicSeq_Create(tPicSeq *pThat, const char *Name, int Dx, int Dy, int Bpp,
+		   int KeyInt)
+{
+  u8		h[HEAD];
+
+  ;   MUST(Bpp==1 || Bpp==2 || Bpp==4);  MUST(KeyInt>0);
+  ;   MUST_In(Dx,1,1<<16);  MUST_In(Dy,1,1<<16);
+
+  memset(pThat,0,sizeof(*pThat));
+  pThat->Name=Name;
+  pThat->Write=TRUE;
+  pThat->Dx=Dx;
+  pThat->Dy=Dy;
+  pThat->Bpp=Bpp;
+  pThat->KeyInt=KeyInt;
+  if(!(pThat->pFile=fopen(Name,"w"))) ERROR("cannot create: %s",Name);
+  Setup(pThat);
+
+  memset(h,0,sizeof(h));
+  memcpy(h,"NQS1",4);
+  h[4]=Bpp;
+  PUT32(h+8,(u32)Dx);
+  PUT32(h+12,(u32)Dy);
+  if(fwrite(h,HEAD,1,pThat->pFile)!=1) ERROR("writing: %s",Name);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** append a frame
+ *
+ *  \param  pThat the sequence
+ *  \param  pPic  the frame, of the size and pel type of the sequence
+ */
+void PicSeq_Put(tPicSeq *pThat, const tPic *pPic)
+{
+  FILE		*file=pThat->pFile;
+  u8		h[FHEAD],*pd=pThat->pBuf,*pp=pThat->Prev.Pel;
+  const u8	*ps=pPic->Pel;
+  int		y,s=pThat->Prev.S;
+  bool		key=pThat->N%pThat->KeyInt==0;
+  long		off;
+
+  ;   MUST(pThat->Write);
+  ;   MUST(pPic->Dx==pThat->Dx && pPic->Dy==pThat->Dy);
+
+  for(y=0;y<pThat->Dy;y++,ps+=pPic->S,pp+=s){
+    pd+=key?Nqi_EncodeRow(&pThat->Nqi,pd,ps,y?ps-pPic->S:NULL):
+      Nqi_EncodeDelta(&pThat->Nqi,pd,ps,pp);
+    memcpy(pp,ps,pThat->Dx*pThat->Bpp);
+  }
+
+  off=ftell(file);
+  memset(h,0,sizeof(h));
+  PUT32(h,(u32)(pd-pThat->pBuf));
+  h[4]=key;
+  if(fwrite(h,FHEAD,1,file)!=1 ||
+     fwrite(pThat->pBuf,pd-pThat->pBuf,1,file)!=1)
+    ERROR("writing: %s",pThat->Name);
+  AddIdx(pThat,off,key);
+}
+
+
+/****************************************************************************/
+/** open a sequence file for reading
+ *
+ *  \param  pThat the sequence, N is the number of frames
+ *  \param  Name  filename, not copied
+ *  \return FALSE if the file cannot be opened
+ */
+bool PicSeq_Open(tPicSeq *pThat, const char *Name)
+{
+  FILE		*file;
+  u8		h[HEAD];
+
+  memset(pThat,0,sizeof(*pThat));
+  pThat->Name=Name;
+  if(!(file=fopen(Name,"r")))
+    return FALSE;
+  pThat->pFile=file;
+
+  if(fread(h,HEAD,1,file)!=1 || memcmp(h,"NQS1",4)!=0)
+    ERROR("sequence header not found in %s",Name);
+  pThat->Bpp=h[4];
+  pThat->Dx=GET32(h+8);
+  pThat->Dy=GET32(h+12);
+  if(!(pThat->Bpp==1 || pThat->Bpp==2 || pThat->Bpp==4) ||
+     pThat->Dx<1 || pThat->Dx>1<<16 || pThat->Dy<1 || pThat->Dy>1<<16)
+    ERROR("unsupported sequence in %s",Name);
+  Setup(pThat);
+
+  if(!ReadIdx(pThat))
+    ScanIdx(pThat);
+  ;   DLOGd(pThat->N); DLOGd(pThat->Dx); DLOGd(pThat->Dy);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** read a frame. goes on from the frame read last if that is on the way,
+ *  else decodes from the key frame before Idx
+ *
+ *  \param  pThat the sequence
+ *  \param  pPic  the frame. if Pel is NULL it is allocated, else it must
+ *		  have room for the frame
+ *  \param  Idx   0..N-1
+ *  \return FALSE if there is no such frame
+ */
+bool PicSeq_Get(tPicSeq *pThat, tPic *pPic, int Idx)
+{
+  int		i,k,y,n=pThat->Dx*pThat->Bpp;
+
+  ;   MUST(!pThat->Write);
+
+  if(Idx<0 || Idx>=pThat->N)
+    return FALSE;
+
+  for(k=Idx;!(pThat->pIdx[k]&1);k--)
+    if(k==0)
+      ERROR("no key frame before frame %d in %s",Idx,pThat->Name);
+  for(i=pThat->Cur>=k && pThat->Cur<=Idx?pThat->Cur+1:k;i<=Idx;i++)
+    Decode(pThat,i);
+
+  if(!pPic->Pel){
+    pPic->S=PAD(n,sizeof(int));
+    pPic->Pel=calloc((size_t)pPic->S*pThat->Dy,1);  MUST(pPic->Pel);
+  }
+  else
+    MUST_Ge(pPic->S,n);
+  pPic->Dx=pThat->Dx;
+  pPic->Dy=pThat->Dy;
+  for(y=0;y<pThat->Dy;y++)
+    memcpy(pPic->Pel+(long)y*pPic->S,pThat->Prev.Pel+(long)y*pThat->Prev.S,n);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** write the index if writing, close the file and free all
+ *
+ *  \param  pThat the sequence
+ */
+void PicSeq_Close(tPicSeq *pThat)
+{
+  FILE		*file=pThat->pFile;
+  u8		e[TRAIL];
+  long		idx;
+  int		i;
+
+  if(!file)
+    return;
+  if(pThat->Write){
+    idx=ftell(file);
+    for(i=0;i<pThat->N;i++){
+      PUT64(e,pThat->pIdx[i]);
+      if(fwrite(e,8,1,file)!=1) ERROR("writing: %s",pThat->Name);
+    }
+    PUT64(e,(u64)idx);
+    PUT32(e+8,(u32)pThat->N);
+    memcpy(e+12,"NQSX",4);
+    if(fwrite(e,TRAIL,1,file)!=1) ERROR("writing: %s",pThat->Name);
+  }
+  fclose(file);
+
+  Nqi_Free(&pThat->Nqi);
+  free(pThat->pBuf);
+  free(pThat->Prev.Pel);
+  free(pThat->pIdx);
+  memset(pThat,0,sizeof(*pThat));
+}
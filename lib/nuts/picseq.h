@@ -0,0 +1,71 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  sequences of pics of one size in a single file, e.g. all frames of a
+ *  processing run. every KeyInt-th frame is a key frame, coded like a nqi
+ *  file, the others only code their difference to the frame before (see
+ *  Nqi_EncodeDelta()), so frames that hardly change take a few bytes per
+ *  line. an index of all frames at the end of the file lets the reader
+ *  seek: it decodes from the last key frame, or goes on from the frame it
+ *  decoded last.
+ *
+ *	PicSeq_Create(&s,"run.nqs",dx,dy,1,30);
+ *	for(...)
+ *	  PicSeq_Put(&s,&pic);
+ *	PicSeq_Close(&s);
+ *
+ *	PicSeq_Open(&s,"run.nqs");
+ *	PicSeq_Get(&s,&pic,s.N-1);
+ *	PicSeq_Close(&s);
+ *
+ *  \file      picseq.h
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#ifndef PICSEQ_H
+#define PICSEQ_H
+
+#include	"pic.h"
+#include	"nqi.h"
+
+
+/*****************************************************************************
+ *  types
+ ****************************************************************************/
+
+/** a sequence file, for writing or reading
+ */
+typedef struct {
+  void		*pFile;		/**< the FILE */
+  const char	*Name;		/**< filename for messages, not copied */
+  bool		Write;		/**< made by PicSeq_Create() */
+  int		Dx,Dy;
+  int		Bpp;		/**< 1, 2 or 4 (XRGB) */
+  int		KeyInt;		/**< frames from key frame to key frame */
+  int		N;		/**< frames */
+  int		Max;		/**< entries of pIdx */
+  u64		*pIdx;		/**< offset<<1|key of each frame */
+  tNqi		Nqi;		/**< the line coder */
+  u8		*pBuf;		/**< a coded frame */
+  int		Cur;		/**< frame in Prev, -1 for none */
+  tPic		Prev;		/**< last frame written or decoded */
+} tPicSeq;
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+EXTERN_C_BEGIN
+
+bool PicSeq_Create(tPicSeq *pThat, const char *Name, int Dx, int Dy, int Bpp,
+		   int KeyInt);
+void PicSeq_Put(tPicSeq *pThat, const tPic *pPic);
+bool PicSeq_Open(tPicSeq *pThat, const char *Name);
+bool PicSeq_Get(tPicSeq *pThat, tPic *pPic, int Idx);
+void PicSeq_Close(tPicSeq *pThat);
+
+EXTERN_C_END
+
+#endif /* PICSEQ_H */
@@ -0,0 +1,550 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  Y4M and raw frame streams, see picstream.h. no stdio: a frame moves
+ *  with one readv()/writev() of an iovec per plane (per line if a plane
+ *  has a padded stride), so the pels are copied once, by the kernel. the
+ *  Y4M header and FRAME lines are read in small pieces, so nothing behind
+ *  them is ever read ahead and PicStream_Copy() can splice() the pels.
+ *  pipes get a buffer of up to PIPE_SIZE, which saves most of the context
+ *  switches between the processes of a pipeline.
+ *
+ *  the reads block: O_NONBLOCK would be set on the open file description,
+ *  which a pipe on stdin shares with the other processes of the shell. if
+ *  the caller made Fd non blocking anyway, the reads poll().
+ *
+ *  \file      picstream.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#define _GNU_SOURCE		/* splice() */
+#include	"picstream.h"
+#include	"debug.h"
+#include	"metric.h"
+
+#ifdef UNIX_GNU
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<ctype.h>
+#include	<errno.h>
+#include	<unistd.h>
+#include	<fcntl.h>
+#include	<poll.h>
+#include	<sys/stat.h>
+#include	<sys/uio.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define PIPE_SIZE	(1024*1024)	/* wanted pipe buffer */
+#define IOVS		256		/* iovecs per readv()/writev(), < IOV_MAX */
+#define LINE		1024		/* max length of a Y4M header */
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  wait until Fd can be read or written, for non blocking fds
+ */
+static void Wait(int Fd, bool Write)
+{
+  struct pollfd	p;
+
+  p.fd=Fd;
+  p.events=Write?POLLOUT:POLLIN;
+  poll(&p,1,-1);
+}
+
+
+/****************************************************************************/
+/*  read or write all bytes of N iovecs, returns the bytes done, less only
+ *  at the end of the input
+ */
+static long Io(tPicStream *pThat, struct iovec *pIov, int N)
+{
+  ssize_t	r;
+  long		done=0;
+
+  while(N>0){
+    r=pThat->Write?writev(pThat->Fd,pIov,N):
+      readv(pThat->Fd,pIov,N);
+    if(r<0){
+      if(errno==EINTR)
+	continue;
+      if(errno==EAGAIN)
+	Wait(pThat->Fd,pThat->Write);
+      else if(pThat->Write)
+	ERROR("writing: %s",pThat->Name);
+      else
+	ERROR("reading: %s",pThat->Name);
+      continue;
+    }
+    if(r==0)
+      break;
+    done+=r;
+    /* skip the finished iovecs, advance the partial one */
+    for(;N>0 && (size_t)r>=pIov->iov_len;N--,pIov++)
+      r-=pIov->iov_len;
+    if(N>0){
+      pIov->iov_base=(u8*)pIov->iov_base+r;
+      pIov->iov_len-=r;
+    }
+  }
+
+  return done;
+}
+
+
+/****************************************************************************/
+/*  read a line up to '\n' into pBuf, without reading ahead. Min bytes are
+ *  read at once, as a line is never shorter. FALSE at the end of input
+ */
+static bool GetLine(tPicStream *pThat, char *pBuf, int Max, int Min)
+{
+  struct iovec	v;
+  int		n=0;
+
+  v.iov_base=pBuf;
+  v.iov_len=Min;
+  if((n=Io(pThat,&v,1))<Min){
+    if(n>0)
+      WARN("%s ends in a header",pThat->Name);
+    return FALSE;
+  }
+  while(pBuf[n-1]!='\n'){
+    if(n==Max-1)
+      ERROR("too long header in %s",pThat->Name);
+    v.iov_base=pBuf+n;
+    v.iov_len=1;
+    if(Io(pThat,&v,1)!=1){
+      WARN("%s ends in a header",pThat->Name);
+      return FALSE;
+    }
+    n++;
+  }
+  pBuf[n-1]=0;
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/*  open Name ("-" for stdin/stdout) and look at what it is
+ */
+static bool OpenFd(tPicStream *pThat, const char *Name, bool Write)
+{
+  struct stat	st;
+  int		sz;
+
+  memset(pThat,0,sizeof(*pThat));
+  pThat->Name=Name;
+  pThat->Write=Write;
+
+  if(strcmp(Name,"-")==0)
+    pThat->Fd=Write?STDOUT_FILENO:STDIN_FILENO;
+  else if((pThat->Fd=Write?open(Name,O_WRONLY|O_CREAT|O_TRUNC,0666):
+	   open(Name,O_RDONLY))<0){
+    if(Write)
+      ERROR("cannot create: %s",Name);
+    return FALSE;
+  }
+  else
+    pThat->Own=TRUE;
+
+  pThat->Pipe=fstat(pThat->Fd,&st)==0 && S_ISFIFO(st.st_mode);
+#ifdef F_SETPIPE_SZ
+  /* a larger pipe buffer if we may, not an error if not */
+  if(pThat->Pipe && (sz=fcntl(pThat->Fd,F_GETPIPE_SZ))>0 && sz<PIPE_SIZE)
+    fcntl(pThat->Fd,F_SETPIPE_SZ,PIPE_SIZE);
+#else
+  (void)sz;
+#endif
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/*  check the format, compute the frame size and allocate the frame buffer
+ */
+static void Setup(tPicStream *pThat, int Dx, int Dy, int Cs, int Bits)
+{
+  int		c,b=Bits>8?2:1,cx,cy;
+  u8		*pp;
+
+  if(Dx<1 || Dy<1 || Dx>1<<16 || Dy>1<<16)
+    ERROR("implausible size %dx%d of %s",Dx,Dy,pThat->Name);
+  if(!(Cs==420 || Cs==422 || Cs==444 || Cs==PICSTREAM_MONO) ||
+     Bits<8 || Bits>16)
+    ERROR("unsupported format %d/%d of %s",Cs,Bits,pThat->Name);
+
+  pThat->Dx=Dx;
+  pThat->Dy=Dy;
+  pThat->Cs=Cs;
+  pThat->Bits=Bits;
+  cx=Cs==444?Dx:(Dx+1)/2;
+  cy=Cs==420?(Dy+1)/2:Dy;
+  pThat->Size=((long)Dx*Dy+(Cs==PICSTREAM_MONO?0:2L*cx*cy))*b;
+
+  pThat->pMem=malloc(pThat->Size);  MUST(pThat->pMem);
+  pThat->Frame.Dx=Dx;
+  pThat->Frame.Dy=Dy;
+  pp=pThat->pMem;
+  for(c=0;c<3;c++){
+    if(c>0 && Cs==PICSTREAM_MONO){
+      Pic_Create(&pThat->Frame.C[c],0,0,0,NULL);
+      continue;
+    }
+    Pic_Create(&pThat->Frame.C[c],(c?cx:Dx)*b,c?cx:Dx,c?cy:Dy,pp);
+    pp+=(long)pThat->Frame.C[c].S*pThat->Frame.C[c].Dy;
+  }
+}
+
+
+/****************************************************************************/
+/*  the Y4M name of a format
+ */
+static void Y4mCs(char *pBuf, int Cs, int Bits)
+{
+  if(Cs==PICSTREAM_MONO)
+    sprintf(pBuf,Bits>8?"mono%d":"mono",Bits);
+  else if(Bits>8)
+    sprintf(pBuf,"%dp%d",Cs,Bits);
+  else
+    sprintf(pBuf,Cs==420?"420jpeg":"%d",Cs);
+}
+
+
+/****************************************************************************/
+/*  read or write the planes of a frame, FALSE at the end of the input.
+ *  Head is written first, if not NULL
+ */
+static bool FrameIo(tPicStream *pThat, const tYuv *pYuv, const char *Head)
+{
+  struct iovec	iov[IOVS];
+  const tPic	*pc;
+  long		len,r,want=0,done=0;
+  int		c,y,n=0,b=pThat->Bits>8?2:1;
+
+  if(Head){
+    iov[n].iov_base=(void*)Head;
+    want+=iov[n++].iov_len=strlen(Head);
+  }
+  for(c=0;c<3 && (c==0 || pThat->Cs!=PICSTREAM_MONO);c++){
+    pc=&pYuv->C[c];
+    len=(long)pc->Dx*b;
+    MUST(pc->Dx==pThat->Frame.C[c].Dx && pc->Dy==pThat->Frame.C[c].Dy);
+    /* the whole plane at once if it has no padding */
+    for(y=0;y<pc->Dy;y+=pc->S==len?pc->Dy:1){
+      if(n==IOVS){
+	if((r=Io(pThat,iov,n))!=want){
+	  done+=r;
+	  goto Short;
+	}
+	done+=want;
+	want=n=0;
+      }
+      iov[n].iov_base=pc->Pel+(long)y*pc->S;
+      want+=iov[n++].iov_len=pc->S==len?len*pc->Dy:len;
+    }
+  }
+  if((r=Io(pThat,iov,n))==want)
+    return TRUE;
+  done+=r;
+
+ Short:
+  if(done || pThat->Y4m)
+    WARN("%s ends in frame %ld",pThat->Name,pThat->N);
+  return FALSE;
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/** open a Y4M stream and read its header
+ *
+ *  \param  pThat the stream, Dx, Dy, Cs, Bits, FpsN and FpsD are set
+ *  \param  Name  filename, "-" for stdin
+ *  \return FALSE if the file cannot be opened
+ */
+bool PicStream_OpenY4m(tPicStream *pThat, const char *Name)
+{
+  char		line[LINE],*p,*e;
+  int		dx=0,dy=0,cs=420,bits=8,fn=0,fd=1;
+
+  if(!OpenFd(pThat,Name,FALSE))
+    return FALSE;
+  pThat->Y4m=TRUE;
+
+  if(!GetLine(pThat,line,LINE,10) || strncmp(line,"YUV4MPEG2 ",10)!=0)
+    ERROR("Y4M header not found in %s",Name);
+  for(p=strtok_r(line+10," ",&e);p;p=strtok_r(NULL," ",&e)){
+    switch(*p){
+    case 'W': dx=atoi(p+1); break;
+    case 'H': dy=atoi(p+1); break;
+    case 'F': sscanf(p+1,"%d:%d",&fn,&fd); break;
+    case 'C':
+      if(strncmp(p+1,"mono",4)==0){
+	cs=PICSTREAM_MONO;
+	bits=p[5]?atoi(p+5):8;
+      }
+      else{
+	cs=strtol(p+1,&p,10);
+	/* chroma siting (420paldv starts with a p too) or p and the bits */
+	if(strcmp(p,"jpeg")==0 || strcmp(p,"mpeg2")==0 ||
+	   strcmp(p,"paldv")==0)
+	  p+=strlen(p);
+	if(*p=='p' && isdigit((u8)p[1]))
+	  bits=atoi(p+1);
+	else if(*p)
+	  cs=0;
+      }
+      break;
+    }
+  }
+  Setup(pThat,dx,dy,cs,bits);
+  pThat->FpsN=fn;
+  pThat->FpsD=fd;
+  ;   DLOGd(pThat->Dx); DLOGd(pThat->Dy); DLOGd(pThat->Cs);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** open a stream of raw frames, e.g. of ffmpeg -f rawvideo
+ *
+ *  \param  pThat the stream
+ *  \param  Name  filename, "-" for stdin
+ *  \param  Dx    width
+ *  \param  Dy    height
+ *  \param  Cs    chroma: 420, 422, 444 or PICSTREAM_MONO
+ *  \param  Bits  per sample, more than 8 are read as little endian u16
+ *  \return FALSE if the file cannot be opened
+ */
+bool PicStream_OpenRaw(tPicStream *pThat, const char *Name, int Dx, int Dy,
+		       int Cs, int Bits)
+{
+  if(!OpenFd(pThat,Name,FALSE))
+    return FALSE;
+  Setup(pThat,Dx,Dy,Cs,Bits);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** create a Y4M stream and write its header
+ *
+ *  \param  pThat the stream
+ *  \param  Name  filename, "-" for stdout
+ *  \param  Dx    width
+ *  \param  Dy    height
+ *  \param  Cs    chroma: 420, 422, 444 or PICSTREAM_MONO
+ *  \param  Bits  per sample
+ *  \param  FpsN  frame rate FpsN/FpsD, 0 for 25 fps
+ *  \param  FpsD
+ *  \return success (always TRUE at the moment)
+ */
+bool PicStream_CreateY4m(tPicStream *pThat, const char *Name, int Dx, int Dy,
+			 int Cs, int Bits, int FpsN, int FpsD)
+{
+  char		line[LINE],cs[16];
+  struct iovec	v;
+
+  OpenFd(pThat,Name,TRUE);
+  pThat->Y4m=TRUE;
+  Setup(pThat,Dx,Dy,Cs,Bits);
+  pThat->FpsN=FpsN>0 && FpsD>0?FpsN:25;
+  pThat->FpsD=FpsN>0 && FpsD>0?FpsD:1;
+
+  Y4mCs(cs,Cs,Bits);
+  v.iov_base=line;
+  v.iov_len=snprintf(line,sizeof(line),"YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 "
+		     "C%s\n",Dx,Dy,pThat->FpsN,pThat->FpsD,cs);
+  Io(pThat,&v,1);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** create a stream of raw frames
+ *
+ *  \param  pThat the stream
+ *  \param  Name  filename, "-" for stdout
+ *  \param  Dx    width
+ *  \param  Dy    height
+ *  \param  Cs    chroma: 420, 422, 444 or PICSTREAM_MONO
+ *  \param  Bits  per sample
+ *  \return success (always TRUE at the moment)
+ */
+bool PicStream_CreateRaw(tPicStream *pThat, const char *Name, int Dx, int Dy,
+			 int Cs, int Bits)
+{
+  OpenFd(pThat,Name,TRUE);
+  Setup(pThat,Dx,Dy,Cs,Bits);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** read the next frame into pYuv, whose planes must have the size of the
+ *  stream. the strides are free
+ *
+ *  \param  pThat the stream
+ *  \param  pYuv  the frame
+ *  \return FALSE at the end of the stream
+ */
+bool PicStream_ReadInto(tPicStream *pThat, tYuv *pYuv)
+{
+  char		line[LINE];
+  METRIC_FUNC;
+
+  ;   MUST(!pThat->Write);
+
+  if(pThat->Y4m){
+    if(!GetLine(pThat,line,LINE,6))
+      return FALSE;
+    if(strncmp(line,"FRAME",5)!=0)
+      ERROR("FRAME not found in %s after %ld frames",pThat->Name,pThat->N);
+  }
+  if(!FrameIo(pThat,pYuv,NULL))
+    return FALSE;
+  pThat->N++;
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** read the next frame into the buffer of the stream
+ *
+ *  \param  pThat the stream
+ *  \return the frame, valid until the next read, NULL at the end
+ */
+tYuv *PicStream_Read(tPicStream *pThat)
+{
+  return PicStream_ReadInto(pThat,&pThat->Frame)?&pThat->Frame:NULL;
+}
+
+
+/****************************************************************************/
+/** write a frame
+ *
+ *  \param  pThat the stream
+ *  \param  pYuv  the frame, planes of the size of the stream
+ */
+void PicStream_Write(tPicStream *pThat, const tYuv *pYuv)
+{
+  METRIC_FUNC;
+
+  ;   MUST(pThat->Write);
+
+  if(!FrameIo(pThat,pYuv,pThat->Y4m?"FRAME\n":NULL))
+    ERROR("writing: %s",pThat->Name);
+  pThat->N++;
+}
+
+
+/****************************************************************************/
+/** pass the next frame of pIn on to pThat, both of the same format. with
+ *  splice() if one of them is a pipe, so the pels never leave the kernel
+ *
+ *  \param  pThat the output stream
+ *  \param  pIn   the input stream
+ *  \return FALSE at the end of pIn
+ */
+bool PicStream_Copy(tPicStream *pThat, tPicStream *pIn)
+{
+  char		line[LINE];
+  struct iovec	v;
+  long		left=pIn->Size;
+  ssize_t	r=0;
+  METRIC_FUNC;
+
+  ;   MUST(pThat->Write && !pIn->Write);
+  ;   MUST(pThat->Size==pIn->Size);
+
+#if defined LINUX_GNU && defined SPLICE_F_MOVE
+  if(pThat->Pipe || pIn->Pipe){
+    if(pIn->Y4m){
+      if(!GetLine(pIn,line,LINE,6))
+	return FALSE;
+      if(strncmp(line,"FRAME",5)!=0)
+	ERROR("FRAME not found in %s after %ld frames",pIn->Name,pIn->N);
+    }
+    if(pThat->Y4m){
+      v.iov_base="FRAME\n";
+      v.iov_len=6;
+      Io(pThat,&v,1);
+    }
+    while(left>0){
+      r=splice(pIn->Fd,NULL,pThat->Fd,NULL,left,SPLICE_F_MOVE|SPLICE_F_MORE);
+      if(r>0)
+	left-=r;
+      else if(r==0)
+	break;
+      else if(errno==EAGAIN)
+	Wait(pIn->Fd,FALSE);
+      else if(errno!=EINTR)
+	break;
+    }
+    if(left>0 && left<pIn->Size)
+      ERROR("%s ends in frame %ld",pIn->Name,pIn->N);
+    if(left==0){
+      pIn->N++;
+      pThat->N++;
+      return TRUE;
+    }
+    if(r==0){
+      if(pIn->Y4m)
+	ERROR("%s ends in frame %ld",pIn->Name,pIn->N);
+      return FALSE;
+    }
+    /* splice() not possible for these fds, the header is out already */
+    if(!FrameIo(pIn,&pIn->Frame,NULL))
+      ERROR("%s ends in frame %ld",pIn->Name,pIn->N);
+    pIn->N++;
+    if(!FrameIo(pThat,&pIn->Frame,NULL))
+      ERROR("writing: %s",pThat->Name);
+    pThat->N++;
+    return TRUE;
+  }
+#else
+  (void)line; (void)v; (void)left; (void)r;
+#endif
+
+  if(!PicStream_ReadInto(pIn,&pIn->Frame))
+    return FALSE;
+  PicStream_Write(pThat,&pIn->Frame);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** close the stream (not stdin/stdout) and free its buffer
+ *
+ *  \param  pThat the stream
+ */
+void PicStream_Close(tPicStream *pThat)
+{
+  if(pThat->Own)
+    close(pThat->Fd);
+  free(pThat->pMem);
+  memset(pThat,0,sizeof(*pThat));
+}
+
+#endif /* UNIX_GNU */
@@ -0,0 +1,90 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  streams of planar YUV frames on pipes or files: Y4M (YUV4MPEG2) with
+ *  its header, or raw frames of a fixed size as ffmpeg -f rawvideo makes
+ *  them. a nuts tool can sit in a shell pipeline:
+ *
+ *	ffmpeg -i in.mp4 -f yuv4mpegpipe - | tool | ffplay -
+ *
+ *	PicStream_OpenY4m(&in,"-");
+ *	PicStream_CreateY4m(&out,"-",in.Dx,in.Dy,in.Cs,in.Bits,in.FpsN,
+ *			    in.FpsD);
+ *	while((p=PicStream_Read(&in))){
+ *	  ... work on p ...
+ *	  PicStream_Write(&out,p);
+ *	}
+ *	PicStream_Close(&out);
+ *	PicStream_Close(&in);
+ *
+ *  PicStream_Read() reuses one frame buffer, with planes of stride Dx
+ *  back to back, so a frame is one large readv() straight into it. with
+ *  more than 8 bits a sample is a little endian u16, as in Y4M.
+ *  PicStream_Copy() passes frames on without looking at them, with
+ *  splice() if one side is a pipe.
+ *
+ *  \file      picstream.h
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#ifndef PICSTREAM_H
+#define PICSTREAM_H
+
+#include	"pic.h"
+
+
+/*****************************************************************************
+ *  defines
+ ****************************************************************************/
+
+#define PICSTREAM_MONO	400		/**< Cs of a stream with Y only */
+
+
+/*****************************************************************************
+ *  types
+ ****************************************************************************/
+
+/** a frame stream, for reading or writing
+ */
+typedef struct {
+  int		Fd;
+  const char	*Name;		/**< filename for messages, not copied */
+  bool		Write;
+  bool		Y4m;		/**< else raw frames */
+  bool		Own;		/**< Fd is closed by PicStream_Close() */
+  bool		Pipe;		/**< Fd is a pipe */
+  int		Dx,Dy;
+  int		Cs;		/**< chroma: 420, 422, 444 or PICSTREAM_MONO */
+  int		Bits;		/**< per sample, 8..16 */
+  int		FpsN,FpsD;	/**< frame rate, of Y4M streams */
+  long		Size;		/**< bytes of the pels of a frame */
+  long		N;		/**< frames read or written */
+  tYuv		Frame;		/**< buffer of PicStream_Read() */
+  u8		*pMem;		/**< memory of Frame */
+} tPicStream;
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+EXTERN_C_BEGIN
+
+bool PicStream_OpenY4m(tPicStream *pThat, const char *Name);
+bool PicStream_OpenRaw(tPicStream *pThat, const char *Name, int Dx, int Dy,
+		       int Cs, int Bits);
+bool PicStream_CreateY4m(tPicStream *pThat, const char *Name, int Dx, int Dy,
+			 int Cs, int Bits, int FpsN, int FpsD);
+bool PicStream_CreateRaw(tPicStream *pThat, const char *Name, int Dx, int Dy,
+			 int Cs, int Bits);
+
+tYuv *PicStream_Read(tPicStream *pThat);
+bool PicStream_ReadInto(tPicStream *pThat, tYuv *pYuv);
+void PicStream_Write(tPicStream *pThat, const tYuv *pYuv);
+bool PicStream_Copy(tPicStream *pThat, tPicStream *pIn);
+void PicStream_Close(tPicStream *pThat);
+
+EXTERN_C_END
+
+#endif /* PICSTREAM_H */
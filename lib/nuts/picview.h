@@ -0,0 +1,190 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  typed view on a tPic for C++, with kernels that are instantiated for the
+ *  pel type and channel count, so the inner loops see a fixed pel size.
+ *
+ *	nuts::PicView<u16>	a Pic16
+ *	nuts::PicView<u8,3>	a Pic24 (RGB)
+ *	nuts::PicView<u8,4>	a Pic32 seen as bytes
+ *
+ *  a view does not own memory, it is made from a tPic and can be turned
+ *  back into one. PICVIEW_CONV() defines a converter with the usual C
+ *  signature, e.g. for a format that has no hand written loop in pic.c:
+ *
+ *	PICVIEW_CONV(Pic16_FromRGB, u16,1, u8,3,
+ *		     d[0]=(s[0]>>3)<<11|(s[1]>>2)<<5|s[2]>>3)
+ *
+ *  \file      picview.h
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#ifndef PICVIEW_H
+#define PICVIEW_H
+
+#include	"debug.h"
+#include	"pic.h"
+#include	<string.h>
+
+#ifdef __cplusplus
+
+#include	<limits>
+
+namespace nuts {
+
+/*****************************************************************************
+ *  types
+ ****************************************************************************/
+
+/** a tPic with pels of Channels values of type T
+ */
+template<typename T, int Channels=1>
+struct PicView {
+  typedef T	tType;
+  enum { CHANNELS=Channels, BPP=sizeof(T)*Channels };
+
+  u8		*Pel;
+  int		Dx,Dy,S;
+
+  PicView(const tPic &Pic) : Pel(Pic.Pel),Dx(Pic.Dx),Dy(Pic.Dy),S(Pic.S) {}
+  PicView(const tPic *pPic) : Pel(pPic->Pel),Dx(pPic->Dx),Dy(pPic->Dy),
+			      S(pPic->S) {}
+
+  /** first value of line y */
+  T *Row(int y) const { return (T*)(Pel+(long)y*S); }
+
+  /** channel c of the pel at x,y */
+  T &operator()(int x, int y, int c=0) const
+  {
+    MUST_In(x,0,Dx-1); MUST_In(y,0,Dy-1);
+    return Row(y)[x*Channels+c];
+  }
+
+  /** a rectangle inside this view */
+  PicView Window(int x, int y, int dx, int dy) const
+  {
+    PicView	w(*this);
+
+    MUST(x>=0 && y>=0 && x+dx<=Dx && y+dy<=Dy);
+    w.Pel=Pel+(long)y*S+x*BPP;
+    w.Dx=dx;
+    w.Dy=dy;
+    return w;
+  }
+
+  /** back to C */
+  tPic Pic() const
+  {
+    tPic	p;
+
+    Pic_Create(&p,S,Dx,Dy,Pel);
+    return p;
+  }
+};
+
+
+/*****************************************************************************
+ *  kernels
+ ****************************************************************************/
+
+/** call f(pd,ps) for each pel of the common area, pd and ps point to the
+ *  channels of the pel
+ */
+template<class D, class S, class F>
+inline void Transform(const D &Dst, const S &Src, F f)
+{
+  int		x,y,dx=MIN(Dst.Dx,Src.Dx),dy=MIN(Dst.Dy,Src.Dy);
+
+  for(y=0;y<dy;y++){
+    typename D::tType		*pd=Dst.Row(y);
+    const typename S::tType	*ps=Src.Row(y);
+    for(x=0;x<dx;x++,pd+=D::CHANNELS,ps+=S::CHANNELS)
+      f(pd,ps);
+  }
+}
+
+
+/** call f(p) for each pel, p points to its channels
+ */
+template<class D, class F>
+inline void ForEach(const D &Dst, F f)
+{
+  int		x,y;
+
+  for(y=0;y<Dst.Dy;y++){
+    typename D::tType	*p=Dst.Row(y);
+    for(x=0;x<Dst.Dx;x++,p+=D::CHANNELS)
+      f(p);
+  }
+}
+
+
+/** copy, same format: line by line with memcpy
+ */
+template<typename T, int C>
+inline void Copy(const PicView<T,C> &Dst, const PicView<T,C> &Src)
+{
+  int		y,dy=MIN(Dst.Dy,Src.Dy);
+
+  for(y=0;y<dy;y++)
+    memcpy(Dst.Row(y),Src.Row(y),MIN(Dst.Dx,Src.Dx)*PicView<T,C>::BPP);
+}
+
+
+/** copy with conversion of each channel, the channel counts must match
+ */
+template<typename TD, typename TS, int C>
+inline void Copy(const PicView<TD,C> &Dst, const PicView<TS,C> &Src)
+{
+  Transform(Dst,Src,[](TD *pd, const TS *ps){
+      for(int c=0;c<C;c++)
+	pd[c]=(TD)ps[c];
+    });
+}
+
+
+/** set all pels to the channel values in pVal
+ */
+template<typename T, int C>
+inline void Set(const PicView<T,C> &Dst, const T *pVal)
+{
+  ForEach(Dst,[pVal](T *p){
+      for(int c=0;c<C;c++)
+	p[c]=pVal[c];
+    });
+}
+
+
+/** shift all values left and clip to the range of T
+ */
+template<typename T, int C>
+inline void ShiftLeft(const PicView<T,C> &Dst, int Shift)
+{
+  const unsigned long long	max=std::numeric_limits<T>::max();
+
+  ForEach(Dst,[Shift,max](T *p){
+      for(int c=0;c<C;c++){
+	unsigned long long	v=(unsigned long long)p[c]<<Shift;
+	p[c]=(T)(v>max?max:v);
+      }
+    });
+}
+
+} /* namespace nuts */
+
+
+/** define a converter "void Name(tPic *pThat, tPic *pSrc)" with C linkage.
+ *  Expr computes the channels d[] of a pel from the channels s[]
+ */
+#define PICVIEW_CONV(Name,TD,CD,TS,CS,Expr)				\
+  extern "C" void Name(tPic *pThat, tPic *pSrc)				\
+  {									\
+    nuts::Transform(nuts::PicView<TD,CD>(pThat),			\
+		    nuts::PicView<TS,CS>(pSrc),				\
+		    [](TD *d, const TS *s){ Expr; });			\
+  }
+
+#endif /* __cplusplus */
+
+#endif /* PICVIEW_H */
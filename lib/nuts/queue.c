@@ -0,0 +1,398 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  bounded lock free queues, see queue.h. the tSpsc is a ring with a head
+ *  and a tail index, each side caches the index of the other side and only
+ *  reloads it when the ring looks full/empty. the tMpsc uses a sequence
+ *  number per cell (D. Vyukov's bounded queue), producers claim a cell by
+ *  a CAS on the tail.
+ *
+ *  sleeping: a waiting thread sets Sleepers and sleeps on Seq, the other
+ *  side checks Sleepers after every operation (behind a full fence) and
+ *  then bumps Seq and wakes. the values stored must not be NULL.
+ *
+ *  \file      queue.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"queue.h"
+#include	"debug.h"
+#include	"timer.h"
+
+#ifdef UNIX_GNU
+
+#include	<stdlib.h>
+#include	<string.h>
+#include	<limits.h>
+#include	<unistd.h>
+#ifdef LINUX_GNU
+#include	<linux/futex.h>
+#include	<sys/syscall.h>
+#endif
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define SPINS		64		/* polls before going to sleep */
+
+#if defined __x86_64__ || defined __i386__
+#define PAUSE()		__builtin_ia32_pause()
+#else
+#define PAUSE()
+#endif
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  round up to a power of 2
+ */
+static u32 Pow2(int Cap)
+{
+  u32		n=1;
+
+  ;   MUST_In(Cap,1,1<<30);
+  while((int)n<Cap)
+    n*=2;
+
+  return n;
+}
+
+
+/****************************************************************************/
+/*  sleep while *pAddr==Val, at most Ns (0: forever)
+ */
+static void FutexWait(u32 *pAddr, u32 Val, u64 Ns)
+{
+#ifdef LINUX_GNU
+  struct timespec	ts;
+
+  ts.tv_sec=Ns/1000000000;
+  ts.tv_nsec=Ns%1000000000;
+  syscall(SYS_futex,pAddr,FUTEX_WAIT_PRIVATE,Val,Ns?&ts:NULL,NULL,0);
+#else
+  (void)pAddr; (void)Val; (void)Ns;
+  usleep(50);
+#endif
+}
+
+
+/****************************************************************************/
+/*  wake the sleepers of one direction of a queue, if there are any
+ */
+static void Wake(tQueueWait *pWait)
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if(__atomic_load_n(&pWait->Sleepers,__ATOMIC_RELAXED)){
+    __atomic_store_n(&pWait->Sleepers,0,__ATOMIC_RELAXED);
+    __atomic_fetch_add(&pWait->Seq,1,__ATOMIC_RELEASE);
+#ifdef LINUX_GNU
+    syscall(SYS_futex,&pWait->Seq,FUTEX_WAKE_PRIVATE,INT_MAX,NULL,NULL,0);
+#endif
+  }
+}
+
+
+/****************************************************************************/
+/*  retry a queue operation until it succeeds: spin a little, then sleep
+ *
+ *  \param  pWait     the direction we wait for
+ *  \param  Try       the operation, returns NULL if it has to be retried
+ *  \param  pQ,p      arguments of Try
+ *  \param  TimeoutMs -1: forever
+ *  \return result of Try or NULL after the timeout
+ */
+static void *WaitFor(tQueueWait *pWait, void *(*Try)(void *pQ, void *p),
+		     void *pQ, void *p, int TimeoutMs)
+{
+  void		*r;
+  u64		end=0,now;
+  u32		seq;
+  int		i;
+
+  for(i=0;i<SPINS;i++){
+    if((r=Try(pQ,p)))
+      return r;
+    PAUSE();
+  }
+
+  if(TimeoutMs>=0)
+    end=timerNs()+TimeoutMs*1000000ull;
+
+  for(;;){
+    seq=__atomic_load_n(&pWait->Seq,__ATOMIC_ACQUIRE);
+    __atomic_store_n(&pWait->Sleepers,1,__ATOMIC_SEQ_CST);
+    if((r=Try(pQ,p)))
+      return r;
+    if(TimeoutMs<0)
+      FutexWait(&pWait->Seq,seq,0);
+    else{
+      if((now=timerNs())>=end)
+	return NULL;
+      FutexWait(&pWait->Seq,seq,end-now);
+    }
+  }
+}
+
+
+/****************************************************************************/
+/*  adapters for WaitFor()
+ */
+static void *TrySpscPush(void *pQ, void *p)
+{
+  return Spsc_Push(pQ,p)?p:NULL;
+}
+
+static void *TrySpscPop(void *pQ, void *p)
+{
+  (void)p;
+  return Spsc_Pop(pQ);
+}
+
+static void *TryMpscPush(void *pQ, void *p)
+{
+  return Mpsc_Push(pQ,p)?p:NULL;
+}
+
+static void *TryMpscPop(void *pQ, void *p)
+{
+  (void)p;
+  return Mpsc_Pop(pQ);
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/** initialize a single producer single consumer queue
+ *
+ *  \param  pThat the queue
+ *  \param  Cap   capacity, rounded up to a power of 2
+ */
+void Spsc_Init(tSpsc *pThat, int Cap)
+{
+  u32		n=Pow2(Cap);
+
+  memset(pThat,0,sizeof(*pThat));
+  pThat->Mask=n-1;
+  pThat->ppBuf=calloc(n,sizeof(void*));  MUST(pThat->ppBuf);
+}
+
+
+/****************************************************************************/
+/** free the memory of a queue (not the queued items)
+ *
+ *  \param  pThat the queue
+ */
+void Spsc_Free(tSpsc *pThat)
+{
+  free(pThat->ppBuf);
+  pThat->ppBuf=NULL;
+}
+
+
+/****************************************************************************/
+/** append an item, producer side
+ *
+ *  \param  pThat the queue
+ *  \param  p     the item, not NULL
+ *  \return FALSE if the queue is full
+ */
+bool Spsc_Push(tSpsc *pThat, void *p)
+{
+  u32		t=pThat->Tail;
+
+  ;   MUST(p);
+
+  if(t-pThat->HeadCache>pThat->Mask){
+    pThat->HeadCache=__atomic_load_n(&pThat->Head,__ATOMIC_ACQUIRE);
+    if(t-pThat->HeadCache>pThat->Mask)
+      return FALSE;
+  }
+  pThat->ppBuf[t&pThat->Mask]=p;
+  __atomic_store_n(&pThat->Tail,t+1,__ATOMIC_RELEASE);
+  Wake(&pThat->NotEmpty);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** take the oldest item, consumer side
+ *
+ *  \param  pThat the queue
+ *  \return the item or NULL if the queue is empty
+ */
+void * Spsc_Pop(tSpsc *pThat)
+{
+  u32		h=pThat->Head;
+  void		*p;
+
+  if(h==pThat->TailCache){
+    pThat->TailCache=__atomic_load_n(&pThat->Tail,__ATOMIC_ACQUIRE);
+    if(h==pThat->TailCache)
+      return NULL;
+  }
+  p=pThat->ppBuf[h&pThat->Mask];
+  __atomic_store_n(&pThat->Head,h+1,__ATOMIC_RELEASE);
+  Wake(&pThat->NotFull);
+
+  return p;
+}
+
+
+/****************************************************************************/
+/** append an item, wait while the queue is full
+ *
+ *  \param  pThat     the queue
+ *  \param  p         the item, not NULL
+ *  \param  TimeoutMs max time to wait, -1 forever
+ *  \return FALSE after a timeout
+ */
+bool Spsc_PushWait(tSpsc *pThat, void *p, int TimeoutMs)
+{
+  return WaitFor(&pThat->NotFull,TrySpscPush,pThat,p,TimeoutMs)!=NULL;
+}
+
+
+/****************************************************************************/
+/** take the oldest item, wait while the queue is empty
+ *
+ *  \param  pThat     the queue
+ *  \param  TimeoutMs max time to wait, -1 forever
+ *  \return the item or NULL after a timeout
+ */
+void * Spsc_PopWait(tSpsc *pThat, int TimeoutMs)
+{
+  return WaitFor(&pThat->NotEmpty,TrySpscPop,pThat,NULL,TimeoutMs);
+}
+
+
+/****************************************************************************/
+/** initialize a multi producer single consumer queue
+ *
+ *  \param  pThat the queue
+ *  \param  Cap   capacity, rounded up to a power of 2
+ */
+void Mpsc_Init(tMpsc *pThat, int Cap)
+{
+  u32		i,n=Pow2(Cap);
+
+  memset(pThat,0,sizeof(*pThat));
+  pThat->Mask=n-1;
+  pThat->pCell=malloc(n*sizeof(tMpscCell));  MUST(pThat->pCell);
+  for(i=0;i<n;i++){
+    pThat->pCell[i].Seq=i;
+    pThat->pCell[i].p=NULL;
+  }
+}
+
+
+/****************************************************************************/
+/** free the memory of a queue (not the queued items)
+ *
+ *  \param  pThat the queue
+ */
+void Mpsc_Free(tMpsc *pThat)
+{
+  free(pThat->pCell);
+  pThat->pCell=NULL;
+}
+
+
+/****************************************************************************/
+/** append an item, any thread
+ *
+ *  \param  pThat the queue
+ *  \param  p     the item, not NULL
+ *  \return FALSE if the queue is full
+ */
+bool Mpsc_Push(tMpsc *pThat, void *p)
+{
+  tMpscCell	*pc;
+  u32		pos,seq;
+  int		dif;
+
+  ;   MUST(p);
+
+  pos=__atomic_load_n(&pThat->Tail,__ATOMIC_RELAXED);
+  for(;;){
+    pc=&pThat->pCell[pos&pThat->Mask];
+    seq=__atomic_load_n(&pc->Seq,__ATOMIC_ACQUIRE);
+    dif=(int)(seq-pos);
+    if(dif==0){
+      if(__atomic_compare_exchange_n(&pThat->Tail,&pos,pos+1,TRUE,
+				     __ATOMIC_RELAXED,__ATOMIC_RELAXED))
+	break;
+    }
+    else if(dif<0)
+      return FALSE;
+    else
+      pos=__atomic_load_n(&pThat->Tail,__ATOMIC_RELAXED);
+  }
+
+  pc->p=p;
+  __atomic_store_n(&pc->Seq,pos+1,__ATOMIC_RELEASE);
+  Wake(&pThat->NotEmpty);
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** take the oldest item, consumer thread only
+ *
+ *  \param  pThat the queue
+ *  \return the item or NULL if the queue is empty
+ */
+void * Mpsc_Pop(tMpsc *pThat)
+{
+  u32		h=pThat->Head;
+  tMpscCell	*pc=&pThat->pCell[h&pThat->Mask];
+  void		*p;
+
+  if(__atomic_load_n(&pc->Seq,__ATOMIC_ACQUIRE)!=h+1)
+    return NULL;
+  p=pc->p;
+  __atomic_store_n(&pc->Seq,h+pThat->Mask+1,__ATOMIC_RELEASE);
+  __atomic_store_n(&pThat->Head,h+1,__ATOMIC_RELAXED);
+  Wake(&pThat->NotFull);
+
+  return p;
+}
+
+
+/****************************************************************************/
+/** append an item, wait while the queue is full
+ *
+ *  \param  pThat     the queue
+ *  \param  p         the item, not NULL
+ *  \param  TimeoutMs max time to wait, -1 forever
+ *  \return FALSE after a timeout
+ */
+bool Mpsc_PushWait(tMpsc *pThat, void *p, int TimeoutMs)
+{
+  return WaitFor(&pThat->NotFull,TryMpscPush,pThat,p,TimeoutMs)!=NULL;
+}
+
+
+/****************************************************************************/
+/** take the oldest item, wait while the queue is empty
+ *
+ *  \param  pThat     the queue
+ *  \param  TimeoutMs max time to wait, -1 forever
+ *  \return the item or NULL after a timeout
+ */
+void * Mpsc_PopWait(tMpsc *pThat, int TimeoutMs)
+{
+  return WaitFor(&pThat->NotEmpty,TryMpscPop,pThat,NULL,TimeoutMs);
+}
+
+#endif /* UNIX_GNU */
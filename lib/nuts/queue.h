@@ -0,0 +1,89 @@
+/* -*- tab-width: 8 -*- */
+/** 
+ *  bounded lock free queues of pointers between threads, e.g. to pass tPic
+ *  frames from a loader to a processing to a display thread: tSpsc for one
+ *  producer and one consumer, tMpsc for many producers and one consumer.
+ *  Push/Pop never block, PushWait/PopWait sleep on a futex until there is
+ *  room/data. the counters of both sides live in cache lines of their own
+ *
+ *  \file      queue.h
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include	"basic.h"
+
+
+/*****************************************************************************
+ *  types
+ ****************************************************************************/
+
+/** futex state of one direction of a queue
+ */
+typedef struct {
+  u32		Seq;		/* bumped to wake sleepers */
+  u32		Sleepers;	/* somebody might sleep on Seq */
+} tQueueWait;
+
+
+/** single producer single consumer queue
+ */
+typedef struct {
+  u32		Tail __attribute__((aligned(64)));	/* producer */
+  u32		HeadCache;
+  u32		Head __attribute__((aligned(64)));	/* consumer */
+  u32		TailCache;
+  tQueueWait	NotEmpty __attribute__((aligned(64)));
+  tQueueWait	NotFull;
+  u32		Mask;
+  void		**ppBuf;
+} tSpsc;
+
+
+/** cell of a tMpsc, Seq tells the state of the cell for position Pos:
+ *  Pos free, Pos+1 full
+ */
+typedef struct {
+  u32		Seq;
+  void		*p;
+} tMpscCell;
+
+/** multi producer single consumer queue
+ */
+typedef struct {
+  u32		Tail __attribute__((aligned(64)));	/* producers */
+  u32		Head __attribute__((aligned(64)));	/* consumer */
+  tQueueWait	NotEmpty __attribute__((aligned(64)));
+  tQueueWait	NotFull;
+  u32		Mask;
+  tMpscCell	*pCell;
+} tMpsc;
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+EXTERN_C_BEGIN
+
+void  Spsc_Init(tSpsc *pThat, int Cap);
+void  Spsc_Free(tSpsc *pThat);
+bool  Spsc_Push(tSpsc *pThat, void *p);
+void* Spsc_Pop(tSpsc *pThat);
+bool  Spsc_PushWait(tSpsc *pThat, void *p, int TimeoutMs);
+void* Spsc_PopWait(tSpsc *pThat, int TimeoutMs);
+
+void  Mpsc_Init(tMpsc *pThat, int Cap);
+void  Mpsc_Free(tMpsc *pThat);
+bool  Mpsc_Push(tMpsc *pThat, void *p);
+void* Mpsc_Pop(tMpsc *pThat);
+bool  Mpsc_PushWait(tMpsc *pThat, void *p, int TimeoutMs);
+void* Mpsc_PopWait(tMpsc *pThat, int TimeoutMs);
+
+EXTERN_C_END
+
+#endif /* QUEUE_H */
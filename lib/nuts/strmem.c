@@ -1,7 +1,12 @@
 /* -*- tab-width: 8 -*- */
 /**
  *  handle strings
- *	
+ *
+ *  temporary strings come from two thread local pools: StrGen() rotates
+ *  through a ring of STRGEN_RING buffers, StrGenA() appends to an arena of
+ *  chunks that is rolled back with StrArena_Reset(). both only touch the
+ *  heap to grow, the memory is kept for reuse and freed at thread exit.
+ *
  *  \file      strmem.c
  *  \author    Norbert Stoeffler
  *  \date      2001-2011
@@ -14,20 +19,181 @@
 #include	<stdio.h>
 #include	<stdlib.h>
 #include	<stdarg.h>
+#ifdef UNIX_GNU
+#include	<pthread.h>
+#endif
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define SLOTSIZE	1024		/* fixed part of a ring slot */
+#define CHUNKSIZE	(16*1024)	/* min size of an arena chunk */
+
+
+/*****************************************************************************
+ *  local types
+ ****************************************************************************/
+
+typedef struct {
+  char			Fix[SLOTSIZE];
+  char			*pBig;		/* for longer strings */
+  int			NBig;
+} tSlot;
+
+typedef struct sChunk {
+  struct sChunk		*pNext;
+  int			Size;
+  char			Dat[];
+} tChunk;
+
+typedef struct {
+  tSlot			Ring[STRGEN_RING];
+  int			Next;		/* next ring slot */
+  tChunk		*pFirst;	/* arena */
+  tChunk		*pCur;		/* NULL: nothing used */
+  int			Pos;		/* used bytes in pCur */
+  bool			Cleanup;	/* destructor registered */
+} tTls;
 
 
 /*****************************************************************************
  *  local variables
  ****************************************************************************/
 
+static THREAD_LOCAL tTls	lTls;
+#ifdef UNIX_GNU
+static pthread_once_t		lOnce=PTHREAD_ONCE_INIT;
+static pthread_key_t		lKey;
+#endif
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  free the heap memory of a thread
+ */
+static void FreeTls(void *pUndef)
+{
+  tChunk	*pc,*pn;
+  int		i;
+
+  (void)pUndef;
+  for(i=0;i<STRGEN_RING;i++){
+    free(lTls.Ring[i].pBig);
+    lTls.Ring[i].pBig=NULL;
+    lTls.Ring[i].NBig=0;
+  }
+  for(pc=lTls.pFirst;pc;pc=pn){
+    pn=pc->pNext;
+    free(pc);
+  }
+  lTls.pFirst=lTls.pCur=NULL;
+  lTls.Pos=0;
+}
+
+
+#ifdef UNIX_GNU
+static void InitKey(void)
+{
+  pthread_key_create(&lKey,FreeTls);
+}
+#endif
+
+
+/****************************************************************************/
+/*  make sure the heap memory of the calling thread is freed at its exit
+ */
+static void NeedCleanup(void)
+{
+#ifdef UNIX_GNU
+  if(!lTls.Cleanup){
+    pthread_once(&lOnce,InitKey);
+    pthread_setspecific(lKey,&lTls);
+    lTls.Cleanup=TRUE;
+  }
+#endif
+}
+
+
+/****************************************************************************/
+/*  format into the next ring slot
+ */
+static const char *RingGen(const char *fmt, va_list v_args)
+{
+  tSlot		*ps=&lTls.Ring[lTls.Next];
+  va_list	v2;
+  int		n;
+
+  lTls.Next=(lTls.Next+1)%STRGEN_RING;
+
+  va_copy(v2,v_args);
+  n=vsnprintf(ps->Fix,sizeof(ps->Fix),fmt,v_args);
+  if(n<(int)sizeof(ps->Fix)){
+    va_end(v2);
+    return ps->Fix;
+  }
+
+  if(n>=ps->NBig){
+    free(ps->pBig);
+    ps->NBig=n+1;
+    ps->pBig=malloc(ps->NBig);  MUST(ps->pBig);
+    NeedCleanup();
+  }
+  vsnprintf(ps->pBig,ps->NBig,fmt,v2);
+  va_end(v2);
+
+  return ps->pBig;
+}
+
+
+/****************************************************************************/
+/*  get N bytes from the arena
+ */
+static char *ArenaAlloc(int N)
+{
+  tChunk	*pc=lTls.pCur,*pn;
+
+  if(pc && lTls.Pos+N<=pc->Size){
+    lTls.Pos+=N;
+    return pc->Dat+lTls.Pos-N;
+  }
+
+  /* next chunk, if it is big enough, else a new one */
+  pn=pc?pc->pNext:lTls.pFirst;
+  if(!pn || pn->Size<N){
+    pn=malloc(sizeof(tChunk)+MAX(N,CHUNKSIZE));  MUST(pn);
+    pn->Size=MAX(N,CHUNKSIZE);
+    if(pc){
+      pn->pNext=pc->pNext;
+      pc->pNext=pn;
+    }
+    else{
+      pn->pNext=lTls.pFirst;
+      lTls.pFirst=pn;
+    }
+    NeedCleanup();
+  }
+  lTls.pCur=pn;
+  lTls.Pos=N;
+
+  return pn->Dat;
+}
+
+
 /*****************************************************************************
  *  exported functions
  ****************************************************************************/
 
 /****************************************************************************/
 /** return a pointer to a temporary string. the pointer can be used directly
- *  as filename in fopen() etc. but becomes invalid with the next call (use
- *  strdup(StrGen(...)) for a permanent string)
+ *  as filename in fopen() etc. it stays valid for the next STRGEN_RING-1
+ *  calls of StrGen()/StrGen2() in the same thread (use strdup(StrGen(...))
+ *  for a permanent string or StrGenA() for many). strings of any length
+ *  are fine
  *
  *  \param  fmt as printf
  *  \return the string
@@ -35,19 +201,18 @@
 const char * StrGen(const char *fmt, ...)
 {
   va_list       v_args;
-  static char   buffer[1024];
+  const char	*s;
 
   va_start(v_args,fmt);
-  vsnprintf(buffer,sizeof(buffer),fmt,v_args);
-  MUST(strlen(buffer)<sizeof(buffer));
+  s=RingGen(fmt,v_args);
   va_end(v_args);
 
-  return buffer;
+  return s;
 }
 
 
 /****************************************************************************/
-/** as StrGen, for cases where 2 tmp strings are needed at once
+/** as StrGen, kept for cases where 2 tmp strings are needed at once
  *
  *  \param  fmt as printf
  *  \return the string
@@ -55,14 +220,13 @@ const char * StrGen(const char *fmt, ...)
 const char * StrGen2(const char *fmt, ...)
 {
   va_list       v_args;
-  static char   buffer[1024];
+  const char	*s;
 
   va_start(v_args,fmt);
-  vsnprintf(buffer,sizeof(buffer),fmt,v_args);
-  MUST(strlen(buffer)<sizeof(buffer));
+  s=RingGen(fmt,v_args);
   va_end(v_args);
 
-  return buffer;
+  return s;
 }
 
 
@@ -82,3 +246,89 @@ const char * impStrGenAt(char *buffer, int size, const char *fmt, ...)
 }
 
 
+/****************************************************************************/
+/** return a pointer to a temporary string in the arena of the calling
+ *  thread. it stays valid until the arena is reset to a mark taken before
+ *  (StrArena_Reset(), STRARENA_SCOPE) or freed
+ *
+ *	STRARENA_SCOPE;
+ *	for(i=0;i<n;i++)
+ *	  names[i]=StrGenA("%s/%04d.pgm",dir,i);
+ *
+ *  \param  fmt as printf
+ *  \return the string
+ */
+const char * StrGenA(const char *fmt, ...)
+{
+  va_list       v_args;
+  tChunk	*pc=lTls.pCur;
+  char		*s;
+  int		n,room;
+
+  /* try the rest of the current chunk first */
+  room=pc?pc->Size-lTls.Pos:0;
+  va_start(v_args,fmt);
+  n=vsnprintf(room?pc->Dat+lTls.Pos:NULL,room,fmt,v_args);
+  va_end(v_args);
+  if(n<room){
+    lTls.Pos+=n+1;
+    return pc->Dat+lTls.Pos-n-1;
+  }
+
+  s=ArenaAlloc(n+1);
+  va_start(v_args,fmt);
+  vsnprintf(s,n+1,fmt,v_args);
+  va_end(v_args);
+
+  return s;
+}
+
+
+/****************************************************************************/
+/** remember the current position of the arena of the calling thread
+ *
+ *  \return the mark for StrArena_Reset()
+ */
+tStrMark StrArena_Mark(void)
+{
+  tStrMark	m;
+
+  m.pChunk=lTls.pCur;
+  m.Pos=lTls.Pos;
+
+  return m;
+}
+
+
+/****************************************************************************/
+/** release all StrGenA() strings that were created after a mark. the memory
+ *  is kept for reuse
+ *
+ *  \param  Mark from StrArena_Mark() of the same thread
+ */
+void StrArena_Reset(tStrMark Mark)
+{
+  lTls.pCur=Mark.pChunk;
+  lTls.Pos=Mark.Pos;
+}
+
+
+/****************************************************************************/
+/** as StrArena_Reset(), for the cleanup attribute of STRARENA_SCOPE
+ *
+ *  \param  pMark the mark
+ */
+void StrArena_Release(tStrMark *pMark)
+{
+  StrArena_Reset(*pMark);
+}
+
+
+/****************************************************************************/
+/** free all temporary strings and the memory of the calling thread. done
+ *  automatically at thread exit
+ */
+void StrArena_Free(void)
+{
+  FreeTls(NULL);
+}
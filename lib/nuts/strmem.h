@@ -25,6 +25,30 @@
 
 #define CLEAR(x)	memset(&(x),0,sizeof(x))
 
+/** number of StrGen() strings per thread that are valid at the same time
+ */
+#define STRGEN_RING	8
+
+#ifdef UNIX_GNU
+/** release all StrGenA() strings of the calling thread that are created
+ *  after this point when the enclosing block is left
+ */
+#define STRARENA_SCOPE	tStrMark strm_ \
+	__attribute__((cleanup(StrArena_Release)))=StrArena_Mark()
+#endif
+
+
+/*****************************************************************************
+ *  types
+ ****************************************************************************/
+
+/** a position in the StrGenA() arena of a thread
+ */
+typedef struct {
+  void		*pChunk;
+  int		Pos;
+} tStrMark;
+
 
 /*****************************************************************************
  *  exported functions
@@ -36,6 +60,12 @@ const char * StrGen(const char *fmt, ...);
 const char * StrGen2(const char *fmt, ...);
 const char * impStrGenAt(char *buffer, int size, const char *fmt, ...);
 
+const char * StrGenA(const char *fmt, ...);
+tStrMark     StrArena_Mark(void);
+void         StrArena_Reset(tStrMark Mark);
+void         StrArena_Release(tStrMark *pMark);
+void         StrArena_Free(void);
+
 EXTERN_C_END
 
 #endif /* UTIL_H */
@@ -0,0 +1,713 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  in process symbolizer, see symtab.h. Sym_Init() walks the loaded
+ *  objects with dl_iterate_phdr(), maps their files and builds sorted
+ *  tables of the function symbols (.symtab, else .dynsym) and of the rows
+ *  of the DWARF line programs (.debug_line, version 2-5, uncompressed).
+ *  the tables point into the mappings, which stay alive. it also calls
+ *  backtrace() once, because the first call loads libgcc_s.
+ *
+ *  \file      symtab.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#define _GNU_SOURCE		/* dl_iterate_phdr */
+#include	"symtab.h"
+#include	"debug.h"
+
+#ifdef LINUX_GNU
+
+#include	<stdlib.h>
+#include	<string.h>
+#include	<stdint.h>
+#include	<unistd.h>
+#include	<fcntl.h>
+#include	<link.h>
+#include	<pthread.h>
+#include	<execinfo.h>
+#include	<sys/mman.h>
+#include	<sys/stat.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define MAXOBJS		64		/* loaded objects */
+#define MAXFRAMES	128		/* Sym_PrintTrace() */
+
+/* DWARF constants used by the line program parser
+ */
+#define DW_LNS_copy		1
+#define DW_LNS_advance_pc	2
+#define DW_LNS_advance_line	3
+#define DW_LNS_set_file		4
+#define DW_LNS_const_add_pc	8
+#define DW_LNS_fixed_advance_pc	9
+#define DW_LNE_end_sequence	1
+#define DW_LNE_set_address	2
+#define DW_LNCT_path		1
+#define DW_FORM_block		0x09
+#define DW_FORM_data1		0x0b
+#define DW_FORM_data2		0x05
+#define DW_FORM_data4		0x06
+#define DW_FORM_data8		0x07
+#define DW_FORM_data16		0x1e
+#define DW_FORM_string		0x08
+#define DW_FORM_strp		0x0e
+#define DW_FORM_line_strp	0x1f
+#define DW_FORM_udata		0x0f
+
+
+/*****************************************************************************
+ *  local types
+ ****************************************************************************/
+
+typedef struct {
+  uintptr_t		Addr;		/* link time address */
+  size_t		Size;
+  const char		*Name;
+} tSym;
+
+typedef struct {
+  uintptr_t		Addr;		/* link time address */
+  const char		*File;
+  int			Line;		/* 0 for the end of a sequence */
+} tRow;
+
+typedef struct {
+  char			*Path;
+  uintptr_t		Base;		/* load bias */
+  uintptr_t		Lo,Hi;		/* mapped address range */
+  void			*pMap;
+  size_t		MapLen;
+  tSym			*pSym;
+  int			NSym;
+  tRow			*pRow;
+  int			NRow;
+  int			MaxRow;
+} tObj;
+
+/* the sections we need from an object file
+ */
+typedef struct {
+  const u8		*pLine,*pStr,*pLineStr;
+  size_t		NLine,NStr,NLineStr;
+} tDwarf;
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static pthread_once_t	lOnce=PTHREAD_ONCE_INIT;
+static tObj		lObjs[MAXOBJS];
+static int		lNObjs=0;
+static volatile int	lReady=0;	/* tables complete */
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  DWARF reading helpers, p is advanced
+ */
+static u64 ULeb(const u8 **pp, const u8 *pEnd)
+{
+  u64		v=0;
+  int		s=0;
+
+  while(*pp<pEnd){
+    u8 b=*(*pp)++;
+    if(s<64)
+      v|=(u64)(b&0x7f)<<s;
+    s+=7;
+    if(!(b&0x80))
+      break;
+  }
+
+  return v;
+}
+
+static s64 SLeb(const u8 **pp, const u8 *pEnd)
+{
+  s64		v=0;
+  int		s=0;
+  u8		b=0;
+
+  while(*pp<pEnd){
+    b=*(*pp)++;
+    if(s<64)
+      v|=(s64)(b&0x7f)<<s;
+    s+=7;
+    if(!(b&0x80))
+      break;
+  }
+  if(s<64 && (b&0x40))
+    v|=-((s64)1<<s);
+
+  return v;
+}
+
+static u64 Fixed(const u8 **pp, int n)
+{
+  u64		v=0;
+
+  memcpy(&v,*pp,n);		/* little endian hosts only */
+  *pp+=n;
+
+  return v;
+}
+
+
+/****************************************************************************/
+/*  read an attribute of a DWARF 5 directory or file entry
+ *
+ *  \return the string for string forms, else NULL. *pOk is cleared for
+ *          unsupported forms
+ */
+static const char *Form(const tDwarf *pD, int Form, int OffSize,
+			const u8 **pp, const u8 *pEnd, bool *pOk)
+{
+  const char	*s=NULL;
+  u64		o;
+
+  switch(Form){
+  case DW_FORM_string:
+    s=(const char*)*pp;
+    *pp+=strnlen(s,pEnd-*pp)+1;
+    break;
+  case DW_FORM_strp:
+  case DW_FORM_line_strp:
+    o=Fixed(pp,OffSize);
+    if(Form==DW_FORM_strp && o<pD->NStr)
+      s=(const char*)pD->pStr+o;
+    if(Form==DW_FORM_line_strp && o<pD->NLineStr)
+      s=(const char*)pD->pLineStr+o;
+    break;
+  case DW_FORM_udata:	ULeb(pp,pEnd);		break;
+  case DW_FORM_data1:	*pp+=1;			break;
+  case DW_FORM_data2:	*pp+=2;			break;
+  case DW_FORM_data4:	*pp+=4;			break;
+  case DW_FORM_data8:	*pp+=8;			break;
+  case DW_FORM_data16:	*pp+=16;		break;
+  case DW_FORM_block:	o=ULeb(pp,pEnd); *pp+=o; break;
+  default:
+    *pOk=FALSE;
+  }
+
+  return s;
+}
+
+
+/****************************************************************************/
+/*  append a row to the line table of an object
+ */
+static void AddRow(tObj *pObj, uintptr_t Addr, const char *File, int Line)
+{
+  if(pObj->NRow==pObj->MaxRow){
+    pObj->MaxRow=pObj->MaxRow?2*pObj->MaxRow:1024;
+    pObj->pRow=realloc(pObj->pRow,pObj->MaxRow*sizeof(tRow));  MUST(pObj->pRow);
+  }
+  pObj->pRow[pObj->NRow].Addr=Addr;
+  pObj->pRow[pObj->NRow].File=File;
+  pObj->pRow[pObj->NRow].Line=Line;
+  pObj->NRow++;
+}
+
+
+/****************************************************************************/
+/*  run the line program of one unit of .debug_line
+ *
+ *  \return start of the next unit, NULL on errors
+ */
+static const u8 *LineUnit(tObj *pObj, const tDwarf *pD, const u8 *p)
+{
+  const u8	*end,*prog,*pe=pD->pLine+pD->NLine,*lens,*fmt;
+  const char	**files=NULL,*s,*name;
+  u64		len;
+  int		ver,offsize=4,minlen,lbase,lrange,opbase,nfmt,nfiles=0;
+  int		i,j,op,file,line;
+  uintptr_t	addr;
+  bool		ok=TRUE;
+
+  len=Fixed(&p,4);
+  if(len==0xffffffff){
+    len=Fixed(&p,8);
+    offsize=8;
+  }
+  if(len>(u64)(pe-p))
+    return NULL;
+  end=p+len;
+
+  ver=Fixed(&p,2);
+  if(ver<2 || ver>5)
+    return end;
+  if(ver>=5)
+    p+=2;			/* address_size, segment_selector_size */
+  prog=p+offsize;
+  prog+=Fixed(&p,offsize);
+  minlen=*p++;
+  if(ver>=4)
+    p++;			/* maximum_operations_per_instruction */
+  p++;				/* default_is_stmt */
+  lbase=(s8)*p++;
+  lrange=*p++;
+  opbase=*p++;
+  lens=p;
+  p+=opbase-1;
+  if(!lrange || prog>end)
+    return end;
+
+  /* file names */
+  if(ver<5){
+    while(p<prog && *p)		/* include_directories */
+      p+=strnlen((const char*)p,prog-p)+1;
+    p++;
+    for(fmt=p;p<prog && *p;nfiles++){
+      p+=strnlen((const char*)p,prog-p)+1;
+      ULeb(&p,prog); ULeb(&p,prog); ULeb(&p,prog);
+    }
+    files=calloc(nfiles+1,sizeof(*files));  MUST(files);
+    files[0]=NULL;		/* file numbers start with 1 */
+    for(p=fmt,i=1;i<=nfiles;i++){
+      files[i]=(const char*)p;
+      p+=strlen((const char*)p)+1;
+      ULeb(&p,prog); ULeb(&p,prog); ULeb(&p,prog);
+    }
+    nfiles++;
+  }
+  else{
+    nfmt=*p++;			/* directories: skip */
+    fmt=p;
+    for(i=0;i<nfmt;i++){
+      ULeb(&p,prog); ULeb(&p,prog);
+    }
+    len=ULeb(&p,prog);
+    for(i=0;i<(int)len && ok;i++){
+      const u8 *f=fmt;
+      for(j=0;j<nfmt;j++){
+	ULeb(&f,prog);
+	Form(pD,ULeb(&f,prog),offsize,&p,prog,&ok);
+      }
+    }
+    nfmt=*p++;			/* files */
+    fmt=p;
+    for(i=0;i<nfmt;i++){
+      ULeb(&p,prog); ULeb(&p,prog);
+    }
+    nfiles=ULeb(&p,prog);
+    files=calloc(nfiles+1,sizeof(*files));  MUST(files);
+    for(i=0;i<nfiles && ok;i++){
+      const u8 *f=fmt;
+      for(j=0;j<nfmt;j++){
+	int ct=ULeb(&f,prog);
+	s=Form(pD,ULeb(&f,prog),offsize,&p,prog,&ok);
+	if(ct==DW_LNCT_path)
+	  files[i]=s;
+      }
+    }
+    if(!ok){
+      free(files);
+      return end;
+    }
+  }
+
+  /* the line program */
+  p=prog;
+  addr=0; file=1; line=1;
+  while(p<end){
+    op=*p++;
+    if(op>=opbase){
+      op-=opbase;
+      addr+=(op/lrange)*minlen;
+      line+=lbase+op%lrange;
+    }
+    else if(op==0){
+      len=ULeb(&p,end);
+      if(!len || len>(u64)(end-p))
+	break;
+      op=*p;
+      if(op==DW_LNE_end_sequence){
+	AddRow(pObj,addr,NULL,0);
+	addr=0; file=1; line=1;
+      }
+      else if(op==DW_LNE_set_address){
+	const u8 *q=p+1;
+	addr=Fixed(&q,MIN((int)len-1,(int)sizeof(addr)));
+      }
+      p+=len;
+      continue;
+    }
+    else{
+      switch(op){
+      case DW_LNS_copy:
+	break;
+      case DW_LNS_advance_pc:
+	addr+=ULeb(&p,end)*minlen;
+	continue;
+      case DW_LNS_advance_line:
+	line+=SLeb(&p,end);
+	continue;
+      case DW_LNS_set_file:
+	file=ULeb(&p,end);
+	continue;
+      case DW_LNS_const_add_pc:
+	addr+=((255-opbase)/lrange)*minlen;
+	continue;
+      case DW_LNS_fixed_advance_pc:
+	addr+=Fixed(&p,2);
+	continue;
+      default:			/* skip the operands */
+	for(i=0;i<lens[op-1];i++)
+	  ULeb(&p,end);
+	continue;
+      }
+    }
+    name=file>=0 && file<nfiles?files[file]:NULL;
+    AddRow(pObj,addr,name,line);
+  }
+
+  free(files);
+
+  return end;
+}
+
+
+/****************************************************************************/
+/*  qsort comparators
+ */
+static int CmpSym(const void *pa, const void *pb)
+{
+  const tSym	*a=pa,*b=pb;
+
+  return a->Addr<b->Addr?-1:a->Addr>b->Addr;
+}
+
+static int CmpRow(const void *pa, const void *pb)
+{
+  const tRow	*a=pa,*b=pb;
+
+  if(a->Addr!=b->Addr)
+    return a->Addr<b->Addr?-1:1;
+  /* end of sequence before the start of the next one */
+  return (a->Line!=0)-(b->Line!=0);
+}
+
+
+/****************************************************************************/
+/*  read symbols and line tables of a mapped object file
+ */
+static void ParseElf(tObj *pObj)
+{
+  const u8		*pf=pObj->pMap;
+  const ElfW(Ehdr)	*eh=(const ElfW(Ehdr)*)pf;
+  const ElfW(Shdr)	*sh,*symtab=NULL,*dynsym=NULL,*tab;
+  const ElfW(Sym)	*ps;
+  const char		*shstr,*name,*str;
+  tDwarf		d;
+  const u8		*p;
+  int			i,n;
+
+  if(pObj->MapLen<sizeof(*eh) || memcmp(eh->e_ident,ELFMAG,SELFMAG) ||
+     eh->e_ident[EI_CLASS]!=(sizeof(void*)==8?ELFCLASS64:ELFCLASS32) ||
+     !eh->e_shoff || eh->e_shstrndx>=eh->e_shnum ||
+     eh->e_shoff+eh->e_shnum*sizeof(*sh)>pObj->MapLen)
+    return;
+
+  sh=(const ElfW(Shdr)*)(pf+eh->e_shoff);
+  shstr=(const char*)pf+sh[eh->e_shstrndx].sh_offset;
+  memset(&d,0,sizeof(d));
+
+  for(i=0;i<eh->e_shnum;i++){
+    if(sh[i].sh_type==SHT_NOBITS || sh[i].sh_offset+sh[i].sh_size>pObj->MapLen)
+      continue;
+    name=shstr+sh[i].sh_name;
+    if(sh[i].sh_type==SHT_SYMTAB)
+      symtab=&sh[i];
+    else if(sh[i].sh_type==SHT_DYNSYM)
+      dynsym=&sh[i];
+    else if(sh[i].sh_flags&SHF_COMPRESSED)
+      continue;
+    else if(!strcmp(name,".debug_line")){
+      d.pLine=pf+sh[i].sh_offset;
+      d.NLine=sh[i].sh_size;
+    }
+    else if(!strcmp(name,".debug_str")){
+      d.pStr=pf+sh[i].sh_offset;
+      d.NStr=sh[i].sh_size;
+    }
+    else if(!strcmp(name,".debug_line_str")){
+      d.pLineStr=pf+sh[i].sh_offset;
+      d.NLineStr=sh[i].sh_size;
+    }
+  }
+
+  /* function symbols */
+  if((tab=symtab?symtab:dynsym) && tab->sh_link<eh->e_shnum){
+    ps=(const ElfW(Sym)*)(pf+tab->sh_offset);
+    str=(const char*)pf+sh[tab->sh_link].sh_offset;
+    n=tab->sh_size/sizeof(*ps);
+    pObj->pSym=malloc(n*sizeof(tSym));  MUST(pObj->pSym);
+    for(i=0;i<n;i++,ps++){
+      if((ELF64_ST_TYPE(ps->st_info)!=STT_FUNC &&
+	  ELF64_ST_TYPE(ps->st_info)!=STT_GNU_IFUNC) ||
+	 !ps->st_value || ps->st_shndx==SHN_UNDEF)
+	continue;
+      pObj->pSym[pObj->NSym].Addr=ps->st_value;
+      pObj->pSym[pObj->NSym].Size=ps->st_size;
+      pObj->pSym[pObj->NSym].Name=str+ps->st_name;
+      pObj->NSym++;
+    }
+    qsort(pObj->pSym,pObj->NSym,sizeof(tSym),CmpSym);
+  }
+
+  /* line tables */
+  for(p=d.pLine;p && p+4<=d.pLine+d.NLine;)
+    p=LineUnit(pObj,&d,p);
+  if(pObj->NRow)
+    qsort(pObj->pRow,pObj->NRow,sizeof(tRow),CmpRow);
+}
+
+
+/****************************************************************************/
+/*  callback of dl_iterate_phdr: register and parse one object
+ */
+static int AddObj(struct dl_phdr_info *pInfo, size_t Size, void *pUndef)
+{
+  tObj		*po;
+  struct stat	st;
+  char		exe[256];
+  const char	*path=pInfo->dlpi_name;
+  int		i,fd;
+  ssize_t	n;
+
+  (void)Size; (void)pUndef;
+
+  if(lNObjs==MAXOBJS)
+    return 1;
+
+  if(!path || !*path){
+    if((n=readlink("/proc/self/exe",exe,sizeof(exe)-1))<=0)
+      return 0;
+    exe[n]=0;
+    path=exe;
+  }
+
+  po=&lObjs[lNObjs];
+  memset(po,0,sizeof(*po));
+  po->Base=pInfo->dlpi_addr;
+  po->Lo=~(uintptr_t)0;
+  for(i=0;i<pInfo->dlpi_phnum;i++){
+    if(pInfo->dlpi_phdr[i].p_type!=PT_LOAD)
+      continue;
+    po->Lo=MIN(po->Lo,po->Base+pInfo->dlpi_phdr[i].p_vaddr);
+    po->Hi=MAX(po->Hi,po->Base+pInfo->dlpi_phdr[i].p_vaddr+
+	       pInfo->dlpi_phdr[i].p_memsz);
+  }
+  if(po->Lo>=po->Hi)
+    return 0;
+
+  po->Path=strdup(path);  MUST(po->Path);
+  if((fd=open(path,O_RDONLY))>=0){
+    if(fstat(fd,&st)==0 && st.st_size>0){
+      po->MapLen=st.st_size;
+      po->pMap=mmap(NULL,po->MapLen,PROT_READ,MAP_PRIVATE,fd,0);
+      if(po->pMap==MAP_FAILED)
+	po->pMap=NULL;
+      else
+	ParseElf(po);
+    }
+    close(fd);
+  }
+  lNObjs++;
+
+  return 0;
+}
+
+
+/****************************************************************************/
+/*  build all tables, run once
+ */
+static void Init(void)
+{
+  void		*bt[2];
+
+  backtrace(bt,LEN(bt));	/* loads libgcc_s now, not in a handler */
+  dl_iterate_phdr(AddObj,NULL);
+  __atomic_store_n(&lReady,1,__ATOMIC_RELEASE);
+}
+
+
+/****************************************************************************/
+/*  async signal safe output helpers
+ */
+static char *PutS(char *p, char *pEnd, const char *s)
+{
+  while(*s && p<pEnd)
+    *p++=*s++;
+  return p;
+}
+
+static char *PutNum(char *p, char *pEnd, u64 v, int Base)
+{
+  char		buf[24];
+  int		n=0;
+
+  do{
+    buf[n++]="0123456789abcdef"[v%Base];
+    v/=Base;
+  }while(v);
+  if(Base==16)
+    p=PutS(p,pEnd,"0x");
+  while(n && p<pEnd)
+    *p++=buf[--n];
+
+  return p;
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/** parse the symbols and line tables of all loaded objects. has to be
+ *  called before the first lookup in a signal handler, for other callers
+ *  it is done on demand. objects loaded later are not known
+ */
+void Sym_Init(void)
+{
+  pthread_once(&lOnce,Init);
+}
+
+
+/****************************************************************************/
+/** find function and source line of a code address. async signal safe
+ *  after Sym_Init(), before it nothing is found
+ *
+ *  \param  pAddr the address, for return addresses pass the address of
+ *                the call, i.e. the return address -1
+ *  \param  pInfo the result
+ *  \return TRUE if at least the object was found
+ */
+bool Sym_Lookup(const void *pAddr, tSymInfo *pInfo)
+{
+  const tObj	*po;
+  uintptr_t	a=(uintptr_t)pAddr;
+  int		i,lo,hi,m;
+
+  memset(pInfo,0,sizeof(*pInfo));
+  if(!__atomic_load_n(&lReady,__ATOMIC_ACQUIRE))
+    return FALSE;
+
+  for(i=0,po=lObjs;i<lNObjs;i++,po++)
+    if(a>=po->Lo && a<po->Hi)
+      break;
+  if(i==lNObjs)
+    return FALSE;
+
+  pInfo->Obj=po->Path;
+  a-=po->Base;
+
+  /* last symbol <= a */
+  for(lo=0,hi=po->NSym;lo<hi;){
+    m=(lo+hi)/2;
+    if(po->pSym[m].Addr<=a)
+      lo=m+1;
+    else
+      hi=m;
+  }
+  if(lo && (!po->pSym[lo-1].Size || a<po->pSym[lo-1].Addr+po->pSym[lo-1].Size)){
+    pInfo->Func=po->pSym[lo-1].Name;
+    pInfo->Off=a-po->pSym[lo-1].Addr;
+  }
+
+  /* last row <= a */
+  for(lo=0,hi=po->NRow;lo<hi;){
+    m=(lo+hi)/2;
+    if(po->pRow[m].Addr<=a)
+      lo=m+1;
+    else
+      hi=m;
+  }
+  if(lo && po->pRow[lo-1].Line){
+    pInfo->File=po->pRow[lo-1].File;
+    pInfo->Line=po->pRow[lo-1].Line;
+  }
+
+  return TRUE;
+}
+
+
+/****************************************************************************/
+/** print a stack trace from a list of return addresses in the format
+ *  "file:line: func() @ addr". async signal safe after Sym_Init()
+ *
+ *  \param  Fd     file descriptor for write()
+ *  \param  ppAddr the return addresses as returned by backtrace()
+ *  \param  N      number of addresses
+ */
+void Sym_PrintFrames(int Fd, void *const *ppAddr, int N)
+{
+  char		buf[512],*p,*e=buf+sizeof(buf)-1;
+  const char	*s;
+  tSymInfo	si;
+  int		i;
+
+  for(i=0;i<N;i++){
+    p=buf;
+    Sym_Lookup((const u8*)ppAddr[i]-1,&si);
+    if(si.File){
+      s=strrchr(si.File,'/');
+      p=PutS(p,e,s?s+1:si.File);
+      p=PutS(p,e,":");
+      p=PutNum(p,e,si.Line,10);
+    }
+    else if(si.Obj){
+      s=strrchr(si.Obj,'/');
+      p=PutS(p,e,s?s+1:si.Obj);
+    }
+    else
+      p=PutS(p,e,"??");
+    p=PutS(p,e,": ");
+    if(si.Func){
+      p=PutS(p,e,si.Func);
+      p=PutS(p,e,"()");
+      if(!si.File){
+	p=PutS(p,e,"+");
+	p=PutNum(p,e,si.Off+1,16);
+      }
+    }
+    else
+      p=PutS(p,e,"??");
+    p=PutS(p,e," @ ");
+    p=PutNum(p,e,(uintptr_t)ppAddr[i],16);
+    *p++='\n';
+    if(write(Fd,buf,p-buf)<0)
+      return;
+  }
+}
+
+
+/****************************************************************************/
+/** print a stack trace of the caller. async signal safe after Sym_Init()
+ *
+ *  \param  Fd   file descriptor for write()
+ *  \param  Skip number of innermost frames to skip (0 is the caller)
+ */
+void Sym_PrintTrace(int Fd, int Skip)
+{
+  void		*bt[MAXFRAMES];
+  int		n;
+
+  n=backtrace(bt,LEN(bt));
+  Skip++;			/* ourselves */
+  if(n>Skip)
+    Sym_PrintFrames(Fd,bt+Skip,n-Skip);
+}
+
+#endif /* LINUX_GNU */
@@ -0,0 +1,49 @@
+/* -*- tab-width: 8 -*- */
+/** 
+ *  in process symbolizer for stack traces: the ELF symbol tables and DWARF
+ *  line tables of all loaded objects are parsed once by Sym_Init(),
+ *  afterwards lookups and printing are async signal safe (no malloc, no
+ *  stdio, no locks), so they can be used from a signal handler
+ *
+ *  \file      symtab.h
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#ifndef SYMTAB_H
+#define SYMTAB_H
+
+#include	"basic.h"
+#include	<stddef.h>
+
+
+/*****************************************************************************
+ *  types
+ ****************************************************************************/
+
+/** result of Sym_Lookup()
+ */
+typedef struct {
+  const char	*Obj;		/**< path of the object file */
+  const char	*Func;		/**< function name (not demangled) or NULL */
+  size_t	Off;		/**< offset of the address in Func */
+  const char	*File;		/**< source file or NULL */
+  int		Line;		/**< source line, 0 if unknown */
+} tSymInfo;
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+EXTERN_C_BEGIN
+
+void Sym_Init(void);
+bool Sym_Lookup(const void *pAddr, tSymInfo *pInfo);
+void Sym_PrintFrames(int Fd, void *const *ppAddr, int N);
+void Sym_PrintTrace(int Fd, int Skip);
+
+EXTERN_C_END
+
+#endif /* SYMTAB_H */
@@ -0,0 +1,254 @@
+/* -*- tab-width: 8 -*- */
+/** 
+ *  test: the inline bitfield accessors of bits.h against the macros, for
+ *  every field m..l of 32 and 64 bits and a set of edge and random values.
+ *  the reference is plain 64 bit math, the macros are compared too where
+ *  they are defined: their int masks overflow for fields of 31 and 32 bits
+ *  and SETBITS also for fields up to bit 31.
+ *  bitsSet32 masks the inserted value, so SETBITS gets it masked. pext and
+ *  pdep are checked against a bit by bit loop
+ *
+ *	test_bits
+ *
+ *  \file      test_bits.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"nuts/bits.h"
+#include	<stdio.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define NRAND		2000		/* random values besides the edges */
+
+#define CHECK(c,...)	do{ if(!(c)){ if(lFails++<10){			\
+	  printf("FAIL %s:%d: ",__FILE__,__LINE__); printf(__VA_ARGS__);	\
+	  printf("\n"); } } }while(0)
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static int		lFails;
+static u64		lVals[64+64+8+NRAND];
+static int		lNVals;
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  xorshift64*, repeatable
+ */
+static u64 Rand(void)
+{
+  static u64	s=0x9e3779b97f4a7c15ull;
+
+  s^=s>>12;  s^=s<<25;  s^=s>>27;
+  return s*0x2545f4914f6cdd1dull;
+}
+
+
+/****************************************************************************/
+/*  single bits, all ones but one, patterns and random values
+ */
+static void InitVals(void)
+{
+  static const u64	pat[]={0,~0ull,0x5555555555555555ull,
+				0xaaaaaaaaaaaaaaaaull,0x0123456789abcdefull,
+				0xfedcba9876543210ull,0x00000000ffffffffull,
+				0xffffffff00000000ull};
+  int			i;
+
+  for(i=0;i<64;i++){
+    lVals[lNVals++]=1ull<<i;
+    lVals[lNVals++]=~(1ull<<i);
+  }
+  for(i=0;i<8;i++)
+    lVals[lNVals++]=pat[i];
+  for(i=0;i<NRAND;i++)
+    lVals[lNVals++]=Rand();
+}
+
+
+/****************************************************************************/
+/*  the lowest n bits, n 0..64
+ */
+static u64 Mask(int n)
+{
+  return n>=64?~0ull:(1ull<<n)-1;
+}
+
+
+/****************************************************************************/
+/*  sign extend the lowest w bits of v
+ */
+static s32 Sext(u32 v, int w)
+{
+  return (s32)(u32)(v>>(w-1)&1?v|~Mask(w):v);
+}
+
+
+/****************************************************************************/
+/*  pext/pdep, one bit a time
+ */
+static u64 RefPext(u64 v, u64 mask)
+{
+  u64		r=0;
+  int		b,o=0;
+
+  for(b=0;b<64;b++)
+    if(mask>>b&1)
+      r|=(v>>b&1)<<o++;
+  return r;
+}
+
+static u64 RefPdep(u64 v, u64 mask)
+{
+  u64		r=0;
+  int		b,o=0;
+
+  for(b=0;b<64;b++)
+    if(mask>>b&1)
+      r|=(v>>o++&1)<<b;
+  return r;
+}
+
+
+/****************************************************************************/
+/*  all fields of 32 bits
+ */
+static void Test32(void)
+{
+  int		m,l,w,i,j;
+  u32		v,x,f,ins,ref;
+
+  for(m=0;m<32;m++)
+    for(l=0;l<=m;l++)
+      for(i=0;i<lNVals;i++){
+	v=(u32)lVals[i];
+	x=(u32)lVals[(i*7+1)%lNVals];
+	w=m-l+1;
+	f=v>>l&Mask(w);
+	ins=(u32)(x&Mask(w));
+	CHECK(bitsU32(v,m,l)==f,"bitsU32(%08x,%d,%d)=%08x",v,m,l,
+	      bitsU32(v,m,l));
+	CHECK(bitsS32(v,m,l)==Sext(f,w),"bitsS32(%08x,%d,%d)=%08x",v,m,l,
+	      bitsS32(v,m,l));
+	CHECK(bitsSet32(v,m,l,x)==(u32)((v&~(Mask(w)<<l))|(u64)ins<<l),
+	      "bitsSet32(%08x,%d,%d,%08x)=%08x",v,m,l,x,bitsSet32(v,m,l,x));
+	if(w<=30){
+	  CHECK(bitsU32(v,m,l)==(u32)BITS(v,m,l),"BITS(%08x,%d,%d)",v,m,l);
+	  CHECK(bitsS32(v,m,l)==(s32)SBITS(v,m,l),"SBITS(%08x,%d,%d)",v,m,l);
+	}
+	if(w<=30 && m<=30){
+	  ref=v;
+	  SETBITS(ref,m,l,ins);
+	  CHECK(bitsSet32(v,m,l,x)==ref,"SETBITS(%08x,%d,%d,%08x)",v,m,l,x);
+	}
+      }
+
+  for(w=1;w<=32;w++)
+    for(i=0;i<lNVals;i++){
+      v=(u32)(lVals[i]&Mask(w));
+      CHECK(sgnExt32(v,w)==Sext(v,w),"sgnExt32(%08x,%d)=%08x",v,w,
+	    sgnExt32(v,w));
+      if(w<=30)
+	CHECK(sgnExt32(v,w)==(s32)SGNEXT(v,w),"SGNEXT(%08x,%d)",v,w);
+    }
+
+  for(i=0;i<lNVals;i++)
+    for(j=0;j<64;j++){
+      v=(u32)lVals[i];
+      x=(u32)lVals[(i+j*31)%lNVals];
+      CHECK(bitsPext32(v,x)==(u32)RefPext(v,x),"bitsPext32(%08x,%08x)",v,x);
+      CHECK(bitsPdep32(v,x)==(u32)RefPdep(v,x),"bitsPdep32(%08x,%08x)",v,x);
+    }
+}
+
+
+/****************************************************************************/
+/*  all fields of 64 bits
+ */
+static void Test64(void)
+{
+  int		m,l,w,i,j;
+  u64		v,x,f,ref;
+
+  for(m=0;m<64;m++)
+    for(l=0;l<=m;l++)
+      for(i=0;i<lNVals;i+=3){
+	v=lVals[i];
+	x=lVals[(i*7+1)%lNVals];
+	w=m-l+1;
+	f=v>>l&Mask(w);
+	CHECK(bitsU64(v,m,l)==BITS64(v,m,l),"bitsU64(%llx,%d,%d)",
+	      (unsigned long long)v,m,l);
+	CHECK(bitsU64(v,m,l)==f,"bitsU64(%llx,%d,%d)",
+	      (unsigned long long)v,m,l);
+	ref=f>>(w-1)&1?f|~Mask(w):f;
+	CHECK((u64)bitsS64(v,m,l)==ref,"bitsS64(%llx,%d,%d)",
+	      (unsigned long long)v,m,l);
+	ref=(v&~(Mask(w)<<l))|(x&Mask(w))<<l;
+	CHECK(bitsSet64(v,m,l,x)==ref,"bitsSet64(%llx,%d,%d,%llx)",
+	      (unsigned long long)v,m,l,(unsigned long long)x);
+      }
+
+  for(w=1;w<=64;w++)
+    for(i=0;i<lNVals;i++){
+      v=lVals[i]&Mask(w);
+      ref=v>>(w-1)&1?v|~Mask(w):v;
+      CHECK((u64)sgnExt64(v,w)==ref,"sgnExt64(%llx,%d)",
+	    (unsigned long long)v,w);
+    }
+
+  for(i=0;i<lNVals;i++)
+    for(j=0;j<64;j++){
+      v=lVals[i];
+      x=lVals[(i+j*31)%lNVals];
+      CHECK(bitsPext64(v,x)==RefPext(v,x),"bitsPext64(%llx,%llx)",
+	    (unsigned long long)v,(unsigned long long)x);
+      CHECK(bitsPdep64(v,x)==RefPdep(v,x),"bitsPdep64(%llx,%llx)",
+	    (unsigned long long)v,(unsigned long long)x);
+    }
+}
+
+
+/****************************************************************************/
+/*  the checked wrappers with constant fields
+ */
+static void TestChecked(void)
+{
+  u32		v=0x89abcdef;
+  u64		v64=0x0123456789abcdefull;
+
+  CHECK(UBITS32(v,7,4)==0xe,"UBITS32");
+  CHECK(SBITS32(v,31,28)==-8,"SBITS32");
+  CHECK(SETBITS32(v,15,8,0x1ff)==0x89abffef,"SETBITS32");
+  CHECK(UBITS64(v64,63,32)==0x01234567,"UBITS64");
+  CHECK(SBITS64(v64,31,24)==-119,"SBITS64");
+  CHECK(SETBITS64(v64,3,0,0)==0x0123456789abcde0ull,"SETBITS64");
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+int main(void)
+{
+  InitVals();
+  Test32();
+  Test64();
+  TestChecked();
+
+  printf("test_bits: %d failures\n",lFails);
+  return lFails!=0;
+}
@@ -0,0 +1,1169 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  test: the pic kernels against a scalar reference and golden hashes.
+ *  every kernel runs on random pics of odd and even sizes in three layouts:
+ *  packed, with a stride of some more pels, and as a Pic_Create() window
+ *  inside a larger pic. all buffers have guard bytes around them.
+ *
+ *  the reference runs on a second set of buffers with the same layout and
+ *  pels, then the whole buffers are compared, so writes to the padding or
+ *  the guards are found too. the references are plain loops, for the YUV
+ *  to RGB conversions they are the scalar tail of the kernel itself, run
+ *  on strips narrower than its SIMD width. the output pels and the return
+ *  values of all sizes are hashed per kernel: the hash must not depend on
+ *  the layout and must match the golden one in test_pic_golden.h, which
+ *  is made with "test_pic -g" (little endian hosts only)
+ *
+ *	test_pic [-g]
+ *
+ *  \file      test_pic.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"nuts/debug.h"
+#include	"nuts/pic.h"
+#include	<limits.h>
+#include	<stdarg.h>
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<unistd.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+/* roles of a kernel: bytes per pel of D, A and B, or'ed with */
+#define FRAME		0x100		/* 8 bit 4:2:0 frame, Y then chroma */
+#define EVEN		0x200		/* width rounded up to even */
+#define PADDED		0x400		/* PADN pels around it in all layouts */
+#define BPP(r)		((r)&0xff)
+
+#define PADN		2		/* pad of Pic8_Pad() */
+#define STRIP		14		/* below the 16 pels of the SIMD loop */
+#define GUARD		64		/* bytes before and after each buffer */
+#define NORET		LONG_MIN	/* reference has no return value */
+
+#define CW		(2*((lDx+1)/2))	/* chroma line of a frame, in bytes */
+#define CH		((lDy+1)/2)	/* chroma lines of a frame */
+
+#define PEL(p,x,y,b)	((p)->Pel+(long)(y)*(p)->S+(long)(x)*(b))
+#define FOR_PELS(p)	for(y=0;y<(p)->Dy;y++) for(x=0;x<(p)->Dx;x++)
+
+/* functions of the YUV to RGB kernels, in Arg>>8 */
+enum { Y_RGBX, Y_BGRX, Y_565, C_RGBX, C_BGRX, C_565 };
+#define VU		0x10		/* Arg: NV21, V first */
+
+/* file round trips, in Arg */
+enum { F_8, F_8A, F_16, F_16A, F_16N, F_16O, F_8O, F_32, F_XRGB, F_RGBX,
+       F_BGRX, F_RAW, F_ROI, F_SHL, F_UNI, F_NQI8, F_NQI16, F_NQI32,
+       F_YUV, F_YC, F_YROI };
+
+enum { L_PACKED, L_STRIDE, L_WINDOW, L_N };
+
+
+/*****************************************************************************
+ *  local types
+ ****************************************************************************/
+
+/* a kernel on D, A and B, see tKernel */
+typedef long tRun(tPic *p[3]);
+
+typedef struct {
+  const char	*Name;
+  int		Role[3];	/* D, A, B, 0 if not used */
+  u32		Arg;		/* value, shift, mode, ... of the kernel */
+  tRun		*pRun,*pRef;	/* pRef NULL: golden hash only */
+} tKernel;
+
+typedef struct {
+  const char	*Name;
+  u64		Hash;
+} tGolden;
+
+/* a pic with its buffer, see ImgAlloc() */
+typedef struct {
+  u8		*pBuf;
+  long		N;
+  tPic		Pic;
+} tImg;
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+#include	"test_pic_golden.h"
+
+static const int	lSize[][2]={{1,1},{2,3},{7,5},{16,4},{33,7},{67,3}};
+static const char	*lLayout[L_N]={"packed","stride","window"};
+
+static const tKernel	*lK;		/* the running kernel */
+static int		lDx,lDy;	/* the size it runs at */
+static int		lFails;
+static char		lDir[]="/tmp/test_picXXXXXX";
+static char		lFile[64];
+
+
+/*****************************************************************************
+ *  local functions: helpers
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  report a failure of the running kernel
+ */
+static void Fail(int Layout, const char *Fmt, ...)
+{
+  va_list	ap;
+
+  if(lFails++<20){
+    printf("FAIL %s %dx%d %s: ",lK->Name,lDx,lDy,lLayout[Layout]);
+    va_start(ap,Fmt);
+    vprintf(Fmt,ap);
+    va_end(ap);
+    printf("\n");
+  }
+}
+
+
+/****************************************************************************/
+/*  allocate the pic of a role in a layout, the pels random, the rest a
+ *  value of the seed, so a copy of padding is seen. the pels are always
+ *  aligned to their size
+ */
+static void ImgAlloc(tImg *pThat, int Role, int Layout, u32 Seed)
+{
+  int		bpp=BPP(Role),dx=lDx,dy=lDy,m=0,w,s;
+
+  if(Role&FRAME){
+    bpp=1;  dx=CW;  dy=lDy+CH;
+  }
+  if(Role&EVEN)
+    dx=CW;
+  if(Role&PADDED)
+    m=PADN;
+
+  switch(Layout){
+  case L_PACKED:  w=dx+2*m;  break;
+  case L_STRIDE:  w=dx+2*m+3;  break;
+  default:  w=dx+2*m+7;  m+=2;
+  }
+  s=w*bpp;
+
+  pThat->N=(long)s*(dy+2*m)+2*GUARD;
+  pThat->pBuf=malloc(pThat->N);  MUST(pThat->pBuf);
+  memset(pThat->pBuf,(u8)(Seed*0x5b),pThat->N);
+  Pic_Create(&pThat->Pic,s,dx,dy,pThat->pBuf+GUARD+(long)m*s+
+	     (Layout==L_WINDOW?m+1:m)*bpp);
+  Pic_Random(&pThat->Pic,bpp,Seed);
+}
+
+
+/****************************************************************************/
+/*  the planes of a frame, see FRAME
+ */
+static void YuvOf(tYuv *pYuv, const tPic *pF)
+{
+  pYuv->Dx=lDx;
+  pYuv->Dy=lDy;
+  Pic_Create(&pYuv->C[0],pF->S,lDx,lDy,pF->Pel);
+  Pic_Create(&pYuv->C[1],pF->S,CW/2,CH,PEL(pF,0,lDy,1));
+  Pic_Create(&pYuv->C[2],pF->S,CW/2,CH,PEL(pF,CW/2,lDy,1));
+}
+
+static void YcOf(tYc *pYc, const tPic *pF)
+{
+  pYc->Dx=lDx;
+  pYc->Dy=lDy;
+  Pic_Create(&pYc->Y,pF->S,lDx,lDy,pF->Pel);
+  Pic_Create(&pYc->C,pF->S,CW,CH,PEL(pF,0,lDy,1));
+}
+
+
+/****************************************************************************/
+/*  a pel of 1, 2 or 4 bytes
+ */
+static u32 Get(const tPic *p, int x, int y, int b)
+{
+  const u8	*pp=PEL(p,x,y,b);
+
+  return b==1?*pp:b==2?*(const u16*)pp:*(const u32*)pp;
+}
+
+static void Put(tPic *p, int x, int y, int b, u32 v)
+{
+  u8		*pp=PEL(p,x,y,b);
+
+  if(b==1) *pp=v;
+  else if(b==2) *(u16*)pp=v;
+  else *(u32*)pp=v;
+}
+
+
+/****************************************************************************/
+/*  copy the pels of a pic allocated by a loader to D and free it
+ */
+static void Take(tPic *pD, tPic *pL, int b)
+{
+  int		y;
+
+  MUST_Eq(pL->Dx,pD->Dx);
+  MUST_Eq(pL->Dy,pD->Dy);
+  for(y=0;y<pD->Dy;y++)
+    memcpy(PEL(pD,0,y,b),PEL(pL,0,y,b),(size_t)pD->Dx*b);
+  Pic_Free(pL);
+}
+
+
+/****************************************************************************/
+/*  hash of the file written, as a return value
+ */
+static long FileHash(void)
+{
+  FILE		*file;
+  u64		h=0xcbf29ce484222325ull;
+  int		c;
+
+  file=fopen(lFile,"r");  MUST(file);
+  while((c=getc(file))!=EOF)
+    h=(h^c)*0x100000001b3ull;
+  fclose(file);
+  remove(lFile);
+
+  return (long)(h>>2);
+}
+
+
+/****************************************************************************/
+/*  a planar 4:2:0 file of a frame
+ */
+static void SaveI420(const tPic *pF)
+{
+  FILE		*file;
+  tYuv		yuv;
+  int		c,y;
+
+  YuvOf(&yuv,pF);
+  file=fopen(lFile,"w");  MUST(file);
+  for(c=0;c<3;c++)
+    for(y=0;y<yuv.C[c].Dy;y++)
+      MUST(fwrite(yuv.C[c].Pel+(long)y*yuv.C[c].S,yuv.C[c].Dx,1,file)==1);
+  fclose(file);
+}
+
+
+/*****************************************************************************
+ *  local functions: the kernels
+ ****************************************************************************/
+
+static long Copy(tPic *p[3])
+{
+  switch(BPP(lK->Role[0])){
+  case 1:  Pic8_Copy(p[0],p[1]);  break;
+  case 2:  Pic16_Copy(p[0],p[1]);  break;
+  case 3:  Pic24_Copy(p[0],p[1]);  break;
+  default:  Pic32_Copy(p[0],p[1]);
+  }
+  return 0;
+}
+
+static long Set(tPic *p[3])
+{
+  switch(BPP(lK->Role[0])){
+  case 1:
+    if(lK->Arg)
+      Pic8_Set(p[0],lK->Arg);
+    else
+      Pic8_Clear(p[0]);
+    break;
+  case 2:  Pic16_Set(p[0],lK->Arg);  break;
+  default:  Pic32_Set(p[0],lK->Arg);
+  }
+  return 0;
+}
+
+static long ShiftLeft(tPic *p[3])
+{
+  if(BPP(lK->Role[0])==1)
+    Pic8_ShiftLeft(p[0],lK->Arg);
+  else
+    Pic16_ShiftLeft(p[0],lK->Arg);
+  return 0;
+}
+
+static long CopyShift(tPic *p[3])
+{
+  switch(BPP(lK->Role[0])){
+  case 1:  Pic8_CopyU16Shr(p[0],p[1],lK->Arg);  break;
+  case 2:  Pic16_CopyU32Shr(p[0],p[1],lK->Arg);  break;
+  default:  Pic32_CopyU16Shl(p[0],p[1],lK->Arg);
+  }
+  return 0;
+}
+
+static long HorFlip(tPic *p[3])
+{
+  Pic_HorFlip(p[0]);
+  return 0;
+}
+
+static long Pack4444(tPic *p[3])
+{
+  Pic16_Pack4444(p[0],p[1]);
+  return 0;
+}
+
+static long Pack565(tPic *p[3])
+{
+  if(lK->Arg)
+    Pic16_Pack565_XRGB(p[0],p[1]);
+  else
+    Pic16_Pack565_RGBX(p[0],p[1]);
+  return 0;
+}
+
+static long UnPack565(tPic *p[3])
+{
+  Pic32_UnPack565(p[0],p[1]);
+  return 0;
+}
+
+static long FromU8(tPic *p[3])
+{
+  switch(lK->Arg){
+  case 0:  Pic32_RGBXfromU8(p[0],p[1]);  break;
+  case 1:  Pic32_XBGRfromU8(p[0],p[1]);  break;
+  default:  Pic16_BGRfromU8(p[0],p[1]);
+  }
+  return 0;
+}
+
+static long Rgb(tPic *p[3])
+{
+  switch(lK->Arg){
+  case 0:  Pic32_RGBXfromRGB(p[0],p[1]);  break;
+  case 1:  Pic32_RGBXfromBGR(p[0],p[1]);  break;
+  case 2:  Pic24_RGBfromRGBX(p[0],p[1]);  break;
+  default:  Pic24_BGRfromRGBX(p[0],p[1]);
+  }
+  return 0;
+}
+
+static long GenAlpha(tPic *p[3])
+{
+  const u8	*pc=PEL(p[0],lDx/2,lDy/2,4);
+
+  Pic32_GenAlpha(p[0],pc[1],pc[2],pc[3]);
+  return 0;
+}
+
+static long Sad(tPic *p[3])
+{
+  switch(BPP(lK->Role[1])){
+  case 1:  return Pic8_Sad8(p[0],p[1],p[2],lK->Arg);
+  case 2:  return Pic8_Sad16(p[0],p[1],p[2],lK->Arg);
+  default:  return Pic8_Sad32(p[0],p[1],p[2],lK->Arg);
+  }
+}
+
+/* the padded pic is hashed into the return value */
+static long Pad(tPic *p[3])
+{
+  tPic		w;
+
+  Pic8_Pad(p[0],PADN);
+  Pic_Create(&w,p[0]->S,lDx+2*PADN,lDy+2*PADN,
+	     p[0]->Pel-PADN*p[0]->S-PADN);
+  return (long)(Pic_Hash(&w,1)>>2);
+}
+
+static long DrawRect(tPic *p[3])
+{
+  int		x,y;
+
+  for(y=1;y<lDy-1;y+=3)
+    for(x=1;x<lDx-1;x+=4){
+      if(BPP(lK->Role[0])==2)
+	Pic16_DrawRect(p[0],x,y,0x1234+x);
+      else
+	Pic32_DrawRect(p[0],x,y,0x123456+x);
+    }
+  return 0;
+}
+
+static long DrawCross(tPic *p[3])
+{
+  int		x,y;
+
+  for(y=2;y<lDy-2;y+=5)
+    for(x=2;x<lDx-2;x+=5)
+      Pic16_DrawCross(p[0],x,y,0x4321+y);
+  return 0;
+}
+
+/* lines inside, across the borders, outside and of one point */
+static long DrawLine(tPic *p[3])
+{
+  const int	l[][4]={{0,0,lDx-1,lDy-1},{lDx-1,0,0,lDy-1},
+			{-3,lDy/2,lDx+2,lDy/3},{lDx/2,-5,lDx/3,lDy+4},
+			{-9,-9,-20,30},{1,1,1,1}};
+  int		i;
+
+  for(i=0;i<LEN(l);i++){
+    if(BPP(lK->Role[0])==2)
+      Pic16_DrawLine(p[0],l[i][0],l[i][1],l[i][2],l[i][3],0xabcd+i);
+    else
+      Pic32_DrawLine(p[0],l[i][0],l[i][1],l[i][2],l[i][3],0xabcdef00+i);
+  }
+  return 0;
+}
+
+/* the YUV to RGB conversion of lK on columns x0..x0+w-1, x0 even */
+static void YuvStrip(tPic *p[3], int x0, int w)
+{
+  tYuv		yuv;
+  tYc		yc;
+  tPic		d;
+  int		b=BPP(lK->Role[0]),m=lK->Arg&(PIC_BT709|PIC_FULL);
+  bool		vu=(lK->Arg&VU)!=0;
+
+  Pic_Create(&d,p[0]->S,w,lDy,PEL(p[0],x0,0,b));
+  if((lK->Arg>>8)<C_RGBX){
+    YuvOf(&yuv,p[1]);
+    Pic_Create(&yuv.C[0],yuv.C[0].S,w,lDy,yuv.C[0].Pel+x0);
+    Pic_Create(&yuv.C[1],yuv.C[1].S,(w+1)/2,CH,yuv.C[1].Pel+x0/2);
+    Pic_Create(&yuv.C[2],yuv.C[2].S,(w+1)/2,CH,yuv.C[2].Pel+x0/2);
+  }
+  else{
+    YcOf(&yc,p[1]);
+    Pic_Create(&yc.Y,yc.Y.S,w,lDy,yc.Y.Pel+x0);
+    Pic_Create(&yc.C,yc.C.S,2*((w+1)/2),CH,yc.C.Pel+x0);
+  }
+
+  switch(lK->Arg>>8){
+  case Y_RGBX:  Pic32_RGBXfromYuv(&d,&yuv,m);  break;
+  case Y_BGRX:  Pic32_BGRXfromYuv(&d,&yuv,m);  break;
+  case Y_565:  Pic16_RGB565fromYuv(&d,&yuv,m);  break;
+  case C_RGBX:  Pic32_RGBXfromYc(&d,&yc,m,vu);  break;
+  case C_BGRX:  Pic32_BGRXfromYc(&d,&yc,m,vu);  break;
+  default:  Pic16_RGB565fromYc(&d,&yc,m,vu);
+  }
+}
+
+static long YuvRgb(tPic *p[3])
+{
+  YuvStrip(p,0,lDx);
+  return 0;
+}
+
+static long YcFromYuv(tPic *p[3])
+{
+  tYuv		yuv;
+  tYc		yc;
+
+  YcOf(&yc,p[0]);
+  YuvOf(&yuv,p[1]);
+  if(lK->Arg&2)
+    Yc_Import(&yc,&yuv);
+  else
+    Yc_FromYuv(&yc,&yuv,lK->Arg&1);
+  return 0;
+}
+
+static long YuvFromYc(tPic *p[3])
+{
+  tYuv		yuv;
+  tYc		yc;
+
+  YuvOf(&yuv,p[0]);
+  YcOf(&yc,p[1]);
+  Yuv_FromYc(&yuv,&yc,lK->Arg&1);
+  return 0;
+}
+
+static long SwapUv(tPic *p[3])
+{
+  tYc		yc;
+
+  YcOf(&yc,p[0]);
+  Yc_SwapUv(&yc);
+  return 0;
+}
+
+static long YuyvFromYuv(tPic *p[3])
+{
+  tYuv		yuv;
+
+  YuvOf(&yuv,p[1]);
+  Pic16_YuyvFromYuv(p[0],&yuv,lK->Arg);
+  return 0;
+}
+
+/* B to the frame A and back to D */
+static long YuvFromYuyv(tPic *p[3])
+{
+  tYuv		yuv;
+
+  YuvOf(&yuv,p[1]);
+  Yuv_FromYuyv(&yuv,p[2],lK->Arg);
+  Pic16_YuyvFromYuv(p[0],&yuv,lK->Arg);
+  return 0;
+}
+
+/* save A, load into D */
+static long File(tPic *p[3])
+{
+  tPicFile	f;
+  tPic		l={0};
+  tYuv		yuv;
+  tYc		yc;
+  u8		*pb;
+  long		n;
+  FILE		*file;
+
+  switch(lK->Arg){
+  case F_8:  Pic8_Save(p[1],lFile);  Pic8_Load(&l,lFile);  break;
+  case F_8A:  Pic8_SaveA(p[1],lFile);  Pic8_Load(&l,lFile);  break;
+  case F_16:  Pic16_Save(p[1],lFile);  Pic16_Load(&l,lFile);  break;
+  case F_16A:  Pic16_SaveA(p[1],lFile);  Pic16_Load(&l,lFile);  break;
+  case F_16N:
+    Pic16_SaveOrder(p[1],lFile,TRUE);
+    Pic16_LoadOrder(&l,lFile,sizeof(int),TRUE);
+    break;
+  case F_32:  Pic32_Save(p[1],lFile);  Pic32_Load(&l,lFile);  break;
+  case F_XRGB:  Pic32_SaveXRGB(p[1],lFile);  Pic32_LoadXRGB(&l,lFile);  break;
+  case F_RGBX:  Pic32_SaveRGBX(p[1],lFile);  Pic32_LoadRGBX(&l,lFile);  break;
+  case F_BGRX:  Pic32_SaveBGRX(p[1],lFile);  Pic32_LoadRGBX(&l,lFile);  break;
+  case F_SHL:  Pic8_Save(p[1],lFile);  Pic16_LoadShl(&l,lFile,3);  break;
+  case F_UNI:  Pic8_Save(p[1],lFile);  Pic16_UniLoad(&l,lFile);  break;
+  case F_NQI8:  Pic8_SaveNqi(p[1],lFile);  Pic8_LoadNqi(&l,lFile);  break;
+  case F_NQI16:  Pic16_SaveNqi(p[1],lFile);  Pic16_LoadNqi(&l,lFile);  break;
+  case F_NQI32:  Pic32_SaveNqi(p[1],lFile);  Pic32_LoadNqi(&l,lFile);  break;
+
+    /* straight into D */
+  case F_16O:
+  case F_8O:
+    if(lK->Arg==F_16O)
+      Pic16_SaveOrder(p[1],lFile,FALSE);
+    else
+      Pic8_Save(p[1],lFile);
+    MUST(Pic_Open(&f,lFile));
+    Pic_ReadInto(&f,p[0],2,lK->Arg==F_8O?4:0);
+    Pic_Close(&f);
+    break;
+  case F_ROI:
+    Pic16_Save(p[1],lFile);
+    MUST(Pic_Open(&f,lFile));
+    f.Threads=2;
+    Pic_ReadRoi(&f,p[0],0,0,lDx,lDy,2,0);
+    Pic_Close(&f);
+    break;
+  case F_RAW:
+    Pic32_SaveXRGB(p[1],lFile);
+    file=fopen(lFile,"r");  MUST(file);
+    fseek(file,0,SEEK_END);
+    n=ftell(file);
+    rewind(file);
+    pb=malloc(n);  MUST(pb);
+    MUST(fread(pb,n,1,file)==1);
+    fclose(file);
+    MUST(Pic_ParseHeader(&f,pb,n,lFile));
+    Pic_ReadRaw(&f,p[0],pb+f.Offset,4,0);
+    free(pb);
+    break;
+  case F_YUV:
+  case F_YROI:
+    SaveI420(p[1]);
+    YuvOf(&yuv,p[0]);
+    if(lK->Arg==F_YUV)
+      Yuv_Load(&yuv,lFile);
+    else
+      Yuv_LoadRoi(&yuv,lFile,lDx,lDy,0,0,2);
+    break;
+  case F_YC:
+    SaveI420(p[1]);
+    YcOf(&yc,p[0]);
+    Yc_Load(&yc,lFile);
+    break;
+  }
+  if(l.Pel)
+    Take(p[0],&l,BPP(lK->Role[0]));
+
+  return FileHash();
+}
+
+
+/*****************************************************************************
+ *  local functions: the references
+ ****************************************************************************/
+
+static long RefCopy(tPic *p[3])
+{
+  int		x,y,b=BPP(lK->Role[0]);
+
+  FOR_PELS(p[0])
+    memcpy(PEL(p[0],x,y,b),PEL(p[1],x,y,b),b);
+  return 0;
+}
+
+static long RefSet(tPic *p[3])
+{
+  int		x,y;
+
+  FOR_PELS(p[0])
+    Put(p[0],x,y,BPP(lK->Role[0]),lK->Arg);
+  return 0;
+}
+
+static long RefShiftLeft(tPic *p[3])
+{
+  int		x,y,b=BPP(lK->Role[0]);
+  u32		v;
+
+  FOR_PELS(p[0]){
+    v=Get(p[0],x,y,b)<<lK->Arg;
+    Put(p[0],x,y,b,MIN(v,b==1?MAX_U8:MAX_U16));
+  }
+  return 0;
+}
+
+static long RefCopyShift(tPic *p[3])
+{
+  int		x,y,b=BPP(lK->Role[0]),a=BPP(lK->Role[1]);
+  u32		v;
+
+  FOR_PELS(p[0]){
+    v=Get(p[1],x,y,a);
+    Put(p[0],x,y,b,b<a?v>>lK->Arg:v<<lK->Arg);
+  }
+  return 0;
+}
+
+/* whole lines of S bytes, as Pic_HorFlip() */
+static long RefHorFlip(tPic *p[3])
+{
+  u8		t;
+  long		i;
+  int		y;
+
+  for(y=0;y<p[0]->Dy/2;y++)
+    for(i=0;i<p[0]->S;i++){
+      t=*PEL(p[0],i,y,1);
+      *PEL(p[0],i,y,1)=*PEL(p[0],i,p[0]->Dy-1-y,1);
+      *PEL(p[0],i,p[0]->Dy-1-y,1)=t;
+    }
+  return 0;
+}
+
+static long RefPack4444(tPic *p[3])
+{
+  const u8	*ps;
+  u8		*pd;
+  int		x,y;
+
+  FOR_PELS(p[0]){
+    ps=PEL(p[1],x,y,4);
+    pd=PEL(p[0],x,y,2);
+    pd[0]=(ps[0]&0xf0)|ps[1]>>4;
+    pd[1]=(ps[2]&0xf0)|ps[3]>>4;
+  }
+  return 0;
+}
+
+static long RefPack565(tPic *p[3])
+{
+  const u8	*ps;
+  int		x,y;
+
+  FOR_PELS(p[0]){
+    ps=PEL(p[1],x,y,4)+(lK->Arg?1:0);
+    Put(p[0],x,y,2,(ps[0]>>3)<<11|(ps[1]>>2)<<5|ps[2]>>3);
+  }
+  return 0;
+}
+
+/* X, R, G, B in memory, the bits replicated */
+static long RefUnPack565(tPic *p[3])
+{
+  u8		*pd;
+  u32		v;
+  int		x,y;
+
+  FOR_PELS(p[0]){
+    v=Get(p[1],x,y,2);
+    pd=PEL(p[0],x,y,4);
+    pd[0]=0;
+    pd[1]=(v>>11)<<3|v>>13;
+    pd[2]=(v>>5&0x3f)<<2|(v>>9&3);
+    pd[3]=(v&0x1f)<<3|(v>>2&7);
+  }
+  return 0;
+}
+
+static long RefFromU8(tPic *p[3])
+{
+  u32		v;
+  int		x,y;
+
+  FOR_PELS(p[0]){
+    v=Get(p[1],x,y,1);
+    switch(lK->Arg){
+    case 0:  Put(p[0],x,y,4,v*0x01010101u);  break;
+    case 1:  Put(p[0],x,y,4,v*0x010101u);  break;
+    default:  Put(p[0],x,y,2,(v>>3)<<11|(v>>2)<<5|v>>3);
+    }
+  }
+  return 0;
+}
+
+static long RefRgb(tPic *p[3])
+{
+  static const u8	ord[4][4]={{0,1,2,0xff},{2,1,0,0xff},{0,1,2},{2,1,0}};
+  const u8	*po=ord[lK->Arg];
+  int		x,y,c,b=BPP(lK->Role[0]),a=BPP(lK->Role[1]);
+
+  FOR_PELS(p[0])
+    for(c=0;c<b;c++)
+      PEL(p[0],x,y,b)[c]=po[c]==0xff?0:PEL(p[1],x,y,a)[po[c]];
+  return 0;
+}
+
+static long RefGenAlpha(tPic *p[3])
+{
+  u8		c[4],*pd;
+  int		x,y;
+
+  memcpy(c,PEL(p[0],lDx/2,lDy/2,4),4);
+  FOR_PELS(p[0]){
+    pd=PEL(p[0],x,y,4);
+    pd[0]=memcmp(pd+1,c+1,3)?0xff:0;
+  }
+  return 0;
+}
+
+static long RefSad(tPic *p[3])
+{
+  int		x,y,b=BPP(lK->Role[1]);
+  s64		d;
+  u64		ss=0;
+
+  FOR_PELS(p[0]){
+    d=(s64)Get(p[1],x,y,b)-Get(p[2],x,y,b);
+    d=d<0?-d:d;
+    Put(p[0],x,y,1,MIN(d*lK->Arg,255));
+    ss+=d;
+  }
+  return (int)ss;
+}
+
+static long RefPad(tPic *p[3])
+{
+  tPic		w;
+  int		x,y;
+
+  Pic_Create(&w,p[0]->S,lDx+2*PADN,lDy+2*PADN,
+	     p[0]->Pel-PADN*p[0]->S-PADN);
+  FOR_PELS(&w)
+    *PEL(&w,x,y,1)=*PEL(p[0],CLIP(x-PADN,0,lDx-1),CLIP(y-PADN,0,lDy-1),1);
+  return (long)(Pic_Hash(&w,1)>>2);
+}
+
+static long RefDrawRect(tPic *p[3])
+{
+  int		x,y,i,j,b=BPP(lK->Role[0]);
+
+  for(y=1;y<lDy-1;y+=3)
+    for(x=1;x<lDx-1;x+=4)
+      for(j=-1;j<=1;j++)
+	for(i=-1;i<=1;i++)
+	  if(i||j)
+	    Put(p[0],x+i,y+j,b,b==2?0x1234+x:0x123456+x);
+  return 0;
+}
+
+static long RefDrawCross(tPic *p[3])
+{
+  int		x,y,i;
+
+  for(y=2;y<lDy-2;y+=5)
+    for(x=2;x<lDx-2;x+=5){
+      Put(p[0],x,y,2,0x4321+y);
+      for(i=1;i<=2;i++){
+	Put(p[0],x-i,y-i,2,0x4321+y);
+	Put(p[0],x+i,y-i,2,0x4321+y);
+	Put(p[0],x-i,y+i,2,0x4321+y);
+	Put(p[0],x+i,y+i,2,0x4321+y);
+      }
+    }
+  return 0;
+}
+
+static long RefYuvRgb(tPic *p[3])
+{
+  int		x;
+
+  for(x=0;x<lDx;x+=STRIP)
+    YuvStrip(p,x,MIN(STRIP,lDx-x));
+  return 0;
+}
+
+static void RefYc(tPic *p[3], bool vu)
+{
+  tYuv		yuv;
+  tYc		yc;
+  int		x,y;
+
+  YcOf(&yc,p[0]);
+  YuvOf(&yuv,p[1]);
+  FOR_PELS(&yc.Y)
+    *PEL(&yc.Y,x,y,1)=*PEL(&yuv.C[0],x,y,1);
+  FOR_PELS(&yuv.C[1]){
+    PEL(&yc.C,x,y,2)[vu]=*PEL(&yuv.C[1],x,y,1);
+    PEL(&yc.C,x,y,2)[!vu]=*PEL(&yuv.C[2],x,y,1);
+  }
+}
+
+static long RefYcFromYuv(tPic *p[3])
+{
+  RefYc(p,lK->Arg&1);
+  return 0;
+}
+
+static long RefYuvFromYc(tPic *p[3])
+{
+  tYuv		yuv;
+  tYc		yc;
+  int		x,y;
+  bool		vu=lK->Arg&1;
+
+  YuvOf(&yuv,p[0]);
+  YcOf(&yc,p[1]);
+  FOR_PELS(&yc.Y)
+    *PEL(&yuv.C[0],x,y,1)=*PEL(&yc.Y,x,y,1);
+  FOR_PELS(&yuv.C[1]){
+    *PEL(&yuv.C[1],x,y,1)=PEL(&yc.C,x,y,2)[vu];
+    *PEL(&yuv.C[2],x,y,1)=PEL(&yc.C,x,y,2)[!vu];
+  }
+  return 0;
+}
+
+static long RefSwapUv(tPic *p[3])
+{
+  tYc		yc;
+  u8		*pc,t;
+  int		x,y;
+
+  YcOf(&yc,p[0]);
+  for(y=0;y<yc.C.Dy;y++)
+    for(x=0;x<yc.C.Dx/2;x++){
+      pc=PEL(&yc.C,x,y,2);
+      t=pc[0];  pc[0]=pc[1];  pc[1]=t;
+    }
+  return 0;
+}
+
+/* the frame pF to pD. an odd width repeats the last luma sample */
+static void RefYuyv(tPic *pD, const tPic *pF)
+{
+  tYuv		yuv;
+  u8		*pd;
+  int		x,y,c;
+  bool		uyvy=lK->Arg;
+
+  YuvOf(&yuv,pF);
+  for(y=0;y<lDy;y++)
+    for(x=0;x<CW/2;x++){
+      c=y*CH/lDy;
+      pd=PEL(pD,2*x,y,2);
+      pd[uyvy]=*PEL(&yuv.C[0],2*x,y,1);
+      pd[2+uyvy]=*PEL(&yuv.C[0],MIN(2*x+1,lDx-1),y,1);
+      pd[!uyvy]=*PEL(&yuv.C[1],x,c,1);
+      pd[2+!uyvy]=*PEL(&yuv.C[2],x,c,1);
+    }
+}
+
+static long RefYuyvFromYuv(tPic *p[3])
+{
+  RefYuyv(p[0],p[1]);
+  return 0;
+}
+
+/* the chroma of the odd lines is dropped, a 4:2:0 frame has only one
+   chroma line per two */
+static long RefYuvFromYuyv(tPic *p[3])
+{
+  tYuv		yuv;
+  const u8	*ps;
+  int		x,y,c;
+  bool		uyvy=lK->Arg;
+
+  YuvOf(&yuv,p[1]);
+  for(y=0;y<lDy;y++)
+    for(x=0;x<CW/2;x++){
+      c=y*CH/lDy;
+      ps=PEL(p[2],2*x,y,2);
+      *PEL(&yuv.C[0],2*x,y,1)=ps[uyvy];
+      if(2*x+1<lDx)
+	*PEL(&yuv.C[0],2*x+1,y,1)=ps[2+uyvy];
+      if(CH<lDy && (y&1))
+	continue;
+      *PEL(&yuv.C[1],x,c,1)=ps[!uyvy];
+      *PEL(&yuv.C[2],x,c,1)=ps[2+!uyvy];
+    }
+  RefYuyv(p[0],p[1]);
+  return 0;
+}
+
+static long RefFile(tPic *p[3])
+{
+  int		x,y;
+  u8		*pd;
+  const u8	*ps;
+
+  switch(lK->Arg){
+  case F_XRGB:
+  case F_RAW:
+    RefCopy(p);
+    FOR_PELS(p[0])
+      *PEL(p[0],x,y,4)=0;
+    break;
+  case F_RGBX:
+    RefCopy(p);
+    FOR_PELS(p[0])
+      PEL(p[0],x,y,4)[3]=0;
+    break;
+  case F_BGRX:
+    FOR_PELS(p[0]){
+      pd=PEL(p[0],x,y,4);
+      ps=PEL(p[1],x,y,4);
+      pd[0]=ps[2];  pd[1]=ps[1];  pd[2]=ps[0];  pd[3]=0;
+    }
+    break;
+  case F_8O:
+  case F_SHL:
+  case F_UNI:
+    FOR_PELS(p[0])
+      Put(p[0],x,y,2,Get(p[1],x,y,1)<<(lK->Arg==F_8O?4:lK->Arg==F_SHL?3:8));
+    break;
+  case F_YUV:
+  case F_YROI:
+    for(y=0;y<lDy+CH;y++)
+      memcpy(PEL(p[0],0,y,1),PEL(p[1],0,y,1),y<lDy?lDx:CW);
+    break;
+  case F_YC:
+    RefYc(p,FALSE);
+    break;
+  default:
+    RefCopy(p);
+  }
+  return NORET;
+}
+
+
+/*****************************************************************************
+ *  local functions: the runner
+ ****************************************************************************/
+
+static const tKernel	lKernel[]={
+  {"Pic8_Copy",		{1,1},			0,	Copy,	RefCopy},
+  {"Pic16_Copy",	{2,2},			0,	Copy,	RefCopy},
+  {"Pic24_Copy",	{3,3},			0,	Copy,	RefCopy},
+  {"Pic32_Copy",	{4,4},			0,	Copy,	RefCopy},
+  {"Pic8_Clear",	{1},			0,	Set,	RefSet},
+  {"Pic8_Set",		{1},			0x5a,	Set,	RefSet},
+  {"Pic16_Set",		{2},			0xbeef,	Set,	RefSet},
+  {"Pic32_Set",		{4},		0xdeadbeef,	Set,	RefSet},
+  {"Pic8_ShiftLeft",	{1},			3,	ShiftLeft,RefShiftLeft},
+  {"Pic16_ShiftLeft",	{2},			5,	ShiftLeft,RefShiftLeft},
+  {"Pic8_CopyU16Shr",	{1,2},			4,	CopyShift,RefCopyShift},
+  {"Pic16_CopyU32Shr",	{2,4},			5,	CopyShift,RefCopyShift},
+  {"Pic32_CopyU16Shl",	{4,2},			7,	CopyShift,RefCopyShift},
+  {"Pic_HorFlip",	{3},			0,	HorFlip,RefHorFlip},
+  {"Pic16_Pack4444",	{2,4},			0,	Pack4444,RefPack4444},
+  {"Pic16_Pack565_RGBX",{2,4},			0,	Pack565,RefPack565},
+  {"Pic16_Pack565_XRGB",{2,4},			1,	Pack565,RefPack565},
+  {"Pic32_UnPack565",	{4,2},			0,	UnPack565,RefUnPack565},
+  {"Pic32_RGBXfromU8",	{4,1},			0,	FromU8,	RefFromU8},
+  {"Pic32_XBGRfromU8",	{4,1},			1,	FromU8,	RefFromU8},
+  {"Pic16_BGRfromU8",	{2,1},			2,	FromU8,	RefFromU8},
+  {"Pic32_RGBXfromRGB",	{4,3},			0,	Rgb,	RefRgb},
+  {"Pic32_RGBXfromBGR",	{4,3},			1,	Rgb,	RefRgb},
+  {"Pic24_RGBfromRGBX",	{3,4},			2,	Rgb,	RefRgb},
+  {"Pic24_BGRfromRGBX",	{3,4},			3,	Rgb,	RefRgb},
+  {"Pic32_GenAlpha",	{4},			0,	GenAlpha,RefGenAlpha},
+  {"Pic8_Sad8",		{1,1,1},		3,	Sad,	RefSad},
+  {"Pic8_Sad16",	{1,2,2},		3,	Sad,	RefSad},
+  {"Pic8_Sad32",	{1,4,4},		3,	Sad,	RefSad},
+  {"Pic8_Pad",		{1|PADDED},		0,	Pad,	RefPad},
+  {"Pic16_DrawRect",	{2},			0,	DrawRect,RefDrawRect},
+  {"Pic32_DrawRect",	{4},			0,	DrawRect,RefDrawRect},
+  {"Pic16_DrawCross",	{2},			0,	DrawCross,RefDrawCross},
+  {"Pic16_DrawLine",	{2},			0,	DrawLine,NULL},
+  {"Pic32_DrawLine",	{4},			0,	DrawLine,NULL},
+  {"Pic32_RGBXfromYuv",	{4,FRAME},	Y_RGBX<<8,	YuvRgb,	RefYuvRgb},
+  {"Pic32_BGRXfromYuv",	{4,FRAME},
+   Y_BGRX<<8|PIC_BT709,					YuvRgb,	RefYuvRgb},
+  {"Pic16_RGB565fromYuv",{2,FRAME},
+   Y_565<<8|PIC_FULL,					YuvRgb,	RefYuvRgb},
+  {"Pic32_RGBXfromYc",	{4,FRAME},
+   C_RGBX<<8|PIC_BT709|PIC_FULL,			YuvRgb,	RefYuvRgb},
+  {"Pic32_BGRXfromYc",	{4,FRAME},	C_BGRX<<8|VU,	YuvRgb,	RefYuvRgb},
+  {"Pic16_RGB565fromYc",{2,FRAME},
+   C_565<<8|PIC_BT709|VU,				YuvRgb,	RefYuvRgb},
+  {"Yc_Import",		{FRAME,FRAME},		2,	YcFromYuv,RefYcFromYuv},
+  {"Yc_FromYuv",	{FRAME,FRAME},		1,	YcFromYuv,RefYcFromYuv},
+  {"Yuv_FromYc",	{FRAME,FRAME},		1,	YuvFromYc,RefYuvFromYc},
+  {"Yc_SwapUv",		{FRAME},		0,	SwapUv,	RefSwapUv},
+  {"Pic16_YuyvFromYuv",	{2|EVEN,FRAME},		0,	YuyvFromYuv,
+							RefYuyvFromYuv},
+  {"Pic16_UyvyFromYuv",	{2|EVEN,FRAME},		1,	YuyvFromYuv,
+							RefYuyvFromYuv},
+  {"Yuv_FromYuyv",	{2|EVEN,FRAME,2|EVEN},	0,	YuvFromYuyv,
+							RefYuvFromYuyv},
+  {"Yuv_FromUyvy",	{2|EVEN,FRAME,2|EVEN},	1,	YuvFromYuyv,
+							RefYuvFromYuyv},
+  {"Pic8_Save",		{1,1},			F_8,	File,	RefFile},
+  {"Pic8_SaveA",	{1,1},			F_8A,	File,	RefFile},
+  {"Pic16_Save",	{2,2},			F_16,	File,	RefFile},
+  {"Pic16_SaveA",	{2,2},			F_16A,	File,	RefFile},
+  {"Pic16_SaveOrder",	{2,2},			F_16N,	File,	RefFile},
+  {"Pic_ReadInto16",	{2,2},			F_16O,	File,	RefFile},
+  {"Pic_ReadInto8",	{2,1},			F_8O,	File,	RefFile},
+  {"Pic32_Save",	{4,4},			F_32,	File,	RefFile},
+  {"Pic32_SaveXRGB",	{4,4},			F_XRGB,	File,	RefFile},
+  {"Pic32_SaveRGBX",	{4,4},			F_RGBX,	File,	RefFile},
+  {"Pic32_SaveBGRX",	{4,4},			F_BGRX,	File,	RefFile},
+  {"Pic_ReadRaw",	{4,4},			F_RAW,	File,	RefFile},
+  {"Pic_ReadRoi",	{2,2},			F_ROI,	File,	RefFile},
+  {"Pic16_LoadShl",	{2,1},			F_SHL,	File,	RefFile},
+  {"Pic16_UniLoad",	{2,1},			F_UNI,	File,	RefFile},
+  {"Pic8_SaveNqi",	{1,1},			F_NQI8,	File,	RefFile},
+  {"Pic16_SaveNqi",	{2,2},			F_NQI16,File,	RefFile},
+  {"Pic32_SaveNqi",	{4,4},			F_NQI32,File,	RefFile},
+  {"Yuv_Load",		{FRAME,FRAME},		F_YUV,	File,	RefFile},
+  {"Yuv_LoadRoi",	{FRAME,FRAME},		F_YROI,	File,	RefFile},
+  {"Yc_Load",		{FRAME,FRAME},		F_YC,	File,	RefFile},
+};
+
+
+/****************************************************************************/
+/*  compare the buffers of kernel and reference, guards included
+ */
+static void Compare(int Layout, int Role, const tImg *pA, const tImg *pB)
+{
+  int		x=0,y=0,n,b=lK->Role[Role]&FRAME?1:BPP(lK->Role[Role]);
+
+  if(memcmp(pA->pBuf,pB->pBuf,pA->N)==0)
+    return;
+  if((n=Pic_Diff(&pA->Pic,&pB->Pic,b,&x,&y)))
+    Fail(Layout,"pic %c: %d pels differ, the first at %d,%d","DAB"[Role],n,
+	 x,y);
+  else
+    Fail(Layout,"pic %c: bytes outside the pels differ","DAB"[Role]);
+}
+
+
+/****************************************************************************/
+/*  run lK on all sizes in a layout, check it against the reference
+ *  \return hash of the outputs and return values
+ */
+static u64 Run(int Layout)
+{
+  tImg		a[3],b[3];
+  tPic		*pa[3],*pb[3];
+  u64		h=0;
+  long		ra,rb;
+  int		s,r;
+
+  for(s=0;s<LEN(lSize);s++){
+    lDx=lSize[s][0];
+    lDy=lSize[s][1];
+    for(r=0;r<3;r++){
+      pa[r]=pb[r]=NULL;
+      if(lK->Role[r]){
+	ImgAlloc(&a[r],lK->Role[r],Layout,3*s+r+1);
+	pa[r]=&a[r].Pic;
+	if(lK->pRef){
+	  ImgAlloc(&b[r],lK->Role[r],Layout,3*s+r+1);
+	  pb[r]=&b[r].Pic;
+	}
+      }
+    }
+
+    ra=lK->pRun(pa);
+    if(lK->pRef){
+      rb=lK->pRef(pb);
+      if(rb!=NORET && rb!=ra)
+	Fail(Layout,"returns %ld, the reference %ld",ra,rb);
+      for(r=0;r<3;r++)
+	if(lK->Role[r])
+	  Compare(Layout,r,&a[r],&b[r]);
+    }
+
+    h=(h^Pic_Hash(pa[0],lK->Role[0]&FRAME?1:BPP(lK->Role[0])))
+      *0x9e3779b97f4a7c15ull;
+    h=(h^h>>31^(u64)ra)*0xff51afd7ed558ccdull;
+    for(r=0;r<3;r++){
+      if(pa[r])
+	free(a[r].pBuf);
+      if(pb[r])
+	free(b[r].pBuf);
+    }
+  }
+
+  return h;
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  bool		gen=argc>1 && strcmp(argv[1],"-g")==0;
+  u64		h[L_N];
+  int		k,l,g;
+
+  MUST(mkdtemp(lDir));
+  snprintf(lFile,sizeof(lFile),"%s/t.pnm",lDir);
+
+  if(gen)
+    printf("/* golden hashes of test_pic.c, made by \"test_pic -g\" */\n"
+	   "static const tGolden lGolden[]={\n");
+
+  for(k=0;k<LEN(lKernel);k++){
+    lK=&lKernel[k];
+    for(l=0;l<L_N;l++){
+      h[l]=Run(l);
+      if(h[l]!=h[0])
+	Fail(l,"hash %016llx, %016llx when packed",(unsigned long long)h[l],
+	     (unsigned long long)h[0]);
+    }
+    if(gen){
+      printf("  {\"%s\",0x%016llxull},\n",lK->Name,(unsigned long long)h[0]);
+      continue;
+    }
+#if __BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__
+    for(g=0;g<LEN(lGolden) && strcmp(lGolden[g].Name,lK->Name);g++);
+    if(g==LEN(lGolden))
+      Fail(L_PACKED,"no golden hash");
+    else if(lGolden[g].Hash!=h[0])
+      Fail(L_PACKED,"hash %016llx, golden %016llx",(unsigned long long)h[0],
+	   (unsigned long long)lGolden[g].Hash);
+#else
+    (void)g;
+#endif
+  }
+
+  rmdir(lDir);
+  if(gen){
+    printf("};\n");
+    return lFails!=0;
+  }
+  printf("test_pic: %d kernels, %d failures\n",LEN(lKernel),lFails);
+  return lFails!=0;
+}
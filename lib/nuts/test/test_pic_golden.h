@@ -0,0 +1,73 @@
+/* golden hashes of test_pic.c, made by "test_pic -g" */
+static const tGolden lGolden[]={
+  {"Pic8_Copy",0xe0761ad3cdd6b238ull},
+  {"Pic16_Copy",0xd91f963d73828910ull},
+  {"Pic24_Copy",0x027ce801fb8c3736ull},
+  {"Pic32_Copy",0xf8c54d5421f2fd52ull},
+  {"Pic8_Clear",0x3a414c7ba16de237ull},
+  {"Pic8_Set",0x8531fd1b644b7c3dull},
+  {"Pic16_Set",0x04f9ba509d4b4786ull},
+  {"Pic32_Set",0x602a19d4c0b95e7aull},
+  {"Pic8_ShiftLeft",0xb9dcb086bcbca2bfull},
+  {"Pic16_ShiftLeft",0x2e4be4eb7756e652ull},
+  {"Pic8_CopyU16Shr",0xc37491bc522f5554ull},
+  {"Pic16_CopyU32Shr",0x1d97901d7f7fc09dull},
+  {"Pic32_CopyU16Shl",0xcf0c525857c56043ull},
+  {"Pic_HorFlip",0xfe537d0029fcea27ull},
+  {"Pic16_Pack4444",0xbee97d9cb838cf43ull},
+  {"Pic16_Pack565_RGBX",0xb90c8d438ee50062ull},
+  {"Pic16_Pack565_XRGB",0x5971870a710ea0f8ull},
+  {"Pic32_UnPack565",0x6a2c113ac7f96027ull},
+  {"Pic32_RGBXfromU8",0xb403a44dc0281083ull},
+  {"Pic32_XBGRfromU8",0x05980c4990cf2794ull},
+  {"Pic16_BGRfromU8",0xe162224e543a6cf2ull},
+  {"Pic32_RGBXfromRGB",0x8e60ddd842b84b9bull},
+  {"Pic32_RGBXfromBGR",0x36b11d2aa975fdfbull},
+  {"Pic24_RGBfromRGBX",0xe417716a1de349aaull},
+  {"Pic24_BGRfromRGBX",0xb232b6eed3378405ull},
+  {"Pic32_GenAlpha",0xa8f922581a305dd1ull},
+  {"Pic8_Sad8",0xe5fbf89c502724f7ull},
+  {"Pic8_Sad16",0x64f1a6cf1403c9e5ull},
+  {"Pic8_Sad32",0x36ace8adf4b8179bull},
+  {"Pic8_Pad",0x3e5060336de4cde4ull},
+  {"Pic16_DrawRect",0x8a402b019543b5b3ull},
+  {"Pic32_DrawRect",0x01c89b6708c4de56ull},
+  {"Pic16_DrawCross",0x47e77870411241d2ull},
+  {"Pic16_DrawLine",0x053cd8d6b8ebc02eull},
+  {"Pic32_DrawLine",0x7e279df45a0636b9ull},
+  {"Pic32_RGBXfromYuv",0xf4a8cd1df49c11e1ull},
+  {"Pic32_BGRXfromYuv",0x653d8377a67ee5c8ull},
+  {"Pic16_RGB565fromYuv",0x54c5b39fbd21af43ull},
+  {"Pic32_RGBXfromYc",0x1f65d2953ec6985cull},
+  {"Pic32_BGRXfromYc",0x0271fda682b3a2b4ull},
+  {"Pic16_RGB565fromYc",0xdd37c4caf39985d5ull},
+  {"Yc_Import",0x3cd3a51d9608bf6dull},
+  {"Yc_FromYuv",0xf0006d1c05fbed38ull},
+  {"Yuv_FromYc",0xdf6be4cf86571e2dull},
+  {"Yc_SwapUv",0x8024a6344c712cb9ull},
+  {"Pic16_YuyvFromYuv",0x73a813c3d39732a5ull},
+  {"Pic16_UyvyFromYuv",0xcd29e13a80458a74ull},
+  {"Yuv_FromYuyv",0x262deddf14f54073ull},
+  {"Yuv_FromUyvy",0xac56bc5cc8aa8452ull},
+  {"Pic8_Save",0x2fc553038ccecabaull},
+  {"Pic8_SaveA",0xabe19491ac8888fdull},
+  {"Pic16_Save",0x134078f25514242eull},
+  {"Pic16_SaveA",0xae1a04394d513009ull},
+  {"Pic16_SaveOrder",0x33f8781583e16f0dull},
+  {"Pic_ReadInto16",0x134078f25514242eull},
+  {"Pic_ReadInto8",0x303c8a81d1b042d2ull},
+  {"Pic32_Save",0x2a5b6582bdc91df4ull},
+  {"Pic32_SaveXRGB",0x19b5fd5e10fa93afull},
+  {"Pic32_SaveRGBX",0x4cfe6cc1b7c1c0b0ull},
+  {"Pic32_SaveBGRX",0x138276468409166full},
+  {"Pic_ReadRaw",0x19b5fd5e10fa93afull},
+  {"Pic_ReadRoi",0x134078f25514242eull},
+  {"Pic16_LoadShl",0xd229d15ba948c7f4ull},
+  {"Pic16_UniLoad",0xf9e832f433d8970eull},
+  {"Pic8_SaveNqi",0xb14d4690b5faf1b2ull},
+  {"Pic16_SaveNqi",0x812be038e30a7ce2ull},
+  {"Pic32_SaveNqi",0xa9277fd4966d98edull},
+  {"Yuv_Load",0xfea122c30816c74cull},
+  {"Yuv_LoadRoi",0xfea122c30816c74cull},
+  {"Yc_Load",0x7499e2a0726f8e15ull},
+};
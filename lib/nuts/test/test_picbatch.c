@@ -0,0 +1,243 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  test: PicBatch_Load() through the io_uring and through the reader
+ *  threads. each pic must equal the one of Pic8_Load(), Pic16_Load() or
+ *  Pic32_LoadXRGB(), files that cannot be read must come back without a pic.
+ *  the io_uring load runs again with a timer signal going off, which must
+ *  not end the load
+ *
+ *	test_picbatch
+ *
+ *  \file      test_picbatch.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"nuts/debug.h"
+#include	"nuts/picbatch.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<unistd.h>
+#include	<signal.h>
+#include	<sys/time.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define EXPECT(c,...)	do{ if(!(c)){ if(lFails++<10){			\
+	  printf("FAIL %s:%d: ",__FILE__,__LINE__); printf(__VA_ARGS__);	\
+	  printf("\n"); } } }while(0)
+
+#define N		40		/* files */
+#define BAD		3		/* of which the last cannot be read */
+
+
+/*****************************************************************************
+ *  local types
+ ****************************************************************************/
+
+/* a file and its pic as loaded by Pic_Load */
+typedef struct {
+  char		Name[64];
+  int		Bpp;
+  tPic		Ref;
+  int		Seen;
+} tFile;
+
+/* state of a load */
+typedef struct {
+  tPicBatch	B;
+  tFile		*pFiles;
+  const char	*Mode;
+} tRun;
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static int		lFails;
+static char		lDir[]="/tmp/test_picbatchXXXXXX";
+static volatile int	lSignals;
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  write the files: 8bit, 16bit and rgb, raw and ascii, small and larger
+ *  than a first read, then a truncated, an empty and a missing one
+ */
+static void Make(tFile *pFiles)
+{
+  tFile		*pf;
+  tPic		p;
+  FILE		*f;
+  int		i,dx,dy;
+
+  for(i=0;i<N-BAD;i++){
+    pf=&pFiles[i];
+    dx=1+i*7%61;
+    dy=1+i*5%37;
+    if(i%7==0){
+      dx*=8;
+      dy*=8;
+    }
+    switch(i%4){
+    case 0:
+      snprintf(pf->Name,sizeof(pf->Name),"%s/%d.pgm",lDir,i);
+      Pic8_Malloc(&p,dx,dy);
+      Pic_Random(&p,1,i);
+      MUST(i%8?Pic8_Save(&p,pf->Name):Pic8_SaveA(&p,pf->Name));
+      MUST(Pic8_Load(&pf->Ref,pf->Name));
+      pf->Bpp=1;
+      break;
+    case 1:
+      snprintf(pf->Name,sizeof(pf->Name),"%s/%d.pgm",lDir,i);
+      Pic16_Malloc(&p,dx,dy);
+      Pic_Random(&p,2,i);
+      MUST(Pic16_Save(&p,pf->Name));
+      MUST(Pic16_Load(&pf->Ref,pf->Name));
+      pf->Bpp=2;
+      break;
+    default:
+      snprintf(pf->Name,sizeof(pf->Name),"%s/%d.ppm",lDir,i);
+      Pic32_Malloc(&p,dx,dy);
+      Pic_Random(&p,4,i);
+      MUST(Pic32_SaveXRGB(&p,pf->Name));
+      MUST(Pic32_LoadXRGB(&pf->Ref,pf->Name));
+      pf->Bpp=4;
+      break;
+    }
+    Pic_Free(&p);
+  }
+
+  snprintf(pFiles[N-3].Name,sizeof(pFiles[0].Name),"%s/short.pgm",lDir);
+  MUST(f=fopen(pFiles[N-3].Name,"w"));
+  fprintf(f,"P5\n100 100\n255\n");
+  fwrite(lDir,1,sizeof(lDir),f);
+  fclose(f);
+  snprintf(pFiles[N-2].Name,sizeof(pFiles[0].Name),"%s/empty.pgm",lDir);
+  MUST(f=fopen(pFiles[N-2].Name,"w"));
+  fclose(f);
+  snprintf(pFiles[N-1].Name,sizeof(pFiles[0].Name),"%s/none.pgm",lDir);
+}
+
+
+/****************************************************************************/
+/*  callback: compare with the pic of Pic_Load
+ */
+static void Done(void *pArg, int Idx, tPicFile *pHead, tPic *pPic)
+{
+  tRun		*pr=pArg;
+  tFile		*pf=&pr->pFiles[Idx];
+  int		x=0,y=0,d;
+
+  pf->Seen++;
+  EXPECT(pHead->Name==pf->Name,"%s: %s for file %d",pr->Mode,pHead->Name,
+	 Idx);
+  if(Idx>=N-BAD){
+    EXPECT(!pPic,"%s: %s loaded",pr->Mode,pf->Name);
+    if(pPic)
+      PicPool_Put(&pr->B.Pool,pPic);
+    return;
+  }
+  EXPECT(pPic,"%s: %s not loaded",pr->Mode,pf->Name);
+  if(!pPic)
+    return;
+  EXPECT(pPic->Dx==pf->Ref.Dx && pPic->Dy==pf->Ref.Dy,"%s: %s is %dx%d",
+	 pr->Mode,pf->Name,pPic->Dx,pPic->Dy);
+  if(pPic->Dx==pf->Ref.Dx && pPic->Dy==pf->Ref.Dy){
+    d=Pic_Diff(pPic,&pf->Ref,pf->Bpp,&x,&y);
+    EXPECT(d==0,"%s: %s has %d different pels, first at %d,%d",pr->Mode,
+	   pf->Name,d,x,y);
+  }
+  PicPool_Put(&pr->B.Pool,pPic);
+}
+
+
+/****************************************************************************/
+static void Alarm(int Sig)
+{
+  (void)Sig;
+  lSignals++;
+}
+
+
+/****************************************************************************/
+/*  load all files, Rounds times with the same loader
+ */
+static void Load(tFile *pFiles, const char *Mode, bool NoUring, int Depth,
+		 int Rounds)
+{
+  const char	*names[N];
+  tRun		r;
+  int		i,k,ok;
+
+  for(i=0;i<N;i++)
+    names[i]=pFiles[i].Name;
+  PicBatch_Init(&r.B);
+  r.B.NoUring=NoUring;
+  r.B.Depth=Depth;
+  r.B.Threads=3;
+  r.pFiles=pFiles;
+  r.Mode=Mode;
+
+  for(k=0;k<Rounds;k++){
+    for(i=0;i<N;i++)
+      pFiles[i].Seen=0;
+    ok=PicBatch_Load(&r.B,names,N,0,0,Done,&r);
+    EXPECT(ok==N-BAD,"%s: %d files loaded",Mode,ok);
+    for(i=0;i<N;i++)
+      EXPECT(pFiles[i].Seen==1,"%s: %s done %d times",Mode,pFiles[i].Name,
+	     pFiles[i].Seen);
+  }
+
+  PicBatch_Free(&r.B);
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+int main(void)
+{
+  static tFile	files[N];
+  struct sigaction sa;
+  struct itimerval it={{0,50},{0,50}};
+  int		i;
+
+  MUST(mkdtemp(lDir));
+  Make(files);
+
+  Load(files,"uring",FALSE,8,1);
+  Load(files,"threads",TRUE,8,1);
+  Load(files,"uring, depth 1",FALSE,1,1);
+  Load(files,"threads, depth 1",TRUE,1,1);
+  Load(files,"uring, depth N",FALSE,N,1);
+
+  /* signals without SA_RESTART: io_uring_enter returns EINTR */
+  memset(&sa,0,sizeof(sa));
+  sa.sa_handler=Alarm;
+  sigaction(SIGALRM,&sa,NULL);
+  setitimer(ITIMER_REAL,&it,NULL);
+  Load(files,"uring, signals",FALSE,4,50);
+  memset(&it,0,sizeof(it));
+  setitimer(ITIMER_REAL,&it,NULL);
+  EXPECT(lSignals>0,"no signals");
+
+  for(i=0;i<N;i++){
+    if(files[i].Ref.Pel)
+      Pic_Free(&files[i].Ref);
+    unlink(files[i].Name);
+  }
+  rmdir(lDir);
+  printf("test_picbatch: %d failures\n",lFails);
+  return lFails!=0;
+}
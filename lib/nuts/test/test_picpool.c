@@ -0,0 +1,151 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  test: reuse and eviction of the buffers of a tPicPool. a buffer must be
+ *  reused by size as it was allocated, also after its pic was shrunk, the
+ *  best fit wins and a full pool frees its smallest buffer
+ *
+ *	test_picpool
+ *
+ *  \file      test_picpool.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"nuts/debug.h"
+#include	"nuts/pic.h"
+#include	<stdio.h>
+#include	<string.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define EXPECT(c,...)	do{ if(!(c)){ if(lFails++<10){			\
+	  printf("FAIL %s:%d: ",__FILE__,__LINE__); printf(__VA_ARGS__);	\
+	  printf("\n"); } } }while(0)
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static int		lFails;
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  \return free buffers of a pool
+ */
+static int Free(const tPicPool *pPool)
+{
+  int		i,n=0;
+
+  for(i=0;i<pPool->N;i++)
+    n+=!pPool->pBufs[i].Used;
+  return n;
+}
+
+
+/****************************************************************************/
+/*  a buffer is reused for a smaller pic, also after it was shrunk
+ */
+static void TestReuse(void)
+{
+  tPicPool	pool={0};
+  tPic		a,b;
+  u8		*pa;
+
+  PicPool_Get(&pool,&a,100,50,1);
+  EXPECT(a.Dx==100 && a.Dy==50 && a.S==100,"size %dx%d S %d",a.Dx,a.Dy,a.S);
+  memset(a.Pel,0x11,(long)a.S*a.Dy);
+  pa=a.Pel;
+  PicPool_Put(&pool,&a);
+  EXPECT(a.Pel==NULL,"put pic not empty");
+  EXPECT(Free(&pool)==1,"%d free",Free(&pool));
+
+  PicPool_Get(&pool,&b,81,40,1);
+  EXPECT(b.Pel==pa,"smaller pic not reused");
+  EXPECT(b.S==84,"stride %d",b.S);
+  EXPECT(Free(&pool)==0,"%d free",Free(&pool));
+
+  /* shrunk as by Pic_ReadInto(): the whole buffer is still there */
+  b.Dy=1;
+  PicPool_Put(&pool,&b);
+  PicPool_Get(&pool,&a,40,100,1);
+  EXPECT(a.Pel==pa,"shrunk pic not reused for its full size");
+  memset(a.Pel,0x22,(long)a.S*a.Dy);
+  PicPool_Put(&pool,&a);
+
+  /* too large: a new buffer */
+  PicPool_Get(&pool,&a,101,50,1);
+  EXPECT(a.Pel!=pa,"too small buffer reused");
+  EXPECT(Free(&pool)==1 && pool.N==2,"%d free of %d",Free(&pool),pool.N);
+  PicPool_Put(&pool,&a);
+
+  /* released by the user */
+  PicPool_Get(&pool,&a,10,10,2);
+  Pic_Free(&a);
+  PicPool_Get(&pool,&a,200,200,4);
+  PicPool_Put(&pool,&a);
+
+  PicPool_Free(&pool);
+  EXPECT(pool.N==0 && pool.pBufs==NULL,"pool not empty after free");
+}
+
+
+/****************************************************************************/
+/*  best fit, and a full pool frees the smallest buffer
+ */
+static void TestEvict(void)
+{
+  tPicPool	pool={0};
+  tPic		p[PICPOOL_MAX+1],a;
+  u8		*p5;
+  int		i;
+
+  for(i=0;i<=PICPOOL_MAX;i++)
+    PicPool_Get(&pool,&p[i],16*(i+1),4,1);
+
+  p5=p[5].Pel;
+  PicPool_Put(&pool,&p[9]);
+  PicPool_Put(&pool,&p[5]);
+  PicPool_Get(&pool,&a,16*4,4,1);
+  EXPECT(a.Pel==p5,"not the best fit");
+  PicPool_Put(&pool,&a);
+
+  for(i=0;i<=PICPOOL_MAX;i++)
+    if(i!=5 && i!=9)
+      PicPool_Put(&pool,&p[i]);
+  EXPECT(Free(&pool)==PICPOOL_MAX && pool.N==PICPOOL_MAX,"%d free of %d",
+	 Free(&pool),pool.N);
+  for(i=0;i<pool.N;i++)
+    EXPECT(pool.pBufs[i].Size>16*4,"smallest buffer kept");
+
+  /* the 16 byte lines are gone, the best fit has 32 */
+  PicPool_Get(&pool,&a,16,4,1);
+  for(i=0;i<pool.N && pool.pBufs[i].pBuf!=a.Pel;i++);
+  EXPECT(i<pool.N && pool.pBufs[i].Size==32*4,"best fit %ld bytes",
+	 i<pool.N?pool.pBufs[i].Size:0L);
+  PicPool_Put(&pool,&a);
+
+  PicPool_Free(&pool);
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+int main(void)
+{
+  TestReuse();
+  TestEvict();
+
+  printf("test_picpool: %d failures\n",lFails);
+  return lFails!=0;
+}
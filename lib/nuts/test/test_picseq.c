@@ -0,0 +1,255 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  test: Nqi_EncodeDelta() and Nqi_DecodeDelta() next to the plain line
+ *  coder, and PicSeq files of key and delta frames: the frames must come
+ *  back as they were put, read in order, seeking to a delta frame, going
+ *  back and without the index
+ *
+ *	test_picseq
+ *
+ *  \file      test_picseq.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"nuts/debug.h"
+#include	"nuts/picseq.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<unistd.h>
+#include	<sys/stat.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define EXPECT(c,...)	do{ if(!(c)){ if(lFails++<10){			\
+	  printf("FAIL %s:%d: ",__FILE__,__LINE__); printf(__VA_ARGS__);	\
+	  printf("\n"); } } }while(0)
+
+#define NF		11		/* frames of a sequence */
+#define KEYINT		4
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static int		lFails;
+static u32		lSeed=1;
+static char		lFile[]="/tmp/test_picseqXXXXXX";
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+static u32 Rand(void)
+{
+  lSeed=lSeed*1103515245+12345;
+  return lSeed>>8;
+}
+
+
+/****************************************************************************/
+/*  change Changes random bytes of N
+ */
+static void Change(u8 *p, int N, int Changes)
+{
+  int		i;
+
+  for(i=0;i<Changes;i++)
+    p[Rand()%N]+=1+Rand()%255;
+}
+
+
+/****************************************************************************/
+/*  a line against the line before it with both coders: both must decode to
+ *  the line, an unchanged line costs a byte per 128 blocks with the delta
+ *  coder and the plain decoder must reject it
+ */
+static void TestLine(int Dx, int Bpp, int Changes)
+{
+  tNqi		q;
+  u8		*prev,*cur,*out,*plain,*delta;
+  int		n=Dx*Bpp,nb,np,nd,blocks;
+
+  Nqi_Init(&q,Dx,Bpp);
+  blocks=(q.N+31)/32;
+  prev=malloc(n);
+  cur=malloc(n);
+  out=malloc(n);
+  plain=malloc(Nqi_Bound(&q));
+  delta=malloc(Nqi_Bound(&q));
+  MUST(prev && cur && out && plain && delta);
+
+  for(nb=0;nb<n;nb++)
+    prev[nb]=Rand();
+  memcpy(cur,prev,n);
+  Change(cur,n,Changes);
+
+  np=Nqi_EncodeRow(&q,plain,cur,prev);
+  nd=Nqi_EncodeDelta(&q,delta,cur,prev);
+  EXPECT(np<=Nqi_Bound(&q) && nd<=Nqi_Bound(&q),
+	 "%dx%d, %d changes: %d, %d bytes, bound %d",Dx,Bpp,Changes,np,nd,
+	 Nqi_Bound(&q));
+
+  memset(out,0,n);
+  EXPECT(Nqi_DecodeRow(&q,out,prev,plain,np)==np && !memcmp(out,cur,n),
+	 "%dx%d, %d changes: plain line differs",Dx,Bpp,Changes);
+  memset(out,0,n);
+  EXPECT(Nqi_DecodeDelta(&q,out,prev,delta,nd)==nd && !memcmp(out,cur,n),
+	 "%dx%d, %d changes: delta line differs",Dx,Bpp,Changes);
+  EXPECT(Nqi_DecodeDelta(&q,out,prev,delta,nd-1)<0,
+	 "%dx%d, %d changes: truncated delta line accepted",Dx,Bpp,Changes);
+
+  if(Changes==0){
+    EXPECT(nd==(blocks+127)/128,"%dx%d: unchanged line has %d bytes",Dx,
+	   Bpp,nd);
+    EXPECT(Nqi_DecodeRow(&q,out,prev,delta,nd)<0,
+	   "%dx%d: delta line accepted by the plain decoder",Dx,Bpp);
+  }
+  /* a changed block costs what the plain coder needs at most */
+  if(Changes==1)
+    EXPECT(nd<=(blocks+127)/128+1+Nqi_Bound(&q)/blocks,
+	   "%dx%d: one change costs %d bytes",Dx,Bpp,nd);
+
+  free(prev);
+  free(cur);
+  free(out);
+  free(plain);
+  free(delta);
+  Nqi_Free(&q);
+}
+
+
+/****************************************************************************/
+/*  compare a pic with a frame
+ */
+static void Same(const tPic *pA, const tPic *pB, int Bpp, const char *What,
+		 int Idx)
+{
+  int		x=0,y=0,d;
+
+  d=Pic_Diff(pA,pB,Bpp,&x,&y);
+  EXPECT(d==0,"%s: frame %d has %d different pels, first at %d,%d",What,
+	 Idx,d,x,y);
+}
+
+
+/****************************************************************************/
+/*  write NF frames that change a little, with an unchanged and a new one,
+ *  read them back in order, by seeking and without the index
+ */
+static void TestSeq(int Dx, int Dy, int Bpp)
+{
+  tPicSeq	s;
+  tPic		f[NF],g={0};
+  struct stat	st;
+  long		len[NF];
+  int		i,n=Dx*Bpp;
+  char		what[64];
+
+  for(i=0;i<NF;i++){
+    Pic8_Malloc(&f[i],n,Dy);
+    f[i].Dx=Dx;
+    if(i==0 || i==7)
+      Pic_Random(&f[i],Bpp,Rand());
+    else{
+      memcpy(f[i].Pel,f[i-1].Pel,(long)f[i].S*Dy);
+      if(i!=5)
+	Change(f[i].Pel,f[i].S*(Dy-1)+n,1+Dy/4);
+    }
+  }
+
+  snprintf(what,sizeof(what),"%dx%dx%d",Dx,Dy,Bpp);
+  PicSeq_Create(&s,lFile,Dx,Dy,Bpp,KEYINT);
+  for(i=0;i<NF;i++)
+    PicSeq_Put(&s,&f[i]);
+  PicSeq_Close(&s);
+
+  /* in order */
+  EXPECT(PicSeq_Open(&s,lFile),"%s: cannot open",what);
+  EXPECT(s.N==NF && s.Dx==Dx && s.Dy==Dy && s.Bpp==Bpp,
+	 "%s: %d frames %dx%dx%d",what,s.N,s.Dx,s.Dy,s.Bpp);
+  for(i=0;i<NF && i<s.N;i++){
+    EXPECT((s.pIdx[i]&1)==(i%KEYINT==0),"%s: frame %d key %d",what,i,
+	   (int)(s.pIdx[i]&1));
+    len[i]=(i+1<s.N?(long)(s.pIdx[i+1]>>1):0)-(long)(s.pIdx[i]>>1);
+    EXPECT(PicSeq_Get(&s,&g,i),"%s: no frame %d",what,i);
+    Same(&g,&f[i],Bpp,what,i);
+  }
+  /* an unchanged delta frame is a few bytes per line */
+  EXPECT(len[5]<=8+Dy*((n+31)/32/128+1),"%s: unchanged frame has %ld bytes",
+	 what,len[5]);
+  EXPECT(len[1]<len[0] || Dx*Dy<64,"%s: delta frame %ld bytes, key frame %ld",
+	 what,len[1],len[0]);
+  EXPECT(!PicSeq_Get(&s,&g,NF) && !PicSeq_Get(&s,&g,-1),"%s: frame %d",
+	 what,NF);
+  PicSeq_Close(&s);
+
+  /* seek to delta frames, forward, back and onwards */
+  PicSeq_Open(&s,lFile);
+  EXPECT(PicSeq_Get(&s,&g,6),"%s: no frame 6",what);
+  Same(&g,&f[6],Bpp,what,6);
+  EXPECT(s.Cur==6,"%s: at frame %d",what,s.Cur);
+  PicSeq_Get(&s,&g,10);
+  Same(&g,&f[10],Bpp,what,10);
+  PicSeq_Get(&s,&g,3);
+  Same(&g,&f[3],Bpp,what,3);
+  PicSeq_Get(&s,&g,9);
+  Same(&g,&f[9],Bpp,what,9);
+  PicSeq_Get(&s,&g,9);
+  Same(&g,&f[9],Bpp,what,9);
+  PicSeq_Close(&s);
+
+  /* without the index: found from the frame headers */
+  MUST(stat(lFile,&st)==0);
+  MUST(truncate(lFile,st.st_size-16-8*NF)==0);
+  PicSeq_Open(&s,lFile);
+  EXPECT(s.N==NF,"%s: %d frames without index",what,s.N);
+  PicSeq_Get(&s,&g,7);
+  Same(&g,&f[7],Bpp,what,7);
+  PicSeq_Get(&s,&g,NF-1);
+  Same(&g,&f[NF-1],Bpp,what,NF-1);
+  PicSeq_Close(&s);
+
+  Pic_Free(&g);
+  for(i=0;i<NF;i++)
+    Pic_Free(&f[i]);
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+int main(void)
+{
+  static const int dx[]={1,31,32,33,100,5000};
+  int		i,b,fd;
+
+  for(i=0;i<(int)(sizeof(dx)/sizeof(dx[0]));i++)
+    for(b=1;b<=4;b++){
+      TestLine(dx[i],b,0);
+      TestLine(dx[i],b,1);
+      TestLine(dx[i],b,dx[i]);
+      TestLine(dx[i],b,dx[i]*b*4);
+    }
+
+  MUST((fd=mkstemp(lFile))>=0);
+  close(fd);
+  TestSeq(37,23,1);
+  TestSeq(37,23,2);
+  TestSeq(37,23,4);
+  TestSeq(1,1,1);
+  TestSeq(2000,3,4);
+  unlink(lFile);
+
+  printf("test_picseq: %d failures\n",lFails);
+  return lFails!=0;
+}
@@ -0,0 +1,180 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  test: the formats of Y4M headers, and frames of a C420paldv stream
+ *  read and written again as Y4M, as raw frames and with
+ *  PicStream_Copy(). the pels must come back as they were
+ *
+ *	test_picstream
+ *
+ *  \file      test_picstream.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"nuts/debug.h"
+#include	"nuts/picstream.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<unistd.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define EXPECT(c,...)	do{ if(!(c)){ if(lFails++<10){			\
+	  printf("FAIL %s:%d: ",__FILE__,__LINE__); printf(__VA_ARGS__);	\
+	  printf("\n"); } } }while(0)
+
+#define DX		33
+#define DY		17
+#define FRAMES		3
+#define SIZE		(DX*DY+2*17*9)	/* of a 420 frame of 8 bit */
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static int		lFails;
+static char		lDir[]="/tmp/test_picstreamXXXXXX";
+static u8		lPels[FRAMES][SIZE];
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  write a Y4M file with the header Head and Frames frames of lPels
+ */
+static void Make(const char *Name, const char *Head, int Frames)
+{
+  FILE		*f;
+  int		i;
+
+  MUST(f=fopen(Name,"w"));
+  fprintf(f,"%s\n",Head);
+  for(i=0;i<Frames;i++){
+    fprintf(f,"FRAME\n");
+    MUST(fwrite(lPels[i],SIZE,1,f)==1);
+  }
+  fclose(f);
+}
+
+
+/****************************************************************************/
+/*  the format of a header
+ */
+static void TestHead(const char *Name, const char *Cs, int WantCs,
+		     int WantBits)
+{
+  tPicStream	s;
+  char		head[128];
+
+  snprintf(head,sizeof(head),"YUV4MPEG2 W%d H%d F30000:1001 It A1:1 C%s",
+	   DX,DY,Cs);
+  Make(Name,head,0);
+  EXPECT(PicStream_OpenY4m(&s,Name),"C%s: cannot open",Cs);
+  EXPECT(s.Cs==WantCs && s.Bits==WantBits,"C%s: %d/%d",Cs,s.Cs,s.Bits);
+  EXPECT(s.Dx==DX && s.Dy==DY && s.FpsN==30000 && s.FpsD==1001,
+	 "C%s: %dx%d at %d:%d",Cs,s.Dx,s.Dy,s.FpsN,s.FpsD);
+  EXPECT(!PicStream_Read(&s),"C%s: frame in an empty stream",Cs);
+  PicStream_Close(&s);
+}
+
+
+/****************************************************************************/
+/*  read all frames of a stream and compare them with lPels
+ */
+static void Check(tPicStream *pThat, const char *What)
+{
+  tYuv		*p;
+  int		i;
+
+  EXPECT(pThat->Dx==DX && pThat->Dy==DY && pThat->Cs==420 &&
+	 pThat->Bits==8 && pThat->Size==SIZE,"%s: %dx%d %d/%d %ld bytes",
+	 What,pThat->Dx,pThat->Dy,pThat->Cs,pThat->Bits,pThat->Size);
+  for(i=0;(p=PicStream_Read(pThat));i++)
+    EXPECT(i<FRAMES && !memcmp(pThat->pMem,lPels[i],SIZE),
+	   "%s: frame %d differs",What,i);
+  EXPECT(i==FRAMES && pThat->N==FRAMES,"%s: %d frames",What,i);
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+int main(void)
+{
+  tPicStream	in,y4m,raw,cp;
+  tYuv		*p;
+  char		src[64],dst[64],dsr[64],dsc[64];
+  int		i,k;
+
+  MUST(mkdtemp(lDir));
+  snprintf(src,sizeof(src),"%s/src.y4m",lDir);
+  snprintf(dst,sizeof(dst),"%s/dst.y4m",lDir);
+  snprintf(dsr,sizeof(dsr),"%s/dst.yuv",lDir);
+  snprintf(dsc,sizeof(dsc),"%s/copy.y4m",lDir);
+
+  TestHead(src,"420",420,8);
+  TestHead(src,"420jpeg",420,8);
+  TestHead(src,"420mpeg2",420,8);
+  TestHead(src,"420paldv",420,8);
+  TestHead(src,"420p10",420,10);
+  TestHead(src,"422p12",422,12);
+  TestHead(src,"444",444,8);
+  TestHead(src,"mono",PICSTREAM_MONO,8);
+  TestHead(src,"mono16",PICSTREAM_MONO,16);
+
+  for(i=0;i<FRAMES;i++)
+    for(k=0;k<SIZE;k++)
+      lPels[i][k]=(u8)(i*71+k*13+k/7);
+  Make(src,"YUV4MPEG2 W33 H17 F25:1 Ip A1:1 C420paldv",FRAMES);
+
+  /* read and write as Y4M and raw frames */
+  EXPECT(PicStream_OpenY4m(&in,src),"cannot open %s",src);
+  Check(&in,"paldv");
+  PicStream_Close(&in);
+
+  PicStream_OpenY4m(&in,src);
+  PicStream_CreateY4m(&y4m,dst,in.Dx,in.Dy,in.Cs,in.Bits,in.FpsN,in.FpsD);
+  PicStream_CreateRaw(&raw,dsr,in.Dx,in.Dy,in.Cs,in.Bits);
+  while((p=PicStream_Read(&in))){
+    PicStream_Write(&y4m,p);
+    PicStream_Write(&raw,p);
+  }
+  PicStream_Close(&raw);
+  PicStream_Close(&y4m);
+  PicStream_Close(&in);
+
+  EXPECT(PicStream_OpenY4m(&y4m,dst),"cannot open %s",dst);
+  EXPECT(y4m.FpsN==25 && y4m.FpsD==1,"%d:%d fps",y4m.FpsN,y4m.FpsD);
+  Check(&y4m,"y4m");
+  PicStream_Close(&y4m);
+  EXPECT(PicStream_OpenRaw(&raw,dsr,DX,DY,420,8),"cannot open %s",dsr);
+  Check(&raw,"raw");
+  PicStream_Close(&raw);
+
+  /* passed on without looking */
+  PicStream_OpenY4m(&in,src);
+  PicStream_CreateY4m(&cp,dsc,in.Dx,in.Dy,in.Cs,in.Bits,in.FpsN,in.FpsD);
+  while(PicStream_Copy(&cp,&in));
+  PicStream_Close(&cp);
+  PicStream_Close(&in);
+  PicStream_OpenY4m(&cp,dsc);
+  Check(&cp,"copy");
+  PicStream_Close(&cp);
+
+  unlink(src);
+  unlink(dst);
+  unlink(dsr);
+  unlink(dsc);
+  rmdir(lDir);
+  printf("test_picstream: %d failures\n",lFails);
+  return lFails!=0;
+}
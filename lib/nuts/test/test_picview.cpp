@@ -0,0 +1,201 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  test: the C++ kernels of picview.h against the C kernels of pic.c. all
+ *  templates of picview.h are instantiated here, on random pics that are
+ *  windows in a larger buffer
+ *
+ *	test_picview
+ *
+ *  \file      test_picview.cpp
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#include	"nuts/picview.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define EXPECT(c,...)	do{ if(!(c)){ if(lFails++<10){			\
+	  printf("FAIL %s:%d: ",__FILE__,__LINE__); printf(__VA_ARGS__);	\
+	  printf("\n"); } } }while(0)
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static int		lFails;
+
+static const int	lSize[][2]={{1,1},{7,5},{33,3},{70,4}};
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/* the converters of pic.c, with PICVIEW_CONV */
+PICVIEW_CONV(View16_BGRfromU8, u16,1, u8,1,
+	     d[0]=(s[0]>>3)<<11|(s[0]>>2)<<5|s[0]>>3)
+PICVIEW_CONV(View32_RGBXfromBGR, u8,4, u8,3,
+	     d[0]=s[2]; d[1]=s[1]; d[2]=s[0]; d[3]=0)
+
+
+/****************************************************************************/
+/*  a random pic of Bpp byte pels, a window 2 pels and 1 line into a buffer
+ *  that is 5 pels wider and 2 lines higher. free with Free()
+ */
+static tPic Alloc(int Dx, int Dy, int Bpp, u32 Seed)
+{
+  tPic		p;
+  int		s=(Dx+5)*Bpp;
+  u8		*pb;
+
+  pb=(u8*)malloc((long)s*(Dy+2));  MUST(pb);
+  memset(pb,0x5a,(long)s*(Dy+2));
+  Pic_Create(&p,s,Dx,Dy,pb+s+2*Bpp);
+  Pic_Random(&p,Bpp,Seed);
+  return p;
+}
+
+static void Free(tPic *p, int Bpp)
+{
+  free(p->Pel-p->S-2*Bpp);
+}
+
+
+/****************************************************************************/
+/*  the pels of pA and pB must be equal
+ */
+static void Same(const tPic *pA, const tPic *pB, int Bpp, const char *What)
+{
+  int		x=0,y=0,n;
+
+  n=Pic_Diff(pA,pB,Bpp,&x,&y);
+  EXPECT(n==0,"%s %dx%d: %d pels differ, the first at %d,%d",What,pA->Dx,
+	pA->Dy,n,x,y);
+}
+
+
+/****************************************************************************/
+/*  copy, set and shift of one format, against the C kernels
+ */
+template<typename T, int C>
+static void TestKernels(int Dx, int Dy, void (*pCopy)(tPic*,tPic*),
+			void (*pSet)(tPic*,const T*),
+			void (*pShift)(tPic*,int), const char *Name)
+{
+  const int	bpp=nuts::PicView<T,C>::BPP;
+  tPic		s=Alloc(Dx,Dy,bpp,1),a=Alloc(Dx,Dy,bpp,2),b=Alloc(Dx,Dy,bpp,2);
+  T		val[C];
+  char		what[64];
+
+  nuts::Copy(nuts::PicView<T,C>(a),nuts::PicView<T,C>(s));
+  pCopy(&b,&s);
+  snprintf(what,sizeof(what),"Copy<%s>",Name);
+  Same(&a,&b,bpp,what);
+
+  for(int c=0;c<C;c++)
+    val[c]=(T)(0x9d3c5a7bu>>(8*c));
+  nuts::Set(nuts::PicView<T,C>(a),val);
+  pSet(&b,val);
+  snprintf(what,sizeof(what),"Set<%s>",Name);
+  Same(&a,&b,bpp,what);
+
+  if(pShift){
+    Pic_Random(&a,bpp,3);
+    Pic_Random(&b,bpp,3);
+    nuts::ShiftLeft(nuts::PicView<T,C>(a),3);
+    pShift(&b,3);
+    snprintf(what,sizeof(what),"ShiftLeft<%s>",Name);
+    Same(&a,&b,bpp,what);
+  }
+
+  Free(&s,bpp);
+  Free(&a,bpp);
+  Free(&b,bpp);
+}
+
+/* the C kernels with the signature of TestKernels() */
+static void Set8(tPic *p, const u8 *v)  { Pic8_Set(p,*v); }
+static void Set16(tPic *p, const u16 *v)  { Pic16_Set(p,*v); }
+static void Set32(tPic *p, const u8 *v)
+{
+  u32		w;
+
+  memcpy(&w,v,4);
+  Pic32_Set(p,w);
+}
+static void Set24(tPic *p, const u8 *v)
+{
+  for(int y=0;y<p->Dy;y++)
+    for(int x=0;x<p->Dx;x++)
+      memcpy(p->Pel+(long)y*p->S+3*x,v,3);
+}
+
+
+/****************************************************************************/
+/*  the converting copy, the windows and the converters
+ */
+static void TestConv(int Dx, int Dy)
+{
+  tPic		g=Alloc(Dx,Dy,1,4),rgb=Alloc(Dx,Dy,3,5);
+  tPic		a16=Alloc(Dx,Dy,2,6),b16=Alloc(Dx,Dy,2,6);
+  tPic		a32=Alloc(Dx,Dy,4,7),b32=Alloc(Dx,Dy,4,7);
+  nuts::PicView<u8>	vg(g);
+  nuts::PicView<u16>	v16(&a16);
+  int		x,y;
+
+  nuts::Copy(v16,vg);
+  for(y=0;y<Dy;y++)
+    for(x=0;x<Dx;x++)
+      EXPECT(v16(x,y)==vg(x,y),"Copy<u16,u8> %dx%d at %d,%d",Dx,Dy,x,y);
+
+  if(Dx>2 && Dy>2){
+    tPic	w=v16.Window(1,1,Dx-2,Dy-2).Pic();
+    EXPECT(w.Pel==a16.Pel+a16.S+2 && w.Dx==Dx-2 && w.Dy==Dy-2 &&
+	  w.S==a16.S,"Window %dx%d",Dx,Dy);
+  }
+
+  View16_BGRfromU8(&a16,&g);
+  Pic16_BGRfromU8(&b16,&g);
+  Same(&a16,&b16,2,"View16_BGRfromU8");
+
+  View32_RGBXfromBGR(&a32,&rgb);
+  Pic32_RGBXfromBGR(&b32,&rgb);
+  Same(&a32,&b32,4,"View32_RGBXfromBGR");
+
+  Free(&g,1);
+  Free(&rgb,3);
+  Free(&a16,2);
+  Free(&b16,2);
+  Free(&a32,4);
+  Free(&b32,4);
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+int main(void)
+{
+  int		i,dx,dy;
+
+  for(i=0;i<LEN(lSize);i++){
+    dx=lSize[i][0];
+    dy=lSize[i][1];
+    TestKernels<u8,1>(dx,dy,Pic8_Copy,Set8,Pic8_ShiftLeft,"u8");
+    TestKernels<u16,1>(dx,dy,Pic16_Copy,Set16,Pic16_ShiftLeft,"u16");
+    TestKernels<u8,3>(dx,dy,Pic24_Copy,Set24,NULL,"u8,3");
+    TestKernels<u8,4>(dx,dy,Pic32_Copy,Set32,NULL,"u8,4");
+    TestConv(dx,dy);
+  }
+  printf("test_picview: %d failures\n",lFails);
+  return lFails!=0;
+}
@@ -0,0 +1,139 @@
+/* -*- tab-width: 8 -*- */
+/**
+ *  test: TRACE_BEGIN/TRACE_END pairs with Trace_Start() and Trace_Stop()
+ *  in between. the nesting must stay balanced and only the scopes that
+ *  began while tracing must be in the saved trace
+ *
+ *	test_trace
+ *
+ *  \file      test_trace.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#define TRACING
+#include	"nuts/debug.h"
+#include	"nuts/trace.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<unistd.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define EXPECT(c,...)	do{ if(!(c)){ if(lFails++<10){			\
+	  printf("FAIL %s:%d: ",__FILE__,__LINE__); printf(__VA_ARGS__);	\
+	  printf("\n"); } } }while(0)
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static int		lFails;
+static char		lFile[]="/tmp/test_traceXXXXXX";
+static char		lJson[1<<16];
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  save the trace and read it into lJson
+ */
+static void Load(void)
+{
+  FILE		*f;
+  size_t	n;
+
+  EXPECT(Trace_Save(lFile),"Trace_Save");
+  f=fopen(lFile,"r");
+  n=f?fread(lJson,1,sizeof(lJson)-1,f):0;
+  lJson[n]=0;
+  if(f)
+    fclose(f);
+}
+
+
+/****************************************************************************/
+/*  \return number of events called Name in lJson
+ */
+static int Count(const char *Name)
+{
+  char		key[64];
+  const char	*p=lJson;
+  int		n=0;
+
+  snprintf(key,sizeof(key),"\"name\":\"%s\"",Name);
+  while((p=strstr(p,key))){
+    n++;
+    p++;
+  }
+  return n;
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+int main(void)
+{
+  int		fd;
+
+  MUST((fd=mkstemp(lFile))>=0);
+  close(fd);
+
+  /* stopped within a scope: the scope is recorded when it ends */
+  Trace_Start();
+  TRACE_BEGIN("stopped");
+  Trace_Stop();
+  TRACE_END();
+  EXPECT(g_TraceDepth==0,"depth %d after stopped",g_TraceDepth);
+
+  /* started within a scope that began while stopped: not recorded */
+  TRACE_BEGIN("started");
+  Trace_Start();
+  TRACE_END();
+  EXPECT(g_TraceDepth==0,"depth %d after started",g_TraceDepth);
+
+  /* toggled within a nested scope: the outer scope ends at its own END */
+  TRACE_BEGIN("outer");
+  Trace_Stop();
+  TRACE_BEGIN("inner");
+  Trace_Start();
+  TRACE_END();
+  EXPECT(g_TraceDepth==1,"depth %d in outer",g_TraceDepth);
+  TRACE_END();
+  EXPECT(g_TraceDepth==0,"depth %d after outer",g_TraceDepth);
+
+  /* later scopes are balanced */
+  TRACE_BEGIN("parent");
+  TRACE_BEGIN("child");
+  EXPECT(g_TraceDepth==2,"depth %d in child",g_TraceDepth);
+  TRACE_END();
+  TRACE_END();
+  EXPECT(g_TraceDepth==0,"depth %d after parent",g_TraceDepth);
+
+  /* unbalanced ENDs are ignored */
+  TRACE_END();
+  EXPECT(g_TraceDepth==0,"depth %d after extra END",g_TraceDepth);
+  Trace_Stop();
+
+  Load();
+  EXPECT(Count("stopped")==1,"stopped: %d events",Count("stopped"));
+  EXPECT(Count("started")==0,"started: %d events",Count("started"));
+  EXPECT(Count("outer")==1,"outer: %d events",Count("outer"));
+  EXPECT(Count("inner")==0,"inner: %d events",Count("inner"));
+  EXPECT(Count("parent")==1,"parent: %d events",Count("parent"));
+  EXPECT(Count("child")==1,"child: %d events",Count("child"));
+
+  unlink(lFile);
+  printf("test_trace: %d failures\n",lFails);
+  return lFails!=0;
+}
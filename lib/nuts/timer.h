@@ -1,7 +1,8 @@
 /** 
+ *  simple timers and a high resolution clock. for nested, per thread
+ *  timing of whole pipelines see trace.h
  *
- *
- *  \file      time.h
+ *  \file      timer.h
  *  \author    Norbert Stoeffler
  *  \date      2014-05-15
  */
@@ -20,13 +21,13 @@
 typedef clock_t tTimer;
 
 
-inline void startTimer(tTimer *pt)
+static inline void startTimer(tTimer *pt)
 {
 	*pt=clock();
 }
 
 
-inline double stopTimer(const tTimer *t)
+static inline double stopTimer(const tTimer *t)
 {
 	clock_t now;
 
@@ -36,23 +37,33 @@ inline double stopTimer(const tTimer *t)
 }
 
 #else
-#include	<sys/time.h>
+#include	<time.h>
 
-typedef struct timeval tTimer;
+typedef u64 tTimer;
 
 
-inline void startTimer(tTimer *pt)
+/** monotonic time in ns
+ */
+static inline u64 timerNs(void)
 {
-	gettimeofday(pt,NULL);
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (u64)ts.tv_sec*1000000000ull+ts.tv_nsec;
 }
 
 
-inline double stopTimer(const tTimer *pt)
+static inline void startTimer(tTimer *pt)
 {
-	struct timeval now;
+	*pt=timerNs();
+}
+
 
-	gettimeofday(&now,NULL);
-	return ((now.tv_sec*10000+now.tv_usec/100)-(pt->tv_sec*10000+pt->tv_usec/100))/10.0;
+/** \return ms since startTimer() with ns resolution
+ */
+static inline double stopTimer(const tTimer *pt)
+{
+	return (timerNs()-*pt)/1e6;
 }
 
 #endif
@@ -0,0 +1,335 @@
+/* -*- tab-width: 8 -*- */
+/** 
+ *  scope based timing instrumentation, see trace.h. every thread appends
+ *  complete events (name, start, end) to its own list of chunks, so
+ *  recording needs no locks. the chunks are kept until Trace_Clear() and
+ *  written by Trace_Save() as Chrome trace JSON.
+ *
+ *  \file      trace.c
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#define _GNU_SOURCE		/* pthread_getname_np */
+#include	"trace.h"
+#include	"debug.h"
+#include	"list.h"
+
+#ifdef UNIX_GNU
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<pthread.h>
+#include	<unistd.h>
+#include	<sys/syscall.h>
+
+
+/*****************************************************************************
+ *  local defines
+ ****************************************************************************/
+
+#define CHUNKEVS	4096		/* events per chunk */
+#define MAXDEPTH	64		/* nesting of TRACE_BEGIN/END */
+
+
+/*****************************************************************************
+ *  local types
+ ****************************************************************************/
+
+typedef struct {
+  const char		*Name;
+  u64			T0;
+  u64			T1;		/* 0 for instant events */
+} tEv;
+
+typedef struct sChunk {
+  struct sChunk		*pNext;
+  int			N;		/* used events */
+  tEv			Ev[CHUNKEVS];
+} tChunk;
+
+typedef struct sThr {
+  struct sThr		*pNext;
+  int			Tid;
+  char			Name[16];
+  tChunk		*pFirst;
+  tChunk		*pLast;
+  tTraceScope		Stack[MAXDEPTH];	/* of TRACE_BEGIN/END */
+} tThr;
+
+
+/*****************************************************************************
+ *  global variables
+ ****************************************************************************/
+
+int			g_TraceOn=0;
+__thread int		g_TraceDepth=0;	/* open TRACE_BEGINs of the thread */
+
+
+/*****************************************************************************
+ *  local variables
+ ****************************************************************************/
+
+static pthread_mutex_t	lMutex=PTHREAD_MUTEX_INITIALIZER;
+static tThr		*lpThrs=NULL;	/* all threads that ever traced */
+static u64		lT0=0;		/* time base of the export */
+static const char	*lAutoName=NULL;	/* NUTS_TRACE */
+static __thread tThr	*lpThr=NULL;
+
+
+/*****************************************************************************
+ *  local functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/*  register the calling thread
+ */
+static tThr *NewThr(void)
+{
+  tThr		*pt;
+
+  pt=NEW(tThr);
+  pt->pFirst=pt->pLast=NEW(tChunk);
+  pt->Tid=syscall(SYS_gettid);
+  pthread_getname_np(pthread_self(),pt->Name,sizeof(pt->Name));
+
+  pthread_mutex_lock(&lMutex);
+  pt->pNext=lpThrs;
+  lpThrs=pt;
+  pthread_mutex_unlock(&lMutex);
+
+  return lpThr=pt;
+}
+
+
+/****************************************************************************/
+/*  print a string as JSON
+ */
+static void PutStr(FILE *f, const char *s)
+{
+  fputc('"',f);
+  for(;*s;s++){
+    if(*s=='"' || *s=='\\')
+      fprintf(f,"\\%c",*s);
+    else if((u8)*s<0x20)
+      fprintf(f,"\\u%04x",*s);
+    else
+      fputc(*s,f);
+  }
+  fputc('"',f);
+}
+
+
+/****************************************************************************/
+/*  print a timestamp in us relative to lT0
+ */
+static void PutTs(FILE *f, const char *Key, u64 t)
+{
+  fprintf(f,",\"%s\":%llu.%03llu",Key,t/1000,t%1000);
+}
+
+
+/****************************************************************************/
+/*  save the trace at exit (NUTS_TRACE)
+ */
+static void AtExit(void)
+{
+  Trace_Stop();
+  Trace_Save(lAutoName);
+}
+
+
+/****************************************************************************/
+/*  check NUTS_TRACE at startup
+ */
+static void __attribute__((constructor)) Init(void)
+{
+  if((lAutoName=getenv("NUTS_TRACE")) && *lAutoName){
+    atexit(AtExit);
+    Trace_Start();
+  }
+}
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/** record a complete event. used internally by the TRACE macros
+ *
+ *  \param  Name static name of the event
+ *  \param  T0   start time in ns (timerNs())
+ *  \param  T1   end time, 0 for an instant event
+ */
+void nuts_trace(const char *Name, u64 T0, u64 T1)
+{
+  tThr		*pt=lpThr;
+  tChunk	*pc;
+  tEv		*pe;
+
+  if(!pt)
+    pt=NewThr();
+
+  pc=pt->pLast;
+  if(pc->N==CHUNKEVS){
+    pc=NEW(tChunk);
+    __atomic_store_n(&pt->pLast->pNext,pc,__ATOMIC_RELEASE);
+    pt->pLast=pc;
+  }
+  pe=&pc->Ev[pc->N];
+  pe->Name=Name;
+  pe->T0=T0;
+  pe->T1=T1;
+  __atomic_store_n(&pc->N,pc->N+1,__ATOMIC_RELEASE);
+}
+
+
+/****************************************************************************/
+/** open a trace scope explicitly. used internally by TRACE_BEGIN. while
+ *  stopped the scope only keeps the nesting and is not recorded
+ *
+ *  \param  Name static name of the scope
+ */
+void nuts_tracebegin(const char *Name)
+{
+  tThr		*pt=lpThr;
+
+  if(!pt)
+    pt=NewThr();
+
+  if(g_TraceDepth<MAXDEPTH){
+    pt->Stack[g_TraceDepth].Name=Name;
+    pt->Stack[g_TraceDepth].T0=g_TraceOn?timerNs():0;
+  }
+  g_TraceDepth++;
+}
+
+
+/****************************************************************************/
+/** close the innermost scope opened by TRACE_BEGIN. used internally by
+ *  TRACE_END, unbalanced calls are ignored
+ */
+void nuts_traceend(void)
+{
+  tThr		*pt=lpThr;
+
+  if(!pt || !g_TraceDepth)
+    return;
+
+  g_TraceDepth--;
+  if(g_TraceDepth<MAXDEPTH && pt->Stack[g_TraceDepth].T0)
+    nuts_trace(pt->Stack[g_TraceDepth].Name,pt->Stack[g_TraceDepth].T0,
+	       timerNs());
+}
+
+
+/****************************************************************************/
+/** start recording trace events
+ */
+void Trace_Start(void)
+{
+  if(!lT0)
+    lT0=timerNs();
+  __atomic_store_n(&g_TraceOn,1,__ATOMIC_RELEASE);
+}
+
+
+/****************************************************************************/
+/** stop recording trace events. scopes that are open are still recorded
+ *  when they end
+ */
+void Trace_Stop(void)
+{
+  __atomic_store_n(&g_TraceOn,0,__ATOMIC_RELEASE);
+}
+
+
+/****************************************************************************/
+/** drop all recorded events. must not be called while other threads are
+ *  tracing
+ */
+void Trace_Clear(void)
+{
+  tThr		*pt;
+  tChunk	*pc,*pn;
+
+  pthread_mutex_lock(&lMutex);
+  for(pt=lpThrs;pt;pt=pt->pNext){
+    for(pc=pt->pFirst->pNext;pc;pc=pn){
+      pn=pc->pNext;
+      free(pc);
+    }
+    pt->pFirst->pNext=NULL;
+    pt->pFirst->N=0;
+    pt->pLast=pt->pFirst;
+  }
+  pthread_mutex_unlock(&lMutex);
+}
+
+
+/****************************************************************************/
+/** save all recorded events in the Chrome trace JSON format
+ *
+ *  \param  Name file name
+ *  \return TRUE if successful
+ */
+bool Trace_Save(const char *Name)
+{
+  FILE		*f;
+  tThr		*pt;
+  tChunk	*pc;
+  tEv		*pe;
+  int		i,n,pid=getpid();
+  const char	*sep="";
+
+  if(!(f=fopen(Name,"w"))){
+    WARN("can't open %s",Name);
+    return FALSE;
+  }
+
+  fprintf(f,"{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+  pthread_mutex_lock(&lMutex);
+  for(pt=lpThrs;pt;pt=pt->pNext){
+    if(pt->Name[0]){
+      fprintf(f,"%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,"
+	      "\"tid\":%d,\"args\":{\"name\":",sep,pid,pt->Tid);
+      PutStr(f,pt->Name);
+      fprintf(f,"}}");
+      sep=",\n";
+    }
+    for(pc=pt->pFirst;pc;pc=__atomic_load_n(&pc->pNext,__ATOMIC_ACQUIRE)){
+      n=__atomic_load_n(&pc->N,__ATOMIC_ACQUIRE);
+      for(i=0;i<n;i++){
+	pe=&pc->Ev[i];
+	if(pe->T0<lT0)
+	  continue;
+	fprintf(f,"%s{\"ph\":\"%s\",\"pid\":%d,\"tid\":%d,\"name\":",
+		sep,pe->T1?"X":"i",pid,pt->Tid);
+	PutStr(f,pe->Name);
+	PutTs(f,"ts",pe->T0-lT0);
+	if(pe->T1)
+	  PutTs(f,"dur",pe->T1-pe->T0);
+	else
+	  fprintf(f,",\"s\":\"t\"");
+	fprintf(f,"}");
+	sep=",\n";
+      }
+    }
+  }
+  pthread_mutex_unlock(&lMutex);
+
+  fprintf(f,"\n]}\n");
+
+  if(fclose(f)){
+    WARN("can't write %s",Name);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+#endif /* UNIX_GNU */
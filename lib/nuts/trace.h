@@ -0,0 +1,125 @@
+/* -*- tab-width: 8 -*- */
+/** 
+ *  scope based timing instrumentation with ns resolution. events are
+ *  recorded in per thread buffers and exported in the Chrome trace JSON
+ *  format (chrome://tracing, ui.perfetto.dev). switch TRACING compiles the
+ *  macros in, tracing itself is started with Trace_Start() or by setting
+ *  the environment variable NUTS_TRACE=<file>, which also saves the trace
+ *  to <file> at program exit. while stopped a TRACE_SCOPE costs one
+ *  predictable branch.
+ *
+ *	void Foo(void)
+ *	{
+ *	  TRACE_FUNC;
+ *	  ...
+ *	  {
+ *	    TRACE_SCOPE("inner loop");
+ *	    ...
+ *	  }
+ *	}
+ *
+ *  \file      trace.h
+ *  \author    Norbert Stoeffler
+ *  \date      2026-10-19
+ *
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include	"basic.h"
+
+#ifdef UNIX_GNU
+#include	"timer.h"
+#endif
+
+
+/*****************************************************************************
+ *  types
+ ****************************************************************************/
+
+/** state of an open scope, lives on the stack of the traced function
+ */
+typedef struct {
+  const char	*Name;		/**< name of the scope, must be static */
+  u64		T0;		/**< start time, 0 if not traced */
+} tTraceScope;
+
+
+/*****************************************************************************
+ *  exported functions
+ ****************************************************************************/
+
+EXTERN_C_BEGIN
+
+extern int	g_TraceOn;
+#ifdef UNIX_GNU
+extern __thread int	g_TraceDepth;
+#endif
+
+void nuts_trace(const char *Name, u64 T0, u64 T1);
+void nuts_tracebegin(const char *Name);
+void nuts_traceend(void);
+
+void Trace_Start(void);
+void Trace_Stop(void);
+void Trace_Clear(void);
+bool Trace_Save(const char *Name);
+
+EXTERN_C_END
+
+
+/*****************************************************************************
+ *  defines
+ ****************************************************************************/
+
+#if defined TRACING && defined UNIX_GNU
+
+#define TRACE_SYM_(p,x)	p##x
+#define TRACE_SYM(p,x)	TRACE_SYM_(p,x)
+
+/** cleanup handler of TRACE_SCOPE
+ */
+static inline void nuts_tracescope(tTraceScope *p)
+{
+  if(__builtin_expect(p->T0!=0,0))
+    nuts_trace(p->Name,p->T0,timerNs());
+}
+
+/** trace the rest of the enclosing block
+ *  \param name static string
+ */
+#define TRACE_SCOPE(name) tTraceScope TRACE_SYM(trs_,__LINE__) \
+	__attribute__((cleanup(nuts_tracescope)))= \
+	{ (name), __builtin_expect(g_TraceOn,0)?timerNs():0 }
+
+/** trace the rest of the enclosing function
+ */
+#define TRACE_FUNC	TRACE_SCOPE(__func__)
+
+/** open/close a trace scope explicitly, e.g. across functions. pairs have
+ *  to be properly nested within a thread. Trace_Start() or Trace_Stop()
+ *  between a pair is fine: TRACE_END closes every scope that is open, and
+ *  within an open scope TRACE_BEGIN keeps the nesting while stopped
+ */
+#define TRACE_BEGIN(name) do{ if(__builtin_expect(g_TraceOn|g_TraceDepth,0)) \
+	nuts_tracebegin(name); }while(0)
+#define TRACE_END()	do{ if(__builtin_expect(g_TraceDepth,0)) \
+	nuts_traceend(); }while(0)
+
+/** an instant event
+ */
+#define TRACE_MARK(name) do{ if(__builtin_expect(g_TraceOn,0)) \
+	nuts_trace((name),timerNs(),0); }while(0)
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_FUNC
+#define TRACE_BEGIN(name)
+#define TRACE_END()
+#define TRACE_MARK(name)
+
+#endif
+
+#endif /* TRACE_H */
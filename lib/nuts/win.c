@@ -11,6 +11,8 @@
 #include	"debug.h"
 #include	"list.h"
 #include	"bits.h"
+#include	"trace.h"
+#include	"metric.h"
 #ifndef NO_X11
 #include	<X11/Xlib.h>
 #include	<X11/Xutil.h>
@@ -40,6 +42,9 @@ typedef struct Win_sX {
   tLnkList		Rects;
   tLnkList		Lines;
   tLnkList		Texts;
+  tNodePool		RectPool;	/* nodes of Rects, Lines, Texts */
+  tNodePool		LinePool;
+  tNodePool		TextPool;
   bool			Redraw;
   bool			AutoZoom;
   bool			FreeGfx;
@@ -135,6 +140,8 @@ static void Redraw(tWin *pThat)
   tRect		*pr;
   tLine		*pl;
   tText		*pt;
+  TRACE_FUNC;
+  METRIC_FUNC;
 
   XPutImage(lDisplay,pThat->pX->Win,pThat->pX->Gc,pThat->pX->XImage,
 	    0,0,0,0,pThat->Dx,pThat->Dy);
@@ -228,6 +235,8 @@ static void FreeGfx(tWin *pThat)
 static void Zoom(tWin *pThat)
 {
   int	        ox,oy,x,y,z,b,xi,yi;
+  TRACE_FUNC;
+  METRIC_FUNC;
 
   z=pThat->pX->Z;
   ox=pThat->pX->X;
@@ -297,6 +306,62 @@ static void AutoZoom(tWin *pThat)
 }
 
 
+/****************************************************************************/
+/** show a Yuv or a Yc image: convert it straight into the back buffer, in
+ *  the pel format of the display. on little endian machines the words of
+ *  24/32 bit displays are BGRX in memory
+ *
+ *  \param pThat the Win
+ *  \param pYuv  the image, or NULL for pYc
+ *  \param pYc   the image, if no pYuv
+ *  \param Mode  see Pic32_RGBXfromYuv()
+ *  \param Vu    pYc is NV21
+ */
+static void ShowYuv(tWin *pThat, const tYuv *pYuv, const tYc *pYc, int Mode,
+		    bool Vu)
+{
+  const tPic	*py;
+  tPic		pic;
+  TRACE_FUNC;
+  METRIC_FUNC;
+
+  ;   MUST(pThat);
+
+  if(pThat->pX->FreeGfx)
+    FreeGfx(pThat);
+
+  py=pYuv?&pYuv->C[0]:&pYc->Y;
+  if(py->Dx<pThat->Dx || py->Dy<pThat->Dy)
+    memset(pThat->pX->Buf,0,pThat->Dx*pThat->Dy*lBpl);
+  Pic_Create(&pic,pThat->Dx*lBpl,pThat->Dx,pThat->Dy,pThat->pX->Buf);
+
+  switch(lDepth){
+  case 32:
+  case 24:
+    if(pYuv)
+      Pic32_BGRXfromYuv(&pic,pYuv,Mode);
+    else
+      Pic32_BGRXfromYc(&pic,pYc,Mode,Vu);
+    break;
+  case 16:
+    if(pYuv)
+      Pic16_RGB565fromYuv(&pic,pYuv,Mode);
+    else
+      Pic16_RGB565fromYc(&pic,pYc,Mode,Vu);
+    break;
+  default:
+    MUST_UNDEF(lDepth);
+  }
+
+  if(pThat->pX->Z>1){
+    Backup(pThat);
+    Zoom(pThat);
+  }
+
+  Redraw(pThat);
+}
+
+
 /****************************************************************************/
 /** handle an X event
  *
@@ -473,9 +538,12 @@ void Win_OpenXY(tWin *pThat, const char *Name, int Dx, int Dy)
 
   pThat->pX=NEW(Win_tX);
   pThat->pX->pThat=pThat;
-  LnkList_Init(&pThat->pX->Rects);
-  LnkList_Init(&pThat->pX->Lines);
-  LnkList_Init(&pThat->pX->Texts);
+  NodePool_Init(&pThat->pX->RectPool,sizeof(tRect));
+  NodePool_Init(&pThat->pX->LinePool,sizeof(tLine));
+  NodePool_Init(&pThat->pX->TextPool,sizeof(tText));
+  LnkList_InitPool(&pThat->pX->Rects,&pThat->pX->RectPool);
+  LnkList_InitPool(&pThat->pX->Lines,&pThat->pX->LinePool);
+  LnkList_InitPool(&pThat->pX->Texts,&pThat->pX->TextPool);
 
   LnkList_Add(&lWinList,pThat->pX);
 
@@ -755,7 +823,7 @@ void * Win_Rect(tWin *pThat, int X, int Y, int Dx, int Dy, int Col)
 
   ;   MUST(pThat);
 
-  LnkList_Add(&pThat->pX->Rects,pr=NEW(tRect));
+  LnkList_Add(&pThat->pX->Rects,pr=LnkList_NewNode(&pThat->pX->Rects));
   pr->X=X;
   pr->Y=Y;
   pr->Dx=Dx;
@@ -785,7 +853,7 @@ void * Win_RectA(tWin *pThat, int X0, int Y0, int X1, int Y1, int Col)
 
   ;   MUST(pThat);
 
-  LnkList_Add(&pThat->pX->Rects,pr=NEW(tRect));
+  LnkList_Add(&pThat->pX->Rects,pr=LnkList_NewNode(&pThat->pX->Rects));
   pr->X=X0;
   pr->Y=Y0;
   pr->Dx=X1-X0;
@@ -837,7 +905,7 @@ void * Win_Line(tWin *pThat, int X0, int Y0, int X1, int Y1, int Col)
 
   ;   MUST(pThat);
 
-  LnkList_Add(&pThat->pX->Lines,pl=NEW(tLine));
+  LnkList_Add(&pThat->pX->Lines,pl=LnkList_NewNode(&pThat->pX->Lines));
   pl->X0=X0;
   pl->Y0=Y0;
   pl->X1=X1;
@@ -896,7 +964,7 @@ void * Win_Text(tWin *pThat, int X, int Y, int Col, const char *Text, ...)
 
   ;   MUST(pThat);
 
-  LnkList_Add(&pThat->pX->Texts,pt=NEW(tText));
+  LnkList_Add(&pThat->pX->Texts,pt=LnkList_NewNode(&pThat->pX->Texts));
   pt->X=X;
   pt->Y=Y;
   pt->Col=Col;
@@ -936,7 +1004,7 @@ void * Win_BigText(tWin *pThat, int X, int Y, int Col, const char *Text, ...)
 
   ;   MUST(pThat);
 
-  LnkList_Add(&pThat->pX->Texts,pt=NEW(tText));
+  LnkList_Add(&pThat->pX->Texts,pt=LnkList_NewNode(&pThat->pX->Texts));
   pt->X=X;
   pt->Y=Y;
   pt->Col=Col;
@@ -1012,7 +1080,9 @@ void Win_Dump(tWin *pThat, tPic *pPic)
 {
 #ifndef NO_X11
   XImage	*xi;
-  int		x,y;
+  int		y;
+  TRACE_FUNC;
+  METRIC_FUNC;
 
   ;   MUST(pThat); MUST_Eq(pThat->Dx,pPic->Dx); MUST_Eq(pThat->Dy,pPic->Dy);
 
@@ -1031,12 +1101,8 @@ void Win_Dump(tWin *pThat, tPic *pPic)
   DLOGd(xi->bytes_per_line);
   DLOGd(xi->bits_per_pixel);
 
-  for(y=0;y<pThat->Dy;y++){
-    for(x=0;x<pThat->Dx;x++){
-      //BEW32(pPEL8(pPic,x*4,y),XGetPixel(xi,x,y));
-      BEW32(pPEL32(pPic,x,y),((u32*)xi->data)[y*pThat->Dx+x]);
-    }
-  }
+  for(y=0;y<pThat->Dy;y++)
+    Bits_Swap32(pPEL32(pPic,0,y),xi->data+y*xi->bytes_per_line,pThat->Dx);
 
   XDestroyImage(xi);
 #endif
@@ -1236,6 +1302,37 @@ void Win_ShowRGB565(tWin *pThat, const tPic *pPic)
 #undef SHOW
 }
 
+
+/****************************************************************************/
+/** show a Yuv image (I420, or 4:2:2), converted to RGB in one pass. fast
+ *  enough to play video
+ *
+ *  \param pThat the Win
+ *  \param pYuv  the image
+ *  \param Mode  PIC_BT601 or PIC_BT709, | PIC_FULL, see Pic32_RGBXfromYuv()
+ */
+void Win_ShowYuv(tWin *pThat, const tYuv *pYuv, int Mode)
+{
+#ifndef NO_X11
+  ShowYuv(pThat,pYuv,NULL,Mode,FALSE);
+#endif
+}
+
+/****************************************************************************/
+/** show a Yc image (NV12 or NV21), see Win_ShowYuv()
+ *
+ *  \param pThat the Win
+ *  \param pYc   the image
+ *  \param Mode  see Win_ShowYuv()
+ *  \param Vu    V first (NV21), else U first (NV12)
+ */
+void Win_ShowYc(tWin *pThat, const tYc *pYc, int Mode, bool Vu)
+{
+#ifndef NO_X11
+  ShowYuv(pThat,NULL,pYc,Mode,Vu);
+#endif
+}
+
 /****************************************************************************/
 /** show an U8 pic as abs/angle image with 16 directions color coded and
  *  brightness proportional to 3 bit length
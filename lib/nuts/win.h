@@ -126,6 +126,8 @@ void Win_ShowU16wDisp(tWin *pThat, const tPic *pPic, const tPic *pD, int DBits);
 void Win_ShowRGB888(tWin *pThat, const tPic *pPic);
 void Win_ShowRGB565(tWin *pThat, const tPic *pPic);
 void Win_ShowRGB555(tWin *pThat, const tPic *pPic);
+void Win_ShowYuv(tWin *pThat, const tYuv *pYuv, int Mode);
+void Win_ShowYc(tWin *pThat, const tYc *pYc, int Mode, bool Vu);
 
 tWin * Win_ShowMemU8(const char *Name, void *pDat, int S, int Dx, int Dy, int Zoom);
 tWin * Win_ShowMemRGBX(const char *Name, void *pDat, int S, int Dx, int Dy);
@@ -15,6 +15,8 @@
 	u32		*out32;
 	u16		*out16;
 	u8		*pp;
+	TRACE_FUNC;
+	METRIC_FUNC;
 
 	;   MUST(pThat); MUST(pPic);
 